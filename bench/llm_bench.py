@@ -0,0 +1,297 @@
+#!/usr/bin/env python3
+"""
+LLM 请求路径的端到端延迟基准测试
+启动本地模拟提供商（mock_llm_server.py）和本机构建的固件（pio run -e native），
+经 CDC（stdin / stdout）发送 userInput 消息，走完整的 LLMManager 请求路径：
+排队、建连、发送请求体、读取并解析回复、执行工具调用。结束时发送 getMetrics，
+按固件自己的分阶段计时（LLMMetrics）输出每个阶段的 p50/p95/p99，另外给出主机侧测得的
+端到端耗时（client_e2e）。
+
+作为性能回归门禁：--baseline 指定上次保存的结果（--output），任一阶段的指定百分位数
+比基线慢超过 --max-regression 且超过噪声下限时，以退出码 1 结束。
+
+用法：
+    pio run -e native
+    python bench/llm_bench.py --scenario bench/scenarios/chat_stream.json --requests 200 --output bench.json
+    python bench/llm_bench.py --scenario bench/scenarios/chat_stream.json --baseline bench.json
+"""
+
+import argparse
+import json
+import os
+import queue
+import shutil
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent))
+import mock_llm_server  # noqa: E402
+
+PROJECT_DIR = Path(__file__).resolve().parent.parent
+DEFAULT_BINARY = PROJECT_DIR / '.pio' / 'build' / 'native' / 'program'
+DEFAULT_SCENARIO = Path(__file__).resolve().parent / 'scenarios' / 'chat_stream.json'
+
+# 与 LLMMetrics::phaseName() 的顺序一致
+PHASES = ['queue_wait', 'dns', 'tcp_connect', 'tls_handshake', 'request_write', 'first_byte',
+          'body_download', 'json_parse', 'tool_dispatch', 'total']
+
+# 用户输入避开本地意图规则（基准配置中也关闭了意图匹配），每次都经过提供商
+PROMPTS = [
+    'Summarize what the noox device can do in two sentences.',
+    'What is the difference between TCP and UDP?',
+    'Write a haiku about embedded systems.',
+    'Explain the role of PSRAM on an ESP32-S3.',
+]
+
+
+def bench_config(args):
+    """基准测试用的配置：单一提供商、关闭缓存、意图匹配和对冲，熔断不触发"""
+    return {
+        'last_used': {'llm_provider': 'deepseek', 'model': 'mock-model', 'wifi_ssid': 'native'},
+        'wifi_networks': [{'ssid': 'native', 'password': ''}],
+        'llm_providers': {'deepseek': {'api_key': 'bench', 'models': ['mock-model']}},
+        'llm_settings': {
+            'stream': not args.no_stream,
+            'native_tools': True,
+            'workers': args.workers,
+            'max_sessions': max(4, args.concurrency),
+            'request_timeout_ms': int(args.timeout * 1000),
+            'intents': {'enabled': False},
+            'cache': {'enabled': False},
+            'routing': {
+                'secondary': {'provider': '', 'model': ''},
+                'hedge': False,
+                'breaker_failures': 1000000,
+                'breaker_cooldown_ms': 0,
+            },
+        },
+        'log_settings': {'level': args.log_level},
+    }
+
+
+def percentile(samples, pct):
+    """最近秩法，与 LLMMetrics::percentile() 一致"""
+    if not samples:
+        return 0.0
+    ordered = sorted(samples)
+    rank = (len(ordered) * pct + 99) // 100
+    return ordered[max(rank, 1) - 1]
+
+
+class Device:
+    """本机构建的固件进程，按行收发 CDC 消息"""
+
+    def __init__(self, binary, fs_root, endpoint, stderr_path):
+        env = dict(os.environ, NOOX_FS_ROOT=str(fs_root), NOOX_LLM_ENDPOINT=endpoint)
+        self.stderr = open(stderr_path, 'w')
+        self.process = subprocess.Popen([str(binary)], stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                                        stderr=self.stderr, env=env, bufsize=0)
+        self.lock = threading.Lock()
+        self.waiters = {}           # requestId -> queue.Queue
+        self.reader = threading.Thread(target=self.read_loop, daemon=True)
+        self.reader.start()
+
+    def read_loop(self):
+        for line in self.process.stdout:
+            try:
+                message = json.loads(line)
+            except ValueError:
+                continue
+            # 流式增量不代表请求结束；aiResponse、metrics、linkTestResult 各自结束一次等待
+            if message.get('type') == 'aiResponseDelta':
+                continue
+            with self.lock:
+                waiter = self.waiters.pop(message.get('requestId', ''), None)
+            if waiter:
+                waiter.put((time.monotonic(), message))
+
+    def request(self, message, timeout):
+        """发送一条消息并等待同一 requestId 的回复，返回 (回复, 耗时秒数)"""
+        waiter = queue.Queue()
+        with self.lock:
+            self.waiters[message['requestId']] = waiter
+        start = time.monotonic()
+        self.process.stdin.write((json.dumps(message) + '\n').encode('utf-8'))
+        self.process.stdin.flush()
+        try:
+            received, reply = waiter.get(timeout=timeout)
+        except queue.Empty:
+            with self.lock:
+                self.waiters.pop(message['requestId'], None)
+            return None, timeout
+        return reply, received - start
+
+    def close(self):
+        self.process.kill()
+        self.process.wait()
+        self.stderr.close()
+
+
+def run(args):
+    binary = Path(args.binary)
+    if not binary.exists():
+        sys.exit('%s not found; build it first with: pio run -e native' % binary)
+
+    server = mock_llm_server.start_server(args.scenario)
+    endpoint = '%s:%d' % server.server_address
+    work_dir = Path(tempfile.mkdtemp(prefix='noox-bench-'))
+    fs_root = work_dir / 'fs'
+    fs_root.mkdir()
+    (fs_root / 'config.json').write_text(json.dumps(bench_config(args)), encoding='utf-8')
+    device = Device(binary, fs_root, endpoint, work_dir / 'device.log')
+
+    try:
+        # 等待 USB 任务开始处理 CDC 消息
+        deadline = time.monotonic() + 10
+        while True:
+            reply, _ = device.request({'type': 'linkTest', 'requestId': 'ready'}, 0.5)
+            if reply:
+                break
+            if time.monotonic() > deadline or device.process.poll() is not None:
+                sys.exit('Device did not start, see %s' % (work_dir / 'device.log'))
+
+        # 每个并发槽位是一个独立会话，收到回复后再发送下一条（闭环）
+        next_index = [0]
+        index_lock = threading.Lock()
+        e2e = []
+        errors = []
+        timeouts = [0]
+
+        def session(slot):
+            while True:
+                with index_lock:
+                    index = next_index[0]
+                    if index >= args.requests:
+                        return
+                    next_index[0] += 1
+                message = {'type': 'userInput', 'requestId': 'bench-%d' % index, 'sessionId': 'bench%d' % slot,
+                           'payload': PROMPTS[index % len(PROMPTS)]}
+                reply, elapsed = device.request(message, args.timeout)
+                with index_lock:
+                    if reply is None:
+                        timeouts[0] += 1
+                        continue
+                    e2e.append(elapsed * 1000.0)
+                    payload = reply.get('payload', '')
+                    if isinstance(payload, str) and payload.startswith('Error:'):
+                        errors.append(payload)
+
+        started = time.monotonic()
+        sessions = [threading.Thread(target=session, args=(slot,)) for slot in range(args.concurrency)]
+        for thread in sessions:
+            thread.start()
+        for thread in sessions:
+            thread.join()
+        wall = time.monotonic() - started
+
+        metrics, _ = device.request({'type': 'getMetrics', 'requestId': 'metrics'}, 10)
+    finally:
+        device.close()
+        server.shutdown()
+        if not args.keep:
+            shutil.rmtree(work_dir, ignore_errors=True)
+
+    phases = {}
+    window = 0
+    if metrics:
+        window = metrics['payload'].get('window', 0)
+        for series in metrics['payload'].get('series', []):
+            if series.get('provider') == 'deepseek':
+                for name in PHASES:
+                    stats = series.get('phases', {}).get(name)
+                    if stats:
+                        phases[name] = {key: stats[key] for key in ('count', 'p50_ms', 'p95_ms', 'p99_ms', 'max_ms')}
+    phases['client_e2e'] = {
+        'count': len(e2e),
+        'p50_ms': percentile(e2e, 50),
+        'p95_ms': percentile(e2e, 95),
+        'p99_ms': percentile(e2e, 99),
+        'max_ms': max(e2e) if e2e else 0.0,
+    }
+
+    return {
+        'scenario': str(args.scenario),
+        'requests': args.requests,
+        'concurrency': args.concurrency,
+        'workers': args.workers,
+        'stream': not args.no_stream,
+        'window': window,
+        'wall_s': round(wall, 3),
+        'throughput_rps': round(len(e2e) / wall, 2) if wall > 0 else 0.0,
+        'errors': len(errors),
+        'timeouts': timeouts[0],
+        'server': server.stats.snapshot(),
+        'phases': phases,
+        'log': str(work_dir / 'device.log') if args.keep else None,
+    }
+
+
+def print_report(result):
+    print('Scenario %s: %d requests, concurrency %d, %d workers, stream %s' % (
+        result['scenario'], result['requests'], result['concurrency'], result['workers'],
+        'on' if result['stream'] else 'off'))
+    print('Wall %.2f s, %.2f req/s, %d errors, %d timeouts; server: %s' % (
+        result['wall_s'], result['throughput_rps'], result['errors'], result['timeouts'],
+        json.dumps(result['server'])))
+    if result['window'] and result['requests'] > result['window']:
+        print('Note: device percentiles cover the last %d requests only' % result['window'])
+    print('%-14s %7s %10s %10s %10s %10s' % ('phase', 'count', 'p50 ms', 'p95 ms', 'p99 ms', 'max ms'))
+    for name, stats in result['phases'].items():
+        print('%-14s %7d %10.3f %10.3f %10.3f %10.3f' % (
+            name, stats['count'], stats['p50_ms'], stats['p95_ms'], stats['p99_ms'], stats['max_ms']))
+
+
+def compare(result, baseline, args):
+    """与基线比较，返回回归的阶段列表"""
+    key = args.gate_percentile + '_ms'
+    regressions = []
+    for name, stats in result['phases'].items():
+        base = baseline.get('phases', {}).get(name)
+        if not base or key not in base:
+            continue
+        current, previous = stats[key], base[key]
+        if current - previous > args.noise_floor_ms and current > previous * (1 + args.max_regression / 100.0):
+            regressions.append('%s %s: %.3f ms -> %.3f ms (+%.1f%%)' % (
+                name, args.gate_percentile, previous, current, (current / previous - 1) * 100 if previous else 0))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description='LLM 请求路径的端到端延迟基准测试（本机构建 + 模拟提供商）')
+    parser.add_argument('--binary', default=str(DEFAULT_BINARY), help='本机构建的固件（pio run -e native）')
+    parser.add_argument('--scenario', default=str(DEFAULT_SCENARIO), help='模拟提供商的场景文件')
+    parser.add_argument('--requests', type=int, default=200, help='请求总数')
+    parser.add_argument('--concurrency', type=int, default=1, help='并发会话数（每个会话收到回复后再发下一条）')
+    parser.add_argument('--workers', type=int, default=2, help='固件的 LLM 工作任务数')
+    parser.add_argument('--no-stream', action='store_true', help='关闭流式回复（llm_settings.stream）')
+    parser.add_argument('--timeout', type=float, default=60.0, help='单个请求的超时（秒）')
+    parser.add_argument('--log-level', default='warn', help='固件日志级别（输出到临时目录中的 device.log）')
+    parser.add_argument('--keep', action='store_true', help='保留临时目录（配置和固件日志）')
+    parser.add_argument('--output', help='把结果写入 JSON 文件，可作为之后的 --baseline')
+    parser.add_argument('--baseline', help='基线结果（JSON），有回归时以退出码 1 结束')
+    parser.add_argument('--gate-percentile', default='p95', choices=['p50', 'p95', 'p99'], help='比较的百分位数')
+    parser.add_argument('--max-regression', type=float, default=10.0, help='允许的变慢比例（%%）')
+    parser.add_argument('--noise-floor-ms', type=float, default=1.0, help='小于此差值（毫秒）的变化不算回归')
+    args = parser.parse_args()
+
+    result = run(args)
+    print_report(result)
+    if args.output:
+        Path(args.output).write_text(json.dumps(result, indent=2), encoding='utf-8')
+
+    if args.baseline:
+        regressions = compare(result, json.loads(Path(args.baseline).read_text(encoding='utf-8')), args)
+        if regressions:
+            print('Regressions against %s:' % args.baseline)
+            for line in regressions:
+                print('  ' + line)
+            sys.exit(1)
+        print('No regressions against %s' % args.baseline)
+
+
+if __name__ == '__main__':
+    main()
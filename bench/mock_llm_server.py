@@ -0,0 +1,308 @@
+#!/usr/bin/env python3
+"""
+本地模拟 LLM 提供商（OpenAI 兼容的 /chat/completions 接口）
+用于在开发机上复现请求延迟，不消耗 token、不依赖外网。DeepSeek、OpenRouter、OpenAI
+三个提供商的路径都会响应，配合本机构建的 NOOX_LLM_ENDPOINT=127.0.0.1:<port> 使用。
+
+回复由场景文件描述（JSON），每个请求按权重随机选取一种回复（固定种子，结果可复现）：
+
+    {
+      "seed": 1,
+      "responses": [
+        {"weight": 8, "first_byte_ms": 400, "jitter_ms": 100, "chunk_ms": 15, "chunks": 24,
+         "content": "Hello from the mock provider."},
+        {"weight": 1, "tool_calls": [{"name": "gpio_set", "arguments": {"gpio": "led1", "state": true}}]},
+        {"weight": 1, "status": 429, "error": "Rate limit reached"}
+      ]
+    }
+
+回复字段（均可省略）：
+    weight         选取权重，缺省 1
+    status         HTTP 状态码，缺省 200；非 200 时返回 {"error":{"message":...}}
+    error          错误信息；status 为 200 且请求为流式时，作为流中的错误事件发送
+    first_byte_ms  读完请求体后到发送响应头的延迟（服务器排队和预填充）
+    jitter_ms      first_byte_ms 的随机抖动（±）
+    chunk_ms       相邻两个分块（SSE 事件或 chunked 分块）之间的延迟
+    chunks         内容拆分的块数，缺省 8
+    content        回复文本
+    tool_calls     原生工具调用 [{"name", "arguments"}]，arguments 为对象或 JSON 字符串
+    transfer       非流式回复的传输方式："length"（Content-Length，缺省）或 "chunked"
+    close          回复后关闭连接（Connection: close）
+
+请求体中 "stream": true 时以 SSE（text/event-stream，chunked 传输）回复，否则返回完整 JSON。
+
+用法：
+    python bench/mock_llm_server.py --port 8089 --scenario bench/scenarios/chat_stream.json
+"""
+
+import argparse
+import json
+import random
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from pathlib import Path
+
+# 三个提供商的接口路径（与 src/llm_provider_router.cpp 一致）
+COMPLETION_PATHS = ('/chat/completions', '/api/v1/chat/completions', '/v1/chat/completions')
+
+DEFAULT_RESPONSE = {
+    'first_byte_ms': 300,
+    'jitter_ms': 50,
+    'chunk_ms': 10,
+    'chunks': 8,
+    'content': 'This is a reply from the mock provider.',
+}
+
+
+class Scenario:
+    """按权重选取回复；多个连接线程共享，选取时加锁"""
+
+    def __init__(self, spec):
+        self.responses = spec.get('responses') or [DEFAULT_RESPONSE]
+        self.weights = [r.get('weight', 1) for r in self.responses]
+        self.random = random.Random(spec.get('seed', 1))
+        self.lock = threading.Lock()
+
+    @classmethod
+    def load(cls, path):
+        if not path:
+            return cls({})
+        return cls(json.loads(Path(path).read_text(encoding='utf-8')))
+
+    def pick(self):
+        """返回 (回复描述, 首字节延迟秒数)"""
+        with self.lock:
+            response = self.random.choices(self.responses, weights=self.weights)[0]
+            jitter = response.get('jitter_ms', 0)
+            delay_ms = response.get('first_byte_ms', 0) + self.random.uniform(-jitter, jitter)
+        return response, max(delay_ms, 0) / 1000.0
+
+
+class Stats:
+    """服务器一侧的计数，基准测试结束时输出"""
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.requests = 0
+        self.connections = 0
+        self.statuses = {}
+        self.request_bytes = 0
+
+    def record(self, status, request_bytes):
+        with self.lock:
+            self.requests += 1
+            self.request_bytes += request_bytes
+            self.statuses[status] = self.statuses.get(status, 0) + 1
+
+    def connected(self):
+        with self.lock:
+            self.connections += 1
+
+    def snapshot(self):
+        with self.lock:
+            return {
+                'requests': self.requests,
+                'connections': self.connections,
+                'statuses': {str(k): v for k, v in sorted(self.statuses.items())},
+                'avg_request_bytes': self.request_bytes // self.requests if self.requests else 0,
+            }
+
+
+def split_text(text, parts):
+    """把文本拆成 parts 段（至少 1 段）"""
+    parts = max(1, min(parts, len(text) or 1))
+    size = -(-len(text) // parts) if text else 0
+    return [text[i:i + size] for i in range(0, len(text), size)] if text else ['']
+
+
+def tool_call_arguments(call):
+    arguments = call.get('arguments', {})
+    return arguments if isinstance(arguments, str) else json.dumps(arguments, ensure_ascii=False)
+
+
+class MockProviderHandler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'  # 保持连接，与固件的连接池配合
+    server_version = 'NOOXMock/1.0'
+
+    def setup(self):
+        super().setup()
+        self.server.stats.connected()
+
+    def log_message(self, format, *args):
+        if self.server.verbose:
+            super().log_message(format, *args)
+
+    # ---------- 请求 ----------
+
+    def read_body(self):
+        """读取请求体，支持 Content-Length 和 chunked（固件以 chunked 发送请求体）"""
+        if 'chunked' in self.headers.get('Transfer-Encoding', '').lower():
+            body = bytearray()
+            while True:
+                size_line = self.rfile.readline()
+                size = int(size_line.split(b';')[0].strip() or b'0', 16)
+                if size == 0:
+                    # 跳过 trailer，直到空行
+                    while self.rfile.readline() not in (b'\r\n', b'\n', b''):
+                        pass
+                    return bytes(body)
+                body += self.rfile.read(size)
+                self.rfile.readline()
+        length = int(self.headers.get('Content-Length', 0))
+        return self.rfile.read(length) if length else b''
+
+    def do_POST(self):
+        body = self.read_body()
+        if self.path not in COMPLETION_PATHS:
+            self.send_json(404, {'error': {'message': 'Unknown path ' + self.path, 'type': 'invalid_request_error'}})
+            self.server.stats.record(404, len(body))
+            return
+        try:
+            request = json.loads(body or b'{}')
+        except ValueError:
+            self.send_json(400, {'error': {'message': 'Invalid JSON body', 'type': 'invalid_request_error'}})
+            self.server.stats.record(400, len(body))
+            return
+
+        response, delay = self.server.scenario.pick()
+        time.sleep(delay)
+        status = response.get('status', 200)
+        self.close_connection = bool(response.get('close'))
+        model = request.get('model', 'mock-model')
+
+        if status != 200:
+            self.send_json(status, {'error': {'message': response.get('error', 'Mock error'), 'type': 'mock_error'}})
+        elif request.get('stream'):
+            self.send_stream(response, model)
+        else:
+            self.send_completion(response, model)
+        self.server.stats.record(status, len(body))
+
+    # ---------- 回复 ----------
+
+    def send_head(self, status, content_type, extra=None):
+        self.send_response(status)
+        self.send_header('Content-Type', content_type)
+        for name, value in (extra or {}).items():
+            self.send_header(name, value)
+        if self.close_connection:
+            self.send_header('Connection', 'close')
+        self.end_headers()
+
+    def send_json(self, status, document):
+        data = json.dumps(document, ensure_ascii=False).encode('utf-8')
+        self.send_head(status, 'application/json', {'Content-Length': str(len(data))})
+        self.wfile.write(data)
+        self.wfile.flush()
+
+    def write_chunk(self, data):
+        self.wfile.write(b'%x\r\n%s\r\n' % (len(data), data))
+        self.wfile.flush()
+
+    def send_completion(self, response, model):
+        message = {'role': 'assistant', 'content': response.get('content', '')}
+        finish_reason = 'stop'
+        if response.get('tool_calls'):
+            message['content'] = None
+            message['tool_calls'] = [
+                {'id': 'call_%d' % i, 'type': 'function',
+                 'function': {'name': call['name'], 'arguments': tool_call_arguments(call)}}
+                for i, call in enumerate(response['tool_calls'])
+            ]
+            finish_reason = 'tool_calls'
+        document = {
+            'id': 'chatcmpl-mock',
+            'object': 'chat.completion',
+            'created': int(time.time()),
+            'model': model,
+            'choices': [{'index': 0, 'message': message, 'finish_reason': finish_reason}],
+            'usage': {'prompt_tokens': 0, 'completion_tokens': 0, 'total_tokens': 0},
+        }
+        data = json.dumps(document, ensure_ascii=False).encode('utf-8')
+
+        if response.get('transfer') != 'chunked':
+            self.send_head(200, 'application/json', {'Content-Length': str(len(data))})
+            self.wfile.write(data)
+            self.wfile.flush()
+            return
+        self.send_head(200, 'application/json', {'Transfer-Encoding': 'chunked'})
+        pieces = split_text(data.decode('utf-8'), response.get('chunks', 8))
+        for i, piece in enumerate(pieces):
+            if i:
+                time.sleep(response.get('chunk_ms', 0) / 1000.0)
+            self.write_chunk(piece.encode('utf-8'))
+        self.write_chunk(b'')
+
+    def send_stream(self, response, model):
+        self.send_head(200, 'text/event-stream', {'Transfer-Encoding': 'chunked', 'Cache-Control': 'no-cache'})
+        chunk_delay = response.get('chunk_ms', 0) / 1000.0
+        base = {'id': 'chatcmpl-mock', 'object': 'chat.completion.chunk', 'created': int(time.time()), 'model': model}
+
+        def event(payload):
+            text = payload if isinstance(payload, str) else json.dumps(payload, ensure_ascii=False)
+            self.write_chunk(('data: %s\n\n' % text).encode('utf-8'))
+
+        def delta(fields, finish_reason=None):
+            return dict(base, choices=[{'index': 0, 'delta': fields, 'finish_reason': finish_reason}])
+
+        self.write_chunk(b': keep-alive\n\n')
+        event(delta({'role': 'assistant', 'content': ''}))
+        finish_reason = 'stop'
+        if response.get('tool_calls'):
+            # 与 OpenAI 一致：首个事件带 id 和函数名，参数分多个事件发送
+            for index, call in enumerate(response['tool_calls']):
+                event(delta({'tool_calls': [{'index': index, 'id': 'call_%d' % index, 'type': 'function',
+                                             'function': {'name': call['name'], 'arguments': ''}}]}))
+                for piece in split_text(tool_call_arguments(call), response.get('chunks', 8)):
+                    time.sleep(chunk_delay)
+                    event(delta({'tool_calls': [{'index': index, 'function': {'arguments': piece}}]}))
+            finish_reason = 'tool_calls'
+        else:
+            for piece in split_text(response.get('content', ''), response.get('chunks', 8)):
+                time.sleep(chunk_delay)
+                event(delta({'content': piece}))
+        if response.get('error'):
+            event({'error': {'message': response['error'], 'type': 'mock_error'}})
+        else:
+            event(delta({}, finish_reason))
+            event('[DONE]')
+        self.write_chunk(b'')
+
+
+class MockProviderServer(ThreadingHTTPServer):
+    daemon_threads = True
+
+    def __init__(self, address, scenario, verbose=False):
+        super().__init__(address, MockProviderHandler)
+        self.scenario = scenario
+        self.verbose = verbose
+        self.stats = Stats()
+
+
+def start_server(scenario_path=None, host='127.0.0.1', port=0, verbose=False):
+    """在后台线程中启动服务器，返回服务器对象（server.server_address 为实际地址）"""
+    server = MockProviderServer((host, port), Scenario.load(scenario_path), verbose)
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    return server
+
+
+def main():
+    parser = argparse.ArgumentParser(description='OpenAI 兼容的本地模拟 LLM 提供商')
+    parser.add_argument('--host', default='127.0.0.1')
+    parser.add_argument('--port', type=int, default=8089)
+    parser.add_argument('--scenario', help='场景文件（JSON），缺省为固定延迟的文本回复')
+    parser.add_argument('--verbose', action='store_true', help='打印每个请求')
+    args = parser.parse_args()
+
+    server = MockProviderServer((args.host, args.port), Scenario.load(args.scenario), args.verbose)
+    print('Mock provider listening on %s:%d' % server.server_address)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    print(json.dumps(server.stats.snapshot()))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""
+系统提示词生成脚本
+将 prompts/ 目录下的提示词文本预先转义为 JSON 字符串字面量，生成 include/llm_prompts.h。
+固件发送请求时直接把这些字节写入连接，运行时无需拷贝到堆或再做 JSON 转义。
+高级模式提示中的 {{TOOLS}} 标记原样保留，由固件启动时替换为工具注册表生成的工具说明。
+
+PlatformIO 构建前自动执行（platformio.ini: extra_scripts = pre:generate_prompts.py），
+也可以手动运行：python generate_prompts.py
+"""
+
+import json
+import os
+from pathlib import Path
+
+# (提示词文件, 生成的常量名)
+PROMPTS = [
+    ('chat_prompt.md', 'LLM_CHAT_PROMPT_JSON'),
+    ('advanced_prompt.md', 'LLM_ADVANCED_PROMPT_JSON'),
+    ('native_prompt.md', 'LLM_NATIVE_PROMPT_JSON'),
+]
+
+HEADER_TEMPLATE = '''/**
+ * @file llm_prompts.h
+ * @brief 预转义的系统提示词（JSON 字符串字面量，含首尾引号）。
+ *
+ * 此文件由 generate_prompts.py 根据 prompts/ 目录自动生成，请勿手动修改。
+ * 常量位于 Flash 只读数据段，请求体写入时直接拼接，不经过堆内存。
+ */
+#ifndef LLM_PROMPTS_H
+#define LLM_PROMPTS_H
+
+{body}
+#endif // LLM_PROMPTS_H
+'''
+
+
+def to_c_literal(json_text):
+    """把 JSON 字符串字面量转换为多行 C 字符串字面量，在每个 \\n 转义后换行便于阅读"""
+    escaped = json_text.replace('\\', '\\\\').replace('"', '\\"')
+    lines = escaped.split('\\\\n')
+    parts = [line + '\\\\n' for line in lines[:-1]] + [lines[-1]]
+    return '\n'.join(f'    "{part}"' for part in parts if part)
+
+
+def generate(project_dir):
+    prompts_dir = project_dir / 'prompts'
+    output_path = project_dir / 'include' / 'llm_prompts.h'
+
+    blocks = []
+    for filename, name in PROMPTS:
+        # 编辑器通常会在文件末尾补一个换行，不属于提示词内容
+        text = (prompts_dir / filename).read_text(encoding='utf-8').rstrip('\n')
+        json_text = json.dumps(text, ensure_ascii=False)
+        blocks.append(
+            f'// 由 prompts/{filename} 生成（{len(text.encode("utf-8"))} 字节原文）\n'
+            f'static const char {name}[] =\n{to_c_literal(json_text)};\n'
+            f'static const size_t {name}_LEN = sizeof({name}) - 1;\n'
+        )
+
+    content = HEADER_TEMPLATE.format(body='\n'.join(blocks))
+
+    # 内容未变化时不重写，避免触发无谓的重新编译
+    if output_path.exists() and output_path.read_text(encoding='utf-8') == content:
+        return
+    output_path.write_text(content, encoding='utf-8')
+    print(f'Generated {output_path}')
+
+
+try:
+    Import('env')  # noqa: F821  由 PlatformIO 注入
+    generate(Path(env.subst('$PROJECT_DIR')))  # noqa: F821
+except NameError:
+    if __name__ == '__main__':
+        generate(Path(os.path.dirname(os.path.abspath(__file__))))
@@ -11,6 +11,7 @@ import (
 	"log"
 	"os"
 	"os/exec"
+	"sort"
 	"strings"
 	"sync"
 	"time"
@@ -38,6 +39,8 @@ type HostMessage struct {
 	RequestId string      `json:"requestId"` // 请求ID，用于跟踪消息
 	Type      string      `json:"type"`      // 消息类型
 	Payload   interface{} `json:"payload,omitempty"`
+	SessionId string      `json:"sessionId,omitempty"` // 会话ID，缺省共用设备上的 "cdc" 会话
+	Priority  string      `json:"priority,omitempty"`  // "background" 表示没有人在等待的请求
 }
 
 // WiFi连接请求的负载结构体
@@ -60,6 +63,9 @@ var (
 	portName   string      // 串口设备名称
 	mu         sync.Mutex  // 串口写入互斥锁
 	wifiStatus string      // WiFi连接状态
+
+	// 已收到流式增量的请求ID，收到最终 aiResponse 时只需换行结束
+	streamedRequests = make(map[string]bool)
 )
 
 // 初始化函数，设置命令行参数
@@ -226,6 +232,18 @@ func handleESP32Response(resp ESP32Response) {
 		}
 		fmt.Printf("[NOOX Shell] Executing: %s\n", command)
 		executeLocalShellCommand(command)
+	case "aiResponseDelta":
+		// 处理流式AI回复的增量片段，边收边打印
+		delta, ok := resp.Payload.(string)
+		if !ok {
+			log.Printf("Error: aiResponseDelta payload is not a string: %v", resp.Payload)
+			return
+		}
+		if !streamedRequests[resp.RequestId] {
+			streamedRequests[resp.RequestId] = true
+			fmt.Print("[NOOX AI] ")
+		}
+		fmt.Print(delta)
 	case "aiResponse":
 		// 处理AI回复消息
 		// Payload应该是AI生成的回复文本
@@ -234,7 +252,38 @@ func handleESP32Response(resp ESP32Response) {
 			log.Printf("Error: aiResponse payload is not a string: %v", resp.Payload)
 			return
 		}
+		if streamedRequests[resp.RequestId] {
+			// 内容已通过增量打印完毕
+			delete(streamedRequests, resp.RequestId)
+			fmt.Println()
+			return
+		}
 		fmt.Printf("[NOOX AI] %s\n", aiResponse)
+	case "metrics":
+		// 处理 LLM 请求指标（各阶段耗时统计），格式化后打印
+		pretty, err := json.MarshalIndent(resp.Payload, "", "  ")
+		if err != nil {
+			log.Printf("Error formatting metrics payload: %v", err)
+			return
+		}
+		fmt.Printf("[NOOX Metrics]\n%s\n", pretty)
+	case "metricsSnapshot":
+		// 处理指标注册表快照：按指标名排序，每行一个指标；直方图为 [次数, 总和, 各桶次数...]
+		snapshot, ok := resp.Payload.(map[string]interface{})
+		if !ok {
+			log.Printf("Error: metricsSnapshot payload is not an object: %v", resp.Payload)
+			return
+		}
+		names := make([]string, 0, len(snapshot))
+		for name := range snapshot {
+			names = append(names, name)
+		}
+		sort.Strings(names)
+		fmt.Println("[NOOX Stats]")
+		for _, name := range names {
+			value, _ := json.Marshal(snapshot[name])
+			fmt.Printf("  %s %s\n", name, value)
+		}
 	case "linkTestResult":
 		// Payload is the linkTest result string (e.g., "pong")
 		linkTestResult, ok := resp.Payload.(string)
@@ -279,6 +328,28 @@ func readFromStdin() {
 			continue
 		}
 
+		// "/metrics" 查询设备上的 LLM 请求指标，不作为用户输入发送
+		if strings.TrimSpace(input) == "/metrics" {
+			sendToESP32(HostMessage{RequestId: generateUUID(), Type: "getMetrics"})
+			continue
+		}
+		// "/stats" 查询设备上所有管理器的指标快照
+		if strings.TrimSpace(input) == "/stats" {
+			sendToESP32(HostMessage{RequestId: generateUUID(), Type: "getMetricsSnapshot"})
+			continue
+		}
+		// "/bg <文本>" 作为后台请求发送：使用独立的会话，不取代正在进行的对话，设备上排在交互请求之后
+		if text, ok := strings.CutPrefix(strings.TrimSpace(input), "/bg "); ok {
+			sendToESP32(HostMessage{
+				RequestId: generateUUID(),
+				Type:      "userInput",
+				Payload:   strings.TrimSpace(text),
+				SessionId: "background",
+				Priority:  "background",
+			})
+			continue
+		}
+
 		// 构造用户输入消息并发送给ESP32
 		msg := HostMessage{
 			RequestId: generateUUID(), // 生成唯一的请求ID
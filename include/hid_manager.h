@@ -6,6 +6,7 @@
 #include "USB.h"
 #include "USBHIDKeyboard.h"
 #include "USBHIDMouse.h"
+#include "metrics_registry.h"
 
 class HIDManager {
 public:
@@ -37,8 +38,13 @@ private:
     USBHIDMouse mouse;
     String lastError;
     bool ready;
+    MetricCounter* keyboardActions; // Keyboard actions sent (keys, strings, combinations)
+    MetricCounter* mouseActions;    // Mouse moves and clicks sent
+    MetricCounter* macros;          // Macros executed
+    MetricCounter* errors;          // Actions rejected (lastError set)
 
     // Helper methods
+    bool fail(const String& error); // Record lastError and count the failure; always returns false
     uint8_t parseModifier(const String& modifier);
     uint8_t parseSpecialKeyCode(const String& keyName);
     uint8_t parseMediaKeyCode(const String& mediaKey);
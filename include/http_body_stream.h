@@ -0,0 +1,123 @@
+/**
+ * @file http_body_stream.h
+ * @brief 按 HTTP 分帧方式读取响应体的 Stream 适配器。
+ *
+ * 长连接下响应体可能使用 chunked 编码，
+ * 也可能只以 Content-Length 界定结束。该适配器负责去掉分帧，只输出响应体本身，
+ * 使 ArduinoJson 可以直接从网络流上反序列化，无需先把整个响应读入缓冲区。
+ * 分帧本身由与平台无关的 HttpResponseParser 完成，这里只负责从连接读取和等待数据。
+ */
+#ifndef HTTP_BODY_STREAM_H
+#define HTTP_BODY_STREAM_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include "http_response_parser.h"
+
+/**
+ * @brief 读取响应时的中止条件：取消标志被置位或超过截止时间后，等待数据的循环立即返回。
+ */
+struct HttpAbortSignal {
+    const volatile bool* cancelled; ///< 取消标志，可为 nullptr
+    unsigned long deadline;         ///< 截止时间（millis），0 表示不限
+
+    /**
+     * @brief 是否应当中止读取
+     */
+    bool triggered() const {
+        return (cancelled && *cancelled) || (deadline != 0 && (long)(millis() - deadline) >= 0);
+    }
+};
+
+/**
+ * @brief 去除 HTTP/1.1 分帧的响应体读取流。
+ *
+ * 支持三种结束方式：Content-Length、chunked、服务器关闭连接。
+ */
+class HttpBodyStream : public Stream {
+public:
+    /**
+     * @brief 构造函数
+     * @param client 已读取完响应头的连接
+     * @param contentLength 响应头中的 Content-Length，未知时为 -1
+     * @param chunked 是否为 Transfer-Encoding: chunked
+     * @param timeoutMs 等待下一段数据的超时（毫秒）
+     */
+    HttpBodyStream(Client& client, int contentLength, bool chunked, unsigned long timeoutMs);
+
+    /**
+     * @brief 使用解析好的响应头构造
+     */
+    HttpBodyStream(Client& client, const HttpResponseHead& head, unsigned long timeoutMs);
+
+    /**
+     * @brief 读取并解析响应状态行和响应头（跳过 1xx 临时响应）
+     * @param client 已发送完请求的连接
+     * @param head 输出的响应头字段
+     * @param timeoutMs 等待响应头的超时（毫秒）
+     * @param abortSignal 中止条件，可为 nullptr
+     * @return 成功读取完整响应头时返回 true
+     */
+    static bool readHead(Client& client, HttpResponseHead& head, unsigned long timeoutMs,
+                         const HttpAbortSignal* abortSignal = nullptr);
+
+    int available();
+    int read();
+    int peek();
+    size_t readBytes(char* buffer, size_t length);
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+    size_t write(uint8_t) { return 0; }
+
+    /**
+     * @brief 读取并丢弃剩余的响应体，使连接停在下一条响应之前，可被复用。
+     * @return 响应体完整结束时返回 true
+     */
+    bool drain();
+
+    /**
+     * @brief 放弃读取剩余响应体（例如调用方已超时），之后 drain() 立即返回 false
+     */
+    void abort() { failed = true; }
+
+    /**
+     * @brief 设置中止条件：触发后正在等待的读取立即失败，drain() 返回 false
+     * @param signal 中止条件（须在流的生命周期内有效），nullptr 表示取消设置
+     */
+    void setAbortSignal(const HttpAbortSignal* signal) { abortSignal = signal; }
+
+    bool isComplete() const { return parser.isComplete() && !failed; } ///< 响应体是否已完整读取
+    bool hasFailed() const { return failed; }               ///< 是否因超时、断开或分帧错误而中止
+    size_t getBytesRead() const { return totalRead; }       ///< 已读取的响应体字节数
+    uint32_t getWaitMicros() const { return waitMicros; }   ///< 阻塞等待网络数据的累计时间（微秒）
+
+private:
+    Client& client;
+    HttpResponseParser parser; ///< 分帧状态机
+    bool failed;             ///< 超时、中止、断开或分帧错误
+    unsigned long timeoutMs;
+    size_t totalRead;
+    uint32_t waitMicros;     ///< 阻塞等待网络数据的累计时间
+    const HttpAbortSignal* abortSignal;
+
+    uint8_t buffer[256];     ///< 从连接读取的原始字节，响应体就地输出
+    size_t rawPos;           ///< 尚未交给状态机的原始字节起点
+    size_t rawLen;
+    size_t bodyPos;          ///< 当前响应体片段的读取位置（buffer 内）
+    size_t bodyEnd;
+
+    /**
+     * @brief 当前片段读完时，从连接读取并解析出下一段响应体
+     * @param block 没有数据时是否等待（最多 timeoutMs）
+     * @return 缓冲区中有响应体数据时返回 true
+     */
+    bool fill(bool block = true);
+
+    /**
+     * @brief 等待连接上有数据可读，并累计等待时间
+     */
+    bool waitForData();
+
+    static bool waitForData(Client& client, unsigned long timeoutMs, const HttpAbortSignal* abortSignal, bool& timedOut);
+};
+
+#endif // HTTP_BODY_STREAM_H
@@ -0,0 +1,63 @@
+/**
+ * @file http_chunked_writer.h
+ * @brief 以 chunked 传输编码把请求体直接写入连接的 Print 适配器。
+ *
+ * 请求体边生成边发送，内存占用只取决于块缓冲区大小，与请求体总长度无关。
+ */
+#ifndef HTTP_CHUNKED_WRITER_H
+#define HTTP_CHUNKED_WRITER_H
+
+#include <Arduino.h>
+#include <Client.h>
+
+/**
+ * @brief Transfer-Encoding: chunked 请求体写入器。
+ *
+ * 写入的数据先攒在块缓冲区中，缓冲区满时作为一个块发送；finish() 发送剩余数据和结束块。
+ */
+class HttpChunkedWriter : public Print {
+public:
+    /**
+     * @brief 构造函数
+     * @param client 已发送完请求头的连接
+     */
+    HttpChunkedWriter(Client& client);
+
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* buffer, size_t size);
+
+    /**
+     * @brief 写入 JSON 字符串字面量（加引号并转义），无需先构造 JsonDocument
+     * @param str UTF-8 字符串，nullptr 视为空字符串
+     * @return 写入的字节数
+     */
+    size_t writeJsonString(const char* str);
+
+    /**
+     * @brief 发送缓冲区中剩余的数据和结束块（0\r\n\r\n）
+     * @return 所有数据都已成功写入连接时返回 true
+     */
+    bool finish();
+
+    bool hasFailed() const { return failed; }          ///< 是否有写入失败（连接已断开）
+    size_t getBytesWritten() const { return total; }   ///< 已写入的请求体字节数（不含分帧）
+
+private:
+    static const size_t CHUNK_SIZE = 1024;
+    static const size_t HEADER_RESERVE = 8;   ///< 十六进制长度行的预留空间（"400\r\n" 右对齐放在数据前）
+    static const size_t TRAILER_RESERVE = 7;  ///< 块尾 CRLF 加结束块 "0\r\n\r\n"
+
+    Client& client;
+    uint8_t buffer[HEADER_RESERVE + CHUNK_SIZE + TRAILER_RESERVE]; ///< 长度行、数据、块尾连续存放，一次 write 发出
+    size_t length;
+    size_t total;
+    bool failed;
+
+    /**
+     * @brief 把缓冲区作为一个块发送（一次 client.write，即一条 TLS 记录）
+     * @param last 为 true 时在同一次写入中附带结束块
+     */
+    void flushChunk(bool last = false);
+};
+
+#endif // HTTP_CHUNKED_WRITER_H
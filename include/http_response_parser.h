@@ -0,0 +1,124 @@
+/**
+ * @file http_response_parser.h
+ * @brief 与平台无关的 HTTP/1.1 响应分帧状态机。
+ *
+ * 按字节块推入原始响应，解析状态行和响应头，并按 Content-Length、chunked
+ * 或连接关闭三种方式界定响应体，响应体一结束立即进入完成状态。
+ * 只依赖 C 标准库，不读写网络，便于在主机上用录制的响应验证。
+ */
+#ifndef HTTP_RESPONSE_PARSER_H
+#define HTTP_RESPONSE_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 解析后的 HTTP 响应头中与读取响应体相关的字段。
+ */
+struct HttpResponseHead {
+    int statusCode;      ///< 状态码，读取失败时为 -1
+    int contentLength;   ///< Content-Length，未提供时为 -1
+    bool chunked;        ///< Transfer-Encoding 是否为 chunked
+    bool keepAlive;      ///< 响应结束后连接是否可复用
+};
+
+/**
+ * @brief HTTP/1.1 响应分帧状态机。
+ *
+ * 用法：反复调用 feed() 推入收到的字节；每次调用最多报告一段连续的响应体
+ * （位于输入缓冲区内，不做拷贝）。状态行和响应头解析完成后 feed() 也会立即返回，
+ * 调用方可以据此只读取响应头。
+ */
+class HttpResponseParser {
+public:
+    /**
+     * @brief 解析状态
+     */
+    enum State : uint8_t {
+        STATUS_LINE,      ///< 等待状态行
+        HEADER_LINE,      ///< 读取响应头
+        BODY_LENGTH,      ///< 按 Content-Length 读取响应体
+        BODY_UNTIL_CLOSE, ///< 读到连接关闭为止
+        CHUNK_SIZE,       ///< 读取块头
+        CHUNK_DATA,       ///< 读取块数据
+        CHUNK_DATA_END,   ///< 块数据后的 CRLF
+        TRAILER,          ///< 末尾块之后的 trailer
+        COMPLETE,         ///< 响应体已完整结束
+        FAILED            ///< 分帧错误或连接提前关闭
+    };
+
+    /**
+     * @brief 构造函数：从状态行开始解析
+     */
+    HttpResponseParser();
+
+    /**
+     * @brief 重置为从状态行开始解析
+     */
+    void reset();
+
+    /**
+     * @brief 跳过状态行和响应头，直接按已知的响应头读取响应体
+     * @param contentLength Content-Length，未知时为 -1
+     * @param chunked 是否为 Transfer-Encoding: chunked
+     */
+    void beginBody(int contentLength, bool chunked);
+
+    /**
+     * @brief 推入收到的字节
+     * @param data 输入数据
+     * @param length 输入长度
+     * @param bodyOffset 输出：本次报告的响应体在 data 中的偏移
+     * @param bodyLength 输出：本次报告的响应体长度，0 表示没有响应体数据
+     * @return 消耗的输入字节数；报告了响应体、响应头刚好结束或进入终止状态时提前返回
+     */
+    size_t feed(const uint8_t* data, size_t length, size_t& bodyOffset, size_t& bodyLength);
+
+    /**
+     * @brief 连接已关闭：读到关闭为止的响应体正常结束，其余状态视为中断
+     */
+    void finishOnClose();
+
+    /**
+     * @brief 下一次最多应从连接读取的字节数，保证不会读过本条响应的末尾（长连接可复用）。
+     *        读取分帧行时为 1，读取数据时为剩余长度。
+     */
+    size_t readLimit() const;
+
+    State getState() const { return state; }                          ///< 当前状态
+    bool isHeadComplete() const { return headComplete; }              ///< 响应头是否已解析完成
+    bool isComplete() const { return state == COMPLETE; }             ///< 响应体是否已完整结束
+    bool hasFailed() const { return state == FAILED; }                ///< 是否出错
+    const HttpResponseHead& getHead() const { return head; }          ///< 解析出的响应头
+    const char* getError() const { return error; }                    ///< 出错原因（未出错时为空字符串）
+
+private:
+    State state;
+    HttpResponseHead head;
+    bool headComplete;
+    size_t remaining;      ///< BODY_LENGTH 模式下剩余字节
+    size_t chunkRemaining; ///< 当前块剩余字节
+    char line[128];        ///< 正在累积的状态行/响应头/块头，超长部分丢弃
+    size_t lineLength;
+    const char* error;
+
+    /**
+     * @brief 累积一个字节到当前行
+     * @return 读到换行（一行结束）时返回 true
+     */
+    bool appendLineByte(uint8_t c);
+
+    /**
+     * @brief 处理一行完整的状态行、响应头、块头或 trailer
+     */
+    void handleLine();
+
+    /**
+     * @brief 响应头结束后按响应头进入对应的响应体状态
+     */
+    void enterBody();
+
+    void fail(const char* reason);
+};
+
+#endif // HTTP_RESPONSE_PARSER_H
@@ -0,0 +1,101 @@
+/**
+ * @file llm_connection_pool.h
+ * @brief LLM 提供商的 TLS 长连接池。
+ *
+ * 每个提供商主机保持一条已完成握手的 LLMTlsClient 连接，跨请求复用，
+ * 省去每次请求的 DNS、TCP 和 TLS 握手开销。复用前检测半关闭或空闲过久的连接，
+ * 必要时重新建立连接。
+ */
+#ifndef LLM_CONNECTION_POOL_H
+#define LLM_CONNECTION_POOL_H
+
+#include <Arduino.h>
+#include "llm_tls_client.h"
+#include "metrics_registry.h"
+
+/**
+ * @brief 池中的单条连接。
+ */
+struct LLMPooledConnection {
+    String host;                 ///< 提供商主机名
+    LLMTlsClient* client;    ///< TLS 客户端（池拥有）
+    unsigned long lastUsed;      ///< 上次归还的时间（millis）
+};
+
+/**
+ * @brief 连接池的复用统计，由所有工作任务的连接池共享（导出到 /metrics）。
+ */
+struct LLMConnectionPoolMetrics {
+    MetricCounter* hits;    ///< 复用已有连接、省去握手的次数
+    MetricCounter* misses;  ///< 需要重新拨号的次数
+    MetricCounter* redials; ///< 复用连接失效后重拨的次数
+};
+
+/**
+ * @brief 按主机保持 TLS 长连接的连接池。
+ *
+ * 单线程使用：由持有它的 LLM 任务独占访问。
+ */
+class LLMConnectionPool {
+public:
+    /**
+     * @brief 构造函数
+     * @param sessionCache 新建客户端共享的 TLS 会话缓存
+     * @param metrics 复用统计计数器（注册表中的指标，池不拥有）
+     * @param maxHosts 最多保持连接的主机数量
+     */
+    LLMConnectionPool(LLMTlsSessionCache* sessionCache, const LLMConnectionPoolMetrics& metrics, size_t maxHosts = 3);
+
+    /**
+     * @brief 析构函数，关闭并释放所有连接
+     */
+    ~LLMConnectionPool();
+
+    /**
+     * @brief 获取指定主机的客户端。
+     *        若池中连接仍然可用则直接复用（命中），否则返回一个未连接的客户端，
+     *        由调用方负责重新建立连接（未命中）。
+     * @param host 提供商主机名
+     * @param reused 输出参数，返回的客户端是否为仍然存活的复用连接
+     * @return 客户端指针；池已满且无法分配时返回 nullptr
+     */
+    LLMTlsClient* acquire(const String& host, bool& reused);
+
+    /**
+     * @brief 请求结束后归还客户端。
+     *        连接仍然存活时保留以供下次复用，否则关闭。
+     * @param client acquire 返回的客户端
+     */
+    void release(LLMTlsClient* client);
+
+    /**
+     * @brief 丢弃指定客户端当前的连接（例如复用的连接在发送时已失效）。
+     *        客户端本身保留在池中，下一次 connect 会重新拨号。
+     * @param client acquire 返回的客户端
+     */
+    void invalidate(LLMTlsClient* client);
+
+    /**
+     * @brief 关闭所有连接（例如 WiFi 断开或配置变更后）
+     */
+    void closeAll();
+
+private:
+    LLMPooledConnection* connections; ///< 连接数组
+    LLMTlsSessionCache* sessionCache; ///< TLS 会话缓存（不拥有）
+    size_t capacity;                  ///< 最大主机数量
+    size_t count;                     ///< 当前主机数量
+    LLMConnectionPoolMetrics metrics; ///< 复用统计
+
+    /**
+     * @brief 判断池中连接是否仍可复用（未关闭、未闲置过久、无残留数据）
+     */
+    bool isReusable(LLMPooledConnection& conn);
+
+    /**
+     * @brief 查找客户端对应的连接项
+     */
+    LLMPooledConnection* find(LLMTlsClient* client);
+};
+
+#endif // LLM_CONNECTION_POOL_H
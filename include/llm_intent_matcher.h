@@ -0,0 +1,123 @@
+/**
+ * @file llm_intent_matcher.h
+ * @brief 本地意图匹配：简单的设备命令不经过 LLM，直接转换为工具调用。
+ *
+ * 规则由模式和工具调用模板组成，例如 "turn on {gpio:led1|led2|led3}" → gpio_set。
+ * 只有整句完全符合某条模式时才算命中，其余输入照常交给 LLM。
+ * 模式语法（按空白分词，字面词不区分大小写）：
+ *   - word          字面词
+ *   - {name}        任意一个词
+ *   - {name:a|b|c}  列出的词之一
+ *   - {name:int}    一个整数
+ *   - {name...}     剩余的全部输入（只能放在末尾）
+ */
+#ifndef LLM_INTENT_MATCHER_H
+#define LLM_INTENT_MATCHER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+class LLMToolRegistry;
+
+/**
+ * @brief 本地意图匹配器（线程安全，所有工作任务共享）。
+ */
+class LLMIntentMatcher {
+public:
+    static const size_t MAX_RULES = 24;          ///< 最多规则数
+    static const size_t MAX_PATTERN_TOKENS = 8;  ///< 每条模式最多的词数
+    static const size_t MAX_INPUT_TOKENS = 16;   ///< 超过该词数的输入不尝试匹配
+
+    /**
+     * @brief 构造函数
+     */
+    LLMIntentMatcher();
+
+    /**
+     * @brief 析构函数
+     */
+    ~LLMIntentMatcher();
+
+    /**
+     * @brief 从配置加载规则。没有配置 rules 时使用内置规则；工具未注册或模式无效的规则被跳过
+     * @param config llm_settings.intents 配置对象
+     * @param registry 工具注册表，用于检查规则中的工具名
+     */
+    void configure(JsonObject config, const LLMToolRegistry& registry);
+
+    bool isEnabled() const { return enabled; } ///< 是否启用
+
+    /**
+     * @brief 尝试匹配一条输入
+     * @param input 用户输入
+     * @param toolCalls 命中时输出 {"tool_calls":[{"name":...,"args":{...}}]}，与 LLM 的工具调用回复格式相同
+     * @return 整句命中某条规则时返回 true
+     */
+    bool match(const String& input, String& toolCalls);
+
+    /**
+     * @brief 以 JSON 输出匹配统计：尝试次数、命中次数、命中率、平均匹配耗时和各规则命中次数
+     * @param out 输出对象
+     */
+    void writeStats(JsonObject out);
+
+private:
+    /**
+     * @brief 模式中的一个词
+     */
+    enum TokenKind : uint8_t {
+        TOKEN_LITERAL, ///< 字面词
+        TOKEN_WORD,    ///< 任意一个词
+        TOKEN_CHOICE,  ///< 列出的词之一
+        TOKEN_INTEGER, ///< 整数
+        TOKEN_REST     ///< 剩余的全部输入
+    };
+
+    struct PatternToken {
+        TokenKind kind;
+        String text;    ///< 字面词（小写）或可选词（小写，'|' 分隔）
+        String slot;    ///< 槽位名
+    };
+
+    /**
+     * @brief 编译后的规则
+     */
+    struct Rule {
+        String pattern;        ///< 原始模式
+        String tool;           ///< 工具名
+        String argsTemplate;   ///< 参数模板（JSON），值为 "{槽位名}" 的字段被替换
+        PatternToken tokens[MAX_PATTERN_TOKENS];
+        uint8_t tokenCount;
+        uint32_t hits;
+    };
+
+    Rule* rules;               ///< 规则表（按配置的规则数分配）
+    size_t ruleCount;
+    bool enabled;
+    SemaphoreHandle_t lock;
+
+    uint32_t attempts;         ///< 尝试匹配的输入数
+    uint32_t hits;             ///< 命中的输入数
+    uint64_t matchMicros;      ///< 累计匹配耗时（含未命中）
+
+    /**
+     * @brief 编译一条模式
+     * @return 模式有效（至少包含一个字面词）时返回 true
+     */
+    static bool compile(const String& pattern, Rule& rule);
+
+    /**
+     * @brief 用一条规则匹配已分词的输入，命中时生成工具调用
+     */
+    static bool matchRule(const Rule& rule, const String& input, const uint16_t* starts, const uint16_t* ends,
+                          size_t tokenCount, String& toolCalls);
+
+    /**
+     * @brief 加入一条规则
+     */
+    void addRule(JsonObject ruleConfig, const LLMToolRegistry& registry);
+};
+
+#endif // LLM_INTENT_MATCHER_H
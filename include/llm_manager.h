@@ -13,10 +13,27 @@
 #include <ArduinoJson.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
+#include <freertos/semphr.h>
 #include "config_manager.h"
 #include "wifi_manager.h" // Include AppWiFiManager header
+#include "llm_metrics.h"  // LLMRequestTiming
+#include "metrics_registry.h"
 
 // Forward declarations
+class Client;
+class HttpBodyStream;
+class LLMConnectionPool;
+class LLMTlsSessionCache;
+class LLMSessionTable;
+class LLMRequestScheduler;
+class LLMResponseCache;
+class LLMProviderRouter;
+class LLMToolRegistry;
+class LLMIntentMatcher;
+class LLMTlsClient;
+struct LLMRoute;
+struct HttpResponseHead;
+struct HttpAbortSignal;
 class UsbShellManager;
 class HIDManager;
 class HardwareManager;
@@ -38,12 +55,29 @@ enum LLMMode {
     ADVANCED_MODE   ///< 高级模式，用于需要工具调用的复杂任务，如Shell通信
 };
 
+/**
+ * @brief 请求优先级类别（数值越小优先级越高），由 LLMRequestScheduler 调度
+ */
+enum LLMPriority : uint8_t {
+    PRIORITY_INTERACTIVE = 0, ///< 用户正在等待的输入（Web 聊天、主机 userInput）
+    PRIORITY_FOLLOW_UP = 1,   ///< 代理自动发起的后续请求（Shell 执行结果回传）
+    PRIORITY_BACKGROUND = 2,  ///< 后台任务，没有用户在等待
+    PRIORITY_CLASS_COUNT = 3
+};
+
 /**
  * @brief 定义发送到 LLM 任务队列的请求结构体。
  * 使用固定大小char数组和PSRAM指针以避免String浅拷贝导致的堆损坏。
  */
 struct LLMRequest {
     char requestId[64];         ///< 请求ID，用于关联响应（固定大小）
+    char sessionKey[48];        ///< 会话键，决定使用哪一份对话历史（如 "ws:3"、"web:<id>"、"cdc"）
+    uint32_t clientId;          ///< 发起请求的 WebSocket 客户端ID，0 表示非 Web 请求
+    uint32_t seq;               ///< 请求序号，同时作为取消令牌：不大于会话取消点的请求被丢弃
+    unsigned long deadline;     ///< 截止时间（millis），超过后请求被中止或出队时直接丢弃
+    unsigned long enqueuedAt;   ///< 进入调度器的时间（millis），用于老化和等待时间统计
+    LLMPriority priority;       ///< 优先级类别
+    int16_t userTextOffset;     ///< 用户原文在 prompt 中的起始位置，用于本地意图匹配；-1 表示 prompt 不是用户输入
     char* prompt;               ///< 用户输入的提示或上下文（PSRAM指针，接收方需释放）
     LLMMode mode;               ///< LLM 的操作模式
 };
@@ -54,39 +88,76 @@ struct LLMRequest {
  */
 struct LLMResponse {
     char requestId[64];         ///< 请求ID，用于关联响应（固定大小）
+    uint32_t clientId;          ///< 发起请求的 WebSocket 客户端ID，0 表示广播给所有客户端
     bool isToolCall;            ///< 指示响应是否为工具调用
-    char toolName[32];          ///< 如果是工具调用，则为工具名称（固定大小）
-    char* toolArgs;             ///< 如果是工具调用，则为工具参数的JSON字符串（PSRAM指针，接收方需释放）
+    char* toolResults;          ///< 如果是工具调用，则为本轮所有调用结果的 JSON 数组 [{"name","args","ok","result"}]（PSRAM指针，接收方需释放）
     char* naturalLanguageResponse; ///< 如果是自然语言回复，则为回复内容（PSRAM指针，接收方需释放）
 };
 
 /**
- * @brief 对话消息结构（使用PSRAM）
+ * @brief 流式模式下从 LLM 任务发往 WebManager 的增量文本。
+ * 每条增量是若干 SSE 内容片段合并后的结果，用于尽早把首个 token 推送给前端。
+ */
+struct LLMStreamDelta {
+    char requestId[64];         ///< 请求ID，用于关联响应（固定大小）
+    uint32_t clientId;          ///< 发起请求的 WebSocket 客户端ID，0 表示广播给所有客户端
+    char* text;                 ///< 增量文本（PSRAM指针，接收方需释放）
+};
+
+/**
+ * @brief 对话消息角色（存储为单字节）
+ */
+enum ConversationRole : uint8_t {
+    ROLE_USER = 0,      ///< 用户输入
+    ROLE_ASSISTANT = 1  ///< AI 回复
+};
+
+/**
+ * @brief 对话消息的索引项，内容本身存放在 ConversationHistory 的环形内存区中
  */
 struct ConversationMessage {
-    char* role;      ///< 消息角色："user" 或 "assistant"
-    char* content;   ///< 消息内容（PSRAM指针）
+    uint32_t offset;        ///< 内容在环形内存区中的偏移
+    uint32_t length;        ///< 内容长度（不含结尾 '\0'）
+    uint32_t tokens;        ///< 存入时估算的 token 数（含消息结构开销）
+    ConversationRole role;  ///< 消息角色
 };
 
 /**
  * @brief 对话历史管理类
  * 
- * 使用环形缓冲区存储最近的对话消息，超过容量时自动覆盖最旧的消息。
- * 所有消息内容存储在PSRAM中，避免DRAM压力。
+ * 消息内容连续存放在一块预先分配的 PSRAM 环形内存区中，添加消息时写入头部，
+ * 空间或条数不足时从尾部淘汰最旧的消息，运行期间不再调用分配器，避免 PSRAM 碎片化。
+ * 每条消息存入时估算 token 数，发送请求时只取预算内最新的若干条。
  */
 class ConversationHistory {
 private:
-    ConversationMessage* messages;  ///< PSRAM数组，存储消息
-    size_t capacity;                ///< 最大容量（默认40条消息）
+    ConversationMessage* messages;  ///< 消息索引环形数组（PSRAM）
+    size_t capacity;                ///< 最大消息条数（默认60条）
     size_t count;                   ///< 当前消息数量
-    size_t startIndex;              ///< 环形缓冲区起始索引
+    size_t startIndex;              ///< 最旧消息在索引数组中的位置
+    char* arena;                    ///< 内容环形内存区（PSRAM）
+    size_t arenaSize;               ///< 内存区大小（字节）
+    size_t head;                    ///< 下一条内容的写入偏移
+    size_t truncatedMessages;       ///< 因超过内存区大小被截断的消息数
+
+    /**
+     * @brief 淘汰最旧的一条消息
+     */
+    void evictOldest();
+
+    /**
+     * @brief 为长度为 size 的内容（含 '\0'）找到连续空间，必要时淘汰旧消息
+     * @return 写入偏移
+     */
+    size_t reserve(size_t size);
     
 public:
     /**
      * @brief 构造函数
-     * @param maxMessages 最大消息数量，默认40（支持约20轮对话）
+     * @param maxMessages 最大消息数量，默认60（支持约30轮对话）
+     * @param arenaBytes 内容环形内存区大小，默认256KB
      */
-    ConversationHistory(size_t maxMessages = 40);
+    ConversationHistory(size_t maxMessages = 60, size_t arenaBytes = 262144);
     
     /**
      * @brief 析构函数，释放所有分配的内存
@@ -94,11 +165,11 @@ public:
     ~ConversationHistory();
     
     /**
-     * @brief 添加新消息到历史
-     * @param role 消息角色（"user" 或 "assistant"）
+     * @brief 添加新消息到历史（超过内存区大小的内容会被截断）
+     * @param role 消息角色
      * @param content 消息内容
      */
-    void addMessage(const String& role, const String& content);
+    void addMessage(ConversationRole role, const String& content);
     
     /**
      * @brief 清除所有对话历史
@@ -112,10 +183,83 @@ public:
     size_t getMessageCount() const;
     
     /**
-     * @brief 将所有历史消息填充到JSON数组中
-     * @param messagesArray 目标JSON数组
+     * @brief 按时间顺序获取第 index 条消息（0 为最旧）
+     * @param index 消息序号，需小于 getMessageCount()
+     * @return 消息指针；越界时返回 nullptr
      */
-    void getMessages(JsonArray& messagesArray);
+    const ConversationMessage* getMessage(size_t index) const;
+
+    /**
+     * @brief 获取消息内容（指向环形内存区，下一次 addMessage 之前有效）
+     * @param msg getMessage 返回的索引项
+     * @return 以 '\0' 结尾的内容
+     */
+    const char* getContent(const ConversationMessage& msg) const { return arena + msg.offset; }
+
+    /**
+     * @brief 获取角色在 API 请求中的名称
+     * @param role 消息角色
+     * @return "user" 或 "assistant"
+     */
+    static const char* roleName(ConversationRole role) { return role == ROLE_ASSISTANT ? "assistant" : "user"; }
+
+    /**
+     * @brief 获取内存区已用字节数（含因回绕留下的空隙）
+     */
+    size_t getArenaUsed() const;
+
+    /**
+     * @brief 获取内存区大小，分配失败时为 0
+     */
+    size_t getArenaSize() const { return arena ? arenaSize : 0; }
+
+    /**
+     * @brief 在 token 预算内，从最新消息向前选取尽可能多的历史消息
+     *        （若选取结果以 assistant 消息开头则跳过它，保证历史从一轮用户输入开始）
+     * @param tokenBudget 可用于历史的 token 预算
+     * @param usedTokens 输出参数，选中消息的 token 总数
+     * @return 第一条选中消息的序号；返回 getMessageCount() 表示不发送历史
+     */
+    size_t getFirstIndexWithinBudget(size_t tokenBudget, size_t& usedTokens) const;
+
+    /**
+     * @brief 粗略估算文本的 token 数：ASCII 约 4 字节一个 token，
+     *        中日韩等多字节字符按每个字符一个 token 计算（偏保守）
+     * @param text UTF-8 文本
+     * @return 估算的 token 数
+     */
+    static size_t estimateTokens(const char* text);
+};
+
+/**
+ * @brief LLM 工作任务的上下文。
+ *        每个工作任务独占一个连接池，可以与其他任务并行请求提供商；
+ *        同一会话的请求由正在处理该会话的任务依次处理，保证顺序。
+ */
+struct LLMWorkerContext {
+    uint8_t index;                     ///< 工作任务编号
+    LLMConnectionPool* connectionPool; ///< 该任务独占的 TLS 长连接池
+    QueueHandle_t backlog;             ///< 转交给该任务的同会话后续请求
+    volatile size_t queued;            ///< 已转交给该任务、尚未开始处理的请求数
+    char sessionKey[48];               ///< 正在处理的会话键，空字符串表示空闲
+    ConversationHistory* history;      ///< 当前请求所属会话的对话历史（仅在处理请求期间有效）
+    uint32_t clientId;                 ///< 当前请求的 WebSocket 客户端ID
+    uint32_t seq;                      ///< 当前请求的序号
+    unsigned long deadline;            ///< 当前请求的截止时间（millis）
+    volatile bool cancelled;           ///< 当前请求已被取消，读取循环应立即退出
+    LLMRequestTiming timing;           ///< 当前请求各阶段的耗时
+};
+
+/**
+ * @brief 会话取消点：该会话中序号不大于 seq 的请求一律丢弃。
+ *
+ * 只为还有未出队请求（在调度队列中或已转交给某个工作任务）的会话保留；
+ * pending 归零后该项空闲，可被其他会话使用，不会覆盖仍然需要的取消点。
+ */
+struct LLMCancelMark {
+    char sessionKey[48];
+    uint32_t seq;      ///< 取消点，0 表示未取消
+    uint8_t pending;   ///< 已提交、尚未开始执行或丢弃的请求数；0 表示空闲
 };
 
 /**
@@ -145,38 +289,126 @@ public:
 
     /**
      * @brief LLM aysnc loop.
-     *        It constantly waits for and retrieves requests from llmRequestQueue,
+     *        It constantly retrieves the highest-priority request from the scheduler,
      *        calls generateResponse to process the request, and then puts the result into llmResponseQueue.
+     *        Each worker task calls this with its own index; requests for a session that another
+     *        worker is already processing are handed over to that worker to keep them in order.
+     *        With more than one worker, worker 0 only serves interactive requests so that a user
+     *        typing never waits behind a long agent loop.
+     * @param workerIndex 工作任务编号（0 ~ getWorkerCount()-1）。
      */
-    void loop();
+    void loop(uint8_t workerIndex);
+
+    /**
+     * @brief 获取工作任务数（首次 begin() 时按配置 llm_settings.workers 和剩余内存确定）。
+     */
+    uint8_t getWorkerCount() const { return workerCount; }
+
+    static const uint32_t WORKER_STACK_SIZE = 8192 * 4; ///< 每个工作任务的栈大小（字节）
 
     /**
      * @brief 处理来自主机的用户输入。
      *        此方法将用户输入打包成一个 LLMRequest，发送到请求队列。
      * @param requestId 请求ID。
+     * @param sessionKey 会话键（"cdc" 或 "cdc:<sessionId>"）。
      * @param userInput 用户输入的字符串。
+     * @param priority 优先级类别（主机可把没有人等待的输入标为后台请求）。
      */
-    void processUserInput(const String& requestId, const String& userInput);
+    void processUserInput(const String& requestId, const String& sessionKey, const String& userInput,
+                          LLMPriority priority = PRIORITY_INTERACTIVE);
 
     /**
      * @brief 处理来自主机的 Shell 命令执行结果。
      *        此方法将命令的输出作为上下文，打包成一个新的 LLMRequest 发送到队列。
      * @param requestId 请求ID。
+     * @param sessionKey 会话键（"cdc" 或 "cdc:<sessionId>"）。
      * @param cmd 已执行的 Shell 命令。
      * @param output 命令的标准输出。
      * @param error 命令的标准错误。
      * @param status 命令执行状态（"success"或"error"）。
      * @param exitCode 命令的退出码。
      */
-    void processShellOutput(const String& requestId, const String& cmd, const String& output, const String& error, const String& status, int exitCode);
+    void processShellOutput(const String& requestId, const String& sessionKey, const String& cmd, const String& output, const String& error, const String& status, int exitCode);
 
     String getCurrentModelName(); // Added to get current LLM model name
     
     /**
-     * @brief 清除对话历史
-     *        清除所有已保存的对话消息，重置对话上下文
+     * @brief 将一个请求放入 LLM 请求队列。
+     * @param requestId 请求ID。
+     * @param sessionKey 会话键，决定使用哪一份对话历史。
+     * @param prompt 用户输入。
+     * @param mode LLM 的操作模式。
+     * @param clientId 发起请求的 WebSocket 客户端ID，0 表示非 Web 请求。
+     * @param priority 优先级类别。
+     * @param userTextOffset 用户原文在 prompt 中的起始位置（本地意图只匹配这部分）；
+     *        NO_USER_TEXT 表示 prompt 不是用户输入（如 Shell 结果的后续请求），不做意图匹配。
+     * @return 成功入队返回 true。
+     */
+    bool createAndSendRequest(const String& requestId, const String& sessionKey, const String& prompt, LLMMode mode,
+                              uint32_t clientId = 0, LLMPriority priority = PRIORITY_INTERACTIVE,
+                              int16_t userTextOffset = 0);
+
+    static const int16_t NO_USER_TEXT = -1; ///< createAndSendRequest() 的 userTextOffset：prompt 中没有用户原文
+
+    /**
+     * @brief 以 JSON 输出调度器各优先级类别的排队情况和等待时间直方图
+     * @param out 输出对象
+     */
+    void writeSchedulerStats(JsonObject out);
+
+    /**
+     * @brief 以 JSON 输出响应缓存的配置和命中统计
+     * @param out 输出对象
+     */
+    void writeCacheStats(JsonObject out);
+
+    /**
+     * @brief 清空响应缓存（PSRAM 和 LittleFS 两层）
+     */
+    void clearResponseCache();
+
+    /**
+     * @brief 以 JSON 输出提供商路由状态：主/备路由、对冲和故障转移次数、各提供商的熔断状态和首字节延迟
+     * @param out 输出对象
+     */
+    void writeRoutingStats(JsonObject out);
+
+    /**
+     * @brief 以 JSON 输出本地意图匹配统计：尝试次数、命中率、平均匹配耗时和各规则命中次数
+     * @param out 输出对象
      */
-    void clearConversationHistory();
+    void writeIntentStats(JsonObject out);
+
+    /**
+     * @brief 以 JSON 输出 LLM 请求指标：丢弃和解析失败计数，以及按提供商和模型统计的
+     *        各阶段耗时（排队、DNS、TCP、TLS、发送、首字节、接收、解析、工具执行）
+     * @param out 输出对象
+     */
+    void writeMetrics(JsonObject out);
+
+    /**
+     * @brief 取消会话中所有已提交的请求：正在执行的请求立即中止读取并关闭连接，
+     *        排队中的请求出队时直接丢弃。之后提交的请求不受影响。
+     * @param sessionKey 会话键。
+     */
+    void cancelSession(const String& sessionKey);
+
+    uint32_t getToolParseFailures() const { return toolParseFailures->get(); } ///< 工具调用解析失败次数（文本 JSON 或原生参数）
+    uint32_t getCancelledCount() const { return cancelledCount->get(); } ///< 被取消而丢弃的请求数
+    uint32_t getExpiredCount() const { return expiredCount->get(); }     ///< 超过截止时间而丢弃的请求数
+
+    /**
+     * @brief 清除某个会话的对话历史（同时取消该会话进行中的请求）
+     *        清除该会话已保存的对话消息，重置对话上下文
+     * @param sessionKey 会话键。
+     */
+    void clearConversationHistory(const String& sessionKey);
+
+    /**
+     * @brief 删除会话及其对话历史（例如 WebSocket 客户端断开）
+     * @param sessionKey 会话键。
+     */
+    void removeSession(const String& sessionKey);
 
     /**
      * @brief 获取当前 LLM 模式
@@ -190,8 +422,8 @@ public:
      */
     void setCurrentMode(LLMMode mode);
 
-    QueueHandle_t llmRequestQueue;  ///< LLM 请求队列的句柄。
     QueueHandle_t llmResponseQueue; ///< LLM 响应队列的句柄。
+    QueueHandle_t llmDeltaQueue;    ///< 流式增量队列的句柄（chat_delta）。
 
 
 private:
@@ -203,47 +435,275 @@ private:
     String currentProvider;       ///< 当前使用的 LLM 提供商名称。
     String currentModel;          ///< 当前使用的模型名称。
     String currentApiKey;         ///< 当前提供商的 API 密钥。
-    ConversationHistory* conversationHistory; ///< 对话历史管理对象
+    LLMRequestScheduler* scheduler; ///< 按优先级排队的请求调度器（所有工作任务共享）
+    LLMSessionTable* sessionTable; ///< 按会话隔离的对话历史表
+    LLMResponseCache* responseCache; ///< 按内容寻址的响应缓存（config: llm_settings.cache）
+    LLMProviderRouter* router;    ///< 提供商路由：对冲请求、故障转移和熔断（config: llm_settings.routing）
+    static const uint8_t MAX_WORKERS = 4;
+    LLMWorkerContext workers[MAX_WORKERS]; ///< 工作任务上下文
+    uint8_t workerCount;          ///< 已创建的工作任务数
+    SemaphoreHandle_t dispatchLock; ///< 保护各工作任务的 sessionKey、queued、seq 以及取消点
+    static const uint8_t MAX_CANCEL_MARKS = 16;
+    LLMCancelMark cancelMarks[MAX_CANCEL_MARKS]; ///< 有未出队请求的会话及其取消点（同时有未出队请求的会话数上限）
+    uint32_t lastSeq;             ///< 最近分配的请求序号
+    unsigned long requestTimeoutMs; ///< 请求从提交起的总超时（config: llm_settings.request_timeout_ms）
+    MetricCounter* cancelledCount; ///< 被取消而丢弃的请求数
+    MetricCounter* expiredCount;   ///< 超过截止时间而丢弃的请求数
+    LLMTlsSessionCache* tlsSessionCache; ///< TLS 会话缓存（所有工作任务共享，NVS 持久化）
     LLMMode currentMode;          ///< 当前 LLM 模式（Chat 或 Advanced）
+    bool streamingEnabled;        ///< 是否以 SSE 流式方式请求（config: llm_settings.stream）
+    size_t tokenBudget;           ///< 当前模型的请求 token 预算（config: llm_settings.token_budgets）
+    size_t chatPromptTokens;      ///< 聊天模式系统提示的估算 token 数
+    size_t advancedPromptTokens;  ///< 高级模式系统提示的估算 token 数
+    uint64_t chatPromptHash;      ///< 聊天模式系统提示的哈希（作为缓存键中的提示版本）
+    uint64_t advancedPromptHash;  ///< 高级模式系统提示的哈希
+    bool nativeTools;             ///< 高级模式以 tools 字段发送工具定义并解析 tool_calls（config: llm_settings.native_tools）
+    size_t nativePromptTokens;    ///< 原生工具模式下系统提示和工具定义的估算 token 数
+    uint64_t nativePromptHash;    ///< 原生工具模式下系统提示和工具定义的哈希
+    MetricCounter* toolParseFailures; ///< 工具调用解析失败次数
+    LLMToolRegistry* toolRegistry; ///< 工具注册表：按名称分发工具调用，并生成工具说明和 tools 字段
+    LLMIntentMatcher* intentMatcher; ///< 本地意图匹配：简单的设备命令不经过 LLM（config: llm_settings.intents）
+    LLMMetrics* metrics;          ///< 按提供商和模型统计的分阶段耗时
+    MetricCounter* providerRequests; ///< 经提供商完成的请求数（以下指标导出到 /metrics）
+    MetricCounter* intentRequests;   ///< 本地意图命中的请求数
+    MetricCounter* cacheRequests;    ///< 缓存命中的请求数
+    MetricCounter* failedRequests;   ///< 回复为错误的请求数
+    MetricCounter* toolCallsExecuted; ///< 执行的工具调用数
+    MetricCounter* toolFailures;     ///< 失败或被拒绝的工具调用数
+    MetricHistogram* requestDuration; ///< 请求总耗时（毫秒）
+    MetricHistogram* firstByteLatency; ///< 提供商首字节耗时（毫秒）
+    MetricGauge* busyWorkers;        ///< 正在处理请求的工作任务数
+    MetricCounter* poolHits;         ///< 连接池复用已有连接的次数（各工作任务的连接池共享）
+    MetricCounter* poolMisses;       ///< 连接池需要重新拨号的次数
+    MetricCounter* poolRedials;      ///< 复用连接失效后重拨的次数
+    char* advancedPromptJson;     ///< 嵌入工具说明后的高级模式系统提示（JSON 字符串字面量，PSRAM）
+    size_t advancedPromptJsonLen; ///< advancedPromptJson 的长度
+    char* toolsJson;              ///< 由注册表生成的 tools 数组（JSON，PSRAM）
+    size_t toolsJsonLen;          ///< toolsJson 的长度
 
 
     /**
      * @brief 根据提示、模式和授权工具生成 LLM 响应。
      *        这是实际执行与 LLM API 通信的核心函数。
+     * @param worker 执行请求的工作任务。
      * @param requestId 请求ID。
      * @param prompt 用户输入的提示。
      * @param mode LLM 的操作模式。
+     * @param userText 用户原文，用于本地意图匹配；prompt 不是用户输入时为 nullptr。
      * @return LLM API 返回的原始响应字符串。
      */
-    String generateResponse(const String& requestId, const String& prompt, LLMMode mode);
+    String generateResponse(LLMWorkerContext& worker, const String& requestId, const String& prompt, LLMMode mode,
+                            const char* userText);
 
     /**
      * @brief 获取类 OpenAI 模型的响应 (适用于 DeepSeek, OpenRouter, OpenAI)。
      *        负责构建 HTTP 请求并与 API 端点通信。
+     * @param worker 执行请求的工作任务。
      * @param requestId 请求ID。
      * @param prompt 用户输入的提示。
      * @param mode LLM 的操作模式。
      * @param authorizedTools 授权工具的 JSON 数组。
      * @return LLM API 返回的原始响应字符串。
      */
-    String getOpenAILikeResponse(const String& requestId, const String& prompt, LLMMode mode);
+    String getOpenAILikeResponse(LLMWorkerContext& worker, const String& requestId, const String& prompt, LLMMode mode);
+
+    /**
+     * @brief 向一个路由发出请求并读取响应。主路由在对冲延迟内没有收到首字节时，
+     *        向备用路由发出对冲请求。先返回状态 200 的一方胜出，另一方的连接被关闭；
+     *        另一方仍在等待时，非 200 的响应或断开的连接不会结束请求。
+     * @param worker 执行请求的工作任务。
+     * @param route 路由。
+     * @param hedgeRoute 对冲使用的备用路由，nullptr 表示不对冲。
+     * @param requestId 请求ID。
+     * @param prompt 当前用户输入。
+     * @param mode LLM 的操作模式。
+     * @param abortSignal 取消标志和截止时间。
+     * @param retryable 输出：失败发生在输出任何内容之前且备用路由没有收到过对冲请求，可以转给备用路由重试。
+     * @return 回复内容；出错时返回以 "Error:" 开头的字符串。
+     */
+    String requestWithHedge(LLMWorkerContext& worker, const LLMRoute& route, const LLMRoute* hedgeRoute,
+                            const String& requestId, const String& prompt, LLMMode mode,
+                            HttpAbortSignal& abortSignal, bool& retryable);
 
     /**
-     * @brief 根据模式和授权工具生成系统提示 (System Prompt)。
-     *        系统提示用于指导 LLM 的行为和响应格式。
+     * @brief 从连接池获取路由主机的连接，必要时建立连接，然后发送请求。
+     *        复用的连接发送失败时重新拨号并重试一次。
+     * @param worker 执行请求的工作任务。
+     * @param route 路由。
+     * @param client 输入/输出：为 nullptr 时从连接池获取；失败时归还并置为 nullptr。
+     * @param reused 输入/输出：连接是否为复用的长连接。
+     * @param prompt 当前用户输入。
      * @param mode LLM 的操作模式。
-     * @param authorizedTools 授权工具的 JSON 数组。
-     * @return 生成的系统提示字符串。
+     * @param dial 输出：建立连接和发送请求的耗时。
+     * @return 请求完整发送时返回 true。
+     */
+    bool sendToRoute(LLMWorkerContext& worker, const LLMRoute& route, LLMTlsClient*& client, bool& reused,
+                     const String& prompt, LLMMode mode, LLMDialTiming& dial);
+
+    /**
+     * @brief 读取响应体并归还连接，同时把结果报告给路由器（成功、失败或不计入）。
+     * @param retryable 输出：响应为 429 或 5xx 时置为 true。
+     * @return 回复内容；出错时返回以 "Error:" 开头的字符串。
+     */
+    String readRouteResponse(LLMWorkerContext& worker, const LLMRoute& route, LLMTlsClient* client, bool reused,
+                             HttpResponseHead& head, const String& requestId, LLMMode mode,
+                             unsigned long requestStart, unsigned long firstByteMs,
+                             HttpAbortSignal& abortSignal, bool& retryable);
+
+    /**
+     * @brief 发送请求头，并以 chunked 传输编码边生成边发送请求体。
+     *        系统提示、对话历史和当前输入逐条转义后直接写入连接，不在内存中拼接完整请求体。
+     * @param worker 执行请求的工作任务。
+     * @param client 已建立的 TLS 连接。
+     * @param route 路由（主机、接口路径、模型和 API 密钥）。
+     * @param prompt 当前用户输入。
+     * @param mode LLM 的操作模式（决定系统提示）。
+     * @return 请求完整写入连接时返回 true。
+     */
+    bool writeChatRequest(LLMWorkerContext& worker, Client& client, const LLMRoute& route, const String& prompt, LLMMode mode);
+
+    /**
+     * @brief 选取本次请求要发送的历史消息：token 预算内最新的消息。
+     *        writeChatRequest() 和 computeCacheKey() 共用，保证缓存键与实际发送的上下文一致。
+     * @param worker 执行请求的工作任务（使用 worker.history）。
+     * @param prompt 当前用户输入。
+     * @param mode LLM 的操作模式。
+     * @param contextTokens 输出系统提示、所选历史和当前输入的估算 token 总数。
+     * @return 第一条要发送的历史消息的下标；没有历史时返回消息数。
+     */
+    size_t selectHistory(LLMWorkerContext& worker, const String& prompt, LLMMode mode, size_t& contextTokens);
+
+    /**
+     * @brief 计算请求的缓存键：提供商、模型、模式、系统提示版本和规范化后的消息列表的哈希。
+     * @param worker 执行请求的工作任务。
+     * @param prompt 当前用户输入。
+     * @param mode LLM 的操作模式。
+     * @return 64 位缓存键。
+     */
+    uint64_t computeCacheKey(LLMWorkerContext& worker, const String& prompt, LLMMode mode);
+
+    /**
+     * @brief 直接从网络流上解析非流式 JSON 响应。
+     *        使用 ArduinoJson 过滤器只保留 content、finish_reason 和 usage，
+     *        不再把整个响应体读入缓冲区。
+     * @param worker 执行请求的工作任务（记录解析耗时）。
+     * @param body 状态码为 200 的响应体。
+     * @return 回复内容；出错时返回以 "Error:" 开头的字符串。
+     */
+    String readJsonResponse(LLMWorkerContext& worker, HttpBodyStream& body);
+
+    /**
+     * @brief 读取 SSE 流式响应，边接收边转发内容增量。
+     *        解析每个 `data:` 事件中的 choices[0].delta.content，拼接为完整回复，
+     *        同时以 aiResponseDelta (CDC) 和 chat_delta (WebSocket) 的形式转发增量。
+     * @param worker 执行请求的工作任务。
+     * @param body 状态码为 200 的响应体。
+     * @param requestId 请求ID。
+     * @param mode LLM 的操作模式（高级模式下工具调用 JSON 不会被转发）。
+     * @param requestStart 发出请求时的 millis()，用于统计首 token 延迟。
+     * @return 拼接后的完整回复；出错时返回以 "Error:" 开头的字符串。
+     */
+    String readStreamingResponse(LLMWorkerContext& worker, HttpBodyStream& body, const String& requestId, LLMMode mode, unsigned long requestStart);
+
+    /**
+     * @brief 将一段内容增量转发给 USB 主机和 Web 客户端。
+     * @param worker 执行请求的工作任务。
+     * @param requestId 请求ID。
+     * @param delta 增量文本。
+     */
+    void emitStreamDelta(LLMWorkerContext& worker, const String& requestId, const String& delta);
+
+    /**
+     * @brief 根据工具注册表生成高级模式系统提示（替换 {{TOOLS}} 标记）和 tools 数组，
+     *        并估算各模式系统提示的 token 数和哈希。构造时调用一次。
      */
-    String generateSystemPrompt(LLMMode mode);
+    void buildToolPrompts();
+
+    /**
+     * @brief 获取系统提示 (System Prompt)。
+     *        系统提示用于指导 LLM 的行为和响应格式，文本位于 prompts/ 目录，
+     *        构建时由 generate_prompts.py 预先转义为 JSON 字符串字面量并放在 Flash 中；
+     *        高级模式的工具说明由工具注册表在启动时嵌入。
+     * @param mode LLM 的操作模式。
+     * @param length 输出参数，返回字面量长度（字节）。
+     * @return 含首尾引号的 JSON 字符串字面量，可直接写入请求体。
+     */
+    const char* getSystemPromptJson(LLMMode mode, size_t& length);
+
+    /**
+     * @brief 本次请求是否使用原生工具调用（高级模式且 llm_settings.native_tools 开启）。
+     *        否则工具以文字形式写在系统提示中，回复中的 JSON 由 handleLLMRawResponse() 识别。
+     */
+    bool usesNativeTools(LLMMode mode) const { return nativeTools && mode == ADVANCED_MODE; }
+
+    /**
+     * @brief 把原生 tool_calls 转换为 handleLLMRawResponse() 识别的 {"tool_calls":[{"name":...,"args":{...}}]}。
+     *        参数不是合法 JSON 对象时计为一次解析失败，并以空参数传递（由工具处理函数报告缺少参数）。
+     * @param names 各工具调用的函数名。
+     * @param arguments 各工具调用的参数（JSON 字符串）。
+     * @param count 工具调用数。
+     * @return 转换后的 JSON 文本。
+     */
+    String toolCallsToContent(const String* names, const String* arguments, size_t count);
 
     /**
      * @brief 处理 LLM 的原始响应，解析工具调用或自然语言回复。
+     * @param worker 执行请求的工作任务。
      * @param requestId 请求ID。
      * @param prompt 用户输入的提示。
      * @param llmContentString LLM 返回的原始 JSON 字符串。
      */
-    void handleLLMRawResponse(const String& requestId, const String& prompt, const String& llmContentString);
+    void handleLLMRawResponse(LLMWorkerContext& worker, const String& requestId, const String& prompt, const String& llmContentString);
+
+    /**
+     * @brief 按配置创建工作任务上下文（连接池和转交队列），数量受剩余 PSRAM 和内部 RAM 限制。
+     * @param wanted 期望的工作任务数。
+     */
+    void createWorkers(size_t wanted);
+
+    /**
+     * @brief 为从共享队列取出的请求认领会话。
+     *        若该会话正由其他工作任务处理，则把请求转交给该任务，保证同一会话按顺序执行。
+     * @param worker 取出请求的工作任务。
+     * @param request 取出的请求。
+     * @return 由 worker 处理时返回 true；已转交时返回 false。
+     */
+    bool claimSession(LLMWorkerContext& worker, const LLMRequest& request);
+
+    /**
+     * @brief 请求处理结束；没有转交过来的后续请求时释放会话认领。
+     */
+    void releaseSession(LLMWorkerContext& worker);
+
+    /**
+     * @brief 请求是否已被所属会话的取消点覆盖（调用方需持有 dispatchLock）。
+     */
+    bool isCancelled(const LLMRequest& request);
+
+    /**
+     * @brief 为即将提交的请求占用会话的取消点记录，未出队计数加一（调用方需持有 dispatchLock）。
+     * @return 没有空闲记录（同时有未出队请求的会话过多）时返回 false，请求不应提交。
+     */
+    bool reserveCancelMark(const LLMRequest& request);
+
+    /**
+     * @brief 请求已出队（开始执行、被丢弃或提交失败），未出队计数减一，归零时释放记录（调用方需持有 dispatchLock）。
+     */
+    void releaseCancelMark(const LLMRequest& request);
+
+    /**
+     * @brief 被丢弃的请求不写入对话历史，只通知请求方。
+     * @param worker 执行请求的工作任务。
+     * @param requestId 请求ID。
+     * @param message 发给请求方的错误信息。
+     * @param notifyWeb 是否同时通知 Web 客户端（主动取消时客户端已收到确认，无需再通知）。
+     */
+    void sendDroppedResponse(LLMWorkerContext& worker, const String& requestId, const String& message, bool notifyWeb);
+
+    /**
+     * @brief 处理一个请求：占用会话历史、调用提供商、分发响应。
+     */
+    void processRequest(LLMWorkerContext& worker, LLMRequest& request);
 
     /**
      * @brief 安全地分配PSRAM内存并拷贝字符串。
@@ -252,14 +712,6 @@ private:
      */
     char* allocateAndCopy(const String& str);
 
-    /**
-     * @brief 创建并发送LLM请求到队列的通用方法。
-     * @param requestId 请求ID。
-     * @param prompt 提示内容。
-     * @param mode LLM模式。
-     * @return 成功返回true，失败返回false。
-     */
-    bool createAndSendRequest(const String& requestId, const String& prompt, LLMMode mode);
 
     /**
      * @brief 分配响应字符串内存的辅助方法。
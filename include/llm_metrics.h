@@ -0,0 +1,199 @@
+/**
+ * @file llm_metrics.h
+ * @brief LLM 请求的分阶段耗时统计。
+ *
+ * 每个请求按阶段计时：排队等待、DNS、TCP 连接、TLS 握手、发送请求、首字节、
+ * 接收响应体、JSON 解析和工具执行。各阶段按提供商和模型分别保留最近的样本，
+ * 输出百分位数和直方图，用于判断延迟来自网络、服务器还是设备本身。
+ */
+#ifndef LLM_METRICS_H
+#define LLM_METRICS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+// 每个阶段保留的最近样本数；本机基准测试（env:native）调大以计算 p99
+#ifndef NOOX_LLM_METRICS_WINDOW
+#define NOOX_LLM_METRICS_WINDOW 32
+#endif
+
+/**
+ * @brief 请求的处理阶段
+ */
+enum LLMPhase : uint8_t {
+    PHASE_QUEUE_WAIT = 0,  ///< 提交到开始处理
+    PHASE_DNS,             ///< 域名解析（仅新建连接）
+    PHASE_TCP_CONNECT,     ///< TCP 连接（仅新建连接）
+    PHASE_TLS_HANDSHAKE,   ///< TLS 握手（仅新建连接）
+    PHASE_REQUEST_WRITE,   ///< 发送请求头和请求体
+    PHASE_FIRST_BYTE,      ///< 请求发出到收到首字节
+    PHASE_BODY_DOWNLOAD,   ///< 接收响应体（不含解析）
+    PHASE_JSON_PARSE,      ///< 解析响应 JSON 或 SSE 事件
+    PHASE_TOOL_DISPATCH,   ///< 执行本轮的工具调用
+    PHASE_TOTAL,           ///< 提交到回复处理完毕
+    PHASE_COUNT
+};
+
+/**
+ * @brief 一次建立连接并发送请求的耗时（对冲时每个路由各一份）
+ */
+struct LLMDialTiming {
+    bool dialed;           ///< 是否新建了连接（复用连接时 DNS/TCP/TLS 不计入）
+    uint32_t dnsMicros;
+    uint32_t connectMicros;
+    uint32_t handshakeMicros;
+    uint32_t writeMicros;
+};
+
+/**
+ * @brief 一个请求各阶段的耗时，处理请求期间由工作任务填写
+ */
+struct LLMRequestTiming {
+    const char* provider;            ///< 提供商名称（"local" 为本地意图，"cache" 为缓存命中），nullptr 表示不记录
+    char model[64];                  ///< 模型名称
+    uint32_t phaseMicros[PHASE_COUNT]; ///< 各阶段耗时（微秒）
+    uint16_t measured;               ///< 已测量的阶段（位掩码）
+    bool failed;                     ///< 回复是否为错误
+
+    /**
+     * @brief 清空，开始计时一个新请求
+     */
+    void reset() { memset(this, 0, sizeof(LLMRequestTiming)); }
+
+    /**
+     * @brief 设置请求所用的提供商和模型
+     */
+    void setRoute(const char* providerName, const char* modelName) {
+        provider = providerName;
+        strncpy(model, modelName, sizeof(model) - 1);
+        model[sizeof(model) - 1] = '\0';
+    }
+
+    /**
+     * @brief 记录某阶段的耗时（覆盖）
+     */
+    void set(LLMPhase phase, uint32_t value) {
+        phaseMicros[phase] = value;
+        measured |= (1u << phase);
+    }
+
+    /**
+     * @brief 累加某阶段的耗时（例如多个 SSE 事件的解析）
+     */
+    void add(LLMPhase phase, uint32_t value) {
+        phaseMicros[phase] += value;
+        measured |= (1u << phase);
+    }
+
+    /**
+     * @brief 清除某阶段（例如故障转移前失败请求的记录）
+     */
+    void clear(LLMPhase phase) {
+        phaseMicros[phase] = 0;
+        measured &= ~(1u << phase);
+    }
+
+    /**
+     * @brief 写入胜出连接的建连和发送耗时（复用的连接清除之前记录的建连耗时）
+     */
+    void applyDial(const LLMDialTiming& dial) {
+        if (dial.dialed) {
+            set(PHASE_DNS, dial.dnsMicros);
+            set(PHASE_TCP_CONNECT, dial.connectMicros);
+            set(PHASE_TLS_HANDSHAKE, dial.handshakeMicros);
+        } else {
+            measured &= ~((1u << PHASE_DNS) | (1u << PHASE_TCP_CONNECT) | (1u << PHASE_TLS_HANDSHAKE));
+        }
+        set(PHASE_REQUEST_WRITE, dial.writeMicros);
+    }
+
+    bool has(LLMPhase phase) const { return measured & (1u << phase); } ///< 是否测量了某阶段
+};
+
+/**
+ * @brief 按提供商和模型汇总的分阶段耗时统计（线程安全，所有工作任务共享）。
+ *
+ * 每个阶段保留最近 WINDOW 个样本（环形覆盖），百分位数和直方图按这些样本计算；
+ * 另外累计全部样本的次数和总耗时。样本缓冲区在 PSRAM 中一次性分配。
+ */
+class LLMMetrics {
+public:
+    static const size_t MAX_SERIES = 6;     ///< 最多统计的提供商/模型组合数
+    static const size_t WINDOW = NOOX_LLM_METRICS_WINDOW; ///< 每个阶段保留的最近样本数
+    static const size_t BUCKET_COUNT = 12;  ///< 直方图的桶数（最后一个桶无上限）
+
+    /**
+     * @brief 构造函数
+     */
+    LLMMetrics();
+
+    /**
+     * @brief 析构函数
+     */
+    ~LLMMetrics();
+
+    /**
+     * @brief 记录一个请求。provider 为 nullptr 的请求不记录
+     * @param timing 请求各阶段的耗时
+     */
+    void record(const LLMRequestTiming& timing);
+
+    /**
+     * @brief 以 JSON 输出各提供商/模型的分阶段统计：
+     *        {"window":32,"series":[{"provider","model","requests","errors","phases":{"dns":{...}}}]}
+     * @param out 输出对象
+     */
+    void writeStats(JsonObject out);
+
+    /**
+     * @brief 阶段名称（JSON 字段名）
+     */
+    static const char* phaseName(LLMPhase phase);
+
+    /**
+     * @brief 直方图各桶的上限（毫秒），最后一个为 0 表示无上限
+     */
+    static const uint32_t* getBucketBounds();
+
+private:
+    /**
+     * @brief 单个阶段的样本窗口
+     */
+    struct PhaseWindow {
+        uint32_t samples[WINDOW]; ///< 最近的耗时样本（微秒，环形覆盖）
+        uint16_t sampleCount;     ///< 窗口中的样本数
+        uint16_t next;            ///< 下一个被覆盖的样本
+        uint32_t count;           ///< 累计样本数
+        uint64_t sumMicros;       ///< 累计耗时
+    };
+
+    /**
+     * @brief 一个提供商/模型组合
+     */
+    struct Series {
+        const char* provider;
+        char model[64];
+        uint32_t requests;
+        uint32_t errors;
+        PhaseWindow phases[PHASE_COUNT];
+    };
+
+    Series* series;           ///< 统计表（PSRAM）
+    size_t seriesCount;
+    uint32_t unrecorded;      ///< 统计表已满而未记录的请求数
+    SemaphoreHandle_t lock;
+
+    /**
+     * @brief 查找或创建某提供商/模型的统计（调用方需持有锁）
+     */
+    Series* findOrCreate(const char* provider, const char* model);
+
+    /**
+     * @brief 计算窗口样本的百分位数（微秒，调用方需持有锁）
+     */
+    static uint32_t percentile(const PhaseWindow& window, uint8_t pct);
+};
+
+#endif // LLM_METRICS_H
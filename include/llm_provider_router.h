@@ -0,0 +1,182 @@
+/**
+ * @file llm_provider_router.h
+ * @brief LLM 提供商路由：对冲请求、故障转移和熔断。
+ *
+ * 主路由是 last_used 中的提供商和模型，备用路由来自 llm_settings.routing.secondary。
+ * 主路由在对冲延迟（最近首字节延迟的百分位数）内没有返回任何字节时，向备用路由发出对冲请求，
+ * 先返回者胜出；连续失败的提供商被熔断一段时间，期间请求直接转给备用路由。
+ */
+#ifndef LLM_PROVIDER_ROUTER_H
+#define LLM_PROVIDER_ROUTER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+/**
+ * @brief 路由类别
+ */
+enum LLMRouteTarget : uint8_t {
+    ROUTE_PRIMARY = 0,   ///< last_used 中的提供商和模型
+    ROUTE_SECONDARY = 1  ///< 对冲和故障转移使用的备用提供商和模型
+};
+
+/**
+ * @brief 一次请求所用的提供商端点
+ */
+struct LLMRoute {
+    uint8_t providerIndex; ///< 提供商在路由器中的编号
+    const char* provider;  ///< 提供商名称（"deepseek"、"openrouter"、"openai"）
+    const char* host;      ///< API 主机名
+    const char* path;      ///< 接口路径
+    String model;          ///< 模型名称
+    String apiKey;         ///< API 密钥
+};
+
+/**
+ * @brief 熔断器状态
+ */
+enum LLMBreakerState : uint8_t {
+    BREAKER_CLOSED = 0,    ///< 正常
+    BREAKER_OPEN = 1,      ///< 熔断中，拒绝请求
+    BREAKER_HALF_OPEN = 2  ///< 冷却结束，放行一个试探请求
+};
+
+/**
+ * @brief 提供商路由器（线程安全，所有工作任务共享）。
+ */
+class LLMProviderRouter {
+public:
+    static const size_t PROVIDER_COUNT = 3;
+    static const size_t LATENCY_SAMPLES = 32; ///< 每个提供商保留的最近首字节延迟样本数
+
+    /**
+     * @brief 构造函数
+     */
+    LLMProviderRouter();
+
+    /**
+     * @brief 析构函数
+     */
+    ~LLMProviderRouter();
+
+    /**
+     * @brief 从配置加载主路由、备用路由和对冲/熔断参数
+     * @param config 已加载的配置文档
+     */
+    void configure(JsonDocument& config);
+
+    /**
+     * @brief 获取路由
+     * @param target 主路由或备用路由
+     * @param route 输出路由
+     * @return 路由已配置（提供商有效且设置了 API 密钥）时返回 true
+     */
+    bool getRoute(LLMRouteTarget target, LLMRoute& route);
+
+    /**
+     * @brief 熔断器是否放行请求。冷却结束后放行一个试探请求（半开）
+     * @param route 路由
+     */
+    bool allow(const LLMRoute& route);
+
+    /**
+     * @brief 对冲延迟：主路由最近首字节延迟的百分位数；样本不足时使用配置的缺省值
+     * @param route 路由
+     * @return 毫秒
+     */
+    unsigned long getHedgeDelay(const LLMRoute& route);
+
+    bool isHedgingEnabled() const { return hedgeEnabled; } ///< 是否启用对冲请求
+
+    /**
+     * @brief 记录一次成功的请求（关闭熔断器）
+     * @param route 路由
+     * @param firstByteMs 发出请求到收到首字节的时间
+     */
+    void recordSuccess(const LLMRoute& route, unsigned long firstByteMs);
+
+    /**
+     * @brief 记录对冲请求胜出时主请求已等待的时间。主请求的首字节延迟至少是这么长，
+     *        作为延迟样本计入（不影响熔断器），避免对冲延迟只随快速的成功请求缩短
+     * @param route 被取消的主请求的路由
+     * @param elapsedMs 发出请求到被取消的时间
+     */
+    void recordLatencyLowerBound(const LLMRoute& route, unsigned long elapsedMs);
+
+    /**
+     * @brief 记录一次失败的请求（连接失败、无响应、5xx 或 429），连续失败达到阈值后熔断
+     * @param route 路由
+     */
+    void recordFailure(const LLMRoute& route);
+
+    void recordHedge() { hedgesFired++; }        ///< 发出了一次对冲请求
+    void recordHedgeWin() { hedgeWins++; }       ///< 对冲请求先于主请求返回
+    void recordFailover() { failovers++; }       ///< 请求转给了备用路由
+
+    /**
+     * @brief 以 JSON 输出路由配置、各提供商的熔断状态和延迟统计
+     * @param out 输出对象
+     */
+    void writeStats(JsonObject out);
+
+    /**
+     * @brief 熔断器状态名称
+     */
+    static const char* breakerStateName(LLMBreakerState state);
+
+private:
+    /**
+     * @brief 单个提供商的熔断器和延迟统计
+     */
+    struct ProviderState {
+        LLMBreakerState state;          ///< 熔断器状态
+        uint8_t consecutiveFailures;    ///< 连续失败次数
+        unsigned long openedAt;         ///< 熔断或开始试探的时间（millis）
+        uint32_t successes;             ///< 累计成功数
+        uint32_t failures;              ///< 累计失败数
+        uint32_t trips;                 ///< 累计熔断次数
+        uint32_t latencies[LATENCY_SAMPLES]; ///< 最近首字节延迟（环形覆盖）
+        size_t latencyCount;            ///< 已记录的样本数（不超过 LATENCY_SAMPLES）
+        size_t latencyNext;             ///< 下一个被覆盖的样本
+    };
+
+    /**
+     * @brief 加入一个首字节延迟样本（调用方需持有 lock）
+     */
+    static void addLatencySample(ProviderState& state, unsigned long firstByteMs);
+
+    ProviderState providers[PROVIDER_COUNT];
+    LLMRoute routes[2];
+    bool routeValid[2];
+    SemaphoreHandle_t lock;
+
+    bool hedgeEnabled;
+    uint8_t hedgePercentile;
+    unsigned long hedgeDefaultDelayMs;
+    unsigned long hedgeMinDelayMs;
+    uint8_t breakerFailures;
+    unsigned long breakerCooldownMs;
+
+    volatile uint32_t hedgesFired;
+    volatile uint32_t hedgeWins;
+    volatile uint32_t failovers;
+
+    /**
+     * @brief 按名称查找提供商，返回编号；未知提供商返回 -1
+     */
+    static int findProvider(const String& name);
+
+    /**
+     * @brief 加载一个路由
+     */
+    bool loadRoute(JsonDocument& config, const String& provider, const String& model, LLMRoute& route);
+
+    /**
+     * @brief 计算延迟样本的百分位数（调用方需持有锁）；没有样本时返回 0
+     */
+    unsigned long percentile(const ProviderState& state, uint8_t pct) const;
+};
+
+#endif // LLM_PROVIDER_ROUTER_H
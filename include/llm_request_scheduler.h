@@ -0,0 +1,109 @@
+/**
+ * @file llm_request_scheduler.h
+ * @brief LLM 请求的优先级调度器。
+ *
+ * 取代原来的单一 FIFO 请求队列：请求按类别（交互、代理后续、后台）分别排队，
+ * 工作任务总是先取优先级最高的请求；排队时间越长的请求优先级逐步提升（老化），
+ * 低优先级请求不会被饿死。每个类别记录排队等待时间的直方图。
+ */
+#ifndef LLM_REQUEST_SCHEDULER_H
+#define LLM_REQUEST_SCHEDULER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "llm_manager.h" // LLMRequest, LLMPriority
+
+/**
+ * @brief 按优先级类别排队的 LLM 请求调度器（线程安全）。
+ *
+ * 每个类别是一个固定容量的环形队列，运行期间不分配内存。
+ */
+class LLMRequestScheduler {
+public:
+    static const size_t WAIT_BUCKET_COUNT = 10; ///< 等待时间直方图的桶数（最后一个桶无上限）
+
+    /**
+     * @brief 构造函数
+     * @param capacityPerClass 每个类别最多排队的请求数
+     * @param agingStepMs 请求每排队这么久，优先级提升一级
+     */
+    LLMRequestScheduler(size_t capacityPerClass = 8, unsigned long agingStepMs = 5000);
+
+    /**
+     * @brief 析构函数
+     */
+    ~LLMRequestScheduler();
+
+    /**
+     * @brief 提交请求
+     * @param request 请求（调度器按值拷贝；prompt 的所有权转移给调度器，直到被取出）
+     * @param priority 优先级类别
+     * @param waitTicks 该类别队列已满时最多等待的时间
+     * @return 成功入队返回 true
+     */
+    bool submit(LLMRequest& request, LLMPriority priority, TickType_t waitTicks);
+
+    /**
+     * @brief 取出当前应当执行的请求（不阻塞）
+     *        比较各类别队首请求的有效优先级（类别减去老化提升的级数），取最小者；相同时取更早提交的。
+     * @param request 输出取出的请求
+     * @param lowestPriority 只考虑不低于该优先级的类别（用于为交互请求保留工作任务）
+     * @return 取到请求时返回 true
+     */
+    bool take(LLMRequest& request, LLMPriority lowestPriority = PRIORITY_BACKGROUND);
+
+    /**
+     * @brief 当前排队的请求数
+     * @param priority 优先级类别
+     */
+    size_t getQueued(LLMPriority priority) const { return queues[priority].count; }
+
+    /**
+     * @brief 以 JSON 输出各类别的排队数、总出队数和等待时间直方图
+     * @param out 输出对象
+     */
+    void writeStats(JsonObject out);
+
+    /**
+     * @brief 类别名称（"interactive"、"follow_up"、"background"）
+     */
+    static const char* priorityName(LLMPriority priority);
+
+    /**
+     * @brief 等待时间直方图各桶的上限（毫秒），最后一个桶为 0 表示无上限
+     */
+    static const unsigned long* getWaitBucketBounds();
+
+private:
+    /**
+     * @brief 单个类别的环形队列和统计
+     */
+    struct ClassQueue {
+        LLMRequest* items;                    ///< 环形缓冲区（PSRAM）
+        size_t head;                          ///< 队首下标
+        size_t count;                         ///< 排队数
+        uint32_t dequeued;                    ///< 累计出队数
+        uint32_t promoted;                    ///< 因老化而先于更高类别出队的次数
+        uint32_t waitBuckets[WAIT_BUCKET_COUNT]; ///< 等待时间直方图
+        unsigned long maxWaitMs;              ///< 最长等待时间
+    };
+
+    ClassQueue queues[PRIORITY_CLASS_COUNT];
+    size_t capacity;
+    unsigned long agingStepMs;
+    SemaphoreHandle_t lock;
+
+    /**
+     * @brief 尝试把请求放入类别队列（调用方需持有锁）
+     */
+    bool tryPush(LLMRequest& request, LLMPriority priority);
+
+    /**
+     * @brief 记录一次出队的等待时间（调用方需持有锁）
+     */
+    void recordWait(ClassQueue& queue, unsigned long waitMs);
+};
+
+#endif // LLM_REQUEST_SCHEDULER_H
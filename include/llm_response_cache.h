@@ -0,0 +1,148 @@
+/**
+ * @file llm_response_cache.h
+ * @brief 按内容寻址的 LLM 响应缓存。
+ *
+ * 键是提供商、模型、模式、系统提示版本和规范化后的消息列表的 64 位 FNV-1a 哈希。
+ * 第一层是 PSRAM 中按最近最少使用淘汰的条目表；可选的第二层把条目写入 LittleFS，
+ * 重启后仍可命中。两层都有 TTL，并统计命中和未命中次数。
+ */
+#ifndef LLM_RESPONSE_CACHE_H
+#define LLM_RESPONSE_CACHE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+/**
+ * @brief PSRAM 缓存中的一个条目。
+ */
+struct LLMCacheEntry {
+    uint64_t key;            ///< 请求内容的哈希，0 表示空槽
+    char* content;           ///< 回复内容（PSRAM）
+    size_t length;           ///< 回复长度
+    unsigned long storedAt;  ///< 写入时间（millis）
+    unsigned long lastUsed;  ///< 最近一次命中时间（millis），用于 LRU
+};
+
+/**
+ * @brief 两层 LLM 响应缓存（线程安全）。
+ */
+class LLMResponseCache {
+public:
+    /**
+     * @brief 构造函数（默认关闭，由 configure() 按配置启用）
+     */
+    LLMResponseCache();
+
+    /**
+     * @brief 析构函数，释放所有条目
+     */
+    ~LLMResponseCache();
+
+    /**
+     * @brief 更新缓存配置；关闭或缩小容量时清空 PSRAM 层
+     * @param enabled 是否启用
+     * @param ttlSeconds 条目有效期（秒）
+     * @param maxEntries PSRAM 层最多条目数（不超过 MAX_ENTRIES）
+     * @param maxBytes PSRAM 层最多占用的内容字节数
+     * @param persist 是否启用 LittleFS 持久层
+     * @param persistSlots LittleFS 层的槽位数（按键取模直接映射，冲突时覆盖）
+     */
+    void configure(bool enabled, unsigned long ttlSeconds, size_t maxEntries, size_t maxBytes,
+                   bool persist, size_t persistSlots);
+
+    bool isEnabled() const { return enabled; } ///< 是否启用
+
+    /**
+     * @brief 查找缓存
+     * @param key 请求内容的哈希
+     * @param content 命中时输出回复内容
+     * @return 命中且未过期时返回 true
+     */
+    bool get(uint64_t key, String& content);
+
+    /**
+     * @brief 写入缓存（两层）
+     * @param key 请求内容的哈希
+     * @param content 回复内容
+     */
+    void put(uint64_t key, const String& content);
+
+    /**
+     * @brief 清空两层缓存
+     */
+    void clear();
+
+    /**
+     * @brief 以 JSON 输出配置和命中统计
+     * @param out 输出对象
+     */
+    void writeStats(JsonObject out);
+
+    /**
+     * @brief 在已有哈希值上继续计算 64 位 FNV-1a
+     * @param hash 当前哈希值（初始值为 FNV_OFFSET_BASIS）
+     * @param data 数据
+     * @param length 数据长度
+     * @return 新的哈希值
+     */
+    static uint64_t hashBytes(uint64_t hash, const void* data, size_t length);
+
+    /**
+     * @brief 以规范化方式把文本加入哈希：去掉首尾空白，连续空白视为一个空格，末尾加分隔符
+     */
+    static uint64_t hashNormalized(uint64_t hash, const char* text);
+
+    static const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+
+private:
+    static const size_t MAX_ENTRIES = 64;
+    static const size_t MAX_ENTRY_BYTES = 32768; ///< 超过该长度的回复不缓存
+
+    LLMCacheEntry entries[MAX_ENTRIES];
+    size_t entryCount;
+    size_t usedBytes;
+    SemaphoreHandle_t lock;
+
+    bool enabled;
+    unsigned long ttlSeconds;
+    size_t maxEntries;
+    size_t maxBytes;
+    bool persist;
+    size_t persistSlots;
+
+    uint32_t memoryHits;
+    uint32_t persistentHits;
+    uint32_t misses;
+    uint32_t stores;
+    uint32_t evictions;
+    uint32_t expirations;
+
+    LLMCacheEntry* find(uint64_t key);
+    void removeAt(size_t index);
+    bool evictLeastRecentlyUsed();
+
+    /**
+     * @brief 放入 PSRAM 层（调用方需持有锁），空间不足时按 LRU 淘汰
+     */
+    void insert(uint64_t key, const char* content, size_t length, unsigned long storedAt);
+
+    /**
+     * @brief LittleFS 层的文件路径
+     */
+    String slotPath(uint64_t key) const;
+
+    /**
+     * @brief 从 LittleFS 层读取条目（调用方需持有锁）
+     * @return 命中且未过期时返回 true
+     */
+    bool readPersistent(uint64_t key, String& content);
+
+    /**
+     * @brief 写入 LittleFS 层（调用方需持有锁）
+     */
+    void writePersistent(uint64_t key, const String& content);
+};
+
+#endif // LLM_RESPONSE_CACHE_H
@@ -0,0 +1,110 @@
+/**
+ * @file llm_session_table.h
+ * @brief 按会话隔离的对话历史表。
+ *
+ * 每个会话（某个 WebSocket 客户端、USB CDC 主机或显式的 sessionId）拥有独立的
+ * ConversationHistory，互不污染上下文。会话数量或 PSRAM 不足时按最近最少使用淘汰。
+ */
+#ifndef LLM_SESSION_TABLE_H
+#define LLM_SESSION_TABLE_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "llm_manager.h"
+
+/**
+ * @brief 会话表中的一项。
+ */
+struct LLMSession {
+    char key[48];                  ///< 会话键，例如 "ws:3"、"web:<sessionId>"、"cdc"
+    ConversationHistory* history;  ///< 该会话的对话历史（会话表拥有）
+    unsigned long lastUsed;        ///< 最近一次使用的时间（millis）
+    bool busy;                     ///< LLM 任务正在使用该会话的历史
+    bool pendingClear;             ///< 使用结束后清空历史
+    bool pendingRemove;            ///< 使用结束后删除会话
+};
+
+/**
+ * @brief 会话键到对话历史的映射表。
+ *
+ * 线程安全：LLM 任务在处理请求期间通过 acquire/release 占用会话，
+ * 其他任务的 clear/remove 若遇到正在使用的会话，会推迟到 release 时执行。
+ */
+class LLMSessionTable {
+public:
+    /**
+     * @brief 构造函数
+     * @param maxSessions 同时保留的最大会话数
+     * @param historyBytes 每个会话的历史内存区大小（字节）
+     * @param maxMessages 每个会话最多保留的消息条数
+     */
+    LLMSessionTable(size_t maxSessions = 4, size_t historyBytes = 65536, size_t maxMessages = 60);
+
+    /**
+     * @brief 析构函数，释放所有会话
+     */
+    ~LLMSessionTable();
+
+    /**
+     * @brief 更新会话上限和每个会话的内存上限（只影响之后新建的会话；超出上限的空闲会话立即淘汰）
+     */
+    void configure(size_t maxSessions, size_t historyBytes);
+
+    /**
+     * @brief 获取会话的对话历史并标记为使用中，不存在时新建
+     * @param key 会话键
+     * @return 对话历史；PSRAM 不足且无法淘汰其他会话时返回 nullptr
+     */
+    ConversationHistory* acquire(const char* key);
+
+    /**
+     * @brief 结束使用会话，执行期间推迟的清空或删除
+     * @param key 会话键
+     */
+    void release(const char* key);
+
+    /**
+     * @brief 清空会话的对话历史
+     * @param key 会话键
+     */
+    void clear(const char* key);
+
+    /**
+     * @brief 删除会话（例如 WebSocket 客户端断开）
+     * @param key 会话键
+     */
+    void remove(const char* key);
+
+    /**
+     * @brief 清空所有会话的对话历史
+     */
+    void clearAll();
+
+    size_t getCount() const { return count; } ///< 当前会话数
+
+private:
+    static const size_t MAX_SESSIONS_LIMIT = 8;
+
+    LLMSession sessions[MAX_SESSIONS_LIMIT];
+    size_t count;
+    size_t maxSessions;
+    size_t historyBytes;
+    size_t maxMessages;
+    SemaphoreHandle_t lock;
+
+    LLMSession* find(const char* key);
+
+    /**
+     * @brief 淘汰最近最少使用的空闲会话
+     * @return 是否淘汰了会话
+     */
+    bool evictLeastRecentlyUsed();
+
+    /**
+     * @brief 删除指定位置的会话（调用方需持有锁）
+     */
+    void removeAt(size_t index);
+};
+
+#endif // LLM_SESSION_TABLE_H
@@ -0,0 +1,190 @@
+/**
+ * @file llm_tls_client.h
+ * @brief 支持 TLS 会话恢复的 LLM 客户端。
+ *
+ * WiFiClientSecure 不提供会话保存/恢复的接口，因此这里直接基于 mbedTLS 实现一个
+ * 可替代 WiFiClientSecure 的 TLS 客户端。每次完整握手后保存会话（Session ID 或 Session Ticket），
+ * 按主机缓存在内存中并持久化到 NVS 分区，重连（包括重启后）时使用简化握手恢复会话。
+ *
+ * 本机构建（env:native）没有 mbedTLS，LLMTlsClient 以明文 TCP 连接，
+ * 实现见 native/src/llm_tls_client_native.cpp。
+ */
+#ifndef LLM_TLS_CLIENT_H
+#define LLM_TLS_CLIENT_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#ifdef ARDUINO
+#include <Preferences.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+#else
+typedef struct mbedtls_ssl_context mbedtls_ssl_context;
+#endif
+
+/**
+ * @brief 按主机缓存 TLS 会话，并持久化到 NVS。
+ *
+ * 线程安全：内部使用互斥锁，可被多个 LLM 客户端共享。
+ */
+class LLMTlsSessionCache {
+public:
+    LLMTlsSessionCache();
+    ~LLMTlsSessionCache();
+
+    /**
+     * @brief 打开 NVS 命名空间。必须在 NVS 可用后调用一次。
+     */
+    void begin();
+
+    /**
+     * @brief 将缓存的会话设置到即将握手的 SSL 上下文中。
+     * @param host 服务器主机名
+     * @param ssl 已完成 setup、尚未握手的 SSL 上下文
+     * @param fingerprint 输出：所提供会话的指纹（主密钥的哈希）。服务器可能不接受该会话而改为完整握手，
+     *                    握手后与 sessionFingerprint() 比较才能确定是否真的恢复了会话；可为 nullptr
+     * @return 若设置了可恢复的会话则返回 true
+     */
+    bool apply(const char* host, mbedtls_ssl_context* ssl, uint64_t* fingerprint = nullptr);
+
+    /**
+     * @brief 已完成握手的连接当前会话的指纹，与 apply() 输出的指纹相同说明服务器恢复了所提供的会话
+     * @param ssl 已完成握手的 SSL 上下文
+     * @return 指纹；读取会话失败时为 0
+     */
+    static uint64_t sessionFingerprint(mbedtls_ssl_context* ssl);
+
+    /**
+     * @brief 握手完成后保存服务器下发的会话。
+     * @param host 服务器主机名
+     * @param ssl 已完成握手的 SSL 上下文
+     */
+    void save(const char* host, mbedtls_ssl_context* ssl);
+
+    /**
+     * @brief 丢弃某主机的会话（例如服务器拒绝恢复导致握手失败）。
+     * @param host 服务器主机名
+     */
+    void forget(const char* host);
+
+    /**
+     * @brief 记录一次握手耗时。
+     * @param resumed 服务器是否恢复了所提供的会话（简化握手）
+     * @param durationMs 握手耗时（毫秒）
+     */
+    void recordHandshake(bool resumed, unsigned long durationMs);
+
+    uint32_t getFullHandshakes() const { return fullHandshakes; }       ///< 完整握手次数
+    uint32_t getResumedHandshakes() const { return resumedHandshakes; } ///< 简化握手次数（服务器接受了所提供的会话）
+    unsigned long getAvgFullHandshakeMs() const;                        ///< 完整握手平均耗时
+    unsigned long getAvgResumedHandshakeMs() const;                     ///< 简化握手平均耗时
+
+private:
+    /**
+     * @brief 单个主机的会话缓存项
+     */
+    struct Entry {
+        char host[64];               ///< 服务器主机名
+        uint8_t* blob;               ///< 序列化的会话（PSRAM）
+        size_t length;               ///< 会话长度
+        bool loaded;                 ///< 是否已尝试从 NVS 加载
+        unsigned long lastPersisted; ///< 上次写入 NVS 的时间（millis）
+        bool persisted;              ///< 是否已写入过 NVS
+    };
+
+    static const size_t MAX_ENTRIES = 4;
+    Entry entries[MAX_ENTRIES];
+    size_t count;
+#ifdef ARDUINO
+    Preferences prefs;
+#endif
+    bool prefsOpen;
+    SemaphoreHandle_t lock;
+
+    uint32_t fullHandshakes;
+    uint32_t resumedHandshakes;
+    unsigned long fullHandshakeMsTotal;
+    unsigned long resumedHandshakeMsTotal;
+
+    Entry* findOrCreate(const char* host);
+    void nvsKeyFor(const char* host, char* key, size_t keySize);
+};
+
+/**
+ * @brief 基于 mbedTLS、支持会话恢复的 TLS 客户端。
+ *
+ * 继承 WiFiClient，可替代 WiFiClientSecure 使用；所有网络读写都走
+ * 自己的 socket 和 SSL 上下文。与原来的 setInsecure() 行为一致，不校验服务器证书。
+ */
+class LLMTlsClient : public WiFiClient {
+public:
+    /**
+     * @brief 构造函数
+     * @param sessionCache 共享的会话缓存，可为 nullptr（不做会话恢复）
+     */
+    LLMTlsClient(LLMTlsSessionCache* sessionCache);
+    ~LLMTlsClient();
+
+    int connect(IPAddress ip, uint16_t port);
+    int connect(IPAddress ip, uint16_t port, int32_t timeout);
+    int connect(const char* host, uint16_t port);
+    int connect(const char* host, uint16_t port, int32_t timeout);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* buf, size_t size);
+    int available();
+    int read();
+    int read(uint8_t* buf, size_t size);
+    int peek();
+    void flush();
+    void stop();
+    uint8_t connected();
+    int setTimeout(uint32_t seconds);
+    operator bool() { return connected(); }
+
+    unsigned long getLastHandshakeMs() const { return lastHandshakeMs; } ///< 上次握手耗时
+    uint32_t getLastDnsMicros() const { return lastDnsMicros; }         ///< 上次连接的域名解析耗时（按 IP 连接时为 0）
+    uint32_t getLastConnectMicros() const { return lastConnectMicros; } ///< 上次连接的 TCP 连接耗时
+    bool wasLastHandshakeResumed() const { return lastHandshakeResumed; } ///< 上次握手是否恢复了缓存会话
+
+private:
+    LLMTlsSessionCache* sessionCache;
+#ifdef ARDUINO
+    mbedtls_net_context net;
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_config conf;
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context drbg;
+    bool contextReady;      ///< mbedTLS 上下文是否已初始化
+#else
+    int sock;               ///< 明文 TCP socket，-1 表示未连接
+#endif
+    bool isConnected;
+    int peekedByte;         ///< peek() 读出的字节，-1 表示无
+    uint32_t timeoutMs;     ///< 读写超时
+    unsigned long lastHandshakeMs;
+    bool lastHandshakeResumed;
+    uint32_t lastDnsMicros;
+    uint32_t lastConnectMicros;
+
+    /**
+     * @brief 建立 TCP 连接并完成 TLS 握手
+     * @param ip 服务器地址
+     * @param host SNI 主机名，也用作会话缓存的键
+     * @param port 端口
+     * @param timeout 连接超时（毫秒）
+     * @param allowResume 是否尝试使用缓存的会话
+     * @return 成功返回 1，失败返回 0
+     */
+    int connectTls(IPAddress ip, const char* host, uint16_t port, int32_t timeout, bool allowResume);
+
+    /**
+     * @brief 释放 socket 和 mbedTLS 上下文
+     */
+    void cleanup();
+};
+
+#endif // LLM_TLS_CLIENT_H
@@ -0,0 +1,103 @@
+/**
+ * @file llm_tool_batch.h
+ * @brief 一轮回复中多个工具调用的批量执行。
+ *
+ * 同一资源（主机 Shell、USB HID、设备 GPIO）上的调用按回复中的顺序依次执行，
+ * 不同资源上的调用在各自的任务中并行执行。每组调用执行期间持有注册表中该资源的锁，
+ * 其他工作任务的批次（包括本地意图快速路径）在同一资源上等待，不会同时操作同一个外设。全部完成后把结果汇总为一条结构化消息，
+ * 每个输出端（WebSocket、USB CDC）只发送一次。
+ */
+#ifndef LLM_TOOL_BATCH_H
+#define LLM_TOOL_BATCH_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "llm_tool_registry.h"
+
+/**
+ * @brief 一个工具调用及其结果
+ */
+struct LLMToolCallResult {
+    const LLMToolSpec* spec;  ///< 工具定义，未知工具为 nullptr
+    const char* name;         ///< 回复中的工具名（指向解析后的文档）
+    JsonObject args;          ///< 工具参数（指向解析后的文档）
+    bool done;                ///< 是否已完成（执行完毕，或因未知工具、参数无效而被拒绝）
+    bool success;             ///< 是否成功
+    String message;           ///< 结果说明或错误信息
+};
+
+/**
+ * @brief 工具调用批量执行器。在处理回复的工作任务中创建，用完即弃。
+ *        工具调用引用的 JSON 文档在 execute() 返回前必须保持有效且不被修改。
+ */
+class LLMToolBatch {
+public:
+    static const size_t MAX_CALLS = 8;    ///< 一轮最多执行的工具调用数，多出的调用记录为被拒绝的结果
+    static const size_t MAX_RESULTS = 16; ///< 最多记录的结果数，更多的调用只计数
+
+    /**
+     * @brief 构造函数
+     * @param registry 工具注册表
+     * @param context 工具执行环境
+     */
+    LLMToolBatch(const LLMToolRegistry& registry, LLMToolContext& context);
+
+    /**
+     * @brief 加入一个工具调用：查找工具并校验参数，失败的调用和超过 MAX_CALLS 的调用直接记录错误结果
+     * @param name 工具名
+     * @param args 工具参数
+     * @return 调用有效、将被执行时返回 true
+     */
+    bool add(const char* name, JsonObject args);
+
+    /**
+     * @brief 执行所有有效的调用。多于一个资源时，除第一个资源外的调用组各在一个临时任务中执行，
+     *        当前任务执行第一组后等待其他组完成；任务创建失败时退回顺序执行
+     */
+    void execute();
+
+    size_t size() const { return count; }           ///< 记录了结果的调用数（含被拒绝的调用）
+    size_t getFailureCount() const;                 ///< 失败或被拒绝的调用数（含超过 MAX_RESULTS 未记录的调用）
+    const LLMToolCallResult& getResult(size_t index) const { return calls[index]; } ///< 按回复中的顺序获取结果
+
+    /**
+     * @brief 以 JSON 数组输出结果：[{"name","args","ok","result"}, ...]
+     * @param out 输出数组
+     */
+    void writeResults(JsonArray out) const;
+
+    /**
+     * @brief 生成给主机的结果摘要，每个有说明的调用一行；所有调用都成功且没有说明时为空
+     */
+    String summarize() const;
+
+private:
+    /**
+     * @brief 临时任务的参数
+     */
+    struct GroupJob {
+        LLMToolBatch* batch;
+        LLMToolResource resource;
+        SemaphoreHandle_t done;
+    };
+
+    const LLMToolRegistry& registry;
+    LLMToolContext& context;
+    LLMToolCallResult calls[MAX_RESULTS];
+    size_t count;
+    size_t unrecorded; ///< 超过 MAX_RESULTS、没有记录结果的调用数
+
+    /**
+     * @brief 持有资源锁，按顺序执行某个资源上的全部调用
+     */
+    void runGroup(LLMToolResource resource);
+
+    /**
+     * @brief 临时任务入口：执行一组调用后通知等待方并删除自身
+     */
+    static void groupTask(void* parameter);
+};
+
+#endif // LLM_TOOL_BATCH_H
@@ -0,0 +1,177 @@
+/**
+ * @file llm_tool_registry.h
+ * @brief LLM 工具注册表：工具名、参数模式和处理函数的表驱动分发。
+ *
+ * 每个工具以编译期常量表描述名称、说明和参数，注册后通过完美哈希按名称 O(1) 查找。
+ * 注册表统一校验参数，并生成高级模式系统提示中的工具说明和原生工具调用的 tools 字段，
+ * 新增工具只需在 llm_tools.cpp 中添加一项。
+ */
+#ifndef LLM_TOOL_REGISTRY_H
+#define LLM_TOOL_REGISTRY_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+class UsbShellManager;
+class HIDManager;
+class HardwareManager;
+
+/**
+ * @brief 工具参数类型
+ */
+enum LLMToolArgType : uint8_t {
+    TOOL_ARG_STRING = 0,  ///< 字符串（必需参数不能为空）
+    TOOL_ARG_INTEGER = 1, ///< 整数
+    TOOL_ARG_BOOLEAN = 2, ///< 布尔值
+    TOOL_ARG_ARRAY = 3    ///< 对象数组
+};
+
+/**
+ * @brief 工具操作的资源。同一资源上的调用按顺序执行，不同资源上的调用可以并行
+ */
+enum LLMToolResource : uint8_t {
+    TOOL_RESOURCE_HOST = 0,   ///< 主机 Shell 通道
+    TOOL_RESOURCE_HID = 1,    ///< USB HID 键盘鼠标
+    TOOL_RESOURCE_DEVICE = 2, ///< 设备本地硬件（GPIO、LED）
+    TOOL_RESOURCE_COUNT = 3
+};
+
+/**
+ * @brief 工具参数模式（编译期常量）
+ */
+struct LLMToolArg {
+    const char* name;        ///< 参数名
+    LLMToolArgType type;     ///< 参数类型
+    bool required;           ///< 是否必需
+    const char* enumValues;  ///< 字符串参数的可选值，以 '|' 分隔（如 "command|text"），不限制时为 nullptr
+    const char* description; ///< 参数说明，没有时为 nullptr
+};
+
+/**
+ * @brief 工具执行环境
+ */
+struct LLMToolContext {
+    const String& requestId;     ///< 触发工具调用的请求ID
+    UsbShellManager* shell;      ///< 主机 Shell 通道
+    HIDManager* hid;             ///< USB HID，可能为空
+    HardwareManager* hardware;   ///< 硬件管理器，可能为空
+};
+
+/**
+ * @brief 工具处理函数。参数已按模式校验。
+ * @param context 执行环境
+ * @param args 工具参数
+ * @param message 输出：成功时的结果说明（可以为空），失败时的错误信息
+ * @return 执行成功返回 true
+ */
+typedef bool (*LLMToolHandler)(LLMToolContext& context, JsonObject args, String& message);
+
+/**
+ * @brief 工具定义（编译期常量）
+ */
+struct LLMToolSpec {
+    const char* name;          ///< 工具名
+    const char* description;   ///< 工具说明，同时用于系统提示和 tools 字段
+    const LLMToolArg* args;    ///< 参数模式
+    uint8_t argCount;          ///< 参数个数
+    LLMToolHandler handler;    ///< 处理函数
+    LLMToolResource resource;  ///< 操作的资源，决定批量执行时能否与其他调用并行
+};
+
+/**
+ * @brief 工具注册表。启动时注册并调用 build()，之后只读，可被所有工作任务并发使用。
+ *        注册表同时持有每个资源的互斥锁，不同工作任务中的工具调用在同一资源上互斥执行。
+ */
+class LLMToolRegistry {
+public:
+    static const size_t MAX_TOOLS = 16;
+    static const size_t TABLE_SIZE = 32; ///< 哈希表槽数（2 的幂，不少于 MAX_TOOLS 的两倍）
+
+    /**
+     * @brief 构造函数
+     */
+    LLMToolRegistry();
+
+    /**
+     * @brief 析构函数，删除资源锁
+     */
+    ~LLMToolRegistry();
+
+    /**
+     * @brief 注册一个工具（需在 build() 之前调用）
+     * @param spec 工具定义，需在注册表的整个生命周期内有效
+     * @return 注册表已满或工具名重复时返回 false
+     */
+    bool add(const LLMToolSpec* spec);
+
+    /**
+     * @brief 为已注册的工具名搜索一个无冲突的哈希种子，建立完美哈希表
+     * @return 找到无冲突的种子时返回 true；否则查找退化为线性扫描
+     */
+    bool build();
+
+    /**
+     * @brief 按名称查找工具：一次哈希加一次字符串比较
+     * @param name 工具名
+     * @return 工具定义，未知工具返回 nullptr
+     */
+    const LLMToolSpec* find(const char* name) const;
+
+    /**
+     * @brief 按参数模式校验工具参数
+     * @param spec 工具定义
+     * @param args 工具参数
+     * @param error 输出：校验失败时的错误信息
+     * @return 参数有效时返回 true
+     */
+    static bool validate(const LLMToolSpec& spec, JsonObject args, String& error);
+
+    /**
+     * @brief 生成系统提示中的工具说明（Markdown，文字工具模式使用）
+     * @return 每个工具一节的说明文本
+     */
+    String renderPromptSection() const;
+
+    /**
+     * @brief 生成 OpenAI 格式的 tools 数组（原生工具调用模式使用）
+     * @param out 输出数组
+     */
+    void writeToolsSchema(JsonArray out) const;
+
+    /**
+     * @brief 占用一个资源：阻塞到其他任务中该资源上的工具调用执行完毕
+     * @param resource 资源
+     */
+    void lockResource(LLMToolResource resource) const;
+
+    /**
+     * @brief 释放 lockResource() 占用的资源
+     * @param resource 资源
+     */
+    void unlockResource(LLMToolResource resource) const;
+
+    size_t getToolCount() const { return toolCount; } ///< 已注册的工具数
+    const LLMToolSpec* getTool(size_t index) const { return tools[index]; } ///< 按注册顺序获取工具
+
+private:
+    const LLMToolSpec* tools[MAX_TOOLS];
+    size_t toolCount;
+    uint8_t table[TABLE_SIZE]; ///< 槽位中存放工具编号 + 1，0 表示空槽
+    uint32_t seed;
+    bool built;
+    SemaphoreHandle_t resourceLocks[TOOL_RESOURCE_COUNT]; ///< 每个资源一个互斥锁（HIDManager、HardwareManager 不是线程安全的）
+
+    /**
+     * @brief 带种子的 32 位 FNV-1a 哈希
+     */
+    static uint32_t hashName(const char* name, uint32_t seed);
+
+    /**
+     * @brief 参数类型在 JSON Schema 中的名称
+     */
+    static const char* typeName(LLMToolArgType type);
+};
+
+#endif // LLM_TOOL_REGISTRY_H
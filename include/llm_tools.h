@@ -0,0 +1,16 @@
+/**
+ * @file llm_tools.h
+ * @brief 内置 LLM 工具：主机 Shell、USB HID 键盘鼠标和 GPIO 输出。
+ */
+#ifndef LLM_TOOLS_H
+#define LLM_TOOLS_H
+
+#include "llm_tool_registry.h"
+
+/**
+ * @brief 注册所有内置工具并建立查找表
+ * @param registry 工具注册表
+ */
+void registerBuiltinTools(LLMToolRegistry& registry);
+
+#endif // LLM_TOOLS_H
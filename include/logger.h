@@ -0,0 +1,139 @@
+/**
+ * @file logger.h
+ * @brief 异步分级日志：调用方只格式化到环形缓冲区，由低优先级任务写出到串口。
+ *
+ * 串口为 115200 波特，直接在请求路径上打印一条 20 KB 的回复会阻塞一秒以上。
+ * 日志记录先写入 PSRAM 中的固定槽位环形缓冲区（多生产者无锁，写满时丢弃新记录并计数），
+ * 后台任务再逐条写出。超过槽位长度的内容被截断，并在末尾注明原始长度。
+ *
+ * 级别分两层：编译期 NOOX_LOG_LEVEL（build_flags 中 -DNOOX_LOG_LEVEL=3 等）之上的调用
+ * 不会被编译；运行期级别（config: log_settings.level）之上的调用在格式化之前返回。
+ */
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <Arduino.h>
+#include "metrics_registry.h"
+
+/**
+ * @brief 日志级别（数值越大越详细）
+ */
+enum LogLevel : uint8_t {
+    LOG_LEVEL_NONE = 0,
+    LOG_LEVEL_ERROR = 1,
+    LOG_LEVEL_WARN = 2,
+    LOG_LEVEL_INFO = 3,
+    LOG_LEVEL_DEBUG = 4
+};
+
+// 编译期级别：高于该级别的日志调用连同参数求值一起被编译器移除
+#ifndef NOOX_LOG_LEVEL
+#define NOOX_LOG_LEVEL 4
+#endif
+
+#define NOOX_LOG(level, tag, ...) \
+    do { \
+        if ((level) <= NOOX_LOG_LEVEL && Logger::instance().isEnabled(level)) \
+            Logger::instance().write((level), (tag), __VA_ARGS__); \
+    } while (0)
+
+#define LOG_E(tag, ...) NOOX_LOG(LOG_LEVEL_ERROR, tag, __VA_ARGS__) ///< 错误
+#define LOG_W(tag, ...) NOOX_LOG(LOG_LEVEL_WARN, tag, __VA_ARGS__)  ///< 警告
+#define LOG_I(tag, ...) NOOX_LOG(LOG_LEVEL_INFO, tag, __VA_ARGS__)  ///< 一般信息
+#define LOG_D(tag, ...) NOOX_LOG(LOG_LEVEL_DEBUG, tag, __VA_ARGS__) ///< 调试信息（完整提示、回复、CDC 消息等大块内容）
+
+/**
+ * @brief 异步日志（进程内唯一）。
+ *
+ * begin() 之前（例如 setup() 早期）的日志直接同步写出到串口。
+ */
+class Logger {
+public:
+    static const size_t SLOT_COUNT = 128;  ///< 环形缓冲区的槽位数
+    static const size_t TEXT_SIZE = 240;   ///< 每条记录正文的最大长度（含结尾的 '\0'）
+
+    /**
+     * @brief 获取日志实例
+     */
+    static Logger& instance();
+
+    /**
+     * @brief 分配环形缓冲区并启动写出任务。应在 Serial.begin() 之后尽早调用
+     */
+    void begin();
+
+    /**
+     * @brief 设置运行期级别
+     */
+    void setLevel(LogLevel newLevel) { __atomic_store_n(&level, (uint8_t)newLevel, __ATOMIC_RELAXED); }
+
+    /**
+     * @brief 从配置设置运行期级别："error"、"warn"、"info"、"debug" 或 "none"，无法识别时为 info
+     * @param name 级别名称
+     */
+    void setLevel(const char* name);
+
+    LogLevel getLevel() const { return (LogLevel)__atomic_load_n(&level, __ATOMIC_RELAXED); } ///< 运行期级别
+
+    /**
+     * @brief 某级别的日志当前是否输出
+     */
+    bool isEnabled(LogLevel messageLevel) const { return messageLevel <= __atomic_load_n(&level, __ATOMIC_RELAXED); }
+
+    /**
+     * @brief 写入一条日志（通常通过 LOG_E/LOG_W/LOG_I/LOG_D 调用）。不会阻塞：缓冲区满时丢弃并计数
+     * @param messageLevel 级别
+     * @param tag 模块标签（静态字符串，如 "LLM"）
+     * @param format printf 格式
+     */
+    void write(LogLevel messageLevel, const char* tag, const char* format, ...)
+        __attribute__((format(printf, 4, 5)));
+
+    uint32_t getDropped() const { return dropped->get(); }     ///< 缓冲区满而丢弃的记录数
+    uint32_t getTruncated() const { return truncated->get(); } ///< 被截断的记录数
+
+private:
+    /**
+     * @brief 环形缓冲区中的一个槽位。
+     *
+     * seq 表示槽位状态：等于写入位置时空闲，等于写入位置 + 1 时已写好待写出，
+     * 写出后加上 SLOT_COUNT 留给下一轮。
+     */
+    struct Slot {
+        uint32_t seq;
+        uint32_t timeMs;
+        const char* tag;
+        uint16_t length;
+        uint8_t level;
+        char text[TEXT_SIZE];
+    };
+
+    Slot* slots;            ///< 环形缓冲区（PSRAM）
+    uint32_t head;          ///< 下一个写入位置（生产者以 CAS 占用；位于内部 RAM，PSRAM 上不能做原子比较交换）
+    uint32_t tail;          ///< 下一个写出位置（只由写出任务访问）
+    uint8_t level;          ///< 运行期级别
+    uint32_t reportedDrops; ///< 写出任务已报告过的丢弃数
+    MetricCounter* records;
+    MetricCounter* dropped;
+    MetricCounter* truncated;
+
+    Logger();
+
+    /**
+     * @brief 写出任务：取出已写好的记录并输出到串口，缓冲区空时休眠
+     */
+    static void drainTask(void* parameter);
+
+    /**
+     * @brief 写出当前已写好的全部记录
+     * @return 写出的记录数
+     */
+    size_t drain();
+
+    /**
+     * @brief 输出一条记录
+     */
+    static void emit(uint32_t timeMs, LogLevel messageLevel, const char* tag, const char* text, size_t length);
+};
+
+#endif // LOGGER_H
@@ -0,0 +1,184 @@
+/**
+ * @file metrics_registry.h
+ * @brief 全局指标注册表：计数器、仪表和固定分桶直方图。
+ *
+ * 各管理器在构造时注册自己的指标并保存返回的指针，运行期间直接更新。
+ * 更新都是无锁的原子操作（计数器和仪表一次原子操作，直方图为所在桶和总和各一次），
+ * 不会因为统计而阻塞热路径。注册表以 Prometheus 文本格式（GET /metrics）
+ * 和紧凑 JSON（USB CDC 的 metricsSnapshot 消息）导出。
+ *
+ * 指标名、说明和标签必须是静态字符串（通常为字面量），注册表只保存指针。
+ */
+#ifndef METRICS_REGISTRY_H
+#define METRICS_REGISTRY_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/**
+ * @brief 指标类型
+ */
+enum MetricType : uint8_t {
+    METRIC_COUNTER = 0,  ///< 只增不减的计数
+    METRIC_GAUGE = 1,    ///< 可增可减的当前值
+    METRIC_HISTOGRAM = 2 ///< 固定分桶的分布
+};
+
+/**
+ * @brief 仪表的读取函数：导出时调用，用于堆内存、RSSI 等直接从系统读取的值
+ */
+typedef int32_t (*MetricGaugeReader)(void* context);
+
+/**
+ * @brief 计数器
+ */
+class MetricCounter {
+public:
+    void inc(uint32_t n = 1) { __atomic_fetch_add(&value, n, __ATOMIC_RELAXED); } ///< 增加
+    uint32_t get() const { return __atomic_load_n(&value, __ATOMIC_RELAXED); }   ///< 当前值
+
+private:
+    friend class MetricsRegistry;
+    uint32_t value;
+};
+
+/**
+ * @brief 仪表
+ */
+class MetricGauge {
+public:
+    void set(int32_t v) { __atomic_store_n(&value, v, __ATOMIC_RELAXED); }       ///< 设置
+    void add(int32_t delta) { __atomic_fetch_add(&value, delta, __ATOMIC_RELAXED); } ///< 增减
+    int32_t get() const;                                                         ///< 当前值（有读取函数时调用读取函数）
+
+private:
+    friend class MetricsRegistry;
+    int32_t value;
+    MetricGaugeReader reader;
+    void* readerContext;
+};
+
+/**
+ * @brief 固定分桶的直方图。桶上限在注册时给定，观测值为整数（单位由指标名表示，如 _ms、_bytes）
+ */
+class MetricHistogram {
+public:
+    static const size_t MAX_BOUNDS = 12; ///< 最多的桶上限数（另有一个 +Inf 桶）
+
+    /**
+     * @brief 记录一个观测值：所在桶和总和各一次原子加法
+     */
+    void observe(uint32_t v);
+
+    uint32_t getCount() const; ///< 观测次数（各桶之和）
+
+private:
+    friend class MetricsRegistry;
+    const uint32_t* bounds;            ///< 桶上限（升序，静态数组）
+    uint8_t boundCount;
+    uint32_t buckets[MAX_BOUNDS + 1];  ///< 各桶的观测次数（非累积），最后一个为 +Inf
+    uint32_t sum;
+};
+
+/**
+ * @brief 指标注册表（进程内唯一）。
+ *
+ * 注册在启动时进行（用自旋锁保护，可在全局对象构造期间调用）；
+ * 导出时不加锁，读取已注册的指标。容量用完时注册返回一个共享的占位指标，
+ * 调用方无需判断空指针，写入的值不会被导出。
+ */
+class MetricsRegistry {
+public:
+    static const size_t MAX_COUNTERS = 48;
+    static const size_t MAX_GAUGES = 24;
+    static const size_t MAX_HISTOGRAMS = 8;
+
+    /**
+     * @brief 获取注册表（首次调用时构造，并注册系统仪表：堆、PSRAM、运行时间）
+     */
+    static MetricsRegistry& instance();
+
+    /**
+     * @brief 注册计数器
+     * @param name 指标名（Prometheus 命名，计数器以 _total 结尾）
+     * @param help 说明
+     * @param labels 标签，如 "reason=\"cancelled\""；nullptr 表示无标签
+     */
+    MetricCounter* counter(const char* name, const char* help, const char* labels = nullptr);
+
+    /**
+     * @brief 注册仪表
+     * @param reader 读取函数，nullptr 表示由调用方 set()/add() 更新
+     * @param context 传给读取函数的参数
+     */
+    MetricGauge* gauge(const char* name, const char* help, const char* labels = nullptr,
+                       MetricGaugeReader reader = nullptr, void* context = nullptr);
+
+    /**
+     * @brief 注册直方图
+     * @param bounds 桶上限（升序，静态数组）
+     * @param boundCount 桶上限数（最多 MAX_BOUNDS）
+     */
+    MetricHistogram* histogram(const char* name, const char* help, const uint32_t* bounds, size_t boundCount,
+                               const char* labels = nullptr);
+
+    /**
+     * @brief 以 Prometheus 文本格式（0.0.4）输出所有指标
+     * @param out 输出流
+     */
+    void writePrometheus(Print& out) const;
+
+    /**
+     * @brief 以紧凑 JSON 输出所有指标：键为 "name" 或 "name{labels}"，
+     *        计数器和仪表为数值，直方图为 [count, sum, 各桶次数...]（非累积，桶上限同 /metrics）
+     * @param out 输出对象
+     */
+    void writeCompact(JsonObject out) const;
+
+private:
+    /**
+     * @brief 注册表中的一项
+     */
+    struct Entry {
+        const char* name;
+        const char* help;
+        const char* labels;
+        MetricType type;
+        uint8_t index;      ///< 在对应类型数组中的位置
+    };
+
+    static const size_t MAX_ENTRIES = MAX_COUNTERS + MAX_GAUGES + MAX_HISTOGRAMS;
+
+    MetricCounter counters[MAX_COUNTERS];
+    MetricGauge gauges[MAX_GAUGES];
+    MetricHistogram histograms[MAX_HISTOGRAMS];
+    Entry entries[MAX_ENTRIES];
+    size_t entryCount;      ///< 已发布的项数（导出方以 acquire 读取）
+    uint8_t counterCount;
+    uint8_t gaugeCount;
+    uint8_t histogramCount;
+
+    MetricCounter overflowCounter;     ///< 容量用完时返回的占位指标
+    MetricGauge overflowGauge;
+    MetricHistogram overflowHistogram;
+
+    MetricsRegistry();
+
+    /**
+     * @brief 发布一项（调用方需持有注册锁）
+     */
+    void publish(const char* name, const char* help, const char* labels, MetricType type, uint8_t index);
+
+    /**
+     * @brief 该指标名在 index 之前是否已出现（同名的各项在第一次出现时一起输出）
+     */
+    bool seenBefore(size_t index) const;
+
+    /**
+     * @brief 输出一行样本：name[suffix]{labels[,extra]} value
+     */
+    static void writeSample(Print& out, const Entry& entry, const char* suffix, const char* extraLabel,
+                            const char* value);
+};
+
+#endif // METRICS_REGISTRY_H
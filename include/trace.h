@@ -0,0 +1,149 @@
+/**
+ * @file trace.h
+ * @brief 跨任务的区间追踪，导出为 Chrome trace 格式（可在 Perfetto / chrome://tracing 中打开）。
+ *
+ * 每个 FreeRTOS 任务（本机构建中为每个线程）有自己的事件环形缓冲区，只由该任务写入，
+ * 记录时不加锁。时间戳来自 esp_timer（微秒）。区间在结束时记录为一个完整事件（"X"），
+ * 环形覆盖旧事件后也不会留下不配对的开始或结束。跨任务的请求生命周期用异步事件（"b"/"e"）
+ * 按 id 关联。
+ *
+ * 编译时定义 NOOX_TRACE=1 启用（build_flags 中 -DNOOX_TRACE=1）；未启用时所有宏为空，
+ * 不产生任何代码。导出：GET /api/trace，或 GET /api/trace?save=1 写入 FFat（U 盘）的 /trace.json。
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#ifndef NOOX_TRACE
+#define NOOX_TRACE 0
+#endif
+
+#if NOOX_TRACE
+
+#include <Arduino.h>
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(_traceScope, __LINE__)(name) ///< 当前作用域为一个区间
+#define TRACE_BEGIN(name) Tracer::instance().begin(name)                        ///< 开始一个区间（与 TRACE_END 成对，可嵌套）
+#define TRACE_END() Tracer::instance().end()                                     ///< 结束最近开始的区间
+#define TRACE_INSTANT(name) Tracer::instance().instant(name)                     ///< 一个瞬时事件
+#define TRACE_ASYNC_BEGIN(name, id) Tracer::instance().async('b', name, id)      ///< 跨任务区间开始（如请求提交）
+#define TRACE_ASYNC_END(name, id) Tracer::instance().async('e', name, id)        ///< 跨任务区间结束（可在另一个任务中调用）
+
+/**
+ * @brief 区间追踪器（进程内唯一）。
+ */
+class Tracer {
+public:
+    static const size_t MAX_TASKS = 10;         ///< 最多追踪的任务数，之后出现的任务不记录
+    static const size_t EVENTS_PER_TASK = 256;  ///< 每个任务保留的最近事件数
+    static const size_t MAX_DEPTH = 8;          ///< TRACE_BEGIN 的最大嵌套深度
+
+    /**
+     * @brief 获取追踪器
+     */
+    static Tracer& instance();
+
+    /**
+     * @brief 开始一个区间
+     * @param name 区间名称（静态字符串）
+     */
+    void begin(const char* name);
+
+    /**
+     * @brief 结束最近开始的区间，记录为一个完整事件
+     */
+    void end();
+
+    /**
+     * @brief 记录一个瞬时事件
+     */
+    void instant(const char* name);
+
+    /**
+     * @brief 记录一个异步事件
+     * @param phase 'b' 开始，'e' 结束
+     * @param name 名称（开始和结束须相同）
+     * @param id 关联开始和结束的 id（如请求序号）
+     */
+    void async(char phase, const char* name, uint32_t id);
+
+    /**
+     * @brief 以 Chrome trace JSON 输出所有任务的事件
+     * @param out 输出流
+     * @return 输出的事件数
+     */
+    size_t writeChromeTrace(Print& out);
+
+private:
+    /**
+     * @brief 一个事件
+     */
+    struct Event {
+        const char* name;
+        uint64_t ts;        ///< 开始时间（微秒）
+        uint32_t dur;       ///< 持续时间（微秒，仅完整事件）
+        uint32_t id;        ///< 异步事件 id
+        char phase;         ///< 'X'、'i'、'b'、'e'
+    };
+
+    /**
+     * @brief 一个任务的追踪状态，只由该任务写入
+     */
+    struct TaskTrace {
+        void* key;                      ///< 任务句柄（本机构建中为线程 id），nullptr 表示空闲
+        char name[16];                  ///< 任务名
+        Event* events;                  ///< 事件环形缓冲区（PSRAM）
+        uint32_t written;               ///< 累计写入的事件数（导出方以 acquire 读取）
+        const char* openNames[MAX_DEPTH]; ///< 未结束的区间
+        uint64_t openStarts[MAX_DEPTH];
+        uint8_t depth;
+        uint32_t overflow;              ///< 超过嵌套深度而未记录的区间数
+    };
+
+    TaskTrace tasks[MAX_TASKS];
+
+    Tracer();
+
+    /**
+     * @brief 当前任务的追踪状态，首次调用时登记并分配缓冲区；任务表已满时返回 nullptr
+     */
+    TaskTrace* current();
+
+    /**
+     * @brief 写入一个事件
+     */
+    static void record(TaskTrace* task, char phase, const char* name, uint64_t ts, uint32_t dur, uint32_t id);
+
+    /**
+     * @brief 当前时间（微秒）
+     */
+    static uint64_t now();
+};
+
+/**
+ * @brief 作用域区间：构造时开始，析构时结束
+ */
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) { Tracer::instance().begin(name); }
+    ~TraceScope() { Tracer::instance().end(); }
+
+private:
+    TraceScope(const TraceScope&);
+    TraceScope& operator=(const TraceScope&);
+};
+
+#else // NOOX_TRACE
+
+#define TRACE_SCOPE(name) do {} while (0)
+#define TRACE_BEGIN(name) do {} while (0)
+#define TRACE_END() do {} while (0)
+#define TRACE_INSTANT(name) do {} while (0)
+#define TRACE_ASYNC_BEGIN(name, id) do {} while (0)
+#define TRACE_ASYNC_END(name, id) do {} while (0)
+
+#endif // NOOX_TRACE
+
+#endif // TRACE_H
@@ -4,6 +4,7 @@
 #include "hardware_manager.h"
 #include "wifi_manager.h"   // Include WiFiManager
 #include "llm_manager.h"    // Include LLMManager
+#include "metrics_registry.h"
 
 // Define UI states for different screens
 enum UIState {
@@ -36,6 +37,11 @@ private:
     bool buttonB_event = false;
     bool buttonC_event = false;
 
+    // Metrics: frames drawn, time per update, debounced button presses
+    MetricCounter* frames;
+    MetricHistogram* frameTime;
+    MetricCounter* buttonPresses;
+
     // State Handlers
     void handleStateStatus();
     void handleStateMainMenu();
@@ -18,6 +18,9 @@
 #include <USBCDC.h>
 #include <USBMSC.h>
 #include <ArduinoJson.h> // JSON解析库
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "metrics_registry.h"
 
 // 前向声明LLMManager类（AI管理器）
 class LLMManager;
@@ -64,6 +67,13 @@ public:
      */
     void sendAiResponseToHost(const String& requestId, const String& response);
 
+    /**
+     * @brief 向主机发送流式AI响应的增量片段
+     * @param requestId 请求ID
+     * @param delta 本次新增的响应文本（完整回复仍会以aiResponse发送）
+     */
+    void sendAiResponseDeltaToHost(const String& requestId, const String& delta);
+
     /**
      * @brief 向主机发送链路测试结果
      * @param requestId 请求ID
@@ -80,6 +90,18 @@ public:
      */
     void sendWifiConnectStatusToHost(const String& requestId, bool success, const String& message);
 
+    /**
+     * @brief 向主机发送 LLM 请求指标（各阶段耗时统计）
+     * @param requestId 请求ID
+     */
+    void sendMetricsToHost(const String& requestId);
+
+    /**
+     * @brief 向主机发送指标注册表的紧凑快照（所有管理器的计数器、仪表和直方图）
+     * @param requestId 请求ID
+     */
+    void sendMetricsSnapshotToHost(const String& requestId);
+
     /**
      * @brief 模拟键盘输入来启动主机代理程序
      * @param wifiStatus 当前WiFi状态，将作为启动参数传递
@@ -91,6 +113,11 @@ private:
     AppWiFiManager* _wifiManager;   // WiFi管理器指针
     USBCDC _cdc;                    // USB CDC（串口）实例
     String _inputBuffer;            // 串口数据接收缓冲区
+    SemaphoreHandle_t _sendLock;    // 多个 LLM 工作任务同时发送时，保证每条消息整行写出
+    MetricCounter* _received;       // 收到的主机消息数
+    MetricCounter* _invalid;        // 无法解析或类型未知的主机消息数
+    MetricCounter* _sent;           // 发给主机的消息数
+    MetricCounter* _sentBytes;      // 发给主机的字节数
 
     /**
      * @brief 处理USB串口接收到的数据
@@ -12,6 +12,7 @@
 #include "llm_manager.h"
 #include "wifi_manager.h"
 #include "config_manager.h"
+#include "metrics_registry.h"
 #include <ArduinoJson.h>
 #include <freertos/queue.h>
 
@@ -58,6 +59,11 @@ private:
     LLMMode currentLLMMode;
     bool configUpdatePending = false;
     JsonDocument pendingConfigDoc;
+    MetricGauge* wsClients;          ///< 已连接的 WebSocket 客户端数
+    MetricCounter* wsReceived;       ///< 收到的 WebSocket 消息数
+    MetricCounter* wsSent;           ///< 发出的 WebSocket 消息数（广播按一条计）
+    MetricCounter* configSaved;      ///< 保存成功的配置更新数
+    MetricCounter* configFailed;     ///< 保存失败的配置更新数
 
     /**
      * @brief WebSocket 事件处理回调函数。
@@ -77,11 +83,23 @@ private:
     /**
      * @brief 创建并发送LLM请求的辅助方法。
      * @param requestId 请求ID。
+     * @param sessionKey 会话键，决定使用哪一份对话历史。
+     * @param clientId 发起请求的 WebSocket 客户端ID，响应只发回该客户端。
      * @param payload 用户输入的内容。
      * @param mode LLM模式。
      * @return 成功返回true，失败返回false。
      */
-    bool createAndSendLLMRequest(const String& requestId, const String& payload, LLMMode mode);
+    bool createAndSendLLMRequest(const String& requestId, const String& sessionKey, uint32_t clientId, const String& payload, LLMMode mode);
+
+    /**
+     * @brief 获取 WebSocket 客户端的会话键：消息带 sessionId 时为 "web:<sessionId>"，否则为 "ws:<客户端ID>"。
+     */
+    static String getSessionKey(AsyncWebSocketClient *client, JsonDocument& doc);
+
+    /**
+     * @brief 把 LLM 输出发给发起请求的客户端；clientId 为 0（非 Web 请求）时广播。
+     */
+    void sendToClient(uint32_t clientId, const String& message);
 };
 
 #endif // WEB_MANAGER_H
@@ -4,6 +4,7 @@
 #include <WiFi.h>
 // #include "llm_manager.h" // Removed direct dependency
 #include "config_manager.h"
+#include "metrics_registry.h"
 #include <ArduinoJson.h>
 
 class AppWiFiManager {
@@ -35,7 +36,10 @@ private:
 
     WiFiConnectionState _connectionState = IDLE;
     unsigned long _connectionAttemptStartTime = 0;
-    const long WIFI_CONNECTION_TIMEOUT_MS = 30000; // 30 seconds timeout
+    const unsigned long WIFI_CONNECTION_TIMEOUT_MS = 30000; // 30 seconds timeout
+    MetricCounter* _connectAttempts;  // Connections initiated
+    MetricCounter* _connectTimeouts;  // Connections that timed out
+    MetricCounter* _connectionsLost;  // Established connections that dropped
 
     void connectToLastSSID();
     void handleWiFiConnection();
@@ -0,0 +1,109 @@
+/**
+ * @file Arduino.h
+ * @brief 本机构建（[env:native]）的 Arduino 核心替身。
+ *
+ * 只提供管理器代码用到的部分：String、Print/Stream、时间、GPIO、ps_malloc、ESP 和 Serial。
+ * 不定义 ARDUINO 宏，代码中以 #ifdef ARDUINO 区分板上和本机的实现。
+ * Serial（调试日志）写到 stderr，stdout 留给 CDC（见 USBCDC.h）。
+ */
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <algorithm>
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "IPAddress.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+using std::max;
+using std::min;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define PULLUP 0x04
+#define INPUT_PULLUP 0x05
+#define PULLDOWN 0x08
+#define INPUT_PULLDOWN 0x09
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+/**
+ * @brief GPIO：本机构建中只记录电平，digitalRead 返回最后写入的电平
+ */
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+void* ps_malloc(size_t size);
+void* ps_calloc(size_t n, size_t size);
+void* ps_realloc(void* ptr, size_t size);
+
+/**
+ * @brief ps_malloc/ps_calloc/ps_realloc 和带 MALLOC_CAP_SPIRAM 的 heap_caps 分配的累计次数
+ *        （本机构建专用，供单元测试比较 PSRAM 分配次数）
+ */
+uint32_t psramAllocationCount();
+
+long random(long max);
+long random(long min, long max);
+
+/**
+ * @brief 主机时钟已由系统同步，不做任何事
+ */
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1, const char* server2 = nullptr,
+                const char* server3 = nullptr);
+
+/**
+ * @brief 调试串口：写到 stderr，不接收输入
+ */
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    void end() {}
+    int available() { return 0; }
+    int read() { return -1; }
+    int peek() { return -1; }
+    void flush();
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* buffer, size_t size);
+    using Print::write;
+    operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+    uint32_t getHeapSize();
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getMaxAllocHeap();
+    uint32_t getPsramSize();
+    uint32_t getFreePsram();
+    uint32_t getMinFreePsram();
+    uint32_t getMaxAllocPsram();
+    const char* getSdkVersion() { return "native"; }
+    void restart();
+};
+
+extern EspClass ESP;
+
+#endif // NATIVE_ARDUINO_H
@@ -0,0 +1,96 @@
+/**
+ * @file FS.h
+ * @brief 本机构建的文件系统替身：把板上的路径映射到主机目录下的普通文件。
+ */
+#ifndef NATIVE_FS_H
+#define NATIVE_FS_H
+
+#include <Arduino.h>
+#include <memory>
+
+namespace fs {
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+enum SeekMode {
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+};
+
+class FileImpl;
+
+/**
+ * @brief 打开的文件；拷贝共享同一个句柄，与 arduino-esp32 一致
+ */
+class File : public Stream {
+public:
+    File() {}
+    explicit File(std::shared_ptr<FileImpl> impl) : impl(impl) {}
+
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* buf, size_t size);
+    using Print::write;
+    int available();
+    int read();
+    int peek();
+    void flush();
+    size_t read(uint8_t* buf, size_t size);
+    size_t readBytes(char* buffer, size_t length) { return read((uint8_t*)buffer, length); }
+    bool seek(uint32_t pos, SeekMode mode = SeekSet);
+    size_t position() const;
+    size_t size() const;
+    void close();
+    operator bool() const;
+    const char* path() const;
+    const char* name() const;
+    bool isDirectory() const;
+
+private:
+    std::shared_ptr<FileImpl> impl;
+};
+
+class FS {
+public:
+    /**
+     * @param root 主机上的根目录
+     */
+    explicit FS(const char* root) : rootDir(root) {}
+
+    /**
+     * @brief 设置主机上的根目录（在 begin() 之前调用）
+     */
+    void setRoot(const char* root) { rootDir = root; }
+    const char* getRoot() const { return rootDir.c_str(); }
+
+    File open(const char* path, const char* mode = FILE_READ, bool create = false);
+    File open(const String& path, const char* mode = FILE_READ, bool create = false) {
+        return open(path.c_str(), mode, create);
+    }
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* pathFrom, const char* pathTo);
+    bool mkdir(const char* path);
+    bool mkdir(const String& path) { return mkdir(path.c_str()); }
+    bool rmdir(const char* path);
+
+protected:
+    String rootDir;
+
+    String hostPath(const char* path) const;
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+
+#endif // NATIVE_FS_H
@@ -0,0 +1,35 @@
+/**
+ * @file FastLED.h
+ * @brief 本机构建的 RGB LED 接口（只保存颜色，不输出）。
+ */
+#ifndef NATIVE_FASTLED_H
+#define NATIVE_FASTLED_H
+
+#include "Arduino.h"
+
+struct CRGB {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+
+    CRGB() : r(0), g(0), b(0) {}
+    CRGB(uint8_t red, uint8_t green, uint8_t blue) : r(red), g(green), b(blue) {}
+    CRGB(uint32_t colorcode) : r((colorcode >> 16) & 0xFF), g((colorcode >> 8) & 0xFF), b(colorcode & 0xFF) {}
+};
+
+enum ESPIChipsets { NEOPIXEL };
+
+class CFastLED {
+public:
+    template <ESPIChipsets CHIPSET, uint8_t DATA_PIN>
+    void addLeds(CRGB* data, int count) {
+        (void)data;
+        (void)count;
+    }
+
+    void show() {}
+};
+
+extern CFastLED FastLED;
+
+#endif // NATIVE_FASTLED_H
@@ -0,0 +1,29 @@
+/**
+ * @file IPAddress.h
+ * @brief 本机构建的 IPv4 地址替身。
+ */
+#ifndef NATIVE_IPADDRESS_H
+#define NATIVE_IPADDRESS_H
+
+#include "Print.h"
+
+class IPAddress : public Printable {
+public:
+    IPAddress() : address(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+        : address((uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24)) {}
+    IPAddress(uint32_t value) : address(value) {}
+
+    operator uint32_t() const { return address; }
+    uint8_t operator[](int index) const { return (address >> (8 * index)) & 0xFF; }
+    bool operator==(const IPAddress& rhs) const { return address == rhs.address; }
+
+    bool fromString(const char* text);
+    String toString() const;
+    size_t printTo(Print& p) const { return p.print(toString()); }
+
+private:
+    uint32_t address; ///< 网络字节序（与 arduino-esp32 相同）
+};
+
+#endif // NATIVE_IPADDRESS_H
@@ -0,0 +1,34 @@
+/**
+ * @file LittleFS.h
+ * @brief 本机构建的 LittleFS 替身：根目录缺省为当前目录下的 native_fs/，
+ *        可用环境变量 NOOX_FS_ROOT 指定。
+ */
+#ifndef NATIVE_LITTLEFS_H
+#define NATIVE_LITTLEFS_H
+
+#include "FS.h"
+
+namespace fs {
+
+class LittleFSFS : public FS {
+public:
+    LittleFSFS() : FS("native_fs") {}
+
+    /**
+     * @brief 挂载：创建主机上的根目录（不存在时）
+     */
+    bool begin(bool formatOnFail = false, const char* basePath = "/littlefs", uint8_t maxOpenFiles = 10,
+               const char* partitionLabel = "spiffs");
+    void end() {}
+    size_t totalBytes() { return BOARD_LITTLEFS_BYTES; }
+    size_t usedBytes();
+
+private:
+    static const size_t BOARD_LITTLEFS_BYTES = 0x200000; ///< 与 platformio.ini 中的 BOARD_LITTLEFS_SIZE 相同
+};
+
+} // namespace fs
+
+extern fs::LittleFSFS LittleFS;
+
+#endif // NATIVE_LITTLEFS_H
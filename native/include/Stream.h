@@ -0,0 +1,36 @@
+/**
+ * @file Stream.h
+ * @brief 本机构建的 Stream 替身：带超时的 readBytes 等，接口与 arduino-esp32 一致。
+ */
+#ifndef NATIVE_STREAM_H
+#define NATIVE_STREAM_H
+
+#include "Print.h"
+
+class Stream : public Print {
+public:
+    Stream() : _timeout(1000) {}
+
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+    unsigned long getTimeout() const { return _timeout; }
+
+    /**
+     * @brief 读取最多 length 字节，每个字节最多等待超时时间
+     * @return 读到的字节数
+     */
+    virtual size_t readBytes(char* buffer, size_t length);
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+    String readString();
+    String readStringUntil(char terminator);
+
+protected:
+    unsigned long _timeout;
+
+    int timedRead();
+};
+
+#endif // NATIVE_STREAM_H
@@ -0,0 +1,31 @@
+/**
+ * @file U8g2lib.h
+ * @brief 本机构建的 OLED 显示接口。
+ *
+ * 本机构建不包含 UIManager，这里只提供 HardwareManager 用到的构造和 begin()。
+ */
+#ifndef NATIVE_U8G2LIB_H
+#define NATIVE_U8G2LIB_H
+
+#include "Arduino.h"
+
+#define U8X8_PIN_NONE 255
+
+struct u8g2_cb_t {
+    uint8_t rotation;
+};
+
+static const u8g2_cb_t U8G2_R0_VALUE = {0};
+#define U8G2_R0 (&U8G2_R0_VALUE)
+
+class U8G2_SSD1315_128X64_NONAME_F_HW_I2C {
+public:
+    U8G2_SSD1315_128X64_NONAME_F_HW_I2C(const u8g2_cb_t* rotation, uint8_t reset = U8X8_PIN_NONE) {
+        (void)rotation;
+        (void)reset;
+    }
+
+    bool begin() { return true; }
+};
+
+#endif // NATIVE_U8G2LIB_H
@@ -0,0 +1,21 @@
+/**
+ * @file USB.h
+ * @brief 本机构建的 USB 复合设备替身。
+ */
+#ifndef NATIVE_USB_H
+#define NATIVE_USB_H
+
+#include <Arduino.h>
+
+class ESPUSB {
+public:
+    bool begin() { started = true; return true; }
+    operator bool() const { return started; }
+
+private:
+    bool started = false;
+};
+
+extern ESPUSB USB;
+
+#endif // NATIVE_USB_H
@@ -0,0 +1,45 @@
+/**
+ * @file USBCDC.h
+ * @brief 本机构建的 USB CDC 替身：主机一侧接到进程的 stdin / stdout。
+ *
+ * 每行一条 JSON，与主机代理经 CDC 收发的内容相同，因此可以直接用管道驱动：
+ * echo '{"type":"linkTest","requestId":"1"}' | .pio/build/native/program
+ */
+#ifndef NATIVE_USBCDC_H
+#define NATIVE_USBCDC_H
+
+#include "USB.h"
+
+class USBCDC : public Stream {
+public:
+    /**
+     * @brief 启动 stdin 读取线程
+     */
+    void begin(unsigned long baud = 0);
+    void end() {}
+    int available();
+    int read();
+    int peek();
+    void flush();
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* buffer, size_t size);
+    using Print::write;
+    operator bool() const { return true; }
+
+    /**
+     * @brief 把数据放入输入缓冲区，与从 stdin 收到的相同（本机构建专用，供单元测试模拟主机）
+     */
+    static void injectInput(const char* data);
+
+    /**
+     * @brief 开始或停止截获输出：截获期间写入的数据存入缓冲区，不写到 stdout（本机构建专用）
+     */
+    static void captureOutput(bool enabled);
+
+    /**
+     * @brief 取走并清空截获的输出（本机构建专用）
+     */
+    static String takeOutput();
+};
+
+#endif // NATIVE_USBCDC_H
@@ -0,0 +1,16 @@
+/**
+ * @file USBHID.h
+ * @brief 本机构建的 USB HID 替身。
+ */
+#ifndef NATIVE_USBHID_H
+#define NATIVE_USBHID_H
+
+#include "USB.h"
+
+class USBHID {
+public:
+    void begin() {}
+    bool ready() { return true; }
+};
+
+#endif // NATIVE_USBHID_H
@@ -0,0 +1,45 @@
+/**
+ * @file USBHIDMouse.h
+ * @brief 本机构建的 HID 鼠标替身：按键常量与 arduino-esp32 / TinyUSB 相同，移动只累计不发送。
+ */
+#ifndef NATIVE_USBHIDMOUSE_H
+#define NATIVE_USBHIDMOUSE_H
+
+#include "USBHID.h"
+
+#define MOUSE_LEFT 0x01
+#define MOUSE_RIGHT 0x02
+#define MOUSE_MIDDLE 0x04
+#define MOUSE_BACKWARD 0x08
+#define MOUSE_FORWARD 0x10
+#define MOUSE_ALL 0x1F
+
+enum {
+    MOUSE_BUTTON_LEFT = MOUSE_LEFT,
+    MOUSE_BUTTON_RIGHT = MOUSE_RIGHT,
+    MOUSE_BUTTON_MIDDLE = MOUSE_MIDDLE,
+    MOUSE_BUTTON_BACKWARD = MOUSE_BACKWARD,
+    MOUSE_BUTTON_FORWARD = MOUSE_FORWARD
+};
+
+class USBHIDMouse {
+public:
+    USBHIDMouse() : buttons(0), x(0), y(0) {}
+    void begin() {}
+    void end() {}
+    void click(uint8_t b = MOUSE_LEFT) { press(b); release(b); }
+    void move(int8_t dx, int8_t dy, int8_t wheel = 0, int8_t pan = 0) { (void)wheel; (void)pan; x += dx; y += dy; }
+    void press(uint8_t b = MOUSE_LEFT) { buttons |= b; }
+    void release(uint8_t b = MOUSE_LEFT) { buttons &= ~b; }
+    bool isPressed(uint8_t b = MOUSE_LEFT) { return (buttons & b) != 0; }
+
+    long getX() const { return x; } ///< 累计的水平移动（本机构建专用）
+    long getY() const { return y; } ///< 累计的垂直移动（本机构建专用）
+
+private:
+    uint8_t buttons;
+    long x;
+    long y;
+};
+
+#endif // NATIVE_USBHIDMOUSE_H
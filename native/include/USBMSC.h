@@ -0,0 +1,20 @@
+/**
+ * @file USBMSC.h
+ * @brief 本机构建的 USB 大容量存储替身（不导出任何介质）。
+ */
+#ifndef NATIVE_USBMSC_H
+#define NATIVE_USBMSC_H
+
+#include "USB.h"
+
+class USBMSC {
+public:
+    void vendorID(const char* vid) { (void)vid; }
+    void productID(const char* pid) { (void)pid; }
+    void productRevision(const char* rev) { (void)rev; }
+    void mediaPresent(bool present) { (void)present; }
+    bool begin(uint32_t blockCount, uint16_t blockSize) { (void)blockCount; (void)blockSize; return true; }
+    void end() {}
+};
+
+#endif // NATIVE_USBMSC_H
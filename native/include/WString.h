@@ -0,0 +1,134 @@
+/**
+ * @file WString.h
+ * @brief 本机构建的 Arduino String 替身，接口与 arduino-esp32 一致（只含管理器代码用到的部分）。
+ */
+#ifndef NATIVE_WSTRING_H
+#define NATIVE_WSTRING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+class String {
+public:
+    String(const char* cstr = "");
+    String(const char* cstr, size_t length);
+    String(const String& str) : buffer(str.buffer) {}
+    String(String&& str) : buffer(static_cast<std::string&&>(str.buffer)) {}
+    explicit String(char c) : buffer(1, c) {}
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(long long value, unsigned char base = 10);
+    explicit String(unsigned long long value, unsigned char base = 10);
+    explicit String(float value, unsigned int decimalPlaces = 2);
+    explicit String(double value, unsigned int decimalPlaces = 2);
+
+    String& operator=(const String& rhs) { buffer = rhs.buffer; return *this; }
+    String& operator=(String&& rhs) { buffer.swap(rhs.buffer); return *this; }
+    String& operator=(const char* cstr) { if (cstr) buffer = cstr; else buffer.clear(); return *this; }
+
+    bool reserve(unsigned int size) { buffer.reserve(size); return true; }
+    unsigned int length() const { return (unsigned int)buffer.size(); }
+    bool isEmpty() const { return buffer.empty(); }
+    const char* c_str() const { return buffer.c_str(); }
+    char* begin() { return &buffer[0]; }
+    char* end() { return &buffer[0] + buffer.size(); }
+    const char* begin() const { return c_str(); }
+    const char* end() const { return c_str() + buffer.size(); }
+
+    // 追加；返回值与 Arduino 一致（成功为 true）
+    bool concat(const String& str) { buffer += str.buffer; return true; }
+    bool concat(const char* cstr) { if (cstr) buffer += cstr; return true; }
+    bool concat(const char* cstr, unsigned int length) { if (cstr) buffer.append(cstr, length); return true; }
+    bool concat(char c) { buffer += c; return true; }
+    bool concat(unsigned char value) { return concat(String(value)); }
+    bool concat(int value) { return concat(String(value)); }
+    bool concat(unsigned int value) { return concat(String(value)); }
+    bool concat(long value) { return concat(String(value)); }
+    bool concat(unsigned long value) { return concat(String(value)); }
+    bool concat(long long value) { return concat(String(value)); }
+    bool concat(unsigned long long value) { return concat(String(value)); }
+    bool concat(float value) { return concat(String(value)); }
+    bool concat(double value) { return concat(String(value)); }
+
+    template <typename T>
+    String& operator+=(const T& rhs) { concat(rhs); return *this; }
+    String& operator+=(const char* cstr) { concat(cstr); return *this; }
+
+    int compareTo(const String& s) const { return buffer.compare(s.buffer); }
+    bool equals(const String& s) const { return buffer == s.buffer; }
+    bool equals(const char* cstr) const { return buffer == (cstr ? cstr : ""); }
+    bool equalsIgnoreCase(const String& s) const;
+    bool operator==(const String& rhs) const { return equals(rhs); }
+    bool operator==(const char* cstr) const { return equals(cstr); }
+    bool operator!=(const String& rhs) const { return !equals(rhs); }
+    bool operator!=(const char* cstr) const { return !equals(cstr); }
+    bool operator<(const String& rhs) const { return compareTo(rhs) < 0; }
+    bool operator>(const String& rhs) const { return compareTo(rhs) > 0; }
+    bool operator<=(const String& rhs) const { return compareTo(rhs) <= 0; }
+    bool operator>=(const String& rhs) const { return compareTo(rhs) >= 0; }
+    bool startsWith(const String& prefix) const { return startsWith(prefix, 0); }
+    bool startsWith(const String& prefix, unsigned int offset) const;
+    bool endsWith(const String& suffix) const;
+
+    char charAt(unsigned int index) const { return index < buffer.size() ? buffer[index] : 0; }
+    void setCharAt(unsigned int index, char c) { if (index < buffer.size()) buffer[index] = c; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index);
+    void getBytes(unsigned char* buf, unsigned int bufsize, unsigned int index = 0) const;
+    void toCharArray(char* buf, unsigned int bufsize, unsigned int index = 0) const {
+        getBytes((unsigned char*)buf, bufsize, index);
+    }
+
+    int indexOf(char ch, unsigned int fromIndex = 0) const;
+    int indexOf(const String& str, unsigned int fromIndex = 0) const;
+    int lastIndexOf(char ch) const;
+    int lastIndexOf(const String& str) const;
+    String substring(unsigned int beginIndex) const { return substring(beginIndex, length()); }
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+    void replace(char find, char replace);
+    void replace(const String& find, const String& replace);
+    void remove(unsigned int index) { remove(index, (unsigned int)-1); }
+    void remove(unsigned int index, unsigned int count);
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+
+    long toInt() const;
+    float toFloat() const;
+    double toDouble() const;
+
+private:
+    std::string buffer;
+};
+
+/**
+ * @brief Arduino 中 operator+ 的中间类型；ArduinoJson 按名称引用它
+ */
+class StringSumHelper : public String {
+public:
+    StringSumHelper(const String& s) : String(s) {}
+    StringSumHelper(const char* p) : String(p) {}
+};
+
+inline StringSumHelper operator+(const String& lhs, const String& rhs) { StringSumHelper s(lhs); s.concat(rhs); return s; }
+inline StringSumHelper operator+(const String& lhs, const char* rhs) { StringSumHelper s(lhs); s.concat(rhs); return s; }
+inline StringSumHelper operator+(const char* lhs, const String& rhs) { StringSumHelper s(lhs); s.concat(rhs); return s; }
+inline StringSumHelper operator+(const String& lhs, char rhs) { StringSumHelper s(lhs); s.concat(rhs); return s; }
+inline StringSumHelper operator+(char lhs, const String& rhs) { StringSumHelper s((String(lhs))); s.concat(rhs); return s; }
+inline StringSumHelper operator+(const String& lhs, int rhs) { StringSumHelper s(lhs); s.concat(rhs); return s; }
+inline StringSumHelper operator+(const String& lhs, unsigned int rhs) { StringSumHelper s(lhs); s.concat(rhs); return s; }
+inline StringSumHelper operator+(const String& lhs, long rhs) { StringSumHelper s(lhs); s.concat(rhs); return s; }
+inline StringSumHelper operator+(const String& lhs, unsigned long rhs) { StringSumHelper s(lhs); s.concat(rhs); return s; }
+inline StringSumHelper operator+(const String& lhs, long long rhs) { StringSumHelper s(lhs); s.concat(rhs); return s; }
+inline StringSumHelper operator+(const String& lhs, unsigned long long rhs) { StringSumHelper s(lhs); s.concat(rhs); return s; }
+inline StringSumHelper operator+(const String& lhs, float rhs) { StringSumHelper s(lhs); s.concat(rhs); return s; }
+inline StringSumHelper operator+(const String& lhs, double rhs) { StringSumHelper s(lhs); s.concat(rhs); return s; }
+inline bool operator==(const char* lhs, const String& rhs) { return rhs.equals(lhs); }
+inline bool operator!=(const char* lhs, const String& rhs) { return !rhs.equals(lhs); }
+
+#endif // NATIVE_WSTRING_H
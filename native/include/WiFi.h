@@ -0,0 +1,60 @@
+/**
+ * @file WiFi.h
+ * @brief 本机构建的 WiFi 接口。
+ *
+ * 主机网络始终可用：begin() 之后立即视为已连接，SSID 为传入的名称，IP 为 127.0.0.1。
+ */
+#ifndef NATIVE_WIFI_H
+#define NATIVE_WIFI_H
+
+#include "Arduino.h"
+#include "WiFiClient.h"
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum {
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+} wifi_mode_t;
+
+class WiFiClass {
+public:
+    WiFiClass() : connected(false) {}
+
+    bool mode(wifi_mode_t m) { (void)m; return true; }
+
+    wl_status_t begin(const char* ssid, const char* passphrase = nullptr) {
+        (void)passphrase;
+        connectedSsid = ssid ? ssid : "";
+        connected = true;
+        return WL_CONNECTED;
+    }
+
+    bool disconnect(bool wifioff = false) {
+        (void)wifioff;
+        connected = false;
+        return true;
+    }
+
+    wl_status_t status() { return connected ? WL_CONNECTED : WL_DISCONNECTED; }
+    String SSID() const { return connected ? connectedSsid : String(); }
+    int8_t RSSI() { return connected ? -40 : 0; }
+    IPAddress localIP() { return connected ? IPAddress(127, 0, 0, 1) : IPAddress(); }
+
+private:
+    bool connected;
+    String connectedSsid;
+};
+
+extern WiFiClass WiFi;
+
+#endif // NATIVE_WIFI_H
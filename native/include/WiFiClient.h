@@ -0,0 +1,30 @@
+/**
+ * @file WiFiClient.h
+ * @brief 本机构建的 WiFiClient。
+ *
+ * 仅作为 LLMTlsClient 的基类，自身不建立任何连接。
+ */
+#ifndef NATIVE_WIFICLIENT_H
+#define NATIVE_WIFICLIENT_H
+
+#include "Client.h"
+
+class WiFiClient : public Client {
+public:
+    virtual ~WiFiClient() {}
+
+    int connect(IPAddress ip, uint16_t port) { (void)ip; (void)port; return 0; }
+    int connect(const char* host, uint16_t port) { (void)host; (void)port; return 0; }
+    size_t write(uint8_t) { return 0; }
+    size_t write(const uint8_t* buf, size_t size) { (void)buf; (void)size; return 0; }
+    int available() { return 0; }
+    int read() { return -1; }
+    int read(uint8_t* buf, size_t size) { (void)buf; (void)size; return -1; }
+    int peek() { return -1; }
+    void flush() {}
+    void stop() {}
+    uint8_t connected() { return 0; }
+    operator bool() { return false; }
+};
+
+#endif // NATIVE_WIFICLIENT_H
@@ -0,0 +1,22 @@
+/**
+ * @file Wire.h
+ * @brief 本机构建的 I2C 接口（无设备）。
+ */
+#ifndef NATIVE_WIRE_H
+#define NATIVE_WIRE_H
+
+#include "Arduino.h"
+
+class TwoWire {
+public:
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) {
+        (void)sda;
+        (void)scl;
+        (void)frequency;
+        return true;
+    }
+};
+
+extern TwoWire Wire;
+
+#endif // NATIVE_WIRE_H
@@ -0,0 +1,29 @@
+/**
+ * @file semphr.h
+ * @brief 本机构建的 FreeRTOS 信号量 API：与 FreeRTOS 一样以长度为 1、项大小为 0 的队列实现。
+ */
+#ifndef NATIVE_FREERTOS_SEMPHR_H
+#define NATIVE_FREERTOS_SEMPHR_H
+
+#include "queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+/**
+ * @brief 创建互斥锁（初始可获取，不可递归）
+ */
+SemaphoreHandle_t xSemaphoreCreateMutex();
+
+/**
+ * @brief 创建二值信号量（初始不可获取）
+ */
+SemaphoreHandle_t xSemaphoreCreateBinary();
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount);
+
+#define xSemaphoreTake(semaphore, ticks) xQueueReceive(semaphore, NULL, ticks)
+#define xSemaphoreGive(semaphore) xQueueSend(semaphore, NULL, 0)
+#define vSemaphoreDelete(semaphore) vQueueDelete(semaphore)
+#define uxSemaphoreGetCount(semaphore) uxQueueMessagesWaiting(semaphore)
+
+#endif // NATIVE_FREERTOS_SEMPHR_H
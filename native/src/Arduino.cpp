@@ -0,0 +1,259 @@
+#include "Arduino.h"
+#include <atomic>
+#include <sched.h>
+#include <stdarg.h>
+#include <time.h>
+#include <unistd.h>
+
+// ==================== 时间 ====================
+
+static uint64_t monotonicMicros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+// 与板上一样从启动时刻计时（首次调用时，可能早于 main()）；按 32 位回绕，与板上一致
+static uint64_t sinceBootMicros() {
+    static const uint64_t bootMicros = monotonicMicros();
+    return monotonicMicros() - bootMicros;
+}
+
+unsigned long millis() {
+    return (uint32_t)(sinceBootMicros() / 1000);
+}
+
+unsigned long micros() {
+    return (uint32_t)sinceBootMicros();
+}
+
+void delay(uint32_t ms) {
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+    while (nanosleep(&ts, &ts) != 0) {
+    }
+}
+
+void delayMicroseconds(uint32_t us) {
+    usleep(us);
+}
+
+void yield() {
+    sched_yield();
+}
+
+// ==================== GPIO ====================
+
+static uint8_t pinLevels[64];
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin < sizeof(pinLevels)) pinLevels[pin] = value ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) {
+    return pin < sizeof(pinLevels) ? pinLevels[pin] : LOW;
+}
+
+// ==================== 内存 ====================
+
+// 开发板的标称容量（ESP32-S3，8 MB PSRAM）
+static const size_t NOMINAL_INTERNAL_BYTES = 320 * 1024;
+static const size_t NOMINAL_PSRAM_BYTES = 8 * 1024 * 1024;
+
+// PSRAM 分配次数，各任务线程都可能分配
+static std::atomic<uint32_t> psramAllocations(0);
+
+uint32_t psramAllocationCount() {
+    return psramAllocations.load();
+}
+
+void* ps_malloc(size_t size) {
+    psramAllocations++;
+    return malloc(size);
+}
+
+void* ps_calloc(size_t n, size_t size) {
+    psramAllocations++;
+    return calloc(n, size);
+}
+
+void* ps_realloc(void* ptr, size_t size) {
+    psramAllocations++;
+    return realloc(ptr, size);
+}
+
+void* heap_caps_malloc(size_t size, uint32_t caps) {
+    if (caps & MALLOC_CAP_SPIRAM) psramAllocations++;
+    return malloc(size);
+}
+
+void* heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+    if (caps & MALLOC_CAP_SPIRAM) psramAllocations++;
+    return calloc(n, size);
+}
+
+void* heap_caps_realloc(void* ptr, size_t size, uint32_t caps) {
+    if (caps & MALLOC_CAP_SPIRAM) psramAllocations++;
+    return realloc(ptr, size);
+}
+
+void heap_caps_free(void* ptr) {
+    free(ptr);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    return (caps & MALLOC_CAP_SPIRAM) ? NOMINAL_PSRAM_BYTES : NOMINAL_INTERNAL_BYTES;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+    return heap_caps_get_free_size(caps);
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    return heap_caps_get_free_size(caps);
+}
+
+long random(long max) {
+    return max > 0 ? ::random() % max : 0;
+}
+
+long random(long min, long max) {
+    return max > min ? min + random(max - min) : min;
+}
+
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1, const char* server2,
+                const char* server3) {
+    (void)gmtOffsetSec;
+    (void)daylightOffsetSec;
+    (void)server1;
+    (void)server2;
+    (void)server3;
+}
+
+// ==================== Print / Stream ====================
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        if (!write(*buffer++)) break;
+        n++;
+    }
+    return n;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char local[64];
+    va_list args;
+    va_start(args, format);
+    va_list copy;
+    va_copy(copy, args);
+    int length = vsnprintf(local, sizeof(local), format, copy);
+    va_end(copy);
+    if (length < 0) {
+        va_end(args);
+        return 0;
+    }
+    char* text = local;
+    if ((size_t)length >= sizeof(local)) {
+        text = (char*)malloc(length + 1);
+        if (!text) {
+            va_end(args);
+            return 0;
+        }
+        vsnprintf(text, length + 1, format, args);
+    }
+    va_end(args);
+    size_t n = write((const uint8_t*)text, length);
+    if (text != local) free(text);
+    return n;
+}
+
+int Stream::timedRead() {
+    unsigned long start = millis();
+    do {
+        int c = read();
+        if (c >= 0) return c;
+        delay(1);
+    } while (millis() - start < _timeout);
+    return -1;
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int c = timedRead();
+        if (c < 0) break;
+        buffer[count++] = (char)c;
+    }
+    return count;
+}
+
+String Stream::readString() {
+    String result;
+    int c;
+    while ((c = timedRead()) >= 0) result += (char)c;
+    return result;
+}
+
+String Stream::readStringUntil(char terminator) {
+    String result;
+    int c;
+    while ((c = timedRead()) >= 0 && c != terminator) result += (char)c;
+    return result;
+}
+
+// ==================== Serial / ESP ====================
+
+HardwareSerial Serial;
+EspClass ESP;
+
+size_t HardwareSerial::write(uint8_t c) {
+    return fwrite(&c, 1, 1, stderr);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    return fwrite(buffer, 1, size, stderr);
+}
+
+void HardwareSerial::flush() {
+    fflush(stderr);
+}
+
+uint32_t EspClass::getHeapSize() { return NOMINAL_INTERNAL_BYTES; }
+uint32_t EspClass::getFreeHeap() { return NOMINAL_INTERNAL_BYTES; }
+uint32_t EspClass::getMinFreeHeap() { return NOMINAL_INTERNAL_BYTES; }
+uint32_t EspClass::getMaxAllocHeap() { return NOMINAL_INTERNAL_BYTES; }
+uint32_t EspClass::getPsramSize() { return NOMINAL_PSRAM_BYTES; }
+uint32_t EspClass::getFreePsram() { return NOMINAL_PSRAM_BYTES; }
+uint32_t EspClass::getMinFreePsram() { return NOMINAL_PSRAM_BYTES; }
+uint32_t EspClass::getMaxAllocPsram() { return NOMINAL_PSRAM_BYTES; }
+
+void EspClass::restart() {
+    fflush(stdout);
+    fflush(stderr);
+    exit(0);
+}
+
+// ==================== IPAddress ====================
+
+bool IPAddress::fromString(const char* text) {
+    unsigned a, b, c, d;
+    char tail;
+    if (!text || sscanf(text, "%u.%u.%u.%u%c", &a, &b, &c, &d, &tail) != 4 || a > 255 || b > 255 || c > 255 || d > 255) {
+        return false;
+    }
+    *this = IPAddress(a, b, c, d);
+    return true;
+}
+
+String IPAddress::toString() const {
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+    return String(text);
+}
@@ -0,0 +1,200 @@
+#include "FS.h"
+#include "LittleFS.h"
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs {
+
+/**
+ * @brief 打开的主机文件
+ */
+class FileImpl {
+public:
+    FileImpl(FILE* file, const String& path, bool directory) : file(file), filePath(path), directory(directory) {}
+    ~FileImpl() { close(); }
+
+    void close() {
+        if (file) {
+            fclose(file);
+            file = nullptr;
+        }
+    }
+
+    FILE* file;
+    String filePath; ///< 板上的路径（如 "/config.json"）
+    bool directory;
+};
+
+size_t File::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t File::write(const uint8_t* buf, size_t size) {
+    if (!impl || !impl->file) return 0;
+    return fwrite(buf, 1, size, impl->file);
+}
+
+int File::available() {
+    if (!impl || !impl->file) return 0;
+    return (int)(size() - position());
+}
+
+int File::read() {
+    if (!impl || !impl->file) return -1;
+    return fgetc(impl->file);
+}
+
+int File::peek() {
+    if (!impl || !impl->file) return -1;
+    int c = fgetc(impl->file);
+    if (c != EOF) ungetc(c, impl->file);
+    return c;
+}
+
+void File::flush() {
+    if (impl && impl->file) fflush(impl->file);
+}
+
+size_t File::read(uint8_t* buf, size_t size) {
+    if (!impl || !impl->file) return 0;
+    return fread(buf, 1, size, impl->file);
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    if (!impl || !impl->file) return false;
+    int whence = mode == SeekCur ? SEEK_CUR : (mode == SeekEnd ? SEEK_END : SEEK_SET);
+    return fseek(impl->file, pos, whence) == 0;
+}
+
+size_t File::position() const {
+    if (!impl || !impl->file) return 0;
+    long pos = ftell(impl->file);
+    return pos < 0 ? 0 : (size_t)pos;
+}
+
+size_t File::size() const {
+    if (!impl || !impl->file) return 0;
+    fflush(impl->file);
+    struct stat st;
+    return fstat(fileno(impl->file), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+void File::close() {
+    if (impl) impl->close();
+}
+
+File::operator bool() const {
+    return impl && (impl->file || impl->directory);
+}
+
+const char* File::path() const {
+    return impl ? impl->filePath.c_str() : nullptr;
+}
+
+const char* File::name() const {
+    if (!impl) return nullptr;
+    const char* slash = strrchr(impl->filePath.c_str(), '/');
+    return slash ? slash + 1 : impl->filePath.c_str();
+}
+
+bool File::isDirectory() const {
+    return impl && impl->directory;
+}
+
+String FS::hostPath(const char* path) const {
+    String result = rootDir;
+    if (!path || path[0] != '/') result += "/";
+    result += path ? path : "";
+    return result;
+}
+
+File FS::open(const char* path, const char* mode, bool create) {
+    (void)create;
+    String host = hostPath(path);
+    struct stat st;
+    if (stat(host.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        return File(std::make_shared<FileImpl>(nullptr, String(path), true));
+    }
+    // 与 LittleFS 一样以二进制方式读写；"r" 打开不存在的文件返回空 File
+    String hostMode = String(mode ? mode : "r") + "b";
+    FILE* file = fopen(host.c_str(), hostMode.c_str());
+    if (!file) {
+        return File();
+    }
+    return File(std::make_shared<FileImpl>(file, String(path), false));
+}
+
+bool FS::exists(const char* path) {
+    struct stat st;
+    return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char* path) {
+    return ::unlink(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* pathFrom, const char* pathTo) {
+    return ::rename(hostPath(pathFrom).c_str(), hostPath(pathTo).c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+    return ::mkdir(hostPath(path).c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+bool FS::rmdir(const char* path) {
+    return ::rmdir(hostPath(path).c_str()) == 0;
+}
+
+// 逐级创建主机目录
+static bool makeDirs(const String& dir) {
+    String partial;
+    int start = 0;
+    while (true) {
+        int slash = dir.indexOf('/', start + 1);
+        partial = slash < 0 ? dir : dir.substring(0, slash);
+        if (partial.length() > 0 && ::mkdir(partial.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+        if (slash < 0) return true;
+        start = slash;
+    }
+}
+
+// 统计目录下的文件字节数
+static size_t directoryBytes(const String& dir) {
+    size_t total = 0;
+    DIR* handle = opendir(dir.c_str());
+    if (!handle) return 0;
+    struct dirent* entry;
+    while ((entry = readdir(handle)) != nullptr) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        String child = dir + "/" + entry->d_name;
+        struct stat st;
+        if (stat(child.c_str(), &st) != 0) continue;
+        total += S_ISDIR(st.st_mode) ? directoryBytes(child) : (size_t)st.st_size;
+    }
+    closedir(handle);
+    return total;
+}
+
+bool LittleFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+    (void)formatOnFail;
+    (void)basePath;
+    (void)maxOpenFiles;
+    (void)partitionLabel;
+    const char* root = getenv("NOOX_FS_ROOT");
+    if (root && root[0]) {
+        setRoot(root);
+    }
+    return makeDirs(rootDir);
+}
+
+size_t LittleFSFS::usedBytes() {
+    return directoryBytes(rootDir);
+}
+
+} // namespace fs
+
+fs::LittleFSFS LittleFS;
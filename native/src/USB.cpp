@@ -0,0 +1,140 @@
+#include "USB.h"
+#include "USBCDC.h"
+#include "USBHIDKeyboard.h"
+#include <unistd.h>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+ESPUSB USB;
+
+// ==================== HID 键盘 ====================
+
+// 修饰键（0x80-0x87）记录在位图中，其余键码按 arduino-esp32 的编码原样记录
+size_t USBHIDKeyboard::press(uint8_t k) {
+    if (k >= KEY_LEFT_CTRL && k <= KEY_RIGHT_GUI) {
+        report.modifiers |= 1 << (k - KEY_LEFT_CTRL);
+        return 1;
+    }
+    for (size_t i = 0; i < sizeof(report.keys); i++) {
+        if (report.keys[i] == k) return 1;
+    }
+    for (size_t i = 0; i < sizeof(report.keys); i++) {
+        if (report.keys[i] == 0) {
+            report.keys[i] = k;
+            return 1;
+        }
+    }
+    return 0; // 与板上一样，超过 6 个键时拒绝
+}
+
+KeyReport USBHIDKeyboard::lastCombination;
+
+// 记录松开前的报告（有键按下时），再清空
+void USBHIDKeyboard::releaseAll() {
+    static const KeyReport empty = {};
+    if (memcmp(&report, &empty, sizeof(report)) != 0) {
+        lastCombination = report;
+    }
+    memset(&report, 0, sizeof(report));
+}
+
+size_t USBHIDKeyboard::release(uint8_t k) {
+    if (k >= KEY_LEFT_CTRL && k <= KEY_RIGHT_GUI) {
+        report.modifiers &= ~(1 << (k - KEY_LEFT_CTRL));
+        return 1;
+    }
+    for (size_t i = 0; i < sizeof(report.keys); i++) {
+        if (report.keys[i] == k) report.keys[i] = 0;
+    }
+    return 1;
+}
+
+// ==================== CDC ====================
+
+// stdin 上收到、尚未被读取的字节（所有 USBCDC 实例共用，与板上只有一个 CDC 口相同）
+static std::mutex inputLock;
+static std::deque<uint8_t> inputBytes;
+static bool readerStarted = false;
+// 单元测试截获的输出
+static std::mutex outputLock;
+static bool capturing = false;
+static String capturedOutput;
+
+static void readStdin() {
+    uint8_t buffer[256];
+    ssize_t n;
+    while ((n = ::read(STDIN_FILENO, buffer, sizeof(buffer))) > 0) {
+        std::lock_guard<std::mutex> guard(inputLock);
+        inputBytes.insert(inputBytes.end(), buffer, buffer + n);
+    }
+}
+
+void USBCDC::begin(unsigned long baud) {
+    (void)baud;
+    std::lock_guard<std::mutex> guard(inputLock);
+    if (!readerStarted) {
+        readerStarted = true;
+        std::thread(readStdin).detach();
+    }
+}
+
+int USBCDC::available() {
+    std::lock_guard<std::mutex> guard(inputLock);
+    return (int)inputBytes.size();
+}
+
+int USBCDC::read() {
+    std::lock_guard<std::mutex> guard(inputLock);
+    if (inputBytes.empty()) return -1;
+    uint8_t c = inputBytes.front();
+    inputBytes.pop_front();
+    return c;
+}
+
+int USBCDC::peek() {
+    std::lock_guard<std::mutex> guard(inputLock);
+    return inputBytes.empty() ? -1 : inputBytes.front();
+}
+
+void USBCDC::flush() {
+    fflush(stdout);
+}
+
+size_t USBCDC::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+// 每条消息以换行结束，换行时刷新，管道另一端按行读取
+size_t USBCDC::write(const uint8_t* buffer, size_t size) {
+    {
+        std::lock_guard<std::mutex> guard(outputLock);
+        if (capturing) {
+            capturedOutput.concat((const char*)buffer, size);
+            return size;
+        }
+    }
+    size_t n = fwrite(buffer, 1, size, stdout);
+    if (size > 0 && buffer[size - 1] == '\n') {
+        fflush(stdout);
+    }
+    return n;
+}
+
+void USBCDC::injectInput(const char* data) {
+    std::lock_guard<std::mutex> guard(inputLock);
+    inputBytes.insert(inputBytes.end(), data, data + strlen(data));
+}
+
+void USBCDC::captureOutput(bool enabled) {
+    std::lock_guard<std::mutex> guard(outputLock);
+    capturing = enabled;
+    capturedOutput = "";
+}
+
+String USBCDC::takeOutput() {
+    std::lock_guard<std::mutex> guard(outputLock);
+    String output = capturedOutput;
+    capturedOutput = "";
+    return output;
+}
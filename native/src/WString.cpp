@@ -0,0 +1,158 @@
+#include "WString.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 按进制格式化整数（与 Arduino 一致：负数只在十进制时带符号）
+static std::string formatUnsigned(unsigned long long value, unsigned char base) {
+    if (base < 2 || base > 36) base = 10;
+    char digits[66];
+    size_t pos = sizeof(digits);
+    do {
+        unsigned digit = value % base;
+        digits[--pos] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        value /= base;
+    } while (value);
+    return std::string(digits + pos, sizeof(digits) - pos);
+}
+
+static std::string formatSigned(long long value, unsigned char base) {
+    if (value < 0 && base == 10) {
+        return "-" + formatUnsigned(0ULL - (unsigned long long)value, base);
+    }
+    return formatUnsigned((unsigned long long)value, base);
+}
+
+String::String(const char* cstr) : buffer(cstr ? cstr : "") {}
+String::String(const char* cstr, size_t length) : buffer(cstr ? std::string(cstr, length) : std::string()) {}
+String::String(unsigned char value, unsigned char base) : buffer(formatUnsigned(value, base)) {}
+String::String(int value, unsigned char base) : buffer(formatSigned(value, base)) {}
+String::String(unsigned int value, unsigned char base) : buffer(formatUnsigned(value, base)) {}
+String::String(long value, unsigned char base) : buffer(formatSigned(value, base)) {}
+String::String(unsigned long value, unsigned char base) : buffer(formatUnsigned(value, base)) {}
+String::String(long long value, unsigned char base) : buffer(formatSigned(value, base)) {}
+String::String(unsigned long long value, unsigned char base) : buffer(formatUnsigned(value, base)) {}
+
+String::String(float value, unsigned int decimalPlaces) : String((double)value, decimalPlaces) {}
+
+String::String(double value, unsigned int decimalPlaces) {
+    char text[64];
+    snprintf(text, sizeof(text), "%.*f", (int)decimalPlaces, value);
+    buffer = text;
+}
+
+bool String::equalsIgnoreCase(const String& s) const {
+    return buffer.size() == s.buffer.size() && strncasecmp(buffer.c_str(), s.buffer.c_str(), buffer.size()) == 0;
+}
+
+bool String::startsWith(const String& prefix, unsigned int offset) const {
+    return offset <= buffer.size() && buffer.compare(offset, prefix.buffer.size(), prefix.buffer) == 0;
+}
+
+bool String::endsWith(const String& suffix) const {
+    return suffix.buffer.size() <= buffer.size() &&
+           buffer.compare(buffer.size() - suffix.buffer.size(), suffix.buffer.size(), suffix.buffer) == 0;
+}
+
+char& String::operator[](unsigned int index) {
+    static char dummy;
+    if (index >= buffer.size()) {
+        dummy = 0;
+        return dummy;
+    }
+    return buffer[index];
+}
+
+void String::getBytes(unsigned char* buf, unsigned int bufsize, unsigned int index) const {
+    if (!buf || bufsize == 0) return;
+    if (index >= buffer.size()) {
+        buf[0] = 0;
+        return;
+    }
+    size_t n = buffer.size() - index;
+    if (n > bufsize - 1) n = bufsize - 1;
+    memcpy(buf, buffer.data() + index, n);
+    buf[n] = 0;
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const {
+    size_t pos = buffer.find(ch, fromIndex);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String& str, unsigned int fromIndex) const {
+    if (fromIndex > buffer.size()) return -1;
+    size_t pos = buffer.find(str.buffer, fromIndex);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(char ch) const {
+    size_t pos = buffer.rfind(ch);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(const String& str) const {
+    size_t pos = buffer.rfind(str.buffer);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+// 与 Arduino 一致：参数顺序颠倒时交换，越界时截到末尾
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+    if (beginIndex > endIndex) {
+        unsigned int t = beginIndex;
+        beginIndex = endIndex;
+        endIndex = t;
+    }
+    if (beginIndex >= buffer.size()) return String();
+    if (endIndex > buffer.size()) endIndex = buffer.size();
+    return String(buffer.data() + beginIndex, endIndex - beginIndex);
+}
+
+void String::replace(char find, char replace) {
+    for (size_t i = 0; i < buffer.size(); i++) {
+        if (buffer[i] == find) buffer[i] = replace;
+    }
+}
+
+void String::replace(const String& find, const String& replace) {
+    if (find.buffer.empty()) return;
+    size_t pos = 0;
+    while ((pos = buffer.find(find.buffer, pos)) != std::string::npos) {
+        buffer.replace(pos, find.buffer.size(), replace.buffer);
+        pos += replace.buffer.size();
+    }
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+    if (index >= buffer.size()) return;
+    buffer.erase(index, count);
+}
+
+void String::toLowerCase() {
+    for (size_t i = 0; i < buffer.size(); i++) buffer[i] = tolower((unsigned char)buffer[i]);
+}
+
+void String::toUpperCase() {
+    for (size_t i = 0; i < buffer.size(); i++) buffer[i] = toupper((unsigned char)buffer[i]);
+}
+
+void String::trim() {
+    size_t first = 0;
+    while (first < buffer.size() && isspace((unsigned char)buffer[first])) first++;
+    size_t last = buffer.size();
+    while (last > first && isspace((unsigned char)buffer[last - 1])) last--;
+    buffer = buffer.substr(first, last - first);
+}
+
+long String::toInt() const {
+    return atol(buffer.c_str());
+}
+
+float String::toFloat() const {
+    return (float)atof(buffer.c_str());
+}
+
+double String::toDouble() const {
+    return atof(buffer.c_str());
+}
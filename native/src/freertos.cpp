@@ -0,0 +1,258 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+extern unsigned long millis();
+extern void delay(uint32_t ms);
+
+// ==================== 临界区 ====================
+
+void vPortEnterCritical(portMUX_TYPE* mux) {
+    uint32_t expected = 0;
+    while (!__atomic_compare_exchange_n(&mux->owner, &expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        expected = 0;
+        sched_yield();
+    }
+}
+
+void vPortExitCritical(portMUX_TYPE* mux) {
+    __atomic_store_n(&mux->owner, 0, __ATOMIC_RELEASE);
+}
+
+// ==================== 任务 ====================
+
+struct NativeTask {
+    pthread_t thread;
+    char name[16];
+    UBaseType_t priority;
+    TaskFunction_t function;
+    void* parameter;
+};
+
+// 当前线程的任务；主线程在首次查询时登记为 "main"
+static thread_local NativeTask* currentTask = nullptr;
+
+static NativeTask* selfTask() {
+    if (!currentTask) {
+        NativeTask* task = new NativeTask();
+        task->thread = pthread_self();
+        strncpy(task->name, "main", sizeof(task->name) - 1);
+        task->priority = 1;
+        currentTask = task;
+    }
+    return currentTask;
+}
+
+static void* taskEntry(void* arg) {
+    NativeTask* task = (NativeTask*)arg;
+    currentTask = task;
+    task->function(task->parameter);
+    // FreeRTOS 任务函数不允许返回；本机构建中返回等同于删除自己
+    return nullptr;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameter,
+                                   UBaseType_t priority, TaskHandle_t* createdTask, BaseType_t coreId) {
+    (void)coreId;
+    NativeTask* task = new NativeTask();
+    strncpy(task->name, name ? name : "", sizeof(task->name) - 1);
+    task->priority = priority;
+    task->function = function;
+    task->parameter = parameter;
+
+    // ESP32 的栈深度以字节计；主机上同样的代码（64 位指针、glibc printf）需要更多栈
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    size_t stackSize = (size_t)stackDepth * 4;
+    if (stackSize < 256 * 1024) stackSize = 256 * 1024;
+    pthread_attr_setstacksize(&attr, stackSize);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int err = pthread_create(&task->thread, &attr, taskEntry, task);
+    pthread_attr_destroy(&attr);
+    if (err != 0) {
+        delete task;
+        return pdFAIL;
+    }
+    pthread_setname_np(task->thread, task->name);
+    if (createdTask) {
+        *createdTask = task;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameter,
+                       UBaseType_t priority, TaskHandle_t* createdTask) {
+    return xTaskCreatePinnedToCore(function, name, stackDepth, parameter, priority, createdTask, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task && task != currentTask) {
+        fprintf(stderr, "[NATIVE] vTaskDelete: deleting another task is not supported\n");
+        return;
+    }
+    pthread_exit(nullptr);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    delay(ticks * portTICK_PERIOD_MS);
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)(millis() / portTICK_PERIOD_MS);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return selfTask();
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task) {
+    return (task ? task : selfTask())->priority;
+}
+
+char* pcTaskGetName(TaskHandle_t task) {
+    return (task ? task : selfTask())->name;
+}
+
+void taskYIELD() {
+    sched_yield();
+}
+
+// ==================== 队列和信号量 ====================
+
+struct NativeQueue {
+    std::mutex lock;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::vector<uint8_t> storage; ///< length * itemSize 字节的环形缓冲区
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    UBaseType_t count;
+    UBaseType_t head;             ///< 最旧的项
+};
+
+// 按节拍数等待条件成立；portMAX_DELAY 表示一直等待
+template <typename Predicate>
+static bool waitFor(std::condition_variable& cond, std::unique_lock<std::mutex>& guard, TickType_t ticks, Predicate ready) {
+    if (ticks == portMAX_DELAY) {
+        cond.wait(guard, ready);
+        return true;
+    }
+    return cond.wait_for(guard, std::chrono::milliseconds((unsigned long)ticks * portTICK_PERIOD_MS), ready);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    if (length == 0) return nullptr;
+    NativeQueue* queue = new NativeQueue();
+    queue->storage.resize((size_t)length * itemSize);
+    queue->length = length;
+    queue->itemSize = itemSize;
+    queue->count = 0;
+    queue->head = 0;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+static BaseType_t queueSend(QueueHandle_t queue, const void* item, TickType_t ticksToWait, bool toFront) {
+    std::unique_lock<std::mutex> guard(queue->lock);
+    if (!waitFor(queue->notFull, guard, ticksToWait, [queue] { return queue->count < queue->length; })) {
+        return errQUEUE_FULL;
+    }
+    UBaseType_t slot;
+    if (toFront) {
+        queue->head = (queue->head + queue->length - 1) % queue->length;
+        slot = queue->head;
+    } else {
+        slot = (queue->head + queue->count) % queue->length;
+    }
+    if (queue->itemSize && item) {
+        memcpy(&queue->storage[(size_t)slot * queue->itemSize], item, queue->itemSize);
+    }
+    queue->count++;
+    guard.unlock();
+    queue->notEmpty.notify_one();
+    return pdPASS;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticksToWait) {
+    return queueSend(queue, item, ticksToWait, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void* item, TickType_t ticksToWait) {
+    return queueSend(queue, item, ticksToWait, true);
+}
+
+static BaseType_t queueReceive(QueueHandle_t queue, void* buffer, TickType_t ticksToWait, bool remove) {
+    std::unique_lock<std::mutex> guard(queue->lock);
+    if (!waitFor(queue->notEmpty, guard, ticksToWait, [queue] { return queue->count > 0; })) {
+        return errQUEUE_EMPTY;
+    }
+    if (queue->itemSize && buffer) {
+        memcpy(buffer, &queue->storage[(size_t)queue->head * queue->itemSize], queue->itemSize);
+    }
+    if (!remove) {
+        return pdPASS;
+    }
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    guard.unlock();
+    queue->notFull.notify_one();
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* buffer, TickType_t ticksToWait) {
+    return queueReceive(queue, buffer, ticksToWait, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void* buffer, TickType_t ticksToWait) {
+    return queueReceive(queue, buffer, ticksToWait, false);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> guard(queue->lock);
+    return queue->count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> guard(queue->lock);
+    return queue->length - queue->count;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    {
+        std::lock_guard<std::mutex> guard(queue->lock);
+        queue->count = 0;
+        queue->head = 0;
+    }
+    queue->notFull.notify_all();
+    return pdPASS;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    QueueHandle_t queue = xQueueCreate(1, 0);
+    xQueueSend(queue, nullptr, 0);
+    return queue;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return xQueueCreate(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount) {
+    QueueHandle_t queue = xQueueCreate(maxCount, 0);
+    for (UBaseType_t i = 0; i < initialCount && i < maxCount; i++) {
+        xQueueSend(queue, nullptr, 0);
+    }
+    return queue;
+}
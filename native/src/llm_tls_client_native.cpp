@@ -0,0 +1,317 @@
+// 本机构建的 LLMTlsClient：以明文 TCP 代替 mbedTLS，接口和计时与板上一致。
+//
+// 环境变量 NOOX_LLM_ENDPOINT=host:port 时，所有提供商的连接都改连到该地址
+// （例如 bench/mock_llm_server.py），否则按提供商主机名和端口明文连接。
+#include "llm_tls_client.h"
+#include "logger.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// 未指定时的连接超时
+const int32_t DEFAULT_TLS_TIMEOUT = 5000;
+
+// ==================== LLMTlsSessionCache 类实现 ====================
+
+// 本机构建没有 TLS 会话，只保留计数
+LLMTlsSessionCache::LLMTlsSessionCache()
+    : count(0), prefsOpen(false), fullHandshakes(0), resumedHandshakes(0),
+      fullHandshakeMsTotal(0), resumedHandshakeMsTotal(0) {
+    memset(entries, 0, sizeof(entries));
+    lock = xSemaphoreCreateMutex();
+}
+
+LLMTlsSessionCache::~LLMTlsSessionCache() {
+    vSemaphoreDelete(lock);
+}
+
+void LLMTlsSessionCache::begin() {
+}
+
+void LLMTlsSessionCache::nvsKeyFor(const char* host, char* key, size_t keySize) {
+    (void)host;
+    if (keySize) key[0] = '\0';
+}
+
+LLMTlsSessionCache::Entry* LLMTlsSessionCache::findOrCreate(const char* host) {
+    (void)host;
+    return nullptr;
+}
+
+bool LLMTlsSessionCache::apply(const char* host, mbedtls_ssl_context* ssl, uint64_t* fingerprint) {
+    (void)host;
+    (void)ssl;
+    (void)fingerprint;
+    return false;
+}
+
+uint64_t LLMTlsSessionCache::sessionFingerprint(mbedtls_ssl_context* ssl) {
+    (void)ssl;
+    return 0;
+}
+
+void LLMTlsSessionCache::save(const char* host, mbedtls_ssl_context* ssl) {
+    (void)host;
+    (void)ssl;
+}
+
+void LLMTlsSessionCache::forget(const char* host) {
+    (void)host;
+}
+
+void LLMTlsSessionCache::recordHandshake(bool resumed, unsigned long durationMs) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (resumed) {
+        resumedHandshakes++;
+        resumedHandshakeMsTotal += durationMs;
+    } else {
+        fullHandshakes++;
+        fullHandshakeMsTotal += durationMs;
+    }
+    xSemaphoreGive(lock);
+}
+
+unsigned long LLMTlsSessionCache::getAvgFullHandshakeMs() const {
+    return fullHandshakes ? fullHandshakeMsTotal / fullHandshakes : 0;
+}
+
+unsigned long LLMTlsSessionCache::getAvgResumedHandshakeMs() const {
+    return resumedHandshakes ? resumedHandshakeMsTotal / resumedHandshakes : 0;
+}
+
+// ==================== LLMTlsClient 类实现 ====================
+
+// 解析 NOOX_LLM_ENDPOINT；未设置时返回 false
+static bool endpointOverride(String& host, uint16_t& port) {
+    const char* endpoint = getenv("NOOX_LLM_ENDPOINT");
+    if (!endpoint || !endpoint[0]) {
+        return false;
+    }
+    String value(endpoint);
+    int colon = value.lastIndexOf(':');
+    if (colon <= 0) {
+        return false;
+    }
+    host = value.substring(0, colon);
+    port = (uint16_t)value.substring(colon + 1).toInt();
+    return port != 0;
+}
+
+LLMTlsClient::LLMTlsClient(LLMTlsSessionCache* cache)
+    : sessionCache(cache), sock(-1), isConnected(false), peekedByte(-1),
+      timeoutMs(DEFAULT_TLS_TIMEOUT), lastHandshakeMs(0), lastHandshakeResumed(false),
+      lastDnsMicros(0), lastConnectMicros(0) {
+}
+
+LLMTlsClient::~LLMTlsClient() {
+    stop();
+}
+
+int LLMTlsClient::connect(IPAddress ip, uint16_t port) {
+    return connect(ip, port, DEFAULT_TLS_TIMEOUT);
+}
+
+int LLMTlsClient::connect(IPAddress ip, uint16_t port, int32_t timeout) {
+    String host = ip.toString();
+    return connect(host.c_str(), port, timeout);
+}
+
+int LLMTlsClient::connect(const char* host, uint16_t port) {
+    return connect(host, port, DEFAULT_TLS_TIMEOUT);
+}
+
+int LLMTlsClient::connect(const char* host, uint16_t port, int32_t timeout) {
+    String targetHost(host);
+    uint16_t targetPort = port;
+    endpointOverride(targetHost, targetPort);
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+    unsigned long dnsStart = micros();
+    if (getaddrinfo(targetHost.c_str(), nullptr, &hints, &result) != 0 || !result) {
+        LOG_E("TLS", "DNS lookup failed for %s", targetHost.c_str());
+        return 0;
+    }
+    lastDnsMicros = micros() - dnsStart;
+    IPAddress ip(((struct sockaddr_in*)result->ai_addr)->sin_addr.s_addr);
+    freeaddrinfo(result);
+    return connectTls(ip, targetHost.c_str(), targetPort, timeout, false);
+}
+
+// 建立明文 TCP 连接；握手耗时记为 0
+int LLMTlsClient::connectTls(IPAddress ip, const char* host, uint16_t port, int32_t timeout, bool allowResume) {
+    (void)allowResume;
+    stop();
+    if (timeout <= 0) {
+        timeout = DEFAULT_TLS_TIMEOUT;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0) {
+        LOG_E("TLS", "socket() failed: %d", errno);
+        return 0;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = (uint32_t)ip;
+    addr.sin_port = htons(port);
+
+    unsigned long connectStart = micros();
+    int res = ::connect(fd, (struct sockaddr*)&addr, sizeof(addr));
+    if (res < 0 && errno != EINPROGRESS) {
+        LOG_E("TLS", "connect() to %s:%u failed: %d", host, port, errno);
+        close(fd);
+        return 0;
+    }
+
+    struct pollfd pfd = {fd, POLLOUT, 0};
+    res = poll(&pfd, 1, timeout);
+    int sockErr = 0;
+    socklen_t errLen = sizeof(sockErr);
+    if (res <= 0 || getsockopt(fd, SOL_SOCKET, SO_ERROR, &sockErr, &errLen) < 0 || sockErr != 0) {
+        LOG_E("TLS", "connect() to %s:%u timed out or failed: %d", host, port, sockErr);
+        close(fd);
+        return 0;
+    }
+    lastConnectMicros = micros() - connectStart;
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    sock = fd;
+    isConnected = true;
+    lastHandshakeMs = 0;
+    lastHandshakeResumed = false;
+    if (sessionCache) {
+        sessionCache->recordHandshake(false, 0);
+    }
+    return 1;
+}
+
+size_t LLMTlsClient::write(uint8_t data) {
+    return write(&data, 1);
+}
+
+size_t LLMTlsClient::write(const uint8_t* buf, size_t size) {
+    if (!isConnected) return 0;
+
+    size_t written = 0;
+    while (written < size) {
+        ssize_t ret = send(sock, buf + written, size - written, MSG_NOSIGNAL);
+        if (ret > 0) {
+            written += ret;
+            continue;
+        }
+        struct pollfd pfd = {sock, POLLOUT, 0};
+        if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && poll(&pfd, 1, timeoutMs) > 0) {
+            continue;
+        }
+        LOG_E("TLS", "Write failed: %d", errno);
+        stop();
+        break;
+    }
+    return written;
+}
+
+int LLMTlsClient::available() {
+    int peeked = (peekedByte >= 0) ? 1 : 0;
+    if (!isConnected) return peeked;
+
+    int pending = 0;
+    if (ioctl(sock, FIONREAD, &pending) < 0) {
+        pending = 0;
+    }
+    if (pending == 0) {
+        // 没有待读数据时检测对端是否已关闭
+        char probe;
+        ssize_t ret = recv(sock, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+        if (ret == 0 || (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            stop();
+        }
+    }
+    return pending + peeked;
+}
+
+int LLMTlsClient::read() {
+    uint8_t data = 0;
+    int res = read(&data, 1);
+    return (res == 1) ? data : -1;
+}
+
+int LLMTlsClient::read(uint8_t* buf, size_t size) {
+    if (size == 0) return 0;
+
+    int offset = 0;
+    if (peekedByte >= 0) {
+        buf[0] = (uint8_t)peekedByte;
+        peekedByte = -1;
+        offset = 1;
+        if (size == 1) return 1;
+    }
+    if (!isConnected) return offset ? offset : -1;
+
+    ssize_t ret = recv(sock, buf + offset, size - offset, 0);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return offset ? offset : -1;
+    }
+    if (ret <= 0) {
+        stop();
+        return offset ? offset : -1;
+    }
+    return (int)ret + offset;
+}
+
+int LLMTlsClient::peek() {
+    if (peekedByte < 0 && isConnected && available() > 0) {
+        uint8_t data = 0;
+        if (read(&data, 1) == 1) {
+            peekedByte = data;
+        }
+    }
+    return peekedByte;
+}
+
+// 与 WiFiClient 一致：丢弃接收缓冲区中尚未读取的数据
+void LLMTlsClient::flush() {
+    uint8_t discard[64];
+    while (available() > 0) {
+        if (read(discard, sizeof(discard)) <= 0) break;
+    }
+}
+
+void LLMTlsClient::stop() {
+    cleanup();
+}
+
+uint8_t LLMTlsClient::connected() {
+    if (isConnected) {
+        available(); // 检测对端是否已关闭
+    }
+    return isConnected ? 1 : 0;
+}
+
+int LLMTlsClient::setTimeout(uint32_t seconds) {
+    timeoutMs = seconds * 1000;
+    Stream::setTimeout(timeoutMs);
+    return 0;
+}
+
+void LLMTlsClient::cleanup() {
+    if (sock >= 0) {
+        close(sock);
+        sock = -1;
+    }
+    isConnected = false;
+    peekedByte = -1;
+}
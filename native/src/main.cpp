@@ -0,0 +1,111 @@
+// 本机构建（env:native）的入口：与 src/main.cpp 相同的初始化顺序和任务划分，
+// 不包含 UI、Web 和 USB 大容量存储。CDC 接到 stdin / stdout，日志输出到 stderr，
+// 配置文件读写 native_fs/（或 NOOX_FS_ROOT 指定的目录）。
+// pio test 构建单元测试时由测试程序提供 main()，本文件不参与。
+#ifndef PIO_UNIT_TESTING
+
+#include <Arduino.h>
+#include "hardware_manager.h"
+#include "wifi_manager.h"
+#include "llm_manager.h"
+#include "hid_manager.h"
+#include "config_manager.h"
+#include "usb_shell_manager.h"
+#include "logger.h"
+#include <LittleFS.h>
+
+HardwareManager hardwareManager;
+ConfigManager configManager;
+AppWiFiManager wifiManager(configManager);
+HIDManager hidManager;
+
+LLMManager* llmManagerPtr;
+UsbShellManager* usbShellManagerPtr;
+
+// 代替 WebTask 取走发给 Web 客户端的回复和流式增量（本机构建没有 Web 客户端，直接释放）
+void webTask(void* pvParameters) {
+    (void)pvParameters;
+    for (;;) {
+        LLMStreamDelta delta;
+        while (xQueueReceive(llmManagerPtr->llmDeltaQueue, &delta, 0) == pdPASS) {
+            free(delta.text);
+        }
+        LLMResponse response;
+        while (xQueueReceive(llmManagerPtr->llmResponseQueue, &response, 0) == pdPASS) {
+            free(response.toolResults);
+            free(response.naturalLanguageResponse);
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+// Task for UsbShellManager
+void usbTask(void* pvParameters) {
+    (void)pvParameters;
+    for (;;) {
+        usbShellManagerPtr->loop();
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+// Task for LLMManager (one per worker, pvParameters is the worker index)
+void llmTask(void* pvParameters) {
+    uint8_t workerIndex = (uint8_t)(uintptr_t)pvParameters;
+    for (;;) {
+        llmManagerPtr->loop(workerIndex);
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+void setup() {
+    Serial.begin(115200);
+    Logger::instance().begin();
+
+    hardwareManager.begin();
+
+    if (!LittleFS.begin(true)) {
+        Serial.println("[FS]  LittleFS Mount Failed!");
+        exit(1);
+    }
+
+    configManager.loadConfig();
+    Logger::instance().setLevel(configManager.getConfig()["log_settings"]["level"] | "info");
+
+    usbShellManagerPtr = new UsbShellManager(nullptr, &wifiManager);
+    llmManagerPtr = new LLMManager(configManager, wifiManager, usbShellManagerPtr, &hidManager, &hardwareManager);
+    usbShellManagerPtr->setLLMManager(llmManagerPtr);
+
+    wifiManager.begin();
+    // 主机网络始终可用；配置中没有上次使用的网络时直接连接一个占位网络
+    if (wifiManager.getWiFiStatus() != "Connecting") {
+        wifiManager.connectToWiFi("native", "");
+    }
+
+    llmManagerPtr->begin();
+    hidManager.begin();
+    usbShellManagerPtr->begin();
+
+    xTaskCreatePinnedToCore(webTask, "WebTask", 4096, NULL, 2, NULL, 0);
+    xTaskCreatePinnedToCore(usbTask, "USBTask", 4096, NULL, 2, NULL, 1);
+    for (uint8_t i = 0; i < llmManagerPtr->getWorkerCount(); i++) {
+        char taskName[16];
+        snprintf(taskName, sizeof(taskName), "LLMTask%u", i);
+        xTaskCreatePinnedToCore(llmTask, taskName, LLMManager::WORKER_STACK_SIZE, (void*)(uintptr_t)i, 2, NULL, i % 2);
+    }
+
+    Serial.println("Setup complete. Starting main loop...");
+}
+
+void loop() {
+    wifiManager.loop();
+    delay(1);
+}
+
+int main() {
+    setup();
+    for (;;) {
+        loop();
+    }
+}
+
+#endif // PIO_UNIT_TESTING
@@ -0,0 +1,7 @@
+#include "WiFi.h"
+#include "Wire.h"
+#include "FastLED.h"
+
+WiFiClass WiFi;
+TwoWire Wire;
+CFastLED FastLED;
@@ -3,6 +3,13 @@ document.addEventListener('DOMContentLoaded', () => {
     let websocket; // WebSocket连接对象
     let currentConfig = {}; // 当前配置数据
     let loadingMessageElement = null; // 加载消息元素
+    let streamingMessageElement = null; // 正在流式接收的AI消息元素
+    // 会话ID：保存在 localStorage 中，刷新页面后设备仍使用同一份对话历史
+    let sessionId = localStorage.getItem('noox_session_id');
+    if (!sessionId) {
+        sessionId = Date.now().toString(36) + Math.random().toString(36).slice(2, 10);
+        localStorage.setItem('noox_session_id', sessionId);
+    }
 
     // Configure marked.js for markdown rendering
     if (typeof marked !== 'undefined') {
@@ -130,6 +137,42 @@ document.addEventListener('DOMContentLoaded', () => {
         messagesContainer.scrollTop = messagesContainer.scrollHeight;
     }
 
+    // 追加流式增量到当前AI消息（首个增量时创建消息元素）
+    function appendStreamDelta(text) {
+        if (!streamingMessageElement) {
+            streamingMessageElement = document.createElement('div');
+            streamingMessageElement.classList.add('message', 'ai', 'streaming');
+            streamingMessageElement.appendChild(document.createTextNode(''));
+            messagesContainer.appendChild(streamingMessageElement);
+        }
+        streamingMessageElement.firstChild.textContent += text;
+        messagesContainer.scrollTop = messagesContainer.scrollHeight;
+    }
+
+    // 收到完整回复时结束流式消息，用最终文本重新渲染
+    function finishStreamingMessage(text) {
+        if (streamingMessageElement && streamingMessageElement.parentElement) {
+            streamingMessageElement.parentElement.removeChild(streamingMessageElement);
+        }
+        streamingMessageElement = null;
+        appendMessage(text, 'ai');
+    }
+
+    // 放弃当前流式消息：保留已收到的部分，后续增量属于新的回复
+    function abandonStreamingMessage() {
+        if (streamingMessageElement) {
+            streamingMessageElement.classList.remove('streaming');
+            streamingMessageElement = null;
+        }
+    }
+
+    // 取消正在进行的请求（Esc）
+    function cancelRequest() {
+        if (loadingMessageElement || streamingMessageElement) {
+            sendToESP32({ type: 'cancel', sessionId: sessionId });
+        }
+    }
+
     // 通过WebSocket发送数据到ESP32
     function sendToESP32(data) {
         if (websocket && websocket.readyState === WebSocket.OPEN) {
@@ -158,8 +201,19 @@ document.addEventListener('DOMContentLoaded', () => {
             try {
                 const data = JSON.parse(event.data);
                 // 处理不同类型的消息
-                if (data.type === 'chat_message' && data.sender === 'bot') {
-                    appendMessage(data.text, 'ai');
+                if (data.type === 'chat_delta') {
+                    appendStreamDelta(data.text);
+                } else if (data.type === 'chat_message' && data.sender === 'bot') {
+                    finishStreamingMessage(data.text);
+                } else if (data.type === 'request_cancelled') {
+                    abandonStreamingMessage();
+                    appendMessage('已取消', 'system');
+                } else if (data.type === 'tool_results') {
+                    abandonStreamingMessage();
+                    (data.results || []).forEach(r => {
+                        const status = r.ok ? '已执行' : '失败';
+                        appendMessage(r.result ? `工具 '${r.name}' ${status}: ${r.result}` : `工具 '${r.name}' ${status}`, 'system');
+                    });
                 } else if (data.type === 'tool_execution_result') {
                     appendMessage(`工具 '${data.tool_name}' 已执行。结果: ${data.result}`, 'system');
                 } else if (data.type === 'config_update_status') {
@@ -274,9 +328,12 @@ document.addEventListener('DOMContentLoaded', () => {
     function sendMessage() {
         const messageText = messageInput.value.trim();
         if (messageText) {
+            // 设备会中止上一条尚未完成的回复
+            abandonStreamingMessage();
+            removeLoadingMessage();
             appendMessage(messageText, 'user');
             showLoadingMessage(); // Show thinking indicator
-            sendToESP32({ type: 'chat_message', payload: messageText });
+            sendToESP32({ type: 'chat_message', payload: messageText, sessionId: sessionId });
             messageInput.value = '';
             messageInput.style.height = 'auto';
         }
@@ -325,6 +382,12 @@ document.addEventListener('DOMContentLoaded', () => {
             sendMessage();
         }
     });
+    // Esc 取消正在生成的回复
+    messageInput.addEventListener('keydown', (e) => {
+        if (e.key === 'Escape') {
+            cancelRequest();
+        }
+    });
 
     // --- New Settings Panel Event Listeners ---
     // LLM提供商切换事件
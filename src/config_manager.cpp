@@ -14,6 +14,43 @@ bool ConfigManager::loadConfig() {
         configDoc["last_used"]["model"] = "deepseek-chat";   // 默认模型
         configDoc["last_used"]["wifi_ssid"] = "CMCC-Tjv9";            // WiFi SSID 占位符
 
+        // LLM 请求行为配置
+        configDoc["llm_settings"]["stream"] = true; // 以 SSE 流式接收回复，尽早推送首个 token
+        configDoc["llm_settings"]["native_tools"] = true; // 高级模式以 tools 字段发送工具定义，关闭时退回文字描述
+        // 本地意图匹配：简单的设备命令（"turn on led2"）直接执行，不经过 LLM；未配置 rules 时使用内置规则
+        configDoc["llm_settings"]["intents"]["enabled"] = true;
+        // 每个模型的请求 token 预算（系统提示 + 历史 + 当前输入），超出时丢弃最旧的历史消息
+        configDoc["llm_settings"]["default_token_budget"] = 8000;
+        configDoc["llm_settings"]["token_budgets"]["deepseek-chat"] = 32000;
+        configDoc["llm_settings"]["token_budgets"]["deepseek-reasoner"] = 32000;
+        configDoc["llm_settings"]["token_budgets"]["gpt-4o"] = 32000;
+        configDoc["llm_settings"]["token_budgets"]["gpt-3.5-turbo"] = 8000;
+        // 请求从提交起的总超时（毫秒），超过后中止读取并丢弃
+        configDoc["llm_settings"]["request_timeout_ms"] = 120000;
+        // 并行处理请求的工作任务数（受剩余内存限制，修改后需重启）
+        configDoc["llm_settings"]["workers"] = 2;
+        // 按会话隔离对话历史：同时保留的会话数和每个会话的历史内存区大小（PSRAM）
+        configDoc["llm_settings"]["max_sessions"] = 4;
+        configDoc["llm_settings"]["session_history_bytes"] = 65536;
+        // 按内容寻址的响应缓存（缺省关闭）：TTL（秒）、PSRAM 层容量、可选的 LittleFS 持久层
+        configDoc["llm_settings"]["cache"]["enabled"] = false;
+        configDoc["llm_settings"]["cache"]["ttl_s"] = 3600;
+        configDoc["llm_settings"]["cache"]["max_entries"] = 32;
+        configDoc["llm_settings"]["cache"]["max_bytes"] = 262144;
+        configDoc["llm_settings"]["cache"]["persist"] = false;
+        configDoc["llm_settings"]["cache"]["persist_slots"] = 32;
+        // 提供商路由：主路由首字节迟迟未到时向备用路由发出对冲请求；连续失败的提供商被熔断
+        configDoc["llm_settings"]["routing"]["secondary"]["provider"] = ""; // 留空表示不对冲、不故障转移
+        configDoc["llm_settings"]["routing"]["secondary"]["model"] = "";
+        configDoc["llm_settings"]["routing"]["hedge"] = true;
+        configDoc["llm_settings"]["routing"]["hedge_percentile"] = 95;
+        configDoc["llm_settings"]["routing"]["hedge_delay_ms"] = 4000;
+        configDoc["llm_settings"]["routing"]["hedge_min_delay_ms"] = 500;
+        configDoc["llm_settings"]["routing"]["breaker_failures"] = 3;
+        configDoc["llm_settings"]["routing"]["breaker_cooldown_ms"] = 30000;
+        // 运行期日志级别：error / warn / info / debug / none（debug 输出完整提示、回复和 CDC 消息）
+        configDoc["log_settings"]["level"] = "info";
+
         // DeepSeek LLM 提供商配置
         JsonObject deepseek = configDoc["llm_providers"]["deepseek"].to<JsonObject>();
         deepseek["api_key"] = "sk-3f54327d09514e21868e78aca13730dd"; // DeepSeek API 密钥
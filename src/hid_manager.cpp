@@ -1,6 +1,12 @@
 #include "hid_manager.h"
 
-HIDManager::HIDManager() : ready(false) {}
+HIDManager::HIDManager() : ready(false) {
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    keyboardActions = registry.counter("noox_hid_actions_total", "HID actions sent", "kind=\"keyboard\"");
+    mouseActions = registry.counter("noox_hid_actions_total", "HID actions sent", "kind=\"mouse\"");
+    macros = registry.counter("noox_hid_actions_total", "HID actions sent", "kind=\"macro\"");
+    errors = registry.counter("noox_hid_errors_total", "HID actions rejected");
+}
 
 void HIDManager::begin() {
     keyboard.begin();
@@ -11,22 +17,27 @@ void HIDManager::begin() {
 }
 
 void HIDManager::sendKey(char key) {
+    keyboardActions->inc();
     keyboard.write(key);
 }
 
 void HIDManager::sendString(const String& str) {
+    keyboardActions->inc();
     keyboard.print(str);
 }
 
 void HIDManager::moveMouse(int x, int y) {
+    mouseActions->inc();
     mouse.move(x, y);
 }
 
 void HIDManager::clickMouse(int button) {
+    mouseActions->inc();
     mouse.click(button);
 }
 
 void HIDManager::openApplication(const String& appName) {
+    keyboardActions->inc();
     // Simulate Windows Key + R to open Run dialog
     keyboard.press(KEY_LEFT_GUI); // Windows Key
     keyboard.press('r');
@@ -42,6 +53,7 @@ void HIDManager::openApplication(const String& appName) {
 }
 
 void HIDManager::runCommand(const String& command) {
+    keyboardActions->inc();
     // Simulate Windows Key + R to open Run dialog
     keyboard.press(KEY_LEFT_GUI); // Windows Key
     keyboard.press('r');
@@ -57,6 +69,7 @@ void HIDManager::runCommand(const String& command) {
 }
 
 void HIDManager::takeScreenshot() {
+    keyboardActions->inc();
     // Simulate Print Screen key press.
     // KEY_PRTSC is often defined as 0x46 in USBHIDKeyboard.h for ESP32.
     keyboard.press(0x46); // HID Usage ID for Print Screen
@@ -65,6 +78,7 @@ void HIDManager::takeScreenshot() {
 }
 
 void HIDManager::simulateKeyPress(uint8_t key, uint8_t modifiers) {
+    keyboardActions->inc();
     if (modifiers & KEY_LEFT_CTRL) keyboard.press(KEY_LEFT_CTRL);
     if (modifiers & KEY_LEFT_SHIFT) keyboard.press(KEY_LEFT_SHIFT);
     if (modifiers & KEY_LEFT_ALT) keyboard.press(KEY_LEFT_ALT);
@@ -85,6 +99,13 @@ String HIDManager::getLastError() {
     return lastError;
 }
 
+// Record lastError and count the failure
+bool HIDManager::fail(const String& error) {
+    lastError = error;
+    errors->inc();
+    return false;
+}
+
 // Parse modifier keys from string
 uint8_t HIDManager::parseModifier(const String& modifier) {
     String mod = modifier;
@@ -163,8 +184,7 @@ uint8_t HIDManager::parseMediaKeyCode(const String& mediaKey) {
 // Press key combination like "Ctrl+C", "Alt+Tab", "Ctrl+Shift+Esc"
 bool HIDManager::pressKeyCombination(const String& keys) {
     if (!ready) {
-        lastError = "HID not ready";
-        return false;
+        return fail("HID not ready");
     }
     
     // Split the key combination by "+"
@@ -184,8 +204,7 @@ bool HIDManager::pressKeyCombination(const String& keys) {
     }
     
     if (partCount == 0) {
-        lastError = "Empty key combination";
-        return false;
+        return fail("Empty key combination");
     }
     
     // Press modifiers (all parts except the last one)
@@ -194,8 +213,8 @@ bool HIDManager::pressKeyCombination(const String& keys) {
         parts[i].trim();
         uint8_t mod = parseModifier(parts[i]);
         if (mod == 0) {
-            lastError = "Unknown modifier: " + parts[i];
-            return false;
+            keyboard.releaseAll(); // 松开已按下的修饰键，避免卡键
+            return fail("Unknown modifier: " + parts[i]);
         }
         modifiers |= mod;
         keyboard.press(mod);
@@ -212,13 +231,13 @@ bool HIDManager::pressKeyCombination(const String& keys) {
         keyboard.press(mainKey.charAt(0));
     } else {
         keyboard.releaseAll();
-        lastError = "Unknown key: " + mainKey;
-        return false;
+        return fail("Unknown key: " + mainKey);
     }
     
     delay(50);
     keyboard.releaseAll();
     
+    keyboardActions->inc();
     lastError = "";
     return true;
 }
@@ -226,14 +245,12 @@ bool HIDManager::pressKeyCombination(const String& keys) {
 // Execute a macro (series of actions)
 bool HIDManager::executeMacro(const JsonArray& actions) {
     if (!ready) {
-        lastError = "HID not ready";
-        return false;
+        return fail("HID not ready");
     }
     
     for (JsonVariant action : actions) {
         if (!action.is<JsonObject>()) {
-            lastError = "Invalid action format";
-            return false;
+            return fail("Invalid action format");
         }
         
         JsonObject actionObj = action.as<JsonObject>();
@@ -259,11 +276,11 @@ bool HIDManager::executeMacro(const JsonArray& actions) {
             int y = actionObj["y"] | 0;
             moveMouse(x, y);
         } else {
-            lastError = "Unknown action type: " + actionType;
-            return false;
+            return fail("Unknown action type: " + actionType);
         }
     }
     
+    macros->inc();
     lastError = "";
     return true;
 }
@@ -271,20 +288,19 @@ bool HIDManager::executeMacro(const JsonArray& actions) {
 // Press special key
 bool HIDManager::pressSpecialKey(const String& keyName) {
     if (!ready) {
-        lastError = "HID not ready";
-        return false;
+        return fail("HID not ready");
     }
     
     uint8_t keyCode = parseSpecialKeyCode(keyName);
     if (keyCode == 0) {
-        lastError = "Unknown special key: " + keyName;
-        return false;
+        return fail("Unknown special key: " + keyName);
     }
     
     keyboard.press(keyCode);
     delay(50);
     keyboard.releaseAll();
     
+    keyboardActions->inc();
     lastError = "";
     return true;
 }
@@ -292,14 +308,12 @@ bool HIDManager::pressSpecialKey(const String& keyName) {
 // Press media key
 bool HIDManager::pressMediaKey(const String& mediaKey) {
     if (!ready) {
-        lastError = "HID not ready";
-        return false;
+        return fail("HID not ready");
     }
     
     uint8_t keyCode = parseMediaKeyCode(mediaKey);
     if (keyCode == 0) {
-        lastError = "Unknown media key: " + mediaKey;
-        return false;
+        return fail("Unknown media key: " + mediaKey);
     }
     
     // Note: Media keys may require special handling depending on the HID library
@@ -308,6 +322,7 @@ bool HIDManager::pressMediaKey(const String& mediaKey) {
     delay(50);
     keyboard.releaseAll();
     
+    keyboardActions->inc();
     lastError = "";
     return true;
 }
@@ -0,0 +1,177 @@
+#include "http_body_stream.h"
+#include "logger.h"
+
+// 构造函数
+HttpBodyStream::HttpBodyStream(Client& client, int contentLength, bool chunked, unsigned long timeoutMs)
+    : client(client), failed(false), timeoutMs(timeoutMs), totalRead(0), waitMicros(0), abortSignal(nullptr),
+      rawPos(0), rawLen(0), bodyPos(0), bodyEnd(0) {
+    setTimeout(timeoutMs);
+    parser.beginBody(contentLength, chunked);
+}
+
+HttpBodyStream::HttpBodyStream(Client& client, const HttpResponseHead& head, unsigned long timeoutMs)
+    : HttpBodyStream(client, head.contentLength, head.chunked, timeoutMs) {
+}
+
+// 读取响应状态行和响应头
+bool HttpBodyStream::readHead(Client& client, HttpResponseHead& head, unsigned long timeoutMs,
+                              const HttpAbortSignal* abortSignal) {
+    HttpResponseParser headParser;
+    bool timedOut = false;
+
+    head.statusCode = -1;
+    // 逐字节交给状态机，响应头结束时立即停下，不读入任何响应体字节（1xx 临时响应由状态机跳过）
+    while (!headParser.isHeadComplete()) {
+        if (!waitForData(client, timeoutMs, abortSignal, timedOut)) {
+            return false;
+        }
+        int c = client.read();
+        if (c < 0) {
+            continue;
+        }
+        uint8_t byte = (uint8_t)c;
+        size_t bodyOffset, bodyLength;
+        headParser.feed(&byte, 1, bodyOffset, bodyLength);
+        if (headParser.hasFailed()) {
+            LOG_W("HTTP", "%s", headParser.getError());
+            return false;
+        }
+    }
+    head = headParser.getHead();
+    return true;
+}
+
+int HttpBodyStream::available() {
+    if (bodyPos < bodyEnd) {
+        return bodyEnd - bodyPos;
+    }
+    if (parser.isComplete() || failed) {
+        return 0;
+    }
+    // 只解析已到达的字节，不阻塞；连接已关闭时由 fill() 判定是正常结束还是中断
+    return fill(false) ? (int)(bodyEnd - bodyPos) : 0;
+}
+
+int HttpBodyStream::read() {
+    if (!fill()) {
+        return -1;
+    }
+    return buffer[bodyPos++];
+}
+
+int HttpBodyStream::peek() {
+    if (!fill()) {
+        return -1;
+    }
+    return buffer[bodyPos];
+}
+
+size_t HttpBodyStream::readBytes(char* dest, size_t length) {
+    size_t copied = 0;
+    while (copied < length && fill()) {
+        size_t n = min(length - copied, bodyEnd - bodyPos);
+        memcpy(dest + copied, buffer + bodyPos, n);
+        bodyPos += n;
+        copied += n;
+    }
+    return copied;
+}
+
+bool HttpBodyStream::drain() {
+    while (fill()) {
+        bodyPos = bodyEnd;
+    }
+    return isComplete();
+}
+
+// 等待连接上有数据可读，并累计等待时间（用于区分网络等待和解析耗时）
+bool HttpBodyStream::waitForData() {
+    unsigned long start = micros();
+    bool ready = waitForData(client, timeoutMs, abortSignal, failed);
+    waitMicros += micros() - start;
+    return ready;
+}
+
+// 等待连接上有数据可读
+bool HttpBodyStream::waitForData(Client& client, unsigned long timeoutMs, const HttpAbortSignal* abortSignal, bool& timedOut) {
+    unsigned long start = millis();
+    while (client.available() <= 0) {
+        if (!client.connected()) {
+            return false;
+        }
+        if (abortSignal && abortSignal->triggered()) {
+            LOG_W("HTTP", "Read aborted (cancelled or past deadline)");
+            timedOut = true;
+            return false;
+        }
+        if (millis() - start > timeoutMs) {
+            LOG_W("HTTP", "Timed out waiting for response data");
+            timedOut = true;
+            return false;
+        }
+        delay(1);
+    }
+    return true;
+}
+
+// 从连接读取并解析出下一段响应体
+bool HttpBodyStream::fill(bool block) {
+    while (bodyPos >= bodyEnd) {
+        if (failed) {
+            return false;
+        }
+
+        // 先把已读入的原始字节交给状态机
+        if (rawPos < rawLen) {
+            size_t bodyOffset, bodyLength;
+            size_t used = parser.feed(buffer + rawPos, rawLen - rawPos, bodyOffset, bodyLength);
+            if (bodyLength > 0) {
+                bodyPos = rawPos + bodyOffset;
+                bodyEnd = bodyPos + bodyLength;
+                totalRead += bodyLength;
+            }
+            rawPos += used;
+            if (parser.hasFailed()) {
+                LOG_W("HTTP", "%s", parser.getError());
+                failed = true;
+                return false;
+            }
+            if (bodyLength > 0) {
+                return true;
+            }
+            if (used > 0) {
+                continue;
+            }
+        }
+        // 响应体一结束立即返回，不再等待连接上的后续数据
+        if (parser.isComplete()) {
+            return false;
+        }
+
+        bool ready = block ? waitForData() : client.available() > 0;
+        if (!ready) {
+            if (!failed && !client.connected()) {
+                // 连接已关闭：只有"读到关闭为止"的响应体是正常结束
+                parser.finishOnClose();
+                if (parser.hasFailed()) {
+                    LOG_W("HTTP", "Connection closed before end of response body");
+                    failed = true;
+                }
+            }
+            return false;
+        }
+
+        // 每次最多读到本条响应的末尾，连接上不会残留被多读的字节
+        size_t want = parser.readLimit();
+        if (want > sizeof(buffer)) want = sizeof(buffer);
+        int n = client.read(buffer, want);
+        if (n <= 0) {
+            return false;
+        }
+        rawPos = 0;
+        rawLen = n;
+        bodyPos = 0;
+        bodyEnd = 0;
+    }
+    return true;
+}
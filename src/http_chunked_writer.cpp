@@ -0,0 +1,95 @@
+#include "http_chunked_writer.h"
+#include "logger.h"
+
+// 构造函数
+HttpChunkedWriter::HttpChunkedWriter(Client& client)
+    : client(client), length(0), total(0), failed(false) {
+}
+
+size_t HttpChunkedWriter::write(uint8_t data) {
+    return write(&data, 1);
+}
+
+size_t HttpChunkedWriter::write(const uint8_t* data, size_t size) {
+    if (failed) return 0;
+
+    size_t written = 0;
+    while (written < size) {
+        size_t n = min(size - written, CHUNK_SIZE - length);
+        memcpy(buffer + HEADER_RESERVE + length, data + written, n);
+        length += n;
+        written += n;
+        if (length == CHUNK_SIZE) {
+            flushChunk();
+            if (failed) break;
+        }
+    }
+    total += written;
+    return written;
+}
+
+// 写入带引号并转义的 JSON 字符串
+size_t HttpChunkedWriter::writeJsonString(const char* str) {
+    size_t n = write('"');
+    if (str) {
+        const char* runStart = str;
+        for (const char* p = str; *p; p++) {
+            uint8_t c = (uint8_t)*p;
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                continue; // 普通字符（含 UTF-8 多字节）成段写入
+            }
+            n += write((const uint8_t*)runStart, p - runStart);
+            runStart = p + 1;
+            switch (c) {
+                case '"':  n += print("\\\""); break;
+                case '\\': n += print("\\\\"); break;
+                case '\n': n += print("\\n"); break;
+                case '\r': n += print("\\r"); break;
+                case '\t': n += print("\\t"); break;
+                case '\b': n += print("\\b"); break;
+                case '\f': n += print("\\f"); break;
+                default:   n += printf("\\u%04x", c); break;
+            }
+        }
+        n += write((const uint8_t*)runStart, strlen(runStart));
+    }
+    n += write('"');
+    return n;
+}
+
+bool HttpChunkedWriter::finish() {
+    if (failed) return false;
+
+    if (length > 0) {
+        flushChunk(true); // 最后一块与结束块合并发送
+    } else if (client.write((const uint8_t*)"0\r\n\r\n", 5) != 5) {
+        failed = true;
+    }
+    return !failed;
+}
+
+// 发送一个块：十六进制长度行、数据、CRLF 在缓冲区中拼好后一次写出，
+// 避免每块拆成三条 TLS 记录（TCP_NODELAY 下往往也是三个报文段）
+void HttpChunkedWriter::flushChunk(bool last) {
+    if (failed || length == 0) return;
+
+    char header[HEADER_RESERVE + 1];
+    int headerLen = snprintf(header, sizeof(header), "%X\r\n", (unsigned int)length);
+    uint8_t* start = buffer + HEADER_RESERVE - headerLen;
+    memcpy(start, header, headerLen);
+
+    uint8_t* end = buffer + HEADER_RESERVE + length;
+    memcpy(end, "\r\n", 2);
+    end += 2;
+    if (last) {
+        memcpy(end, "0\r\n\r\n", 5);
+        end += 5;
+    }
+
+    size_t frameLen = end - start;
+    if (client.write(start, frameLen) != frameLen) {
+        LOG_E("HTTP", "Failed to write request chunk");
+        failed = true;
+    }
+    length = 0;
+}
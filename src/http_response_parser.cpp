@@ -0,0 +1,256 @@
+#include "http_response_parser.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 不区分大小写地比较两个字符串
+static bool equalsIgnoreCase(const char* a, const char* b) {
+    while (*a && *b) {
+        if (tolower((unsigned char)*a) != tolower((unsigned char)*b)) return false;
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+// 不区分大小写地查找子串
+static bool containsIgnoreCase(const char* haystack, const char* needle) {
+    size_t needleLength = strlen(needle);
+    for (; *haystack; haystack++) {
+        size_t i = 0;
+        while (i < needleLength && haystack[i] &&
+               tolower((unsigned char)haystack[i]) == tolower((unsigned char)needle[i])) {
+            i++;
+        }
+        if (i == needleLength) return true;
+    }
+    return false;
+}
+
+// 构造函数
+HttpResponseParser::HttpResponseParser() {
+    reset();
+}
+
+// 重置为从状态行开始解析
+void HttpResponseParser::reset() {
+    state = STATUS_LINE;
+    head.statusCode = -1;
+    head.contentLength = -1;
+    head.chunked = false;
+    head.keepAlive = true;
+    headComplete = false;
+    remaining = 0;
+    chunkRemaining = 0;
+    lineLength = 0;
+    error = "";
+}
+
+// 跳过响应头，直接读取响应体
+void HttpResponseParser::beginBody(int contentLength, bool chunked) {
+    reset();
+    head.contentLength = contentLength;
+    head.chunked = chunked;
+    headComplete = true;
+    enterBody();
+}
+
+void HttpResponseParser::fail(const char* reason) {
+    state = FAILED;
+    error = reason;
+}
+
+// 响应头结束后进入对应的响应体状态
+void HttpResponseParser::enterBody() {
+    lineLength = 0;
+    if (head.chunked) {
+        state = CHUNK_SIZE;
+    } else if (head.contentLength == 0) {
+        state = COMPLETE;
+    } else if (head.contentLength > 0) {
+        remaining = head.contentLength;
+        state = BODY_LENGTH;
+    } else {
+        state = BODY_UNTIL_CLOSE;
+    }
+}
+
+// 累积一个字节到当前行
+bool HttpResponseParser::appendLineByte(uint8_t c) {
+    if (c == '\n') {
+        line[lineLength] = '\0';
+        return true;
+    }
+    if (c != '\r' && lineLength < sizeof(line) - 1) {
+        line[lineLength++] = (char)c;
+    }
+    return false;
+}
+
+// 处理一行完整的分帧行
+void HttpResponseParser::handleLine() {
+    lineLength = 0;
+    switch (state) {
+        case STATUS_LINE:
+            // 状态行：HTTP/1.1 200 OK
+            if (strncmp(line, "HTTP/1.", 7) != 0 || strlen(line) < 12) {
+                fail("Malformed status line");
+                return;
+            }
+            head.keepAlive = (line[7] == '1'); // HTTP/1.0 默认不保持连接
+            head.statusCode = atoi(line + 9);
+            head.contentLength = -1;
+            head.chunked = false;
+            state = HEADER_LINE;
+            return;
+
+        case HEADER_LINE: {
+            if (line[0] == '\0') {
+                if (head.statusCode >= 100 && head.statusCode < 200) {
+                    // 1xx 临时响应：继续等待最终响应
+                    state = STATUS_LINE;
+                    return;
+                }
+                if (head.statusCode == 204 || head.statusCode == 304) {
+                    head.contentLength = 0; // 没有响应体
+                    head.chunked = false;
+                }
+                // 既无长度也非 chunked 的响应体只能读到连接关闭为止
+                if (!head.chunked && head.contentLength < 0) {
+                    head.keepAlive = false;
+                }
+                headComplete = true;
+                enterBody();
+                return;
+            }
+            // 过长的头（如 Set-Cookie）只保留前半部分，不影响这里关心的字段
+            char* colon = strchr(line, ':');
+            if (!colon) {
+                return;
+            }
+            *colon = '\0';
+            const char* value = colon + 1;
+            while (*value == ' ' || *value == '\t') value++;
+
+            if (equalsIgnoreCase(line, "Content-Length")) {
+                head.contentLength = atoi(value);
+            } else if (equalsIgnoreCase(line, "Transfer-Encoding")) {
+                head.chunked = containsIgnoreCase(value, "chunked");
+            } else if (equalsIgnoreCase(line, "Connection")) {
+                if (containsIgnoreCase(value, "close")) {
+                    head.keepAlive = false;
+                } else if (containsIgnoreCase(value, "keep-alive")) {
+                    head.keepAlive = true;
+                }
+            }
+            return;
+        }
+
+        case CHUNK_SIZE: {
+            char* end = nullptr;
+            unsigned long size = strtoul(line, &end, 16); // 忽略 ";ext" 扩展
+            if (end == line) {
+                fail("Malformed chunk header");
+                return;
+            }
+            if (size == 0) {
+                state = TRAILER; // 末尾块：跳过 trailer 直到空行
+            } else {
+                chunkRemaining = size;
+                state = CHUNK_DATA;
+            }
+            return;
+        }
+
+        case CHUNK_DATA_END:
+            if (line[0] != '\0') {
+                fail("Missing CRLF after chunk data");
+                return;
+            }
+            state = CHUNK_SIZE;
+            return;
+
+        case TRAILER:
+            if (line[0] == '\0') {
+                state = COMPLETE;
+            }
+            return;
+
+        default:
+            return;
+    }
+}
+
+// 推入收到的字节
+size_t HttpResponseParser::feed(const uint8_t* data, size_t length, size_t& bodyOffset, size_t& bodyLength) {
+    bodyOffset = 0;
+    bodyLength = 0;
+    size_t pos = 0;
+
+    while (pos < length) {
+        switch (state) {
+            case BODY_LENGTH: {
+                size_t n = length - pos;
+                if (n > remaining) n = remaining;
+                bodyOffset = pos;
+                bodyLength = n;
+                remaining -= n;
+                if (remaining == 0) state = COMPLETE;
+                return pos + n;
+            }
+
+            case BODY_UNTIL_CLOSE:
+                bodyOffset = pos;
+                bodyLength = length - pos;
+                return length;
+
+            case CHUNK_DATA: {
+                size_t n = length - pos;
+                if (n > chunkRemaining) n = chunkRemaining;
+                bodyOffset = pos;
+                bodyLength = n;
+                chunkRemaining -= n;
+                if (chunkRemaining == 0) state = CHUNK_DATA_END;
+                return pos + n;
+            }
+
+            case COMPLETE:
+            case FAILED:
+                return pos;
+
+            default: {
+                // 分帧行：状态行、响应头、块头、块尾 CRLF、trailer
+                bool wasHead = headComplete;
+                if (appendLineByte(data[pos++])) {
+                    handleLine();
+                    if (!wasHead && headComplete) {
+                        return pos; // 响应头刚结束，让调用方决定如何读取响应体
+                    }
+                }
+                break;
+            }
+        }
+    }
+    return pos;
+}
+
+// 连接已关闭
+void HttpResponseParser::finishOnClose() {
+    if (state == BODY_UNTIL_CLOSE) {
+        state = COMPLETE;
+    } else if (state != COMPLETE && state != FAILED) {
+        fail("Connection closed before end of response");
+    }
+}
+
+// 下一次最多应从连接读取的字节数
+size_t HttpResponseParser::readLimit() const {
+    switch (state) {
+        case BODY_LENGTH: return remaining;
+        case CHUNK_DATA: return chunkRemaining;
+        case BODY_UNTIL_CLOSE: return SIZE_MAX;
+        case COMPLETE:
+        case FAILED: return 0;
+        default: return 1;
+    }
+}
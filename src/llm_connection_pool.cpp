@@ -0,0 +1,137 @@
+#include "llm_connection_pool.h"
+#include "logger.h"
+
+// 连接空闲超过该时间后不再复用（服务器通常在60秒左右关闭空闲的keep-alive连接）
+const unsigned long POOL_IDLE_TIMEOUT = 45000;
+
+// 构造函数
+LLMConnectionPool::LLMConnectionPool(LLMTlsSessionCache* sessionCache, const LLMConnectionPoolMetrics& metrics,
+                                     size_t maxHosts)
+    : sessionCache(sessionCache), capacity(maxHosts), count(0), metrics(metrics) {
+    connections = new LLMPooledConnection[capacity];
+    for (size_t i = 0; i < capacity; i++) {
+        connections[i].client = nullptr;
+        connections[i].lastUsed = 0;
+    }
+}
+
+// 析构函数
+LLMConnectionPool::~LLMConnectionPool() {
+    for (size_t i = 0; i < count; i++) {
+        if (connections[i].client) {
+            connections[i].client->stop();
+            delete connections[i].client;
+            connections[i].client = nullptr;
+        }
+    }
+    delete[] connections;
+}
+
+// 判断池中连接是否仍可复用
+bool LLMConnectionPool::isReusable(LLMPooledConnection& conn) {
+    if (!conn.client->connected()) {
+        return false;
+    }
+    if (millis() - conn.lastUsed > POOL_IDLE_TIMEOUT) {
+        // 服务器可能已经单方面关闭，提前丢弃以免在发送时才发现
+        LOG_I("POOL", "Connection to %s idle too long, closing", conn.host.c_str());
+        return false;
+    }
+    if (conn.client->available() > 0) {
+        // 空闲连接上出现未请求的数据（通常是服务器的关闭通知），不能再用于新的请求
+        LOG_I("POOL", "Stale data on idle connection to %s, closing", conn.host.c_str());
+        return false;
+    }
+    return true;
+}
+
+// 获取指定主机的客户端
+LLMTlsClient* LLMConnectionPool::acquire(const String& host, bool& reused) {
+    reused = false;
+
+    LLMPooledConnection* conn = nullptr;
+    for (size_t i = 0; i < count; i++) {
+        if (connections[i].host == host) {
+            conn = &connections[i];
+            break;
+        }
+    }
+
+    if (!conn) {
+        if (count < capacity) {
+            conn = &connections[count++];
+        } else {
+            // 池已满，淘汰最久未使用的主机
+            conn = &connections[0];
+            for (size_t i = 1; i < count; i++) {
+                if (connections[i].lastUsed < conn->lastUsed) {
+                    conn = &connections[i];
+                }
+            }
+            LOG_I("POOL", "Evicting connection to %s", conn->host.c_str());
+            if (conn->client) {
+                conn->client->stop();
+            }
+        }
+        conn->host = host;
+        if (!conn->client) {
+            conn->client = new LLMTlsClient(sessionCache);
+            if (!conn->client) {
+                return nullptr;
+            }
+        }
+    }
+
+    if (isReusable(*conn)) {
+        reused = true;
+        metrics.hits->inc();
+    } else {
+        conn->client->stop();
+        metrics.misses->inc();
+    }
+
+    LOG_I("POOL", "%s for %s (hits: %u, misses: %u, redials: %u)",
+          reused ? "Reusing connection" : "New connection", host.c_str(),
+          metrics.hits->get(), metrics.misses->get(), metrics.redials->get());
+    return conn->client;
+}
+
+// 归还客户端
+void LLMConnectionPool::release(LLMTlsClient* client) {
+    LLMPooledConnection* conn = find(client);
+    if (!conn) return;
+
+    conn->lastUsed = millis();
+    if (!client->connected()) {
+        // 服务器要求关闭（Connection: close 或 HTTP/1.0），下次需要重新拨号
+        client->stop();
+    }
+}
+
+// 丢弃指定客户端当前的连接
+void LLMConnectionPool::invalidate(LLMTlsClient* client) {
+    LLMPooledConnection* conn = find(client);
+    if (!conn) return;
+
+    client->stop();
+    metrics.redials->inc();
+}
+
+// 关闭所有连接
+void LLMConnectionPool::closeAll() {
+    for (size_t i = 0; i < count; i++) {
+        if (connections[i].client) {
+            connections[i].client->stop();
+        }
+    }
+}
+
+// 查找客户端对应的连接项
+LLMPooledConnection* LLMConnectionPool::find(LLMTlsClient* client) {
+    for (size_t i = 0; i < count; i++) {
+        if (connections[i].client == client) {
+            return &connections[i];
+        }
+    }
+    return nullptr;
+}
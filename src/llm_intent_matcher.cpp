@@ -0,0 +1,307 @@
+#include "llm_intent_matcher.h"
+#include "logger.h"
+#include "llm_tool_registry.h"
+
+// 没有配置 llm_settings.intents.rules 时使用的内置规则
+static const char DEFAULT_INTENT_RULES[] = R"JSON([
+  {"pattern": "turn on {gpio:led1|led2|led3|gpio1|gpio2}", "tool": "gpio_set", "args": {"gpio": "{gpio}", "state": true}},
+  {"pattern": "turn off {gpio:led1|led2|led3|gpio1|gpio2}", "tool": "gpio_set", "args": {"gpio": "{gpio}", "state": false}},
+  {"pattern": "press {keys}", "tool": "hid_keyboard_press", "args": {"keys": "{keys}"}},
+  {"pattern": "type {text...}", "tool": "hid_keyboard_type", "args": {"text": "{text}"}},
+  {"pattern": "click", "tool": "hid_mouse_click", "args": {}},
+  {"pattern": "{button:left|right|middle} click", "tool": "hid_mouse_click", "args": {"button": "{button}"}},
+  {"pattern": "move mouse {x:int} {y:int}", "tool": "hid_mouse_move", "args": {"x": "{x}", "y": "{y}"}}
+])JSON";
+
+// 构造函数
+LLMIntentMatcher::LLMIntentMatcher()
+    : rules(nullptr), ruleCount(0), enabled(false), attempts(0), hits(0), matchMicros(0) {
+    lock = xSemaphoreCreateMutex();
+}
+
+// 析构函数
+LLMIntentMatcher::~LLMIntentMatcher() {
+    delete[] rules;
+    vSemaphoreDelete(lock);
+}
+
+// 编译一条模式
+bool LLMIntentMatcher::compile(const String& pattern, Rule& rule) {
+    rule.tokenCount = 0;
+    bool hasLiteral = false;
+    int pos = 0;
+    int length = pattern.length();
+    while (pos < length) {
+        while (pos < length && isspace((unsigned char)pattern[pos])) pos++;
+        if (pos >= length) break;
+        int end = pos;
+        while (end < length && !isspace((unsigned char)pattern[end])) end++;
+        String word = pattern.substring(pos, end);
+        pos = end;
+
+        if (rule.tokenCount >= MAX_PATTERN_TOKENS) {
+            return false;
+        }
+        // 剩余输入只能作为最后一个词
+        if (rule.tokenCount > 0 && rule.tokens[rule.tokenCount - 1].kind == TOKEN_REST) {
+            return false;
+        }
+        PatternToken& token = rule.tokens[rule.tokenCount++];
+        if (word.startsWith("{") && word.endsWith("}")) {
+            String slot = word.substring(1, word.length() - 1);
+            int colon = slot.indexOf(':');
+            if (slot.endsWith("...")) {
+                token.kind = TOKEN_REST;
+                token.slot = slot.substring(0, slot.length() - 3);
+            } else if (colon < 0) {
+                token.kind = TOKEN_WORD;
+                token.slot = slot;
+            } else {
+                token.slot = slot.substring(0, colon);
+                token.text = slot.substring(colon + 1);
+                token.text.toLowerCase();
+                token.kind = (token.text == "int") ? TOKEN_INTEGER : TOKEN_CHOICE;
+            }
+            if (token.slot.length() == 0) {
+                return false;
+            }
+        } else {
+            token.kind = TOKEN_LITERAL;
+            token.text = word;
+            token.text.toLowerCase();
+            hasLiteral = true;
+        }
+    }
+    // 没有字面词的模式会匹配过多的输入，不够可靠
+    return hasLiteral;
+}
+
+// 加入一条规则
+void LLMIntentMatcher::addRule(JsonObject ruleConfig, const LLMToolRegistry& registry) {
+    Rule& rule = rules[ruleCount];
+    rule.pattern = ruleConfig["pattern"] | "";
+    rule.tool = ruleConfig["tool"] | "";
+    if (!registry.find(rule.tool.c_str())) {
+        LOG_I("INTENT", "Skipping rule \"%s\": unknown tool %s", rule.pattern.c_str(), rule.tool.c_str());
+        return;
+    }
+    if (!compile(rule.pattern, rule)) {
+        LOG_I("INTENT", "Skipping rule \"%s\": invalid pattern", rule.pattern.c_str());
+        return;
+    }
+    rule.argsTemplate = "";
+    if (ruleConfig["args"].is<JsonObject>()) {
+        serializeJson(ruleConfig["args"], rule.argsTemplate);
+    } else {
+        rule.argsTemplate = "{}";
+    }
+    rule.hits = 0;
+    ruleCount++;
+}
+
+// 从配置加载规则
+void LLMIntentMatcher::configure(JsonObject config, const LLMToolRegistry& registry) {
+    JsonDocument defaultRules;
+    JsonArray ruleConfigs = config["rules"];
+    if (ruleConfigs.isNull()) {
+        deserializeJson(defaultRules, DEFAULT_INTENT_RULES);
+        ruleConfigs = defaultRules.as<JsonArray>();
+    }
+    size_t wanted = ruleConfigs.size();
+    if (wanted > MAX_RULES) wanted = MAX_RULES;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    enabled = config["enabled"] | true;
+    delete[] rules;
+    rules = (wanted > 0) ? new Rule[wanted] : nullptr;
+    ruleCount = 0;
+    for (JsonObject ruleConfig : ruleConfigs) {
+        if (ruleCount >= wanted) break;
+        addRule(ruleConfig, registry);
+    }
+    xSemaphoreGive(lock);
+
+    LOG_I("INTENT", "Local intent matching %s, %u rules", enabled ? "on" : "off", (unsigned)ruleCount);
+}
+
+// 词是否为整数
+static bool isInteger(const char* text, size_t length) {
+    size_t i = (length > 0 && (text[0] == '-' || text[0] == '+')) ? 1 : 0;
+    if (i >= length) return false;
+    for (; i < length; i++) {
+        if (!isdigit((unsigned char)text[i])) return false;
+    }
+    return true;
+}
+
+// 词是否为 '|' 分隔的可选词之一（不区分大小写）
+static bool matchesChoice(const String& options, const char* word, size_t length) {
+    int start = 0;
+    while (start <= (int)options.length()) {
+        int end = options.indexOf('|', start);
+        if (end < 0) end = options.length();
+        if ((size_t)(end - start) == length && strncasecmp(options.c_str() + start, word, length) == 0) {
+            return true;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+// 用一条规则匹配已分词的输入
+bool LLMIntentMatcher::matchRule(const Rule& rule, const String& input, const uint16_t* starts, const uint16_t* ends,
+                                 size_t tokenCount, String& toolCalls) {
+    // 槽位值：名称、文本、是否为整数
+    const String* slotNames[MAX_PATTERN_TOKENS];
+    String slotValues[MAX_PATTERN_TOKENS];
+    bool slotIsInteger[MAX_PATTERN_TOKENS];
+    size_t slotCount = 0;
+
+    size_t t = 0;
+    for (uint8_t p = 0; p < rule.tokenCount; p++) {
+        const PatternToken& token = rule.tokens[p];
+        if (token.kind == TOKEN_REST) {
+            if (t >= tokenCount) return false;
+            slotNames[slotCount] = &token.slot;
+            slotValues[slotCount] = input.substring(starts[t], ends[tokenCount - 1]);
+            slotIsInteger[slotCount++] = false;
+            t = tokenCount;
+            continue;
+        }
+        if (t >= tokenCount) return false;
+        const char* word = input.c_str() + starts[t];
+        size_t length = ends[t] - starts[t];
+        switch (token.kind) {
+            case TOKEN_LITERAL:
+                if (token.text.length() != length || strncasecmp(token.text.c_str(), word, length) != 0) return false;
+                break;
+            case TOKEN_CHOICE:
+                if (!matchesChoice(token.text, word, length)) return false;
+                break;
+            case TOKEN_INTEGER:
+                if (!isInteger(word, length)) return false;
+                break;
+            default:
+                break;
+        }
+        if (token.kind != TOKEN_LITERAL) {
+            slotNames[slotCount] = &token.slot;
+            slotValues[slotCount] = input.substring(starts[t], ends[t]);
+            if (token.kind == TOKEN_CHOICE) slotValues[slotCount].toLowerCase();
+            slotIsInteger[slotCount++] = (token.kind == TOKEN_INTEGER);
+        }
+        t++;
+    }
+    // 整句都必须被模式覆盖
+    if (t != tokenCount) {
+        return false;
+    }
+
+    // 按模板生成工具调用：值为 "{槽位名}" 的字段替换为槽位值
+    JsonDocument doc;
+    JsonObject call = doc["tool_calls"].to<JsonArray>().add<JsonObject>();
+    call["name"] = rule.tool;
+    JsonObject args = call["args"].to<JsonObject>();
+    JsonDocument templateDoc;
+    deserializeJson(templateDoc, rule.argsTemplate);
+    for (JsonPair field : templateDoc.as<JsonObject>()) {
+        const char* value = field.value().as<const char*>();
+        bool replaced = false;
+        if (value && value[0] == '{') {
+            for (size_t s = 0; s < slotCount; s++) {
+                size_t nameLength = slotNames[s]->length();
+                if (strncmp(value + 1, slotNames[s]->c_str(), nameLength) == 0 &&
+                    value[nameLength + 1] == '}' && value[nameLength + 2] == '\0') {
+                    if (slotIsInteger[s]) {
+                        args[field.key()] = slotValues[s].toInt();
+                    } else {
+                        args[field.key()] = slotValues[s];
+                    }
+                    replaced = true;
+                    break;
+                }
+            }
+        }
+        if (!replaced) {
+            args[field.key()] = field.value();
+        }
+    }
+    toolCalls = "";
+    serializeJson(doc, toolCalls);
+    return true;
+}
+
+// 尝试匹配一条输入
+bool LLMIntentMatcher::match(const String& input, String& toolCalls) {
+    if (!enabled) {
+        return false;
+    }
+    unsigned long start = micros();
+
+    // 规范化：去掉首尾空白和句末标点；问句交给 LLM
+    String text = input;
+    text.trim();
+    while (text.length() > 0 && strchr(".!", text[text.length() - 1])) {
+        text.remove(text.length() - 1);
+    }
+    bool matched = false;
+    if (text.length() > 0 && !text.endsWith("?") && !text.endsWith("？")) {
+        // 按空白分词，记录每个词在输入中的位置
+        uint16_t starts[MAX_INPUT_TOKENS];
+        uint16_t ends[MAX_INPUT_TOKENS];
+        size_t tokenCount = 0;
+        int pos = 0;
+        int length = text.length();
+        bool tooLong = false;
+        while (pos < length) {
+            while (pos < length && isspace((unsigned char)text[pos])) pos++;
+            if (pos >= length) break;
+            if (tokenCount >= MAX_INPUT_TOKENS) {
+                tooLong = true;
+                break;
+            }
+            starts[tokenCount] = pos;
+            while (pos < length && !isspace((unsigned char)text[pos])) pos++;
+            ends[tokenCount++] = pos;
+        }
+
+        if (!tooLong && tokenCount > 0) {
+            xSemaphoreTake(lock, portMAX_DELAY);
+            for (size_t r = 0; r < ruleCount && !matched; r++) {
+                if (matchRule(rules[r], text, starts, ends, tokenCount, toolCalls)) {
+                    rules[r].hits++;
+                    matched = true;
+                }
+            }
+            xSemaphoreGive(lock);
+        }
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    attempts++;
+    if (matched) {
+        hits++;
+    }
+    matchMicros += micros() - start;
+    xSemaphoreGive(lock);
+    return matched;
+}
+
+// 以 JSON 输出匹配统计
+void LLMIntentMatcher::writeStats(JsonObject out) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    out["enabled"] = enabled;
+    out["attempts"] = attempts;
+    out["hits"] = hits;
+    out["misses"] = attempts - hits;
+    out["hit_rate"] = attempts > 0 ? (float)hits / attempts : 0.0f;
+    out["avg_match_us"] = attempts > 0 ? (uint32_t)(matchMicros / attempts) : 0;
+    JsonArray ruleStats = out["rules"].to<JsonArray>();
+    for (size_t r = 0; r < ruleCount; r++) {
+        JsonObject rule = ruleStats.add<JsonObject>();
+        rule["pattern"] = rules[r].pattern;
+        rule["tool"] = rules[r].tool;
+        rule["hits"] = rules[r].hits;
+    }
+    xSemaphoreGive(lock);
+}
@@ -1,105 +1,136 @@
 #include "llm_manager.h"
+#include "logger.h"
 #include "usb_shell_manager.h" // Include the full header for UsbShellManager
 #include "hid_manager.h" // Include HIDManager header
 #include "hardware_manager.h" // Include HardwareManager header
+#include "llm_connection_pool.h"
+#include "llm_session_table.h"
+#include "llm_request_scheduler.h"
+#include "llm_response_cache.h"
+#include "llm_provider_router.h"
+#include "llm_tools.h"
+#include "llm_tool_batch.h"
+#include "llm_intent_matcher.h"
+#include "llm_metrics.h"
+#include "llm_tls_client.h"
+#include "http_body_stream.h"
+#include "http_chunked_writer.h"
+#include "llm_prompts.h"
+#include "trace.h"
 #include <WiFi.h>
-#include <WiFiClientSecure.h>
-#include <HTTPClient.h>
-
-// 为LLM响应定义JSON文档缓冲区的大小
-const size_t JSON_DOC_SIZE = 262144; // 为可能更大的LLM响应增加了大小，并利用PSRAM
-const size_t MAX_RESPONSE_LENGTH = JSON_DOC_SIZE; // Maximum expected response length
 
 // ==================== ConversationHistory 类实现 ====================
 
+// 每条消息在请求中的结构开销（role、引号、分隔符）折合的 token 数
+const size_t MESSAGE_TOKEN_OVERHEAD = 4;
+
 // 构造函数
-ConversationHistory::ConversationHistory(size_t maxMessages) 
-    : capacity(maxMessages), count(0), startIndex(0) {
-    // 使用PSRAM分配消息数组
+ConversationHistory::ConversationHistory(size_t maxMessages, size_t arenaBytes) 
+    : capacity(maxMessages), count(0), startIndex(0), arenaSize(arenaBytes), head(0), truncatedMessages(0) {
+    // 索引数组和内容内存区都只在这里分配一次（PSRAM）
     messages = (ConversationMessage*)ps_malloc(sizeof(ConversationMessage) * capacity);
-    if (messages) {
-        // 初始化所有消息指针为nullptr
-        for (size_t i = 0; i < capacity; i++) {
-            messages[i].role = nullptr;
-            messages[i].content = nullptr;
-        }
-        Serial.printf("ConversationHistory initialized with capacity: %d\n", capacity);
+    arena = (char*)ps_malloc(arenaSize);
+    if (messages && arena) {
+        memset(messages, 0, sizeof(ConversationMessage) * capacity);
+        LOG_I("LLM", "ConversationHistory initialized with capacity: %u messages, %u byte arena",
+              (unsigned)capacity, (unsigned)arenaSize);
     } else {
-        Serial.println("Error: Failed to allocate memory for ConversationHistory!");
+        LOG_E("LLM", "Error: Failed to allocate memory for ConversationHistory!");
+        if (messages) free(messages);
+        if (arena) free(arena);
+        messages = nullptr;
+        arena = nullptr;
     }
 }
 
 // 析构函数
 ConversationHistory::~ConversationHistory() {
-    clear();
     if (messages) {
         free(messages);
         messages = nullptr;
     }
+    if (arena) {
+        free(arena);
+        arena = nullptr;
+    }
 }
 
-// 添加新消息
-void ConversationHistory::addMessage(const String& role, const String& content) {
-    if (!messages) return;
-    
-    // 计算实际存储位置（环形缓冲）
-    size_t index;
-    if (count < capacity) {
-        // 还未满，直接追加
-        index = count;
-        count++;
-    } else {
-        // 已满，覆盖最旧的消息
-        index = startIndex;
-        // 释放被覆盖消息的内存
-        if (messages[index].role) {
-            free(messages[index].role);
-            messages[index].role = nullptr;
+// 淘汰最旧的一条消息：只需移动尾部
+void ConversationHistory::evictOldest() {
+    if (count == 0) return;
+    startIndex = (startIndex + 1) % capacity;
+    count--;
+    if (count == 0) {
+        startIndex = 0;
+        head = 0;
+    }
+}
+
+// 为内容找到连续空间，必要时淘汰旧消息（size 不超过 arenaSize）
+size_t ConversationHistory::reserve(size_t size) {
+    while (true) {
+        if (count == 0) {
+            head = 0;
+            return 0;
         }
-        if (messages[index].content) {
-            free(messages[index].content);
-            messages[index].content = nullptr;
+        size_t tail = messages[startIndex].offset;
+        if (head > tail) {
+            // 已用区间为 [tail, head)：优先写在 head 之后，放不下则回绕到开头（末尾剩余空间作废）
+            if (arenaSize - head >= size) return head;
+            if (tail > size) return 0;
+        } else {
+            // 已回绕：空闲区间为 [head, tail)，保持 head 严格小于 tail
+            if (tail - head > size) return head;
         }
-        // 移动起始索引
-        startIndex = (startIndex + 1) % capacity;
+        evictOldest();
     }
-    
-    // 分配并拷贝role
-    size_t roleLen = role.length() + 1;
-    messages[index].role = (char*)ps_malloc(roleLen);
-    if (messages[index].role) {
-        strncpy(messages[index].role, role.c_str(), roleLen);
-        messages[index].role[roleLen - 1] = '\0';
+}
+
+// 添加新消息
+void ConversationHistory::addMessage(ConversationRole role, const String& content) {
+    if (!messages || !arena) return;
+
+    // 单条消息最多占用内存区的四分之一，避免一次巨大的输出冲掉全部历史
+    size_t length = content.length();
+    size_t maxLength = arenaSize / 4 - 1;
+    if (length > maxLength) {
+        length = maxLength;
+        // 不在 UTF-8 多字节字符中间截断
+        while (length > 0 && ((uint8_t)content[length] & 0xC0) == 0x80) {
+            length--;
+        }
+        truncatedMessages++;
+        LOG_I("LLM", "History message truncated from %u to %u bytes", content.length(), (unsigned)length);
     }
-    
-    // 分配并拷贝content
-    size_t contentLen = content.length() + 1;
-    messages[index].content = (char*)ps_malloc(contentLen);
-    if (messages[index].content) {
-        strncpy(messages[index].content, content.c_str(), contentLen);
-        messages[index].content[contentLen - 1] = '\0';
+
+    // 条数已满时淘汰最旧的消息
+    if (count == capacity) {
+        evictOldest();
     }
-    
-    Serial.printf("Added message to history (count: %d/%d): %s\n", count, capacity, role.c_str());
+
+    size_t offset = reserve(length + 1);
+    memcpy(arena + offset, content.c_str(), length);
+    arena[offset + length] = '\0';
+    head = offset + length + 1;
+
+    ConversationMessage& msg = messages[(startIndex + count) % capacity];
+    msg.offset = offset;
+    msg.length = length;
+    msg.role = role;
+    msg.tokens = estimateTokens(arena + offset) + MESSAGE_TOKEN_OVERHEAD;
+    count++;
+
+    LOG_D("LLM", "Added message to history (count: %u/%u, ~%u tokens, arena %u/%u bytes): %s",
+          (unsigned)count, (unsigned)capacity, (unsigned)msg.tokens, (unsigned)getArenaUsed(),
+          (unsigned)arenaSize, roleName(role));
 }
 
 // 清除所有消息
 void ConversationHistory::clear() {
-    if (!messages) return;
-    
-    for (size_t i = 0; i < capacity; i++) {
-        if (messages[i].role) {
-            free(messages[i].role);
-            messages[i].role = nullptr;
-        }
-        if (messages[i].content) {
-            free(messages[i].content);
-            messages[i].content = nullptr;
-        }
-    }
     count = 0;
     startIndex = 0;
-    Serial.println("Conversation history cleared.");
+    head = 0;
+    LOG_I("LLM", "Conversation history cleared.");
 }
 
 // 获取消息数量
@@ -107,21 +138,57 @@ size_t ConversationHistory::getMessageCount() const {
     return count;
 }
 
-// 将历史消息填充到JSON数组
-void ConversationHistory::getMessages(JsonArray& messagesArray) {
-    if (!messages || count == 0) return;
-    
-    // 按正确顺序添加消息
-    for (size_t i = 0; i < count; i++) {
-        size_t index = (startIndex + i) % capacity;
-        if (messages[index].role && messages[index].content) {
-            JsonObject msg = messagesArray.add<JsonObject>();
-            msg["role"] = messages[index].role;
-            msg["content"] = messages[index].content;
+// 获取内存区已用字节数
+size_t ConversationHistory::getArenaUsed() const {
+    if (count == 0) return 0;
+    size_t tail = messages[startIndex].offset;
+    return (head > tail) ? head - tail : arenaSize - tail + head;
+}
+
+// 按时间顺序获取消息
+const ConversationMessage* ConversationHistory::getMessage(size_t index) const {
+    if (!messages || index >= count) return nullptr;
+    return &messages[(startIndex + index) % capacity];
+}
+
+// 在 token 预算内选取最新的历史消息
+size_t ConversationHistory::getFirstIndexWithinBudget(size_t tokenBudget, size_t& usedTokens) const {
+    usedTokens = 0;
+    if (!messages || count == 0) return count;
+
+    // 从最新的消息向前累加，直到超出预算
+    size_t first = count;
+    while (first > 0) {
+        const ConversationMessage& msg = messages[(startIndex + first - 1) % capacity];
+        if (usedTokens + msg.tokens > tokenBudget) break;
+        usedTokens += msg.tokens;
+        first--;
+    }
+
+    // 不以孤立的 assistant 回复开头
+    while (first < count) {
+        const ConversationMessage& msg = messages[(startIndex + first) % capacity];
+        if (msg.role != ROLE_ASSISTANT) break;
+        usedTokens -= msg.tokens;
+        first++;
+    }
+    return first;
+}
+
+// 估算文本的 token 数
+size_t ConversationHistory::estimateTokens(const char* text) {
+    if (!text) return 0;
+
+    size_t asciiBytes = 0;
+    size_t wideChars = 0;
+    for (const uint8_t* p = (const uint8_t*)text; *p; p++) {
+        if (*p < 0x80) {
+            asciiBytes++;
+        } else if ((*p & 0xC0) != 0x80) {
+            wideChars++; // 多字节字符的首字节
         }
     }
-    
-    Serial.printf("Retrieved %d messages from history\n", count);
+    return (asciiBytes + 3) / 4 + wideChars;
 }
 
 // ==================== LLMManager 类实现 ====================
@@ -129,30 +196,134 @@ void ConversationHistory::getMessages(JsonArray& messagesArray) {
 // 用于配置网络超时的常量
 const unsigned long NETWORK_TIMEOUT = 40000;  // 40秒（网络请求总超时）
 const unsigned long STREAM_TIMEOUT = 40000;   // 流读取超时40秒（给LLM生成留足时间）
-const unsigned long DATA_TIMEOUT = 2000;      // 数据接收间隔超时2秒
 
-// 定义 API 端点
-const char* DEEPSEEK_API_HOST = "api.deepseek.com";
-const char* OPENROUTER_API_HOST = "openrouter.ai";
-const char* OPENAI_API_HOST = "api.openai.com";
+// 未在 llm_settings.token_budgets 中配置的模型使用的请求 token 预算
+const size_t DEFAULT_TOKEN_BUDGET = 8000;
+
+// 请求从提交起的默认总超时（含排队时间），超过后中止读取并丢弃
+const unsigned long DEFAULT_REQUEST_TIMEOUT = 120000;
+
+// 工作任务：默认数量，以及每个任务大致占用的 PSRAM（TLS 收发缓冲、请求/响应字符串、会话历史）
+const size_t DEFAULT_WORKER_COUNT = 2;
+const size_t WORKER_PSRAM_BYTES = 96 * 1024;
+// 创建工作任务后 PSRAM 和内部 RAM 至少要保留的余量
+const size_t WORKER_PSRAM_RESERVE = 512 * 1024;
+const size_t WORKER_INTERNAL_RESERVE = 48 * 1024;
+// 每个工作任务的转交队列深度（同一会话排队的后续请求）
+const size_t WORKER_BACKLOG_DEPTH = 4;
+
+// 高级模式系统提示中由工具注册表生成的工具说明所在位置
+const char* const TOOLS_PROMPT_MARKER = "{{TOOLS}}";
+
+// 一次回复中最多处理的原生工具调用数
+const size_t MAX_NATIVE_TOOL_CALLS = 8;
+
+// 流式增量合并参数：攒够一定字节数或间隔一定时间再转发，避免每个token都产生一条CDC/WS消息
+const size_t STREAM_DELTA_FLUSH_BYTES = 48;
+const unsigned long STREAM_DELTA_FLUSH_MS = 50;
+
+// 对冲请求需要第二条 TLS 连接，发出前内部 RAM 至少要保留的余量
+const size_t HEDGE_INTERNAL_RESERVE = 48 * 1024;
+// 等待首字节时轮询各连接的间隔
+const unsigned long FIRST_BYTE_POLL_MS = 10;
 
 // 构造函数
 LLMManager::LLMManager(ConfigManager& config, AppWiFiManager& wifi, UsbShellManager* usbShellManager,
                        HIDManager* hidManager, HardwareManager* hardwareManager)
     : configManager(config), wifiManager(wifi), _usbShellManager(usbShellManager),
-      _hidManager(hidManager), _hardwareManager(hardwareManager), currentMode(CHAT_MODE) {
-    // 创建 LLM 请求队列，用于接收来自其他模块的请求（优化：减少队列深度为3）
-    llmRequestQueue = xQueueCreate(3, sizeof(LLMRequest));
+      _hidManager(hidManager), _hardwareManager(hardwareManager), currentMode(CHAT_MODE),
+      streamingEnabled(true) {
+    // 请求调度器：交互、代理后续、后台三个类别各排队 8 个请求，每排队 5 秒提升一级
+    scheduler = new LLMRequestScheduler(8, 5000);
     // 创建 LLM 响应队列，用于发送处理完的响应给请求者（优化：减少队列深度为3）
     llmResponseQueue = xQueueCreate(3, sizeof(LLMResponse));
+    // 创建流式增量队列，WebManager 从中取出并广播 chat_delta
+    llmDeltaQueue = xQueueCreate(16, sizeof(LLMStreamDelta));
 
     // 检查队列是否成功创建
-    if (llmRequestQueue == NULL || llmResponseQueue == NULL) {
-        Serial.println("Error creating LLM queues!");
+    if (llmResponseQueue == NULL || llmDeltaQueue == NULL) {
+        LOG_E("LLM", "Error creating LLM queues!");
     }
     
-    // 初始化对话历史（容量40，支持约20轮对话）
-    conversationHistory = new ConversationHistory(40);
+    // 每个会话一份对话历史（容量60，支持约30轮对话；内容存放在 64KB 的 PSRAM 环形内存区中）
+    sessionTable = new LLMSessionTable(4, 65536, 60);
+
+    tokenBudget = DEFAULT_TOKEN_BUDGET;
+    nativeTools = true;
+    // 工具注册表：生成高级模式的工具说明和 tools 字段，并估算系统提示的 token 数和哈希
+    toolRegistry = new LLMToolRegistry();
+    registerBuiltinTools(*toolRegistry);
+    buildToolPrompts();
+    // 本地意图匹配规则在 begin() 中按配置加载
+    intentMatcher = new LLMIntentMatcher();
+    // 分阶段耗时统计
+    metrics = new LLMMetrics();
+    // 导出到 /metrics 的计数和分布（在构造时注册一次，begin() 会随配置更新重复调用）
+    static const uint32_t DURATION_BOUNDS_MS[] = {50, 100, 250, 500, 1000, 2500, 5000, 10000, 30000};
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    providerRequests = registry.counter("noox_llm_requests_total", "LLM requests completed", "source=\"provider\"");
+    intentRequests = registry.counter("noox_llm_requests_total", "LLM requests completed", "source=\"intent\"");
+    cacheRequests = registry.counter("noox_llm_requests_total", "LLM requests completed", "source=\"cache\"");
+    failedRequests = registry.counter("noox_llm_request_errors_total", "LLM requests answered with an error");
+    cancelledCount = registry.counter("noox_llm_requests_dropped_total", "LLM requests dropped before completion",
+                                      "reason=\"cancelled\"");
+    expiredCount = registry.counter("noox_llm_requests_dropped_total", "LLM requests dropped before completion",
+                                    "reason=\"expired\"");
+    toolCallsExecuted = registry.counter("noox_llm_tool_calls_total", "Tool calls executed");
+    toolFailures = registry.counter("noox_llm_tool_failures_total", "Tool calls failed or rejected");
+    toolParseFailures = registry.counter("noox_llm_tool_parse_failures_total", "Malformed tool call replies");
+    requestDuration = registry.histogram("noox_llm_request_duration_ms", "LLM request time from submit to reply",
+                                         DURATION_BOUNDS_MS, sizeof(DURATION_BOUNDS_MS) / sizeof(DURATION_BOUNDS_MS[0]));
+    firstByteLatency = registry.histogram("noox_llm_first_byte_ms", "Provider time to first response byte",
+                                          DURATION_BOUNDS_MS, sizeof(DURATION_BOUNDS_MS) / sizeof(DURATION_BOUNDS_MS[0]));
+    busyWorkers = registry.gauge("noox_llm_workers_busy", "LLM workers processing a request");
+    poolHits = registry.counter("noox_llm_pool_acquires_total", "Provider connections taken from the pool",
+                                "result=\"hit\"");
+    poolMisses = registry.counter("noox_llm_pool_acquires_total", "Provider connections taken from the pool",
+                                  "result=\"miss\"");
+    poolRedials = registry.counter("noox_llm_pool_redials_total", "Reused connections found dead and redialed");
+    // 响应缓存默认关闭，在 begin() 中按配置启用
+    responseCache = new LLMResponseCache();
+    // 提供商路由器在 begin() 中按配置加载主/备路由
+    router = new LLMProviderRouter();
+
+    // TLS 会话缓存由所有工作任务共享；工作任务及其连接池在 begin() 中按配置创建
+    tlsSessionCache = new LLMTlsSessionCache();
+    memset(workers, 0, sizeof(workers));
+    workerCount = 0;
+    dispatchLock = xSemaphoreCreateMutex();
+
+    memset(cancelMarks, 0, sizeof(cancelMarks));
+    lastSeq = 0;
+    requestTimeoutMs = DEFAULT_REQUEST_TIMEOUT;
+}
+
+// 按配置创建工作任务上下文
+void LLMManager::createWorkers(size_t wanted) {
+    if (wanted == 0) wanted = 1;
+    if (wanted > MAX_WORKERS) wanted = MAX_WORKERS;
+
+    while (workerCount < wanted) {
+        // 第一个工作任务总是创建；之后的任务只在内存余量充足时创建
+        if (workerCount > 0 &&
+            (heap_caps_get_free_size(MALLOC_CAP_SPIRAM) < WORKER_PSRAM_BYTES + WORKER_PSRAM_RESERVE ||
+             heap_caps_get_free_size(MALLOC_CAP_INTERNAL) < WORKER_STACK_SIZE + WORKER_INTERNAL_RESERVE)) {
+            LOG_I("LLM", "Not enough memory for more workers, using %u of %u", workerCount, (unsigned)wanted);
+            break;
+        }
+
+        LLMWorkerContext& worker = workers[workerCount];
+        worker.index = workerCount;
+        worker.backlog = xQueueCreate(WORKER_BACKLOG_DEPTH, sizeof(LLMRequest));
+        if (worker.backlog == NULL) {
+            LOG_E("LLM", "Error creating worker backlog queue!");
+            break;
+        }
+        // 每个工作任务对每个提供商主机保持一条 TLS 长连接；断开后通过共享的会话缓存简化握手
+        LLMConnectionPoolMetrics poolMetrics = {poolHits, poolMisses, poolRedials};
+        worker.connectionPool = new LLMConnectionPool(tlsSessionCache, poolMetrics, 3);
+        workerCount++;
+    }
 }
 
 // ==================== 辅助函数实现 ====================
@@ -176,29 +347,58 @@ void LLMManager::allocateResponseString(char*& dest, const String& src) {
 }
 
 // 创建并发送LLM请求到队列的通用方法
-bool LLMManager::createAndSendRequest(const String& requestId, const String& prompt, LLMMode mode) {
+bool LLMManager::createAndSendRequest(const String& requestId, const String& sessionKey, const String& prompt, LLMMode mode,
+                                      uint32_t clientId, LLMPriority priority, int16_t userTextOffset) {
     LLMRequest request;
     memset(&request, 0, sizeof(LLMRequest));
     
-    // 安全拷贝requestId到固定大小数组
+    // 安全拷贝requestId和会话键到固定大小数组
     strncpy(request.requestId, requestId.c_str(), sizeof(request.requestId) - 1);
     request.requestId[sizeof(request.requestId) - 1] = '\0';
+    strncpy(request.sessionKey, sessionKey.c_str(), sizeof(request.sessionKey) - 1);
+    request.sessionKey[sizeof(request.sessionKey) - 1] = '\0';
+    request.clientId = clientId;
+    request.deadline = millis() + requestTimeoutMs;
+    xSemaphoreTake(dispatchLock, portMAX_DELAY);
+    request.seq = ++lastSeq;
+    bool reserved = reserveCancelMark(request);
+    xSemaphoreGive(dispatchLock);
+    if (!reserved) {
+        LOG_E("LLM", "createAndSendRequest: Too many sessions with pending requests (max %u).", MAX_CANCEL_MARKS);
+        if (clientId == 0) {
+            _usbShellManager->sendAiResponseToHost(requestId, "Error: Failed to send request to LLM task.");
+        }
+        return false;
+    }
     
     // 使用PSRAM分配prompt内存
     request.prompt = allocateAndCopy(prompt);
     if (!request.prompt) {
-        Serial.println("createAndSendRequest: Failed to allocate memory for prompt.");
-        _usbShellManager->sendAiResponseToHost(requestId, "Error: Memory allocation failed.");
+        LOG_E("LLM", "createAndSendRequest: Failed to allocate memory for prompt.");
+        xSemaphoreTake(dispatchLock, portMAX_DELAY);
+        releaseCancelMark(request);
+        xSemaphoreGive(dispatchLock);
+        if (clientId == 0) {
+            _usbShellManager->sendAiResponseToHost(requestId, "Error: Memory allocation failed.");
+        }
         return false;
     }
     
     request.mode = mode;
+    request.userTextOffset = userTextOffset;
+    TRACE_ASYNC_BEGIN("llm.request", request.seq);
     
-    // 发送请求到队列
-    if (xQueueSend(llmRequestQueue, &request, portMAX_DELAY) != pdPASS) {
-        Serial.println("createAndSendRequest: Failed to send request to queue.");
+    // 提交到调度器（Web 请求来自 WebSocket 回调，不能阻塞；队列满时由调用方回复错误）
+    if (!scheduler->submit(request, priority, clientId ? 0 : portMAX_DELAY)) {
+        LOG_E("LLM", "createAndSendRequest: Failed to send request to queue.");
+        TRACE_ASYNC_END("llm.request", request.seq);
         free(request.prompt);
-        _usbShellManager->sendAiResponseToHost(requestId, "Error: Failed to send request to LLM task.");
+        xSemaphoreTake(dispatchLock, portMAX_DELAY);
+        releaseCancelMark(request);
+        xSemaphoreGive(dispatchLock);
+        if (clientId == 0) {
+            _usbShellManager->sendAiResponseToHost(requestId, "Error: Failed to send request to LLM task.");
+        }
         return false;
     }
     
@@ -215,22 +415,80 @@ void LLMManager::begin() {
     currentModel = config["last_used"]["model"].as<String>();
     // 从配置中获取当前提供商的 API 密钥
     currentApiKey = config["llm_providers"][currentProvider]["api_key"].as<String>();
+    // 是否启用流式响应（缺省开启）
+    streamingEnabled = config["llm_settings"]["stream"] | true;
+    // 高级模式是否使用原生工具调用（关闭时工具以文字写在系统提示中）
+    nativeTools = config["llm_settings"]["native_tools"] | true;
+    // 当前模型的请求 token 预算（系统提示 + 历史 + 当前输入）
+    size_t defaultBudget = config["llm_settings"]["default_token_budget"] | DEFAULT_TOKEN_BUDGET;
+    tokenBudget = config["llm_settings"]["token_budgets"][currentModel] | defaultBudget;
+    // 会话数上限和每个会话的历史内存区大小
+    sessionTable->configure(config["llm_settings"]["max_sessions"] | 4,
+                            config["llm_settings"]["session_history_bytes"] | 65536);
+    // 请求从提交起的总超时，超过后中止读取，不再占用工作任务
+    requestTimeoutMs = config["llm_settings"]["request_timeout_ms"] | DEFAULT_REQUEST_TIMEOUT;
+    // 响应缓存（缺省关闭）
+    JsonObject cacheConfig = config["llm_settings"]["cache"];
+    responseCache->configure(cacheConfig["enabled"] | false,
+                             cacheConfig["ttl_s"] | 3600UL,
+                             cacheConfig["max_entries"] | 32,
+                             cacheConfig["max_bytes"] | 262144,
+                             cacheConfig["persist"] | false,
+                             cacheConfig["persist_slots"] | 32);
+    // 主路由（last_used）和备用路由、对冲与熔断参数
+    router->configure(config);
+    // 本地意图匹配（缺省开启，没有配置规则时使用内置规则）
+    intentMatcher->configure(config["llm_settings"]["intents"], *toolRegistry);
+    // 打开 TLS 会话缓存的 NVS 命名空间（重复调用无副作用）
+    tlsSessionCache->begin();
+    // 工作任务只在首次初始化时创建，修改数量需重启
+    if (workerCount == 0) {
+        createWorkers(config["llm_settings"]["workers"] | DEFAULT_WORKER_COUNT);
+    }
 
     // 打印 LLMManager 初始化信息
-    Serial.printf("LLMManager initialized. Provider: %s, Model: %s\n", currentProvider.c_str(), currentModel.c_str());
+    LOG_I("LLM", "LLMManager initialized. Provider: %s, Model: %s, Streaming: %s, Token budget: %u, Workers: %u",
+          currentProvider.c_str(), currentModel.c_str(), streamingEnabled ? "on" : "off", (unsigned)tokenBudget, workerCount);
 }
 
 
 // 根据当前提供商生成响应（此函数由后台任务调用）
-String LLMManager::generateResponse(const String& requestId, const String& prompt, LLMMode mode) {
+String LLMManager::generateResponse(LLMWorkerContext& worker, const String& requestId, const String& prompt, LLMMode mode,
+                                   const char* userText) {
+    TRACE_SCOPE("llm.generate");
+    // 本地意图快速路径：高级模式下用户原文是简单设备命令时直接生成工具调用，由 handleLLMRawResponse() 执行。
+    // 只匹配用户原文，不含 "User input: " 等前缀；Shell 结果的后续请求不参与匹配
+    if (mode == ADVANCED_MODE && userText) {
+        String toolCalls;
+        if (intentMatcher->match(userText, toolCalls)) {
+            LOG_D("INTENT", "Request %s handled locally: %s", requestId.c_str(), toolCalls.c_str());
+            worker.timing.setRoute("local", "intent");
+            return toolCalls;
+        }
+    }
+
+    // 先查响应缓存：同样的上下文直接返回上次的回复，不需要网络
+    uint64_t cacheKey = 0;
+    if (responseCache->isEnabled()) {
+        unsigned long lookupStart = millis();
+        cacheKey = computeCacheKey(worker, prompt, mode);
+        String cached;
+        if (responseCache->get(cacheKey, cached)) {
+            LOG_I("CACHE", "Hit for request %s (%u bytes, %lu ms)", requestId.c_str(), cached.length(), millis() - lookupStart);
+            worker.timing.setRoute("cache", currentModel.c_str());
+            return cached;
+        }
+    }
+
     // 检查WiFi是否连接
     if (wifiManager.getWiFiStatus() != "Connected") {
         return "Error: WiFi is not connected.";
     }
 
     // 打印 LLM 调用前最大的空闲堆内存块大小，用于调试内存使用情况
-    Serial.printf("Largest Free Heap Block before LLM call: %u bytes\n", heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
-    Serial.printf("Free DRAM before LLM call: %u, Free PSRAM before LLM call: %u\n", heap_caps_get_free_size(MALLOC_CAP_8BIT), heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+    LOG_D("LLM", "Largest Free Heap Block before LLM call: %u bytes", (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    LOG_D("LLM", "Free DRAM before LLM call: %u, Free PSRAM before LLM call: %u",
+          (unsigned)heap_caps_get_free_size(MALLOC_CAP_8BIT), (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
     
     // 检查 API 密钥是否已设置
     if (currentApiKey.length() == 0) {
@@ -240,37 +498,124 @@ String LLMManager::generateResponse(const String& requestId, const String& promp
     String response;
     // 根据当前提供商，调用相应的处理函数
     if (currentProvider == "deepseek" || currentProvider == "openrouter" || currentProvider == "openai") {
-        response = getOpenAILikeResponse(requestId, prompt, mode);
+        response = getOpenAILikeResponse(worker, requestId, prompt, mode);
     } else {
         response = "Error: Invalid LLM provider selected.";
     }
 
+    // 只缓存完整的成功回复；含工具调用的回复不缓存，否则命中时会再次执行工具（如重复按键、重复切换 GPIO）
+    if (cacheKey && !worker.cancelled && !response.startsWith("Error:") && response.indexOf("\"tool_calls\"") < 0) {
+        responseCache->put(cacheKey, response);
+    }
+
     // 打印 LLM 调用后最大的空闲堆内存块大小
-    Serial.printf("Largest Free Heap Block after LLM call: %u bytes\n", heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
-    Serial.printf("Free DRAM after LLM call: %u, Free PSRAM after LLM call: %u\n", heap_caps_get_free_size(MALLOC_CAP_8BIT), heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+    LOG_D("LLM", "Largest Free Heap Block after LLM call: %u bytes", (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    LOG_D("LLM", "Free DRAM after LLM call: %u, Free PSRAM after LLM call: %u",
+          (unsigned)heap_caps_get_free_size(MALLOC_CAP_8BIT), (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
     return response;
 }
 
 // 处理来自主机的用户输入
-void LLMManager::processUserInput(const String& requestId, const String& userInput) {
-    String prompt = "User input: " + userInput;
-    createAndSendRequest(requestId, prompt, ADVANCED_MODE); // Shell通信使用高级模式
+void LLMManager::processUserInput(const String& requestId, const String& sessionKey, const String& userInput,
+                                  LLMPriority priority) {
+    static const char PREFIX[] = "User input: ";
+    String prompt = PREFIX + userInput;
+    // 新一轮输入取代该会话中尚未完成的请求
+    cancelSession(sessionKey);
+    // Shell通信使用高级模式；本地意图只匹配前缀之后的用户原文
+    createAndSendRequest(requestId, sessionKey, prompt, ADVANCED_MODE, 0, priority, sizeof(PREFIX) - 1);
 }
 
 String LLMManager::getCurrentModelName() {
     return currentModel;
 }
 
-// 清除对话历史
-void LLMManager::clearConversationHistory() {
-    if (conversationHistory) {
-        conversationHistory->clear();
-        Serial.println("LLMManager: Conversation history cleared.");
+// 清除某个会话的对话历史
+void LLMManager::clearConversationHistory(const String& sessionKey) {
+    cancelSession(sessionKey);
+    sessionTable->clear(sessionKey.c_str());
+    LOG_I("LLM", "LLMManager: Conversation history cleared for session %s.", sessionKey.c_str());
+}
+
+// 删除会话及其对话历史
+void LLMManager::removeSession(const String& sessionKey) {
+    cancelSession(sessionKey);
+    sessionTable->remove(sessionKey.c_str());
+}
+
+// 取消会话中所有已提交的请求
+void LLMManager::cancelSession(const String& sessionKey) {
+    if (sessionKey.length() == 0) return;
+
+    xSemaphoreTake(dispatchLock, portMAX_DELAY);
+    // 记录取消点：序号不大于它的请求（仍在队列中或已转交给某个工作任务）出队时丢弃。
+    // 没有记录说明该会话没有未出队的请求，之后提交的请求序号更大，无需记录
+    for (uint8_t i = 0; i < MAX_CANCEL_MARKS; i++) {
+        if (cancelMarks[i].pending > 0 && strcmp(cancelMarks[i].sessionKey, sessionKey.c_str()) == 0) {
+            cancelMarks[i].seq = lastSeq;
+            break;
+        }
+    }
+
+    // 正在执行的请求：置位取消标志，读取循环会立即退出并关闭连接
+    for (uint8_t i = 0; i < workerCount; i++) {
+        if (workers[i].seq != 0 && strcmp(workers[i].sessionKey, sessionKey.c_str()) == 0) {
+            workers[i].cancelled = true;
+            LOG_I("LLM", "Cancelling in-flight request on worker %u (session %s)", i, sessionKey.c_str());
+        }
+    }
+    xSemaphoreGive(dispatchLock);
+}
+
+// 请求是否已被所属会话的取消点覆盖（调用方需持有 dispatchLock）
+bool LLMManager::isCancelled(const LLMRequest& request) {
+    for (uint8_t i = 0; i < MAX_CANCEL_MARKS; i++) {
+        if (cancelMarks[i].pending > 0 && strcmp(cancelMarks[i].sessionKey, request.sessionKey) == 0) {
+            return request.seq <= cancelMarks[i].seq;
+        }
+    }
+    return false;
+}
+
+// 为即将提交的请求占用会话的取消点记录（调用方需持有 dispatchLock）
+bool LLMManager::reserveCancelMark(const LLMRequest& request) {
+    if (request.sessionKey[0] == '\0') return true; // 没有会话键的请求不能按会话取消
+
+    LLMCancelMark* freeMark = nullptr;
+    for (uint8_t i = 0; i < MAX_CANCEL_MARKS; i++) {
+        LLMCancelMark& mark = cancelMarks[i];
+        if (mark.pending == 0) {
+            if (!freeMark) freeMark = &mark;
+        } else if (strcmp(mark.sessionKey, request.sessionKey) == 0) {
+            if (mark.pending == UINT8_MAX) return false;
+            mark.pending++;
+            return true;
+        }
+    }
+    if (!freeMark) return false;
+
+    strncpy(freeMark->sessionKey, request.sessionKey, sizeof(freeMark->sessionKey) - 1);
+    freeMark->sessionKey[sizeof(freeMark->sessionKey) - 1] = '\0';
+    freeMark->seq = 0;
+    freeMark->pending = 1;
+    return true;
+}
+
+// 请求已出队，释放它占用的取消点记录（调用方需持有 dispatchLock）
+void LLMManager::releaseCancelMark(const LLMRequest& request) {
+    if (request.sessionKey[0] == '\0') return;
+
+    for (uint8_t i = 0; i < MAX_CANCEL_MARKS; i++) {
+        LLMCancelMark& mark = cancelMarks[i];
+        if (mark.pending > 0 && strcmp(mark.sessionKey, request.sessionKey) == 0) {
+            mark.pending--;
+            return;
+        }
     }
 }
 
 // 处理来自主机的shell命令执行结果
-void LLMManager::processShellOutput(const String& requestId, const String& cmd, const String& output, const String& error, const String& status, int exitCode) {
+void LLMManager::processShellOutput(const String& requestId, const String& sessionKey, const String& cmd, const String& output, const String& error, const String& status, int exitCode) {
     // 将上一个命令及其输出作为上下文，构建新的提示
     String prompt = "Previous shell command: " + cmd + "\n" +
                     "STDOUT: " + output + "\n" +
@@ -279,476 +624,799 @@ void LLMManager::processShellOutput(const String& requestId, const String& cmd,
                     "Exit Code: " + String(exitCode) + "\n" +
                     "Based on the above shell output, what should be the next action or response?";
     
-    createAndSendRequest(requestId, prompt, ADVANCED_MODE);
+    // 代理自动发起的后续请求，优先级低于用户正在等待的输入
+    createAndSendRequest(requestId, sessionKey, prompt, ADVANCED_MODE, 0, PRIORITY_FOLLOW_UP, NO_USER_TEXT);
+}
+
+// 以 JSON 输出调度器统计
+void LLMManager::writeSchedulerStats(JsonObject out) {
+    scheduler->writeStats(out);
+}
+
+// 输出响应缓存统计
+void LLMManager::writeCacheStats(JsonObject out) {
+    responseCache->writeStats(out);
+}
+
+// 清空响应缓存
+void LLMManager::clearResponseCache() {
+    responseCache->clear();
+}
+
+// 输出提供商路由状态
+void LLMManager::writeRoutingStats(JsonObject out) {
+    router->writeStats(out);
+}
+
+// 输出本地意图匹配统计
+void LLMManager::writeIntentStats(JsonObject out) {
+    intentMatcher->writeStats(out);
+}
+
+// 输出 LLM 请求指标
+void LLMManager::writeMetrics(JsonObject out) {
+    out["cancelled"] = cancelledCount->get();
+    out["expired"] = expiredCount->get();
+    out["tool_parse_failures"] = toolParseFailures->get();
+    metrics->writeStats(out);
 }
 
 
 // 获取类 OpenAI 格式的响应 (适用于 DeepSeek, OpenRouter, OpenAI)
-String LLMManager::getOpenAILikeResponse(const String& requestId, const String& prompt, LLMMode mode) {
-    HTTPClient http;
-    WiFiClientSecure client;
-    client.setInsecure(); // 跳过SSL证书验证
-
-    const char* apiHost = "";
-    String apiPath;
-
-    if (currentProvider == "openrouter") {
-        apiHost = OPENROUTER_API_HOST;
-        apiPath = "/api/v1/chat/completions";
-    } else if (currentProvider == "deepseek") {
-        apiHost = DEEPSEEK_API_HOST;
-        apiPath = "/chat/completions";
-    } else if (currentProvider == "openai") {
-        apiHost = OPENAI_API_HOST;
-        apiPath = "/v1/chat/completions";
-    } else {
+String LLMManager::getOpenAILikeResponse(LLMWorkerContext& worker, const String& requestId, const String& prompt, LLMMode mode) {
+    LLMRoute primary;
+    if (!router->getRoute(ROUTE_PRIMARY, primary)) {
         return "Error: Invalid OpenAI-like provider selected.";
     }
+    LLMRoute secondary;
+    bool hasSecondary = router->getRoute(ROUTE_SECONDARY, secondary);
 
-    String apiUrl = "https://" + String(apiHost) + apiPath;
-    http.begin(client, apiUrl); // 使用安全客户端
-    http.setTimeout(NETWORK_TIMEOUT);     // 设置网络请求总超时
-    client.setTimeout(STREAM_TIMEOUT / 1000);   // 设置底层 TCP 超时（秒）
-    
-    // 启用更详细的HTTP调试输出
-    http.setReuse(false);       // 禁用连接重用
-    http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
-    
-    http.addHeader("Content-Type", "application/json");
-    // 添加额外的请求头以提高兼容性
-    http.addHeader("Accept", "application/json");
-    http.addHeader("Connection", "close");
-    http.addHeader("Authorization", "Bearer " + currentApiKey);
-    if (currentProvider == "openrouter") {
-        http.addHeader("HTTP-Referer", "http://localhost");
-    }
-
-    JsonDocument doc;
-    doc["model"] = currentModel;
+    // 请求被取消或超过截止时间时，等待响应的读取立即返回
+    HttpAbortSignal abortSignal = {&worker.cancelled, worker.deadline};
 
-    // 构建消息数组
-    JsonArray messages = doc["messages"].to<JsonArray>();
-    
-    // 1. 添加系统提示
-    String systemPrompt = generateSystemPrompt(mode);
-    if (systemPrompt.length() > 0) {
-        JsonObject sysMsg = messages.add<JsonObject>();
-        sysMsg["role"] = "system";
-        sysMsg["content"] = systemPrompt;
+    // 主路由被熔断时直接转给备用路由
+    const LLMRoute* route = &primary;
+    if (!router->allow(primary)) {
+        if (!hasSecondary || !router->allow(secondary)) {
+            return "Error: Provider temporarily unavailable";
+        }
+        LOG_I("ROUTE", "%s circuit open, failing over to %s", primary.provider, secondary.provider);
+        router->recordFailover();
+        route = &secondary;
+        hasSecondary = false;
     }
-    
-    // 2. 添加对话历史
-    if (conversationHistory) {
-        conversationHistory->getMessages(messages);
+
+    bool retryable = false;
+    String content = requestWithHedge(worker, *route, hasSecondary ? &secondary : nullptr, requestId, prompt, mode,
+                                      abortSignal, retryable);
+    // 主路由还没有输出任何内容就失败了（且没有发出过对冲请求）：转给备用路由重试一次
+    if (retryable && hasSecondary && !abortSignal.triggered() && router->allow(secondary)) {
+        LOG_W("ROUTE", "%s failed, failing over to %s", route->provider, secondary.provider);
+        router->recordFailover();
+        content = requestWithHedge(worker, secondary, nullptr, requestId, prompt, mode, abortSignal, retryable);
     }
-    
-    // 3. 添加当前用户输入
-    JsonObject currentMsg = messages.add<JsonObject>();
-    currentMsg["role"] = "user";
-    currentMsg["content"] = prompt;
+    return content;
+}
 
-    String requestBody;
-    serializeJson(doc, requestBody);
+// 向一个路由发出请求，必要时向备用路由发出对冲请求
+String LLMManager::requestWithHedge(LLMWorkerContext& worker, const LLMRoute& route, const LLMRoute* hedgeRoute,
+                                    const String& requestId, const String& prompt, LLMMode mode,
+                                    HttpAbortSignal& abortSignal, bool& retryable) {
+    retryable = false;
+    const LLMRoute* inFlight[2] = {&route, hedgeRoute};
+    LLMTlsClient* clients[2] = {nullptr, nullptr};
+    bool reused[2] = {false, false};
+    unsigned long sentAt[2] = {0, 0};
+    LLMDialTiming dial[2];
+    memset(dial, 0, sizeof(dial));
 
-    int httpCode = http.POST(requestBody);
-    Serial.printf("POST request completed with code: %d\n", httpCode);
+    // 先按主请求记录；对冲请求胜出时改为备用路由
+    worker.timing.setRoute(route.provider, route.model.c_str());
+    bool sent = sendToRoute(worker, route, clients[0], reused[0], prompt, mode, dial[0]);
+    worker.timing.applyDial(dial[0]);
+    if (!sent) {
+        if (abortSignal.triggered()) {
+            return worker.cancelled ? "Error: Request cancelled" : "Error: Request timed out";
+        }
+        router->recordFailure(route);
+        retryable = true;
+        return "Error: Connection failed";
+    }
+    sentAt[0] = millis();
 
-    if (httpCode > 0) {
-        if (httpCode == HTTP_CODE_OK) {
-            Serial.println("[LLM] Starting to read response...");
-            
-            // 获取内容长度（如果有的话）
-            int contentLength = http.getSize();
-            Serial.printf("[LLM] Content-Length: %d\n", contentLength);
-            
-            // 使用HTTPClient的getString方法，它能更好地处理chunked编码
-            WiFiClient* stream = http.getStreamPtr();
-            
-            // 分配PSRAM缓冲区
-            char* buffer = (char*)ps_malloc(MAX_RESPONSE_LENGTH);
-            if (!buffer) {
-                http.end();
-                return "Error: Failed to allocate memory for response buffer";
+    // 同一提供商共用连接池中的一条连接，不能同时发出两个请求
+    bool canHedge = hedgeRoute && router->isHedgingEnabled() && hedgeRoute->providerIndex != route.providerIndex;
+    unsigned long hedgeDelay = canHedge ? router->getHedgeDelay(route) : 0;
+    bool hedged = false;
+    bool hedgeSent = false; ///< 备用路由已收到过请求（失败时不再转给它重试）
+
+    // 轮询等待任一连接收到首字节，读取响应头：状态 200 的一方胜出。
+    // 另一方仍在等待时，非 200 的响应或读取响应头时断开的连接只记为该路由失败，继续等待另一方
+    int winner = -1;
+    HttpResponseHead heads[2];
+    unsigned long firstByteMs[2] = {0, 0};
+    while (!abortSignal.triggered()) {
+        unsigned long now = millis();
+        for (int i = 0; i < 2 && winner < 0; i++) {
+            if (!clients[i]) continue;
+            if (clients[i]->available() > 0) {
+                firstByteMs[i] = millis() - sentAt[i];
+                bool otherPending = clients[1 - i] != nullptr;
+                if (!HttpBodyStream::readHead(*clients[i], heads[i], NETWORK_TIMEOUT, &abortSignal)) {
+                    if (abortSignal.triggered()) break;
+                    LOG_W("LLM", "Connection to %s dropped before response headers", inFlight[i]->host);
+                    worker.connectionPool->invalidate(clients[i]);
+                    worker.connectionPool->release(clients[i]);
+                    clients[i] = nullptr;
+                    router->recordFailure(*inFlight[i]);
+                    continue;
+                }
+                if (heads[i].statusCode == 200 || !otherPending) {
+                    winner = i;
+                    break;
+                }
+                // 读完错误响应（计入该路由的失败并释放连接），等待另一方
+                LOG_I("ROUTE", "%s answered %d, waiting for %s", inFlight[i]->provider, heads[i].statusCode,
+                      inFlight[1 - i]->provider);
+                bool ignored = false;
+                readRouteResponse(worker, *inFlight[i], clients[i], reused[i], heads[i], requestId, mode,
+                                  sentAt[i], firstByteMs[i], abortSignal, ignored);
+                clients[i] = nullptr;
+                continue;
             }
-            memset(buffer, 0, MAX_RESPONSE_LENGTH);
-            
-            size_t totalBytesRead = 0;
-            unsigned long startTime = millis();
-            unsigned long lastDataTime = millis();
-            bool receivedData = false;
-            
-            // 改进的读取循环：更好地处理chunked编码
-            while ((millis() - startTime < STREAM_TIMEOUT) && 
-                   totalBytesRead < MAX_RESPONSE_LENGTH - 1) {
-                
-                // 等待数据可用或连接关闭
-                size_t available = stream->available();
-                
-                if (available) {
-                    // 有数据可读
-                    receivedData = true;
-                    size_t bytesToRead = min(available, MAX_RESPONSE_LENGTH - 1 - totalBytesRead);
-                    size_t bytesRead = stream->readBytes(buffer + totalBytesRead, bytesToRead);
-                    totalBytesRead += bytesRead;
-                    lastDataTime = millis();
-                    
-                } else {
-                    // 没有数据可用
-                    if (!http.connected()) {
-                        // 连接已关闭，数据接收完毕
-                        Serial.println("[LLM] Connection closed by server");
-                        break;
-                    }
-                    
-                    // 如果已经接收过数据，且超过DATA_TIMEOUT没有新数据，认为传输完成
-                    if (receivedData && (millis() - lastDataTime > DATA_TIMEOUT)) {
-                        Serial.println("[LLM] No more data, assuming transfer complete");
-                        break;
-                    }
-                    
-                    // 等待更多数据
-                    delay(10);
+            bool timedOut = now - sentAt[i] >= NETWORK_TIMEOUT;
+            if (clients[i]->connected() && !timedOut) continue;
+
+            // 复用的连接可能已被服务器半关闭，重新拨号并重发一次
+            if (!timedOut && reused[i]) {
+                LOG_W("LLM", "Reused connection failed, redialing %s", inFlight[i]->host);
+                worker.connectionPool->invalidate(clients[i]);
+                reused[i] = false;
+                if (sendToRoute(worker, *inFlight[i], clients[i], reused[i], prompt, mode, dial[i])) {
+                    sentAt[i] = millis();
+                    continue;
                 }
+            } else {
+                LOG_I("LLM", "No response from %s before %s", inFlight[i]->host, timedOut ? "timeout" : "disconnect");
+                worker.connectionPool->invalidate(clients[i]);
+                worker.connectionPool->release(clients[i]);
+                clients[i] = nullptr;
             }
-            
-            buffer[totalBytesRead] = '\0';
-            Serial.printf("[LLM] Total received: %d bytes\n", totalBytesRead);
-            
-            http.end();
-            
-            // 检查是否接收到数据
-            if (totalBytesRead == 0) {
-                free(buffer);
-                Serial.println("[LLM] Error: Received 0 bytes");
-                return "Error: No data received from server";
+            if (!abortSignal.triggered()) {
+                router->recordFailure(*inFlight[i]);
             }
-            
-            // 输出前100个字符用于调试
-            Serial.print("[LLM] Response preview: ");
-            for (int i = 0; i < min((int)totalBytesRead, 100); i++) {
-                if (buffer[i] >= 32 && buffer[i] < 127) {
-                    Serial.print((char)buffer[i]);
-                } else {
-                    Serial.print('.');
+        }
+        if (winner >= 0 || (!clients[0] && !clients[1]) || abortSignal.triggered()) break;
+
+        // 主请求在对冲延迟内没有收到首字节：向备用路由发出对冲请求，先返回者胜出
+        if (canHedge && !hedged && clients[0] && now - sentAt[0] >= hedgeDelay) {
+            hedged = true;
+            if (heap_caps_get_free_size(MALLOC_CAP_INTERNAL) < HEDGE_INTERNAL_RESERVE) {
+                LOG_I("ROUTE", "Not enough memory for a hedged request");
+            } else if (router->allow(*hedgeRoute)) {
+                LOG_I("ROUTE", "No first byte from %s after %lu ms, hedging to %s",
+                      route.provider, now - sentAt[0], hedgeRoute->provider);
+                router->recordHedge();
+                hedgeSent = true;
+                if (sendToRoute(worker, *hedgeRoute, clients[1], reused[1], prompt, mode, dial[1])) {
+                    sentAt[1] = millis();
+                } else if (!abortSignal.triggered()) {
+                    router->recordFailure(*hedgeRoute);
                 }
             }
-            Serial.println();
-            
-            // 提取JSON响应
-            char* start = strchr(buffer, '{');
-            char* end = strrchr(buffer, '}');
-            
-            String jsonStr;
-            if (start && end && end > start) {
-                *++end = '\0';
-                jsonStr = String(start);
-            } else {
-                free(buffer);
-                Serial.println("[LLM] Error: No valid JSON found in response");
-                return "Error: Invalid response format";
+        }
+        delay(FIRST_BYTE_POLL_MS);
+    }
+
+    // 对冲请求胜出时主请求还没有响应：它的首字节延迟至少是已等待的时间，计入延迟样本，
+    // 否则对冲延迟只由更快的成功请求决定，只会越来越短
+    if (winner == 1 && clients[0]) {
+        router->recordLatencyLowerBound(route, millis() - sentAt[0]);
+    }
+
+    // 关闭失败方（或全部连接）：服务器随即停止生成
+    for (int i = 0; i < 2; i++) {
+        if (clients[i] && i != winner) {
+            if (winner >= 0) {
+                LOG_I("ROUTE", "%s answered first, cancelling request to %s", inFlight[winner]->provider, inFlight[i]->provider);
             }
-            
-            free(buffer);
-            
-            if (jsonStr.isEmpty()) {
-                Serial.println("[LLM] Error: Empty JSON string");
-                return "Error: Empty response";
+            clients[i]->stop();
+            worker.connectionPool->release(clients[i]);
+            clients[i] = nullptr;
+        }
+    }
+    if (winner < 0) {
+        if (abortSignal.triggered()) {
+            return worker.cancelled ? "Error: Request cancelled" : "Error: Request timed out";
+        }
+        retryable = !hedgeSent;
+        return "Error: Connection failed";
+    }
+    if (winner == 1) {
+        router->recordHedgeWin();
+    }
+
+    LLMTlsClient* client = clients[winner];
+    HttpResponseHead& head = heads[winner];
+    worker.timing.setRoute(inFlight[winner]->provider, inFlight[winner]->model.c_str());
+    worker.timing.applyDial(dial[winner]);
+    worker.timing.set(PHASE_FIRST_BYTE, firstByteMs[winner] * 1000);
+
+    String content = readRouteResponse(worker, *inFlight[winner], client, reused[winner], head, requestId, mode,
+                                       sentAt[winner], firstByteMs[winner], abortSignal, retryable);
+    retryable = retryable && winner == 0 && !hedgeSent;
+    return content;
+}
+
+// 从连接池获取连接并发送请求
+bool LLMManager::sendToRoute(LLMWorkerContext& worker, const LLMRoute& route, LLMTlsClient*& client, bool& reused,
+                             const String& prompt, LLMMode mode, LLMDialTiming& dial) {
+    TRACE_SCOPE("llm.send");
+    // 从连接池获取该主机的长连接，命中时省去 DNS、TCP 和 TLS 握手
+    if (!client) {
+        client = worker.connectionPool->acquire(route.host, reused);
+        if (!client) {
+            LOG_E("LLM", "Failed to allocate TLS client");
+            return false;
+        }
+        client->setTimeout(STREAM_TIMEOUT / 1000);   // 设置底层 TCP 超时（秒）
+    }
+
+    while (true) {
+        // 连接超时不超过距截止时间的剩余时间
+        long remaining = (long)(worker.deadline - millis());
+        if (remaining <= 0 || worker.cancelled) {
+            break;
+        }
+        unsigned long connectTimeout = ((unsigned long)remaining < NETWORK_TIMEOUT) ? (unsigned long)remaining : NETWORK_TIMEOUT;
+        if (!reused) {
+            if (!client->connect(route.host, 443, connectTimeout)) {
+                LOG_E("LLM", "Connection to %s failed", route.host);
+                break;
             }
-            
-            Serial.printf("[LLM] JSON length: %d bytes\n", jsonStr.length());
-            
-            // 解析JSON
-            JsonDocument responseDoc;
-            DeserializationError error = deserializeJson(responseDoc, jsonStr);
-            
-            if (error) {
-                Serial.printf("[LLM] JSON parse error: %s\n", error.c_str());
-                return "Error: Failed to parse response";
+            dial.dialed = true;
+            dial.dnsMicros = client->getLastDnsMicros();
+            dial.connectMicros = client->getLastConnectMicros();
+            dial.handshakeMicros = client->getLastHandshakeMs() * 1000;
+        }
+        unsigned long writeStart = micros();
+        bool written = writeChatRequest(worker, *client, route, prompt, mode);
+        dial.writeMicros = micros() - writeStart;
+        if (written) {
+            return true;
+        }
+        if (!reused) {
+            break;
+        }
+        // 复用的连接在发送时已失效，重新拨号并重试一次
+        LOG_W("LLM", "Reused connection failed, redialing %s", route.host);
+        worker.connectionPool->invalidate(client);
+        reused = false;
+    }
+
+    worker.connectionPool->invalidate(client);
+    worker.connectionPool->release(client);
+    client = nullptr;
+    return false;
+}
+
+// 读取胜出连接的响应体，并向路由器报告结果
+String LLMManager::readRouteResponse(LLMWorkerContext& worker, const LLMRoute& route, LLMTlsClient* client, bool reused,
+                                     HttpResponseHead& head, const String& requestId, LLMMode mode,
+                                     unsigned long requestStart, unsigned long firstByteMs,
+                                     HttpAbortSignal& abortSignal, bool& retryable) {
+    TRACE_SCOPE("llm.read");
+    LOG_I("LLM", "POST request to %s completed with code: %d (first byte %lu ms)", route.provider, head.statusCode, firstByteMs);
+    if (!reused) {
+        LOG_I("TLS", "Handshakes: %u full (avg %lu ms), %u resumed (avg %lu ms)",
+              tlsSessionCache->getFullHandshakes(), tlsSessionCache->getAvgFullHandshakeMs(),
+              tlsSessionCache->getResumedHandshakes(), tlsSessionCache->getAvgResumedHandshakeMs());
+    }
+
+    HttpBodyStream body(*client, head, STREAM_TIMEOUT);
+    body.setAbortSignal(&abortSignal);
+    unsigned long bodyStart = micros();
+    worker.timing.clear(PHASE_JSON_PARSE);
+    String content;
+    if (head.statusCode == 200 && streamingEnabled) {
+        content = readStreamingResponse(worker, body, requestId, mode, requestStart);
+    } else if (head.statusCode == 200) {
+        content = readJsonResponse(worker, body);
+    } else {
+        // 记录提供商返回的错误信息，并读完响应体以便连接复用
+        JsonDocument filter;
+        filter["error"]["message"] = true;
+        JsonDocument errorDoc;
+        deserializeJson(errorDoc, body, DeserializationOption::Filter(filter));
+        LOG_E("LLM", "HTTP error: %d %s", head.statusCode, errorDoc["error"]["message"] | "");
+        content = "Error: Request failed";
+    }
+
+    // 响应体未完整读完或服务器要求关闭时，连接不能再用于下一个请求；
+    // 被取消或超时的请求在这里关闭连接，释放 TLS 缓冲区
+    if (!body.drain() || !head.keepAlive) {
+        client->stop();
+    }
+    // 接收耗时不含解析：读取响应体的总时间减去解析时间
+    uint32_t bodyMicros = micros() - bodyStart;
+    uint32_t parseMicros = worker.timing.phaseMicros[PHASE_JSON_PARSE];
+    worker.timing.set(PHASE_BODY_DOWNLOAD, bodyMicros > parseMicros ? bodyMicros - parseMicros : 0);
+    worker.connectionPool->release(client);
+    if (abortSignal.triggered()) {
+        return worker.cancelled ? "Error: Request cancelled" : "Error: Request timed out";
+    }
+
+    // 限流和服务端错误计入熔断，可以转给备用路由；其余 4xx 是请求或配置问题，不计入
+    if (head.statusCode == 429 || head.statusCode >= 500) {
+        router->recordFailure(route);
+        retryable = true;
+    } else if (head.statusCode == 200 && content.startsWith("Error:")) {
+        router->recordFailure(route);
+    } else if (head.statusCode == 200) {
+        router->recordSuccess(route, firstByteMs);
+    }
+    return content;
+}
+
+// 发送请求头，并以 chunked 编码边生成边发送请求体
+bool LLMManager::writeChatRequest(LLMWorkerContext& worker, Client& client, const LLMRoute& route, const String& prompt, LLMMode mode) {
+    String requestHead = String("POST ") + route.path + " HTTP/1.1\r\n"
+                         "Host: " + route.host + "\r\n"
+                         "User-Agent: NOOX\r\n"
+                         "Connection: keep-alive\r\n"
+                         "Content-Type: application/json\r\n"
+                         "Accept: " + (streamingEnabled ? "text/event-stream" : "application/json") + "\r\n"
+                         "Authorization: Bearer " + route.apiKey + "\r\n";
+    if (strcmp(route.provider, "openrouter") == 0) {
+        requestHead += "HTTP-Referer: http://localhost\r\n";
+    }
+    requestHead += "Transfer-Encoding: chunked\r\n\r\n";
+
+    if (client.write((const uint8_t*)requestHead.c_str(), requestHead.length()) != requestHead.length()) {
+        return false;
+    }
+
+    // 请求体：{"model":...,"stream":true,"messages":[system, 历史..., user],"tools":[...]}
+    HttpChunkedWriter body(client);
+    body.print("{\"model\":");
+    body.writeJsonString(route.model.c_str());
+    if (streamingEnabled) {
+        body.print(",\"stream\":true");
+    }
+    body.print(",\"messages\":[");
+
+    bool first = true;
+    auto writeMessage = [&](const char* role, const char* content) {
+        body.print(first ? "{\"role\":" : ",{\"role\":");
+        body.writeJsonString(role);
+        body.print(",\"content\":");
+        body.writeJsonString(content);
+        body.print("}");
+        first = false;
+    };
+
+    // 1. 系统提示：已预先转义，直接从 Flash 写入，不做拷贝和转义
+    size_t systemPromptLength = 0;
+    const char* systemPromptJson = getSystemPromptJson(mode, systemPromptLength);
+    if (systemPromptLength > 0) {
+        body.print("{\"role\":\"system\",\"content\":");
+        body.write((const uint8_t*)systemPromptJson, systemPromptLength);
+        body.print("}");
+        first = false;
+    }
+
+    // 2. 对话历史（直接从 PSRAM 中的历史写出，不再拷贝到 JsonDocument）
+    //    只发送 token 预算内最新的消息；当前输入和系统提示总是发送
+    if (worker.history) {
+        size_t contextTokens = 0;
+        size_t firstIndex = selectHistory(worker, prompt, mode, contextTokens);
+        LOG_I("LLM", "Context: %u/%u history messages, ~%u tokens (budget %u)",
+              (unsigned)(worker.history->getMessageCount() - firstIndex), (unsigned)worker.history->getMessageCount(),
+              (unsigned)contextTokens, (unsigned)tokenBudget);
+
+        for (size_t i = firstIndex; i < worker.history->getMessageCount(); i++) {
+            const ConversationMessage* msg = worker.history->getMessage(i);
+            if (msg) {
+                writeMessage(ConversationHistory::roleName(msg->role), worker.history->getContent(*msg));
             }
+        }
+    }
+
+    // 3. 当前用户输入
+    writeMessage("user", prompt.c_str());
+    body.print("]");
 
-            // 只提取 LLM 的实际回复内容
-            if (responseDoc["choices"][0]["message"]["content"].is<String>()) {
-                String content = responseDoc["choices"][0]["message"]["content"].as<String>();
-                Serial.printf("[LLM] Extracted content length: %d\n", content.length());
-                return content;
+    // 4. 原生工具定义：启动时由工具注册表生成的 JSON 数组
+    if (usesNativeTools(mode) && toolsJsonLen > 0) {
+        body.print(",\"tools\":");
+        body.write((const uint8_t*)toolsJson, toolsJsonLen);
+    }
+    body.print("}");
+
+    bool ok = body.finish();
+    LOG_I("LLM", "Request body streamed: %u bytes", (unsigned)body.getBytesWritten());
+    return ok;
+}
+
+
+// 选取 token 预算内最新的历史消息
+size_t LLMManager::selectHistory(LLMWorkerContext& worker, const String& prompt, LLMMode mode, size_t& contextTokens) {
+    size_t systemTokens = (mode == CHAT_MODE) ? chatPromptTokens
+                        : (usesNativeTools(mode) ? nativePromptTokens : advancedPromptTokens);
+    size_t fixedTokens = systemTokens +
+                         ConversationHistory::estimateTokens(prompt.c_str()) + MESSAGE_TOKEN_OVERHEAD;
+    contextTokens = fixedTokens;
+    if (!worker.history) return 0;
+
+    size_t historyBudget = (tokenBudget > fixedTokens) ? tokenBudget - fixedTokens : 0;
+    size_t historyTokens = 0;
+    size_t firstIndex = worker.history->getFirstIndexWithinBudget(historyBudget, historyTokens);
+    contextTokens += historyTokens;
+    return firstIndex;
+}
+
+// 计算请求的缓存键
+uint64_t LLMManager::computeCacheKey(LLMWorkerContext& worker, const String& prompt, LLMMode mode) {
+    uint64_t key = LLMResponseCache::FNV_OFFSET_BASIS;
+    key = LLMResponseCache::hashNormalized(key, currentProvider.c_str());
+    key = LLMResponseCache::hashNormalized(key, currentModel.c_str());
+    uint8_t modeByte = (uint8_t)mode;
+    key = LLMResponseCache::hashBytes(key, &modeByte, 1);
+    uint64_t promptHash = (mode == CHAT_MODE) ? chatPromptHash
+                        : (usesNativeTools(mode) ? nativePromptHash : advancedPromptHash);
+    key = LLMResponseCache::hashBytes(key, &promptHash, sizeof(promptHash));
+
+    // 与 writeChatRequest() 发送的消息列表一致：预算内的历史 + 当前输入
+    size_t contextTokens = 0;
+    size_t firstIndex = selectHistory(worker, prompt, mode, contextTokens);
+    if (worker.history) {
+        for (size_t i = firstIndex; i < worker.history->getMessageCount(); i++) {
+            const ConversationMessage* msg = worker.history->getMessage(i);
+            if (msg) {
+                key = LLMResponseCache::hashNormalized(key, ConversationHistory::roleName(msg->role));
+                key = LLMResponseCache::hashNormalized(key, worker.history->getContent(*msg));
             }
-            
-            Serial.println("[LLM] Error: Invalid response structure");
-            return "Error: Invalid response structure";
-        } else {
-            http.end();
-            Serial.printf("[LLM] HTTP error: %d\n", httpCode);
-            return "Error: Request failed";
         }
-    } else {
-        http.end();
-        Serial.println("[LLM] Connection failed");
-        return "Error: Connection failed";
     }
+    key = LLMResponseCache::hashNormalized(key, "user");
+    key = LLMResponseCache::hashNormalized(key, prompt.c_str());
+    return key ? key : 1; // 0 保留为“未计算”
 }
 
+// 直接从网络流上解析非流式响应，只保留需要的字段
+String LLMManager::readJsonResponse(LLMWorkerContext& worker, HttpBodyStream& body) {
+    // 过滤器：只保留回复内容、结束原因和用量，其余字段在解析时直接跳过
+    JsonDocument filter;
+    filter["choices"][0]["message"]["content"] = true;
+    filter["choices"][0]["message"]["tool_calls"][0]["function"] = true;
+    filter["choices"][0]["finish_reason"] = true;
+    filter["usage"] = true;
 
-// 根据模式和工具生成系统提示（优化：使用静态缓存避免重复构建）
-String LLMManager::generateSystemPrompt(LLMMode mode) {
-    // 静态缓存，只在第一次调用时构建
-    static String cachedChatPrompt;
-    static String cachedAdvancedPrompt;
-    static bool initialized = false;
-    
-    if (!initialized) {
-        // ============ 聊天模式提示词 ============
-        cachedChatPrompt = 
-            "You are a helpful and friendly AI assistant. "
-            "Respond concisely and accurately to user queries with clear explanations.";
-        
-        // ============ 高级模式提示词（完整版，整合所有工具描述）============
-        cachedAdvancedPrompt = 
-            "# Your Role\n"
-            "You are an advanced AI assistant integrated into an ESP32-S3 device with multi-modal capabilities. "
-            "You can interact with the host computer through shell commands, USB HID (keyboard/mouse), and GPIO control. "
-            "Your purpose is to help users accomplish tasks by intelligently combining these capabilities.\n"
-            "\n"
-            "# Core Capabilities\n"
-            "1. **Command Execution**: Execute shell commands on the host computer and analyze their output\n"
-            "2. **Natural Language Communication**: Provide explanations, suggestions, and responses to users\n"
-            "3. **USB HID Control**: Simulate keyboard typing and mouse operations on the host computer\n"
-            "4. **GPIO Control**: Control hardware pins (LEDs and GPIO) on the ESP32-S3 device\n"
-            "\n"
-            "# Available Tools\n"
-            "\n"
-            "## Primary Tool: sendtoshell\n"
-            "Use this tool when you need to execute commands or send structured responses.\n"
-            "\n"
-            "**Parameters** (both required):\n"
-            "  - type: string - MUST be exactly \"command\" or \"text\" (case-sensitive)\n"
-            "  - value: string - The command string or text message (non-empty)\n"
-            "\n"
-            "**When to use**:\n"
-            "  • type=\"command\": Execute shell commands on the host computer\n"
-            "    - File operations: ls, cat, mkdir, rm, etc.\n"
-            "    - System queries: pwd, whoami, hostname, etc.\n"
-            "    - App launching: open/start applications\n"
-            "  • type=\"text\": Send structured text messages to the user\n"
-            "    - Important status updates\n"
-            "    - Notifications that don't require action\n"
-            "\n"
-            "**Best Practices**:\n"
-            "  • Always validate both parameters are present\n"
-            "  • Use platform-appropriate commands (consider Windows/Linux/Mac differences)\n"
-            "  • For destructive operations, confirm with user first\n"
-            "  • Keep commands simple and atomic when possible\n"
-            "\n"
-            "**Common Mistakes to Avoid**:\n"
-            "  • DO NOT use empty values\n"
-            "  • DO NOT use types other than \"command\" or \"text\"\n"
-            "  • DO NOT chain complex commands without understanding the shell environment\n"
-            "  • DO NOT assume the working directory or environment variables\n"
-            "\n"
-            "## HID Tools: USB Keyboard and Mouse Control\n"
-            "\n"
-            "### hid_keyboard_type\n"
-            "Type text via USB HID keyboard emulation.\n"
-            "\n"
-            "**Parameters** (required):\n"
-            "  - text: string - The text to type (non-empty)\n"
-            "\n"
-            "**Example** (return as raw JSON):\n"
-            "{\"tool_calls\": [{\"name\": \"hid_keyboard_type\", \"args\": {\"text\": \"Hello World\"}}]}\n"
-            "\n"
-            "\n"
-            "### hid_keyboard_press\n"
-            "Press key combinations or special keys.\n"
-            "\n"
-            "**Parameters** (required):\n"
-            "  - keys: string - Key combination like \"Ctrl+C\", \"Alt+Tab\", or special key like \"Enter\"\n"
-            "\n"
-            "**Supported modifiers**: Ctrl, Shift, Alt, Win (case-insensitive)\n"
-            "**Supported special keys**: F1-F12, Enter, Tab, Backspace, Escape, Home, End, PageUp, PageDown, Delete, Arrow keys\n"
-            "\n"
-            "**Examples**:\n"
-            "  - Copy: \"Ctrl+C\"\n"
-            "  - Paste: \"Ctrl+V\"\n"
-            "  - Switch window: \"Alt+Tab\"\n"
-            "  - Task manager: \"Ctrl+Shift+Esc\"\n"
-            "  - Press Enter: \"Enter\"\n"
-            "\n"
-            "### hid_keyboard_macro\n"
-            "Execute a sequence of keyboard/mouse actions.\n"
-            "\n"
-            "**Parameters** (required):\n"
-            "  - actions: array - Array of action objects\n"
-            "\n"
-            "**Action types**:\n"
-            "  - {\"action\": \"type\", \"value\": \"text\"} - Type text\n"
-            "  - {\"action\": \"press\", \"key\": \"Ctrl+C\"} - Press key combination\n"
-            "  - {\"action\": \"delay\", \"ms\": 500} - Wait specified milliseconds\n"
-            "  - {\"action\": \"click\", \"button\": \"left\"} - Click mouse button\n"
-            "  - {\"action\": \"move\", \"x\": 10, \"y\": 20} - Move mouse\n"
-            "\n"
-            "**Example** (return as raw JSON):\n"
-            "{\"tool_calls\": [{\"name\": \"hid_keyboard_macro\", \"args\": {\"actions\": "
-            "[{\"action\": \"type\", \"value\": \"notepad\"}, {\"action\": \"delay\", \"ms\": 500}, "
-            "{\"action\": \"press\", \"key\": \"Enter\"}]}}]}\n"
-            "\n"
-            "\n"
-            "### hid_mouse_click\n"
-            "Click mouse button.\n"
-            "\n"
-            "**Parameters** (optional):\n"
-            "  - button: string - \"left\" (default), \"right\", or \"middle\"\n"
-            "\n"
-            "### hid_mouse_move\n"
-            "Move mouse cursor relatively.\n"
-            "\n"
-            "**Parameters** (required):\n"
-            "  - x: integer - Horizontal movement (positive=right, negative=left)\n"
-            "  - y: integer - Vertical movement (positive=down, negative=up)\n"
-            "\n"
-            "## GPIO Tools: Hardware Pin Control\n"
-            "\n"
-            "### gpio_set\n"
-            "Control GPIO output pins on the ESP32-S3 device.\n"
-            "\n"
-            "**Parameters** (required):\n"
-            "  - gpio: string - GPIO name from the available list\n"
-            "  - state: boolean - true for HIGH, false for LOW\n"
-            "\n"
-            "**Available GPIOs**:\n"
-            "  - led1, led2, led3 - Onboard LED indicators\n"
-            "  - gpio1, gpio2 - Reserved general-purpose GPIO pins\n"
-            "\n"
-            "**Use Cases**:\n"
-            "  - Control indicator LEDs for status display\n"
-            "  - Trigger external devices via GPIO pins\n"
-            "  - Create visual feedback patterns\n"
-            "\n"
-            "**Examples** (return as raw JSON):\n"
-            "Turn on LED 1:\n"
-            "{\"tool_calls\": [{\"name\": \"gpio_set\", \"args\": {\"gpio\": \"led1\", \"state\": true}}]}\n"
-            "\n"
-            "Turn off all LEDs:\n"
-            "{\"tool_calls\": [{\"name\": \"gpio_set\", \"args\": {\"gpio\": \"led1\", \"state\": false}}, "
-            "{\"name\": \"gpio_set\", \"args\": {\"gpio\": \"led2\", \"state\": false}}, "
-            "{\"name\": \"gpio_set\", \"args\": {\"gpio\": \"led3\", \"state\": false}}]}\n"
-            "\n"
-            "\n"
-            "**Note**: Only output control is supported. GPIO names are case-insensitive.\n"
-            "\n"
-            "# Response Modes\n"
-            "\n"
-            "You have TWO ways to respond:\n"
-            "\n"
-            "## Mode 1: Tool Call (Pure JSON Format)\n"
-            "Use when you need to execute commands or send structured data.\n"
-            "\n"
-            "**CRITICAL: Return ONLY the raw JSON object. DO NOT wrap it in markdown code blocks (```json or ```).**\n"
-            "\n"
-            "Example (return exactly this format):\n"
-            "{\n"
-            "  \"tool_calls\": [\n"
-            "    {\n"
-            "      \"name\": \"sendtoshell\",\n"
-            "      \"args\": {\n"
-            "        \"type\": \"command\",\n"
-            "        \"value\": \"ls -lah\"\n"
-            "      }\n"
-            "    }\n"
-            "  ]\n"
-            "}\n"
-            "\n"
-            "For multiple tool calls, add more objects to the array:\n"
-            "{\n"
-            "  \"tool_calls\": [\n"
-            "    {\"name\": \"gpio_set\", \"args\": {\"gpio\": \"led1\", \"state\": true}},\n"
-            "    {\"name\": \"gpio_set\", \"args\": {\"gpio\": \"led2\", \"state\": true}}\n"
-            "  ]\n"
-            "}\n"
-            "\n"
-            "## Mode 2: Natural Language (Direct Text)\n"
-            "Use for casual conversation, explanations, questions, or when no action is needed.\n"
-            "Simply respond with plain text (no JSON):\n"
-            "\n"
-            "I can help you manage files, execute commands, and automate tasks on your computer. "
-            "What would you like me to do?\n"
-            "\n"
-            "\n"
-            "# When to Use Each Mode\n"
-            "\n"
-            "**Use JSON Tool Call when**:\n"
-            "- User asks you to DO something (execute, create, delete, run, etc.)\n"
-            "- You need to execute a shell command\n"
-            "- Taking action is required\n"
-            "\n"
-            "**Use Natural Language when**:\n"
-            "- User asks ABOUT something (what, how, why, explain)\n"
-            "- Providing explanations or suggestions\n"
-            "- Casual conversation or clarifying questions\n"
-            "- Analyzing or interpreting command results\n"
-            "- No action is immediately needed\n"
-            "\n"
-            "# Example Interactions\n"
-            "\n"
-            "**Example 1: Action Required (JSON)**\n"
-            "User: \"List all files in the current directory\"\n"
-            "Your response (raw JSON, no markdown):\n"
-            "{\"tool_calls\": [{\"name\": \"sendtoshell\", \"args\": {\"type\": \"command\", \"value\": \"ls -lah\"}}]}\n"
-            "\n"
-            "**Example 2: Explanation (Natural Language)**\n"
-            "User: \"What can you help me with?\"\n"
-            "Your response (plain text):\n"
-            "I can help you with various tasks on your computer! I can execute shell commands, "
-            "manage files and directories, run applications, check system status, and automate "
-            "repetitive tasks. Just tell me what you need, and I'll do my best to help!\n"
-            "\n"
-            "**Example 3: Analysis (Natural Language)**\n"
-            "User: \"Previous command output: [error logs]\"\n"
-            "Your response (plain text):\n"
-            "It looks like there's a permission error. The file you're trying to access requires "
-            "elevated privileges. Would you like me to try running the command with sudo?\n"
-            "\n"
-            "**Example 4: Follow-up Action (JSON)**\n"
-            "User: \"Yes, use sudo\"\n"
-            "Your response (raw JSON, no markdown):\n"
-            "{\"tool_calls\": [{\"name\": \"sendtoshell\", \"args\": {\"type\": \"command\", \"value\": \"sudo cat /var/log/syslog\"}}]}\n"
-            "\n"
-            "**Example 5: Multiple GPIO Controls (JSON)**\n"
-            "User: \"Turn on all LEDs\"\n"
-            "Your response (raw JSON with multiple tool calls):\n"
-            "{\"tool_calls\": [{\"name\": \"gpio_set\", \"args\": {\"gpio\": \"led1\", \"state\": true}}, "
-            "{\"name\": \"gpio_set\", \"args\": {\"gpio\": \"led2\", \"state\": true}}, "
-            "{\"name\": \"gpio_set\", \"args\": {\"gpio\": \"led3\", \"state\": true}}]}\n"
-            "\n"
-            "\n"
-            "# Decision Making Guidelines\n"
-            "1. **Understand intent**: Is the user asking you to DO or to EXPLAIN?\n"
-            "2. **Choose response mode**: Action → JSON, Conversation → Natural Language\n"
-            "3. **JSON format**: When using tool calls, return ONLY raw JSON. NEVER use ```json or ``` wrappers\n"
-            "4. **Be contextual**: Consider previous commands and their output\n"
-            "5. **Be safe**: Avoid destructive commands without clear confirmation\n"
-            "6. **Be helpful**: Explain complex operations, suggest alternatives\n"
-            "7. **Be efficient**: Use the most direct approach to achieve the goal\n"
-            "\n"
-            "**CRITICAL REMINDER**: For tool calls, output pure JSON like this:\n"
-            "{\"tool_calls\": [{\"name\": \"tool_name\", \"args\": {...}}]}\n"
-            "NOT like this: ```json\\n{...}\\n```\n"
-            "\n"
-            "Choose the response mode that best fits the situation. Don't force JSON when "
-            "natural conversation is more appropriate!";
-        
-        initialized = true;
+    JsonDocument responseDoc;
+    unsigned long parseStart = micros();
+    uint32_t waitBefore = body.getWaitMicros();
+    DeserializationError error = deserializeJson(responseDoc, body, DeserializationOption::Filter(filter));
+    // 边接收边解析：解析耗时为反序列化的总时间减去等待网络数据的时间
+    uint32_t parseMicros = micros() - parseStart;
+    uint32_t waitMicros = body.getWaitMicros() - waitBefore;
+    worker.timing.set(PHASE_JSON_PARSE, parseMicros > waitMicros ? parseMicros - waitMicros : 0);
+
+    // 读完响应体剩余部分（例如结尾换行和 chunked 结束块），连接才能被复用
+    body.drain();
+    LOG_I("LLM", "Total received: %u bytes", (unsigned)body.getBytesRead());
+
+    if (error) {
+        LOG_E("LLM", "JSON parse error: %s", error.c_str());
+        return body.getBytesRead() == 0 ? "Error: No data received from server" : "Error: Failed to parse response";
     }
-    
-    return (mode == CHAT_MODE) ? cachedChatPrompt : cachedAdvancedPrompt;
+
+    JsonObject usage = responseDoc["usage"];
+    if (!usage.isNull()) {
+        LOG_I("LLM", "Usage: prompt %d, completion %d, total %d tokens",
+              usage["prompt_tokens"] | 0, usage["completion_tokens"] | 0, usage["total_tokens"] | 0);
+    }
+    const char* finishReason = responseDoc["choices"][0]["finish_reason"] | "";
+    if (strcmp(finishReason, "length") == 0) {
+        LOG_W("LLM", "Response truncated by max_tokens");
+    }
+
+    // 原生工具调用：转换为 handleLLMRawResponse() 识别的格式
+    JsonArray toolCalls = responseDoc["choices"][0]["message"]["tool_calls"];
+    if (toolCalls.size() > 0) {
+        size_t count = (toolCalls.size() < MAX_NATIVE_TOOL_CALLS) ? toolCalls.size() : MAX_NATIVE_TOOL_CALLS;
+        String names[MAX_NATIVE_TOOL_CALLS];
+        String arguments[MAX_NATIVE_TOOL_CALLS];
+        for (size_t i = 0; i < count; i++) {
+            names[i] = toolCalls[i]["function"]["name"] | "";
+            arguments[i] = toolCalls[i]["function"]["arguments"] | "";
+        }
+        LOG_I("LLM", "Received %u native tool calls", (unsigned)count);
+        return toolCallsToContent(names, arguments, count);
+    }
+
+    // 只提取 LLM 的实际回复内容
+    if (responseDoc["choices"][0]["message"]["content"].is<String>()) {
+        String content = responseDoc["choices"][0]["message"]["content"].as<String>();
+        LOG_I("LLM", "Extracted content length: %d", content.length());
+        return content;
+    }
+
+    LOG_E("LLM", "Error: Invalid response structure");
+    return "Error: Invalid response structure";
+}
+
+// 读取 SSE 流式响应，边接收边转发内容增量
+String LLMManager::readStreamingResponse(LLMWorkerContext& worker, HttpBodyStream& body, const String& requestId, LLMMode mode, unsigned long requestStart) {
+
+    // 只保留增量内容字段，避免为每个事件构建完整文档
+    JsonDocument filter;
+    filter["choices"][0]["delta"]["content"] = true;
+    filter["choices"][0]["delta"]["tool_calls"] = true;
+    filter["error"]["message"] = true;
+
+    String content;          // 拼接后的完整回复
+    String line;             // 当前正在接收的 SSE 行
+    String pendingDelta;     // 尚未转发的增量
+    String errorMessage;
+    // 原生工具调用按 index 分片到达：函数名和参数 JSON 分别拼接
+    String toolNames[MAX_NATIVE_TOOL_CALLS];
+    String toolArguments[MAX_NATIVE_TOOL_CALLS];
+    size_t toolCallCount = 0;
+    // 聊天模式和原生工具模式直接转发（工具调用不在 content 中）；
+    // 文字工具模式需根据首个非空白字符判断是否为工具调用 JSON
+    bool forwardDecided = (mode == CHAT_MODE || usesNativeTools(mode));
+    bool forwardDeltas = forwardDecided;
+    bool done = false;
+    unsigned long startTime = millis();
+    unsigned long lastFlushTime = startTime;
+    unsigned long firstTokenTime = 0;
+    uint8_t readBuffer[256];
+
+    while (!done && (millis() - startTime < STREAM_TIMEOUT)) {
+        // 请求被取消或超过截止时间：立即停止读取
+        if (worker.cancelled || (long)(millis() - worker.deadline) >= 0) {
+            LOG_I("LLM", "Stream aborted: %s", worker.cancelled ? "cancelled" : "deadline exceeded");
+            break;
+        }
+        size_t available = body.available();
+        if (!available) {
+            if (body.isComplete() || body.hasFailed()) {
+                LOG_I("LLM", "Stream closed by server");
+                break;
+            }
+            if (pendingDelta.length() > 0 && forwardDeltas && millis() - lastFlushTime >= STREAM_DELTA_FLUSH_MS) {
+                emitStreamDelta(worker, requestId, pendingDelta);
+                pendingDelta = "";
+                lastFlushTime = millis();
+            }
+            delay(5);
+            continue;
+        }
+
+        size_t bytesRead = body.readBytes(readBuffer, min(available, sizeof(readBuffer)));
+        for (size_t i = 0; i < bytesRead && !done; i++) {
+            char c = (char)readBuffer[i];
+            if (c == '\r') continue;
+            if (c != '\n') {
+                line += c;
+                continue;
+            }
+
+            // 一行结束：只关心 "data:" 事件，注释行（": keep-alive"）和空行直接忽略
+            if (line.startsWith("data:")) {
+                const char* payload = line.c_str() + 5;
+                while (*payload == ' ') payload++;
+
+                if (strcmp(payload, "[DONE]") == 0) {
+                    done = true;
+                } else {
+                    JsonDocument event;
+                    unsigned long parseStart = micros();
+                    DeserializationError error = deserializeJson(event, payload, DeserializationOption::Filter(filter));
+                    worker.timing.add(PHASE_JSON_PARSE, micros() - parseStart);
+                    if (error) {
+                        LOG_I("LLM", "Skipping malformed SSE event: %s", error.c_str());
+                    } else if (event["error"]["message"].is<const char*>()) {
+                        errorMessage = event["error"]["message"].as<String>();
+                        done = true;
+                    } else {
+                        for (JsonObject toolCall : event["choices"][0]["delta"]["tool_calls"].as<JsonArray>()) {
+                            size_t index = toolCall["index"] | 0;
+                            if (index >= MAX_NATIVE_TOOL_CALLS) continue;
+                            if (index >= toolCallCount) toolCallCount = index + 1;
+                            toolNames[index] += toolCall["function"]["name"] | "";
+                            toolArguments[index] += toolCall["function"]["arguments"] | "";
+                            if (firstTokenTime == 0) {
+                                firstTokenTime = millis();
+                                LOG_I("LLM", "Time to first token: %lu ms", firstTokenTime - requestStart);
+                            }
+                        }
+                        const char* delta = event["choices"][0]["delta"]["content"];
+                        if (delta && *delta) {
+                            if (firstTokenTime == 0) {
+                                firstTokenTime = millis();
+                                LOG_I("LLM", "Time to first token: %lu ms", firstTokenTime - requestStart);
+                            }
+                            content += delta;
+                            pendingDelta += delta;
+                        }
+                    }
+                }
+            }
+            line = "";
+
+            if (!forwardDecided) {
+                String head = content;
+                head.trim();
+                if (head.length() > 0) {
+                    // 以 '{' 或 '`' 开头的回复是工具调用 JSON，不作为聊天文本转发
+                    forwardDeltas = head[0] != '{' && head[0] != '`';
+                    forwardDecided = true;
+                }
+            }
+
+            if (forwardDeltas && (pendingDelta.length() >= STREAM_DELTA_FLUSH_BYTES ||
+                                  (pendingDelta.length() > 0 && millis() - lastFlushTime >= STREAM_DELTA_FLUSH_MS))) {
+                emitStreamDelta(worker, requestId, pendingDelta);
+                pendingDelta = "";
+                lastFlushTime = millis();
+            }
+        }
+    }
+
+    if (forwardDeltas && pendingDelta.length() > 0) {
+        emitStreamDelta(worker, requestId, pendingDelta);
+    }
+
+    if (!done && !body.isComplete()) {
+        // 超时退出：剩余的流不再等待，连接由调用方关闭
+        body.abort();
+    }
+
+    LOG_I("LLM", "Stream finished in %lu ms, content length: %d", millis() - requestStart, content.length());
+
+    if (errorMessage.length() > 0) {
+        LOG_E("LLM", "Provider reported error in stream: %s", errorMessage.c_str());
+        return "Error: " + errorMessage;
+    }
+    if (toolCallCount > 0) {
+        if (!done && !body.isComplete()) {
+            return "Error: Stream ended before tool calls were complete";
+        }
+        LOG_I("LLM", "Received %u native tool calls", (unsigned)toolCallCount);
+        return toolCallsToContent(toolNames, toolArguments, toolCallCount);
+    }
+    if (content.isEmpty()) {
+        LOG_E("LLM", "Error: Empty streamed response");
+        return done ? "Error: Empty response" : "Error: No data received from server";
+    }
+    return content;
+}
+
+// 将一段内容增量转发给 USB 主机和 Web 客户端
+void LLMManager::emitStreamDelta(LLMWorkerContext& worker, const String& requestId, const String& delta) {
+    _usbShellManager->sendAiResponseDeltaToHost(requestId, delta);
+
+    LLMStreamDelta streamDelta;
+    memset(&streamDelta, 0, sizeof(LLMStreamDelta));
+    strncpy(streamDelta.requestId, requestId.c_str(), sizeof(streamDelta.requestId) - 1);
+    streamDelta.requestId[sizeof(streamDelta.requestId) - 1] = '\0';
+    streamDelta.clientId = worker.clientId;
+    streamDelta.text = allocateAndCopy(delta);
+    if (!streamDelta.text) return;
+
+    // 不阻塞流读取：队列满时丢弃该增量，最终的 chat_message 会携带完整文本
+    if (xQueueSend(llmDeltaQueue, &streamDelta, 0) != pdPASS) {
+        free(streamDelta.text);
+    }
+}
+
+// 获取预转义的系统提示（Flash 中的 JSON 字符串字面量，由 generate_prompts.py 生成）
+const char* LLMManager::getSystemPromptJson(LLMMode mode, size_t& length) {
+    if (mode == CHAT_MODE) {
+        length = LLM_CHAT_PROMPT_JSON_LEN;
+        return LLM_CHAT_PROMPT_JSON;
+    }
+    if (usesNativeTools(mode)) {
+        length = LLM_NATIVE_PROMPT_JSON_LEN;
+        return LLM_NATIVE_PROMPT_JSON;
+    }
+    length = advancedPromptJsonLen;
+    return advancedPromptJson;
+}
+
+// 根据工具注册表生成系统提示中的工具说明和 tools 数组
+void LLMManager::buildToolPrompts() {
+    // tools 数组：启动时生成一次，之后每个请求直接写入
+    JsonDocument schemaDoc;
+    toolRegistry->writeToolsSchema(schemaDoc.to<JsonArray>());
+    toolsJsonLen = measureJson(schemaDoc);
+    toolsJson = (char*)ps_malloc(toolsJsonLen + 1);
+    if (toolsJson) {
+        serializeJson(schemaDoc, toolsJson, toolsJsonLen + 1);
+    } else {
+        toolsJsonLen = 0;
+    }
+
+    // 高级模式系统提示：把工具说明转义为 JSON 字符串内容后替换 {{TOOLS}} 标记
+    advancedPromptJson = nullptr;
+    advancedPromptJsonLen = 0;
+    const char* marker = strstr(LLM_ADVANCED_PROMPT_JSON, TOOLS_PROMPT_MARKER);
+    if (marker) {
+        JsonDocument sectionDoc;
+        sectionDoc.set(toolRegistry->renderPromptSection());
+        String section;
+        serializeJson(sectionDoc, section);
+        // 去掉首尾引号，只保留转义后的内容
+        size_t prefixLength = marker - LLM_ADVANCED_PROMPT_JSON;
+        size_t suffixLength = LLM_ADVANCED_PROMPT_JSON_LEN - prefixLength - strlen(TOOLS_PROMPT_MARKER);
+        size_t sectionLength = section.length() - 2;
+        advancedPromptJsonLen = prefixLength + sectionLength + suffixLength;
+        advancedPromptJson = (char*)ps_malloc(advancedPromptJsonLen + 1);
+        if (advancedPromptJson) {
+            memcpy(advancedPromptJson, LLM_ADVANCED_PROMPT_JSON, prefixLength);
+            memcpy(advancedPromptJson + prefixLength, section.c_str() + 1, sectionLength);
+            memcpy(advancedPromptJson + prefixLength + sectionLength, marker + strlen(TOOLS_PROMPT_MARKER), suffixLength);
+            advancedPromptJson[advancedPromptJsonLen] = '\0';
+        }
+    }
+    if (!advancedPromptJson) {
+        LOG_I("TOOL", "Could not embed tool descriptions, using advanced prompt as is");
+        advancedPromptJson = (char*)LLM_ADVANCED_PROMPT_JSON;
+        advancedPromptJsonLen = LLM_ADVANCED_PROMPT_JSON_LEN;
+    }
+
+    // 系统提示在运行期间不变，token 数只需估算一次
+    chatPromptTokens = ConversationHistory::estimateTokens(LLM_CHAT_PROMPT_JSON) + MESSAGE_TOKEN_OVERHEAD;
+    advancedPromptTokens = ConversationHistory::estimateTokens(advancedPromptJson) + MESSAGE_TOKEN_OVERHEAD;
+    nativePromptTokens = ConversationHistory::estimateTokens(LLM_NATIVE_PROMPT_JSON) + MESSAGE_TOKEN_OVERHEAD +
+                         (toolsJson ? ConversationHistory::estimateTokens(toolsJson) : 0);
+    // 系统提示的哈希作为缓存键中的提示版本：提示或工具定义更新后旧的缓存条目自然失效
+    chatPromptHash = LLMResponseCache::hashBytes(LLMResponseCache::FNV_OFFSET_BASIS, LLM_CHAT_PROMPT_JSON, LLM_CHAT_PROMPT_JSON_LEN);
+    advancedPromptHash = LLMResponseCache::hashBytes(LLMResponseCache::FNV_OFFSET_BASIS, advancedPromptJson, advancedPromptJsonLen);
+    nativePromptHash = LLMResponseCache::hashBytes(LLMResponseCache::FNV_OFFSET_BASIS, LLM_NATIVE_PROMPT_JSON, LLM_NATIVE_PROMPT_JSON_LEN);
+    nativePromptHash = LLMResponseCache::hashBytes(nativePromptHash, toolsJson, toolsJsonLen);
+
+    LOG_I("TOOL", "Advanced prompt %u bytes, native tools schema %u bytes",
+          (unsigned)advancedPromptJsonLen, (unsigned)toolsJsonLen);
+}
+
+// 把原生 tool_calls 转换为 handleLLMRawResponse() 识别的 JSON 文本
+String LLMManager::toolCallsToContent(const String* names, const String* arguments, size_t count) {
+    JsonDocument doc;
+    JsonArray calls = doc["tool_calls"].to<JsonArray>();
+    for (size_t i = 0; i < count; i++) {
+        JsonObject call = calls.add<JsonObject>();
+        call["name"] = names[i];
+        if (arguments[i].length() == 0) {
+            call["args"].to<JsonObject>(); // 无参数的工具（如 hid_mouse_click）
+            continue;
+        }
+        JsonDocument args;
+        DeserializationError error = deserializeJson(args, arguments[i]);
+        if (error || !args.is<JsonObject>()) {
+            toolParseFailures->inc();
+            LOG_W("LLM", "Malformed arguments for tool %s (%u parse failures): %s",
+                  names[i].c_str(), toolParseFailures->get(), arguments[i].c_str());
+            call["args"].to<JsonObject>();
+        } else {
+            call["args"] = args;
+        }
+    }
+    String content;
+    serializeJson(doc, content);
+    return content;
 }
 
 // 处理 LLM 的原始响应，解析工具调用或自然语言回复。
-void LLMManager::handleLLMRawResponse(const String& requestId, const String& prompt, const String& llmContentString) {
+void LLMManager::handleLLMRawResponse(LLMWorkerContext& worker, const String& requestId, const String& prompt, const String& llmContentString) {
     LLMResponse response;
     memset(&response, 0, sizeof(LLMResponse));
     
     // 安全拷贝requestId到固定大小数组
     strncpy(response.requestId, requestId.c_str(), sizeof(response.requestId) - 1);
     response.requestId[sizeof(response.requestId) - 1] = '\0';
+    response.clientId = worker.clientId;
     response.isToolCall = false;
 
     // 清理可能的markdown代码块标记
@@ -773,328 +1441,266 @@ void LLMManager::handleLLMRawResponse(const String& requestId, const String& pro
     DeserializationError error = deserializeJson(contentDoc, cleanedContent);
 
     if (error) {
-        // JSON解析失败，视为自然语言响应
-        Serial.printf("handleLLMRawResponse: Natural language response (parse error: %s)\n", error.c_str());
+        // JSON解析失败，视为自然语言响应；看起来像 JSON 的回复计为一次工具调用解析失败
+        if (cleanedContent.startsWith("{")) {
+            toolParseFailures->inc();
+        }
+        LOG_I("LLM", "handleLLMRawResponse: Natural language response (parse error: %s)", error.c_str());
         _usbShellManager->sendAiResponseToHost(requestId, llmContentString);
         allocateResponseString(response.naturalLanguageResponse, llmContentString);
     } else {
         // 成功解析JSON，检查是否有工具调用
         if (contentDoc["tool_calls"].is<JsonArray>() && contentDoc["tool_calls"].size() > 0) {
             JsonArray toolCalls = contentDoc["tool_calls"].as<JsonArray>();
-            Serial.printf("handleLLMRawResponse: Processing %d tool calls\n", toolCalls.size());
+            LOG_I("LLM", "handleLLMRawResponse: Processing %u tool calls", (unsigned)toolCalls.size());
             
-            // 遍历所有工具调用
+            LLMToolContext context = {requestId, _usbShellManager, _hidManager, _hardwareManager};
+            // 本轮的工具调用作为一批执行：按名称查表并校验参数，不同资源上的调用并行
+            LLMToolBatch batch(*toolRegistry, context);
             for (JsonVariant toolCallVariant : toolCalls) {
                 if (!toolCallVariant.is<JsonObject>()) {
                     continue;
                 }
-                
                 JsonObject toolCall = toolCallVariant.as<JsonObject>();
-                String toolName = toolCall["name"] | "";
-
-            if (toolName == "sendtoshell") {
-                String outputType = toolCall["args"]["type"] | "";
-                String value = toolCall["args"]["value"] | "";
-
-                // 参数验证
-                if (outputType.isEmpty() || value.isEmpty()) {
-                    Serial.println("LLM called sendtoshell with missing parameters");
-                    String errorMsg = "Error: sendtoshell requires both 'type' and 'value' parameters";
-                    _usbShellManager->sendAiResponseToHost(requestId, errorMsg);
-                    allocateResponseString(response.naturalLanguageResponse, errorMsg);
-                    response.isToolCall = false;
-                } else if (outputType != "command" && outputType != "text") {
-                    Serial.printf("LLM called sendtoshell with invalid type: %s\n", outputType.c_str());
-                    String errorMsg = "Error: sendtoshell type must be 'command' or 'text', got: " + outputType;
-                    _usbShellManager->sendAiResponseToHost(requestId, errorMsg);
-                    allocateResponseString(response.naturalLanguageResponse, errorMsg);
-                    response.isToolCall = false;
-                } else {
-                    // 参数验证通过，执行工具调用
-                    response.isToolCall = true;
-                    strncpy(response.toolName, toolName.c_str(), sizeof(response.toolName) - 1);
-                    response.toolName[sizeof(response.toolName) - 1] = '\0';
-                    
-                    // 构建toolArgs的JSON字符串
-                    JsonDocument argsDoc;
-                    argsDoc["type"] = outputType;
-                    argsDoc["value"] = value;
-                    String argsStr;
-                    serializeJson(argsDoc, argsStr);
-                    allocateResponseString(response.toolArgs, argsStr);
-
-                    if (outputType == "command") {
-                        Serial.printf("LLM requested shell command: %s\n", value.c_str());
-                        _usbShellManager->sendShellCommandToHost(requestId, value);
-                    } else if (outputType == "text") {
-                        Serial.printf("LLM requested AI response: %s\n", value.c_str());
-                        _usbShellManager->sendAiResponseToHost(requestId, value);
-                    }
-                }
-            } else if (toolName == "hid_keyboard_type") {
-                // 输入文本字符串
-                String text = toolCall["args"]["text"] | "";
-                
-                if (text.isEmpty()) {
-                    Serial.println("LLM called hid_keyboard_type with missing text");
-                    String errorMsg = "Error: hid_keyboard_type requires 'text' parameter";
-                    _usbShellManager->sendAiResponseToHost(requestId, errorMsg);
-                    allocateResponseString(response.naturalLanguageResponse, errorMsg);
-                    response.isToolCall = false;
-                } else if (_hidManager && _hidManager->isReady()) {
-                    Serial.printf("LLM requested keyboard type: %s\n", text.c_str());
-                    _hidManager->sendString(text);
-                    String successMsg = "Typed text: " + text;
-                    _usbShellManager->sendAiResponseToHost(requestId, successMsg);
-                    
-                    response.isToolCall = true;
-                    strncpy(response.toolName, toolName.c_str(), sizeof(response.toolName) - 1);
-                    response.toolName[sizeof(response.toolName) - 1] = '\0';
-                    
-                    JsonDocument argsDoc;
-                    argsDoc["text"] = text;
-                    String argsStr;
-                    serializeJson(argsDoc, argsStr);
-                    allocateResponseString(response.toolArgs, argsStr);
-                } else {
-                    String errorMsg = "Error: HID not available";
-                    _usbShellManager->sendAiResponseToHost(requestId, errorMsg);
-                    allocateResponseString(response.naturalLanguageResponse, errorMsg);
-                    response.isToolCall = false;
-                }
-            } else if (toolName == "hid_keyboard_press") {
-                // 处理组合键和特殊键
-                String keys = toolCall["args"]["keys"] | "";
-                
-                if (keys.isEmpty()) {
-                    Serial.println("LLM called hid_keyboard_press with missing keys");
-                    String errorMsg = "Error: hid_keyboard_press requires 'keys' parameter";
-                    _usbShellManager->sendAiResponseToHost(requestId, errorMsg);
-                    allocateResponseString(response.naturalLanguageResponse, errorMsg);
-                    response.isToolCall = false;
-                } else if (_hidManager && _hidManager->isReady()) {
-                    Serial.printf("LLM requested keyboard press: %s\n", keys.c_str());
-                    bool success = _hidManager->pressKeyCombination(keys);
-                    
-                    if (success) {
-                        String successMsg = "Pressed keys: " + keys;
-                        _usbShellManager->sendAiResponseToHost(requestId, successMsg);
-                        
-                        response.isToolCall = true;
-                        strncpy(response.toolName, toolName.c_str(), sizeof(response.toolName) - 1);
-                        response.toolName[sizeof(response.toolName) - 1] = '\0';
-                        
-                        JsonDocument argsDoc;
-                        argsDoc["keys"] = keys;
-                        String argsStr;
-                        serializeJson(argsDoc, argsStr);
-                        allocateResponseString(response.toolArgs, argsStr);
-                    } else {
-                        String errorMsg = "Error: " + _hidManager->getLastError();
-                        _usbShellManager->sendAiResponseToHost(requestId, errorMsg);
-                        allocateResponseString(response.naturalLanguageResponse, errorMsg);
-                        response.isToolCall = false;
-                    }
-                } else {
-                    String errorMsg = "Error: HID not available";
-                    _usbShellManager->sendAiResponseToHost(requestId, errorMsg);
-                    allocateResponseString(response.naturalLanguageResponse, errorMsg);
-                    response.isToolCall = false;
-                }
-            } else if (toolName == "hid_keyboard_macro") {
-                // 处理宏操作
-                if (!toolCall["args"]["actions"].is<JsonArray>()) {
-                    Serial.println("LLM called hid_keyboard_macro with invalid actions");
-                    String errorMsg = "Error: hid_keyboard_macro requires 'actions' array parameter";
-                    _usbShellManager->sendAiResponseToHost(requestId, errorMsg);
-                    allocateResponseString(response.naturalLanguageResponse, errorMsg);
-                    response.isToolCall = false;
-                } else if (_hidManager && _hidManager->isReady()) {
-                    JsonArray actions = toolCall["args"]["actions"].as<JsonArray>();
-                    Serial.printf("LLM requested keyboard macro with %d actions\n", actions.size());
-                    bool success = _hidManager->executeMacro(actions);
-                    
-                    if (success) {
-                        String successMsg = "Executed macro with " + String(actions.size()) + " actions";
-                        _usbShellManager->sendAiResponseToHost(requestId, successMsg);
-                        
-                        response.isToolCall = true;
-                        strncpy(response.toolName, toolName.c_str(), sizeof(response.toolName) - 1);
-                        response.toolName[sizeof(response.toolName) - 1] = '\0';
-                        
-                        JsonDocument argsDoc;
-                        argsDoc["actions"] = actions;
-                        String argsStr;
-                        serializeJson(argsDoc, argsStr);
-                        allocateResponseString(response.toolArgs, argsStr);
-                    } else {
-                        String errorMsg = "Error: " + _hidManager->getLastError();
-                        _usbShellManager->sendAiResponseToHost(requestId, errorMsg);
-                        allocateResponseString(response.naturalLanguageResponse, errorMsg);
-                        response.isToolCall = false;
-                    }
-                } else {
-                    String errorMsg = "Error: HID not available";
-                    _usbShellManager->sendAiResponseToHost(requestId, errorMsg);
-                    allocateResponseString(response.naturalLanguageResponse, errorMsg);
-                    response.isToolCall = false;
-                }
-            } else if (toolName == "hid_mouse_click") {
-                // 处理鼠标点击
-                String button = toolCall["args"]["button"] | "left";
-                int buttonCode = MOUSE_BUTTON_LEFT;
-                
-                if (button == "right") buttonCode = MOUSE_BUTTON_RIGHT;
-                else if (button == "middle") buttonCode = MOUSE_BUTTON_MIDDLE;
-                
-                if (_hidManager && _hidManager->isReady()) {
-                    Serial.printf("LLM requested mouse click: %s\n", button.c_str());
-                    _hidManager->clickMouse(buttonCode);
-                    String successMsg = "Clicked mouse button: " + button;
-                    _usbShellManager->sendAiResponseToHost(requestId, successMsg);
-                    
-                    response.isToolCall = true;
-                    strncpy(response.toolName, toolName.c_str(), sizeof(response.toolName) - 1);
-                    response.toolName[sizeof(response.toolName) - 1] = '\0';
-                    
-                    JsonDocument argsDoc;
-                    argsDoc["button"] = button;
-                    String argsStr;
-                    serializeJson(argsDoc, argsStr);
-                    allocateResponseString(response.toolArgs, argsStr);
-                } else {
-                    String errorMsg = "Error: HID not available";
-                    _usbShellManager->sendAiResponseToHost(requestId, errorMsg);
-                    allocateResponseString(response.naturalLanguageResponse, errorMsg);
-                    response.isToolCall = false;
-                }
-            } else if (toolName == "hid_mouse_move") {
-                // 处理鼠标移动
-                int x = toolCall["args"]["x"] | 0;
-                int y = toolCall["args"]["y"] | 0;
-                
-                if (_hidManager && _hidManager->isReady()) {
-                    Serial.printf("LLM requested mouse move: x=%d, y=%d\n", x, y);
-                    _hidManager->moveMouse(x, y);
-                    String successMsg = "Moved mouse by (" + String(x) + ", " + String(y) + ")";
-                    _usbShellManager->sendAiResponseToHost(requestId, successMsg);
-                    
-                    response.isToolCall = true;
-                    strncpy(response.toolName, toolName.c_str(), sizeof(response.toolName) - 1);
-                    response.toolName[sizeof(response.toolName) - 1] = '\0';
-                    
-                    JsonDocument argsDoc;
-                    argsDoc["x"] = x;
-                    argsDoc["y"] = y;
-                    String argsStr;
-                    serializeJson(argsDoc, argsStr);
-                    allocateResponseString(response.toolArgs, argsStr);
-                } else {
-                    String errorMsg = "Error: HID not available";
-                    _usbShellManager->sendAiResponseToHost(requestId, errorMsg);
-                    allocateResponseString(response.naturalLanguageResponse, errorMsg);
-                    response.isToolCall = false;
-                }
-            } else if (toolName == "gpio_set") {
-                // 设置 GPIO 输出状态
-                String gpioName = toolCall["args"]["gpio"] | "";
-                bool state = toolCall["args"]["state"] | false;
-                
-                if (gpioName.isEmpty()) {
-                    Serial.println("LLM called gpio_set with missing gpio parameter");
-                    String errorMsg = "Error: gpio_set requires 'gpio' parameter";
-                    _usbShellManager->sendAiResponseToHost(requestId, errorMsg);
-                    allocateResponseString(response.naturalLanguageResponse, errorMsg);
-                    response.isToolCall = false;
-                } else if (_hardwareManager) {
-                    Serial.printf("LLM requested gpio_set: %s = %s\n", gpioName.c_str(), state ? "HIGH" : "LOW");
-                    bool success = _hardwareManager->setGpioOutput(gpioName, state);
-                    
-                    if (success) {
-                        String successMsg = "GPIO " + gpioName + " set to " + (state ? "HIGH" : "LOW");
-                        _usbShellManager->sendAiResponseToHost(requestId, successMsg);
-                        
-                        response.isToolCall = true;
-                        strncpy(response.toolName, toolName.c_str(), sizeof(response.toolName) - 1);
-                        response.toolName[sizeof(response.toolName) - 1] = '\0';
-                        
-                        JsonDocument argsDoc;
-                        argsDoc["gpio"] = gpioName;
-                        argsDoc["state"] = state;
-                        String argsStr;
-                        serializeJson(argsDoc, argsStr);
-                        allocateResponseString(response.toolArgs, argsStr);
-                    } else {
-                        String errorMsg = "Error: Invalid GPIO name: " + gpioName + ". Available: " + _hardwareManager->getAvailableGpios();
-                        _usbShellManager->sendAiResponseToHost(requestId, errorMsg);
-                        allocateResponseString(response.naturalLanguageResponse, errorMsg);
-                        response.isToolCall = false;
-                    }
-                } else {
-                    String errorMsg = "Error: Hardware manager not available";
-                    _usbShellManager->sendAiResponseToHost(requestId, errorMsg);
-                    allocateResponseString(response.naturalLanguageResponse, errorMsg);
-                    response.isToolCall = false;
+                const char* toolName = toolCall["name"] | "";
+                JsonObject args = toolCall["args"].is<JsonObject>() ? toolCall["args"].as<JsonObject>()
+                                                                    : toolCall["args"].to<JsonObject>();
+                batch.add(toolName, args);
+            }
+            unsigned long dispatchStart = micros();
+            TRACE_BEGIN("llm.tools");
+            batch.execute();
+            TRACE_END();
+            worker.timing.set(PHASE_TOOL_DISPATCH, micros() - dispatchStart);
+            toolCallsExecuted->inc(batch.size());
+            toolFailures->inc(batch.getFailureCount());
+            for (size_t i = 0; i < batch.size(); i++) {
+                const LLMToolCallResult& result = batch.getResult(i);
+                if (!result.success) {
+                    LOG_I("TOOL", "%s: %s", result.name, result.message.c_str());
                 }
-            } else {
-                Serial.printf("LLM called unknown tool: %s\n", toolName.c_str());
-                String errorMsg = "Error: LLM called an unknown tool: " + toolName;
-                _usbShellManager->sendAiResponseToHost(requestId, errorMsg);
-                allocateResponseString(response.naturalLanguageResponse, errorMsg);
-                response.isToolCall = false;
             }
-            } // 结束工具调用循环
+
+            // 每个输出端只发送一次汇总结果：Web 端收到结构化的结果数组，主机收到一条文本摘要
+            response.isToolCall = true;
+            JsonDocument resultsDoc;
+            batch.writeResults(resultsDoc.to<JsonArray>());
+            String resultsStr;
+            serializeJson(resultsDoc, resultsStr);
+            allocateResponseString(response.toolResults, resultsStr);
+            String summary = batch.summarize();
+            if (summary.length() > 0) {
+                _usbShellManager->sendAiResponseToHost(requestId, summary);
+            }
         } else {
             // 解析成功但没有tool_calls，视为自然语言响应
-            Serial.println("handleLLMRawResponse: No tool_calls, treating as natural language.");
+            LOG_I("LLM", "handleLLMRawResponse: No tool_calls, treating as natural language.");
             _usbShellManager->sendAiResponseToHost(requestId, llmContentString);
             allocateResponseString(response.naturalLanguageResponse, llmContentString);
         }
     }
 
-    // 保存用户输入和AI回复到对话历史
-    if (conversationHistory) {
-        conversationHistory->addMessage("user", prompt);
-        conversationHistory->addMessage("assistant", llmContentString);
+    // 保存用户输入和AI回复到当前会话的对话历史
+    if (worker.history) {
+        worker.history->addMessage(ROLE_USER, prompt);
+        worker.history->addMessage(ROLE_ASSISTANT, llmContentString);
     }
     
     // 发送响应到队列
     if (xQueueSend(llmResponseQueue, &response, 0) != pdPASS) {
-        Serial.println("handleLLMRawResponse: Failed to send response to queue.");
+        LOG_E("LLM", "handleLLMRawResponse: Failed to send response to queue.");
         // 发送失败，释放已分配的内存
-        if (response.toolArgs) free(response.toolArgs);
+        if (response.toolResults) free(response.toolResults);
         if (response.naturalLanguageResponse) free(response.naturalLanguageResponse);
     }
 }
 
-// LLM aysnc loop
-void LLMManager::loop() {
+// LLM aysnc loop（每个工作任务各自调用）
+void LLMManager::loop(uint8_t workerIndex) {
+    if (workerIndex >= workerCount) return;
+    LLMWorkerContext& worker = workers[workerIndex];
     LLMRequest request;   // 用于存储接收到的请求
-    String llmRawResponse; // 用于存储生成的原始响应
-
-    // 检查队列中是否有请求，非阻塞
-    if (xQueueReceive(llmRequestQueue, &request, 0) == pdPASS) {
-    Serial.printf("LLMTask: Received request for prompt: %s (requestId: %s)\n", request.prompt ? request.prompt : "NULL", request.requestId);
-        
-        if (request.prompt) {
-            // 将char*转换为String用于generateResponse函数
-            String requestIdStr = String(request.requestId);
-            String promptStr = String(request.prompt);
-            
-            // 调用核心函数生成响应
-            String llmContent = generateResponse(requestIdStr, promptStr, request.mode);
-            Serial.printf("LLMTask: Generated content: %s\n", llmContent.c_str());
 
-            // 处理LLM的原始响应，解析工具调用或自然语言回复（传递prompt用于保存历史）
-            handleLLMRawResponse(requestIdStr, promptStr, llmContent);
-            
-            // 释放请求的prompt内存（接收方负责释放）
-            free(request.prompt);
-            request.prompt = nullptr;
+    if (worker.queued > 0) {
+        // 其他任务已把同一会话的后续请求转交给本任务，先按顺序处理完
+        if (xQueueReceive(worker.backlog, &request, portMAX_DELAY) != pdPASS) return;
+        xSemaphoreTake(dispatchLock, portMAX_DELAY);
+        worker.queued--;
+        xSemaphoreGive(dispatchLock);
+    } else {
+        // 从调度器取优先级最高的请求；有多个工作任务时，0 号任务只处理交互请求
+        LLMPriority lowest = (workerCount > 1 && worker.index == 0) ? PRIORITY_INTERACTIVE : PRIORITY_BACKGROUND;
+        if (!scheduler->take(request, lowest)) return;
+        // 该会话正由其他任务处理时转交给那个任务
+        if (!claimSession(worker, request)) return;
+    }
+
+    processRequest(worker, request);
+    releaseSession(worker);
+}
+
+// 为从共享队列取出的请求认领会话
+bool LLMManager::claimSession(LLMWorkerContext& worker, const LLMRequest& request) {
+    xSemaphoreTake(dispatchLock, portMAX_DELAY);
+    if (request.sessionKey[0] != '\0') {
+        for (uint8_t i = 0; i < workerCount; i++) {
+            LLMWorkerContext& owner = workers[i];
+            if (i == worker.index || strcmp(owner.sessionKey, request.sessionKey) != 0) continue;
+
+            // 先计数再入队：owner 在 queued 归零前不会释放会话，也不会去取共享队列
+            owner.queued++;
+            xSemaphoreGive(dispatchLock);
+            LOG_I("LLM", "Worker %u: session %s busy on worker %u, handing over request",
+                  worker.index, request.sessionKey, owner.index);
+            xQueueSend(owner.backlog, &request, portMAX_DELAY);
+            return false;
+        }
+    }
+    strncpy(worker.sessionKey, request.sessionKey, sizeof(worker.sessionKey) - 1);
+    worker.sessionKey[sizeof(worker.sessionKey) - 1] = '\0';
+    xSemaphoreGive(dispatchLock);
+    return true;
+}
+
+// 请求处理结束，没有转交过来的后续请求时释放会话认领
+void LLMManager::releaseSession(LLMWorkerContext& worker) {
+    xSemaphoreTake(dispatchLock, portMAX_DELAY);
+    if (worker.queued == 0) {
+        worker.sessionKey[0] = '\0';
+    }
+    xSemaphoreGive(dispatchLock);
+}
+
+// 被丢弃的请求只通知请求方，不写入对话历史
+void LLMManager::sendDroppedResponse(LLMWorkerContext& worker, const String& requestId, const String& message, bool notifyWeb) {
+    if (worker.clientId == 0) {
+        _usbShellManager->sendAiResponseToHost(requestId, message);
+        return;
+    }
+    if (!notifyWeb) return;
+
+    LLMResponse response;
+    memset(&response, 0, sizeof(LLMResponse));
+    strncpy(response.requestId, requestId.c_str(), sizeof(response.requestId) - 1);
+    response.requestId[sizeof(response.requestId) - 1] = '\0';
+    response.clientId = worker.clientId;
+    response.isToolCall = false;
+    allocateResponseString(response.naturalLanguageResponse, message);
+    if (xQueueSend(llmResponseQueue, &response, 0) != pdPASS && response.naturalLanguageResponse) {
+        free(response.naturalLanguageResponse);
+    }
+}
+
+// 处理一个请求
+void LLMManager::processRequest(LLMWorkerContext& worker, LLMRequest& request) {
+    TRACE_SCOPE("llm.process");
+    LOG_I("LLM", "LLMTask %u: Received %s request (requestId: %s, session: %s, waited %lu ms)",
+          worker.index, LLMRequestScheduler::priorityName(request.priority),
+          request.requestId, request.sessionKey, millis() - request.enqueuedAt);
+    LOG_D("LLM", "LLMTask %u: Prompt: %s", worker.index, request.prompt ? request.prompt : "NULL");
+
+    if (!request.prompt) {
+        LOG_I("LLM", "LLMTask: Received request with NULL prompt, skipping.");
+        xSemaphoreTake(dispatchLock, portMAX_DELAY);
+        releaseCancelMark(request);
+        xSemaphoreGive(dispatchLock);
+        return;
+    }
+
+    // 将char*转换为String用于generateResponse函数
+    String requestIdStr = String(request.requestId);
+    String promptStr = String(request.prompt);
+
+    // 开始执行前检查取消点和截止时间；之后 cancelSession() 通过 worker.cancelled 中止本请求
+    xSemaphoreTake(dispatchLock, portMAX_DELAY);
+    bool cancelled = isCancelled(request);
+    releaseCancelMark(request);
+    worker.cancelled = false;
+    worker.seq = request.seq;
+    worker.deadline = request.deadline;
+    worker.clientId = request.clientId;
+    xSemaphoreGive(dispatchLock);
+
+    bool expired = (long)(millis() - request.deadline) >= 0;
+    if (cancelled || expired) {
+        if (cancelled) cancelledCount->inc(); else expiredCount->inc();
+        LOG_I("LLM", "LLMTask %u: Dropping %s request %s (dropped: %u cancelled, %u expired)", worker.index,
+              cancelled ? "cancelled" : "expired", request.requestId, cancelledCount->get(), expiredCount->get());
+        sendDroppedResponse(worker, requestIdStr, cancelled ? "Error: Request cancelled" : "Error: Request timed out",
+                            !cancelled);
+        worker.seq = 0;
+        worker.clientId = 0;
+        free(request.prompt);
+        request.prompt = nullptr;
+        TRACE_ASYNC_END("llm.request", request.seq);
+        return;
+    }
+
+    // 开始计时：排队等待在这里结束，其余阶段在请求过程中填写
+    worker.timing.reset();
+    worker.timing.set(PHASE_QUEUE_WAIT, (millis() - request.enqueuedAt) * 1000);
+    busyWorkers->add(1);
+
+    // 占用请求所属会话的对话历史；无法分配时本次请求不带历史
+    worker.history = request.sessionKey[0] ? sessionTable->acquire(request.sessionKey) : nullptr;
+
+    // 调用核心函数生成响应（用户原文供本地意图匹配）
+    const char* userText = nullptr;
+    if (request.userTextOffset >= 0 && (unsigned)request.userTextOffset <= promptStr.length()) {
+        userText = request.prompt + request.userTextOffset;
+    }
+    String llmContent = generateResponse(worker, requestIdStr, promptStr, request.mode, userText);
+    LOG_D("LLM", "LLMTask %u: Generated content: %s", worker.index, llmContent.c_str());
+
+    if (worker.cancelled || (long)(millis() - request.deadline) >= 0) {
+        // 被中止的请求不写入对话历史
+        bool wasCancelled = worker.cancelled;
+        if (wasCancelled) cancelledCount->inc(); else expiredCount->inc();
+        LOG_I("LLM", "LLMTask %u: Aborted %s request %s (dropped: %u cancelled, %u expired)", worker.index,
+              wasCancelled ? "cancelled" : "expired", request.requestId, cancelledCount->get(), expiredCount->get());
+        sendDroppedResponse(worker, requestIdStr, wasCancelled ? "Error: Request cancelled" : "Error: Request timed out",
+                            !wasCancelled);
+    } else {
+        // 处理LLM的原始响应，解析工具调用或自然语言回复（传递prompt用于保存历史）
+        handleLLMRawResponse(worker, requestIdStr, promptStr, llmContent);
+
+        // 被中止的请求只计入丢弃计数，不计入耗时统计
+        worker.timing.set(PHASE_TOTAL, (millis() - request.enqueuedAt) * 1000);
+        worker.timing.failed = llmContent.startsWith("Error:");
+        metrics->record(worker.timing);
+
+        const char* source = worker.timing.provider;
+        if (source && strcmp(source, "local") == 0) {
+            intentRequests->inc();
+        } else if (source && strcmp(source, "cache") == 0) {
+            cacheRequests->inc();
         } else {
-            Serial.println("LLMTask: Received request with NULL prompt, skipping.");
+            providerRequests->inc();
+        }
+        if (worker.timing.failed) {
+            failedRequests->inc();
+        }
+        requestDuration->observe(worker.timing.phaseMicros[PHASE_TOTAL] / 1000);
+        if (worker.timing.has(PHASE_FIRST_BYTE)) {
+            firstByteLatency->observe(worker.timing.phaseMicros[PHASE_FIRST_BYTE] / 1000);
         }
     }
+    busyWorkers->add(-1);
+
+    if (worker.history) {
+        sessionTable->release(request.sessionKey);
+    }
+    worker.history = nullptr;
+    worker.clientId = 0;
+    xSemaphoreTake(dispatchLock, portMAX_DELAY);
+    worker.seq = 0;
+    worker.cancelled = false;
+    xSemaphoreGive(dispatchLock);
+
+    // 释放请求的prompt内存（接收方负责释放）
+    free(request.prompt);
+    request.prompt = nullptr;
+    TRACE_ASYNC_END("llm.request", request.seq);
 }
 
 // 获取当前 LLM 模式
@@ -1105,5 +1711,5 @@ String LLMManager::getCurrentMode() const {
 // 设置 LLM 模式
 void LLMManager::setCurrentMode(LLMMode mode) {
     currentMode = mode;
-    Serial.printf("LLM Mode changed to: %s\n", getCurrentMode().c_str());
+    LOG_I("LLM", "LLM Mode changed to: %s", getCurrentMode().c_str());
 }
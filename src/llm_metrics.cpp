@@ -0,0 +1,158 @@
+#include "llm_metrics.h"
+#include "logger.h"
+
+// 直方图各桶的上限（毫秒），最后一个桶无上限；解析和工具执行通常在毫秒级，网络阶段在百毫秒到秒级
+static const uint32_t BUCKET_BOUNDS[LLMMetrics::BUCKET_COUNT] = {
+    1, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 10000, 0
+};
+
+// 构造函数
+LLMMetrics::LLMMetrics() : seriesCount(0), unrecorded(0) {
+    series = (Series*)ps_malloc(MAX_SERIES * sizeof(Series));
+    if (series) {
+        memset(series, 0, MAX_SERIES * sizeof(Series));
+    } else {
+        LOG_E("METRICS", "Failed to allocate latency series");
+    }
+    lock = xSemaphoreCreateMutex();
+}
+
+// 析构函数
+LLMMetrics::~LLMMetrics() {
+    if (series) free(series);
+    vSemaphoreDelete(lock);
+}
+
+// 查找或创建某提供商/模型的统计（调用方需持有锁）
+LLMMetrics::Series* LLMMetrics::findOrCreate(const char* provider, const char* model) {
+    for (size_t i = 0; i < seriesCount; i++) {
+        if (strcmp(series[i].provider, provider) == 0 && strcmp(series[i].model, model) == 0) {
+            return &series[i];
+        }
+    }
+    if (seriesCount >= MAX_SERIES) {
+        return nullptr;
+    }
+    Series* entry = &series[seriesCount++];
+    memset(entry, 0, sizeof(Series));
+    entry->provider = provider;
+    strncpy(entry->model, model, sizeof(entry->model) - 1);
+    return entry;
+}
+
+// 记录一个请求
+void LLMMetrics::record(const LLMRequestTiming& timing) {
+    if (!timing.provider || !series) {
+        return;
+    }
+    xSemaphoreTake(lock, portMAX_DELAY);
+    Series* entry = findOrCreate(timing.provider, timing.model);
+    if (!entry) {
+        unrecorded++;
+        xSemaphoreGive(lock);
+        return;
+    }
+    entry->requests++;
+    if (timing.failed) {
+        entry->errors++;
+    }
+    for (size_t p = 0; p < PHASE_COUNT; p++) {
+        if (!timing.has((LLMPhase)p)) continue;
+        PhaseWindow& window = entry->phases[p];
+        window.samples[window.next] = timing.phaseMicros[p];
+        window.next = (window.next + 1) % WINDOW;
+        if (window.sampleCount < WINDOW) window.sampleCount++;
+        window.count++;
+        window.sumMicros += timing.phaseMicros[p];
+    }
+    xSemaphoreGive(lock);
+}
+
+// 计算窗口样本的百分位数（调用方需持有锁）
+uint32_t LLMMetrics::percentile(const PhaseWindow& window, uint8_t pct) {
+    if (window.sampleCount == 0) return 0;
+
+    uint32_t sorted[WINDOW];
+    memcpy(sorted, window.samples, window.sampleCount * sizeof(uint32_t));
+    // 窗口不大（板上 32 个样本），插入排序即可
+    for (size_t i = 1; i < window.sampleCount; i++) {
+        uint32_t value = sorted[i];
+        size_t j = i;
+        while (j > 0 && sorted[j - 1] > value) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+    size_t rank = (window.sampleCount * pct + 99) / 100; // 最近秩法
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+// 以 JSON 输出各提供商/模型的分阶段统计
+void LLMMetrics::writeStats(JsonObject out) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    out["window"] = (uint32_t)WINDOW; // 转换为值，避免 ODR 使用静态常量成员
+    out["unrecorded"] = unrecorded;
+    JsonArray seriesStats = out["series"].to<JsonArray>();
+    for (size_t i = 0; i < seriesCount; i++) {
+        const Series& entry = series[i];
+        JsonObject s = seriesStats.add<JsonObject>();
+        s["provider"] = entry.provider;
+        s["model"] = entry.model;
+        s["requests"] = entry.requests;
+        s["errors"] = entry.errors;
+        JsonObject phases = s["phases"].to<JsonObject>();
+        for (size_t p = 0; p < PHASE_COUNT; p++) {
+            const PhaseWindow& window = entry.phases[p];
+            if (window.count == 0) continue;
+            JsonObject phase = phases[phaseName((LLMPhase)p)].to<JsonObject>();
+            phase["count"] = window.count;
+            phase["avg_ms"] = (float)(window.sumMicros / window.count) / 1000.0f;
+            phase["p50_ms"] = percentile(window, 50) / 1000.0f;
+            phase["p95_ms"] = percentile(window, 95) / 1000.0f;
+            phase["p99_ms"] = percentile(window, 99) / 1000.0f;
+            phase["max_ms"] = percentile(window, 100) / 1000.0f;
+            // 直方图按窗口中的样本统计：le 为桶上限（毫秒），最后一个桶为 "+Inf"
+            uint32_t bucketCounts[BUCKET_COUNT] = {0};
+            for (size_t k = 0; k < window.sampleCount; k++) {
+                size_t bucket = 0;
+                while (bucket < BUCKET_COUNT - 1 && window.samples[k] > BUCKET_BOUNDS[bucket] * 1000) {
+                    bucket++;
+                }
+                bucketCounts[bucket]++;
+            }
+            JsonArray buckets = phase["buckets"].to<JsonArray>();
+            for (size_t b = 0; b < BUCKET_COUNT; b++) {
+                JsonObject bucket = buckets.add<JsonObject>();
+                if (BUCKET_BOUNDS[b]) {
+                    bucket["le"] = BUCKET_BOUNDS[b];
+                } else {
+                    bucket["le"] = "+Inf";
+                }
+                bucket["count"] = bucketCounts[b];
+            }
+        }
+    }
+    xSemaphoreGive(lock);
+}
+
+// 阶段名称
+const char* LLMMetrics::phaseName(LLMPhase phase) {
+    switch (phase) {
+        case PHASE_QUEUE_WAIT: return "queue_wait";
+        case PHASE_DNS: return "dns";
+        case PHASE_TCP_CONNECT: return "tcp_connect";
+        case PHASE_TLS_HANDSHAKE: return "tls_handshake";
+        case PHASE_REQUEST_WRITE: return "request_write";
+        case PHASE_FIRST_BYTE: return "first_byte";
+        case PHASE_BODY_DOWNLOAD: return "body_download";
+        case PHASE_JSON_PARSE: return "json_parse";
+        case PHASE_TOOL_DISPATCH: return "tool_dispatch";
+        case PHASE_TOTAL: return "total";
+        default: return "unknown";
+    }
+}
+
+const uint32_t* LLMMetrics::getBucketBounds() {
+    return BUCKET_BOUNDS;
+}
@@ -0,0 +1,247 @@
+#include "llm_provider_router.h"
+#include "logger.h"
+
+/**
+ * @brief 支持的提供商及其端点（均为 OpenAI 兼容接口）
+ */
+struct LLMProviderEndpoint {
+    const char* name;
+    const char* host;
+    const char* path;
+};
+
+static const LLMProviderEndpoint PROVIDER_ENDPOINTS[LLMProviderRouter::PROVIDER_COUNT] = {
+    {"deepseek", "api.deepseek.com", "/chat/completions"},
+    {"openrouter", "openrouter.ai", "/api/v1/chat/completions"},
+    {"openai", "api.openai.com", "/v1/chat/completions"},
+};
+
+// 计算百分位数所需的最少样本数，不足时使用缺省对冲延迟
+const size_t MIN_HEDGE_SAMPLES = 8;
+
+// 构造函数
+LLMProviderRouter::LLMProviderRouter()
+    : hedgeEnabled(false), hedgePercentile(95), hedgeDefaultDelayMs(4000), hedgeMinDelayMs(500),
+      breakerFailures(3), breakerCooldownMs(30000), hedgesFired(0), hedgeWins(0), failovers(0) {
+    memset(providers, 0, sizeof(providers));
+    routeValid[ROUTE_PRIMARY] = false;
+    routeValid[ROUTE_SECONDARY] = false;
+    lock = xSemaphoreCreateMutex();
+}
+
+// 析构函数
+LLMProviderRouter::~LLMProviderRouter() {
+    vSemaphoreDelete(lock);
+}
+
+// 按名称查找提供商
+int LLMProviderRouter::findProvider(const String& name) {
+    for (size_t i = 0; i < PROVIDER_COUNT; i++) {
+        if (name == PROVIDER_ENDPOINTS[i].name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// 加载一个路由
+bool LLMProviderRouter::loadRoute(JsonDocument& config, const String& provider, const String& model, LLMRoute& route) {
+    int index = findProvider(provider);
+    if (index < 0 || model.length() == 0) {
+        return false;
+    }
+    route.providerIndex = index;
+    route.provider = PROVIDER_ENDPOINTS[index].name;
+    route.host = PROVIDER_ENDPOINTS[index].host;
+    route.path = PROVIDER_ENDPOINTS[index].path;
+    route.model = model;
+    route.apiKey = config["llm_providers"][provider]["api_key"].as<String>();
+    return route.apiKey.length() > 0;
+}
+
+// 从配置加载路由和参数
+void LLMProviderRouter::configure(JsonDocument& config) {
+    JsonObject routing = config["llm_settings"]["routing"];
+    String primaryProvider = config["last_used"]["llm_provider"].as<String>();
+    String primaryModel = config["last_used"]["model"].as<String>();
+    String secondaryProvider = routing["secondary"]["provider"] | "";
+    String secondaryModel = routing["secondary"]["model"] | "";
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    routeValid[ROUTE_PRIMARY] = loadRoute(config, primaryProvider, primaryModel, routes[ROUTE_PRIMARY]);
+    routeValid[ROUTE_SECONDARY] = loadRoute(config, secondaryProvider, secondaryModel, routes[ROUTE_SECONDARY]);
+    // 备用路由与主路由完全相同时没有意义
+    if (routeValid[ROUTE_SECONDARY] && routeValid[ROUTE_PRIMARY] &&
+        routes[ROUTE_SECONDARY].providerIndex == routes[ROUTE_PRIMARY].providerIndex &&
+        routes[ROUTE_SECONDARY].model == routes[ROUTE_PRIMARY].model) {
+        routeValid[ROUTE_SECONDARY] = false;
+    }
+
+    hedgeEnabled = routing["hedge"] | true;
+    hedgePercentile = routing["hedge_percentile"] | 95;
+    if (hedgePercentile == 0 || hedgePercentile > 100) hedgePercentile = 95;
+    hedgeDefaultDelayMs = routing["hedge_delay_ms"] | 4000UL;
+    hedgeMinDelayMs = routing["hedge_min_delay_ms"] | 500UL;
+    breakerFailures = routing["breaker_failures"] | 3;
+    if (breakerFailures == 0) breakerFailures = 1;
+    breakerCooldownMs = routing["breaker_cooldown_ms"] | 30000UL;
+    xSemaphoreGive(lock);
+
+    if (routeValid[ROUTE_SECONDARY]) {
+        LOG_I("ROUTE", "Secondary %s/%s, hedging %s at p%u (default %lu ms)",
+              routes[ROUTE_SECONDARY].provider, routes[ROUTE_SECONDARY].model.c_str(),
+              hedgeEnabled ? "on" : "off", hedgePercentile, hedgeDefaultDelayMs);
+    } else {
+        LOG_I("ROUTE", "No secondary provider, hedging and failover disabled");
+    }
+}
+
+// 获取路由
+bool LLMProviderRouter::getRoute(LLMRouteTarget target, LLMRoute& route) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool valid = routeValid[target];
+    if (valid) {
+        route = routes[target];
+    }
+    xSemaphoreGive(lock);
+    return valid;
+}
+
+// 熔断器是否放行请求
+bool LLMProviderRouter::allow(const LLMRoute& route) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    ProviderState& state = providers[route.providerIndex];
+    bool allowed = true;
+    if (state.state != BREAKER_CLOSED) {
+        // 冷却结束后放行一个试探请求；试探请求迟迟没有结果（例如作为对冲失败方被关闭）时，
+        // 再过一个冷却期放行下一个
+        allowed = millis() - state.openedAt >= breakerCooldownMs;
+        if (allowed) {
+            state.state = BREAKER_HALF_OPEN;
+            state.openedAt = millis();
+            LOG_I("ROUTE", "%s half-open, sending a trial request", route.provider);
+        }
+    }
+    xSemaphoreGive(lock);
+    return allowed;
+}
+
+// 计算延迟样本的百分位数（调用方需持有锁）
+unsigned long LLMProviderRouter::percentile(const ProviderState& state, uint8_t pct) const {
+    if (state.latencyCount == 0) return 0;
+
+    uint32_t sorted[LATENCY_SAMPLES];
+    memcpy(sorted, state.latencies, state.latencyCount * sizeof(uint32_t));
+    // 样本很少，插入排序即可
+    for (size_t i = 1; i < state.latencyCount; i++) {
+        uint32_t value = sorted[i];
+        size_t j = i;
+        while (j > 0 && sorted[j - 1] > value) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+    size_t rank = (state.latencyCount * pct + 99) / 100; // 最近秩法
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+// 对冲延迟
+unsigned long LLMProviderRouter::getHedgeDelay(const LLMRoute& route) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    const ProviderState& state = providers[route.providerIndex];
+    unsigned long delayMs = (state.latencyCount >= MIN_HEDGE_SAMPLES) ? percentile(state, hedgePercentile)
+                                                                     : hedgeDefaultDelayMs;
+    xSemaphoreGive(lock);
+    return (delayMs < hedgeMinDelayMs) ? hedgeMinDelayMs : delayMs;
+}
+
+// 记录一次成功的请求
+void LLMProviderRouter::recordSuccess(const LLMRoute& route, unsigned long firstByteMs) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    ProviderState& state = providers[route.providerIndex];
+    if (state.state != BREAKER_CLOSED) {
+        LOG_I("ROUTE", "%s recovered, circuit closed", route.provider);
+    }
+    state.state = BREAKER_CLOSED;
+    state.consecutiveFailures = 0;
+    state.successes++;
+    addLatencySample(state, firstByteMs);
+    xSemaphoreGive(lock);
+}
+
+// 记录被对冲请求取代的主请求已等待的时间
+void LLMProviderRouter::recordLatencyLowerBound(const LLMRoute& route, unsigned long elapsedMs) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    addLatencySample(providers[route.providerIndex], elapsedMs);
+    xSemaphoreGive(lock);
+}
+
+// 加入一个首字节延迟样本
+void LLMProviderRouter::addLatencySample(ProviderState& state, unsigned long firstByteMs) {
+    state.latencies[state.latencyNext] = firstByteMs;
+    state.latencyNext = (state.latencyNext + 1) % LATENCY_SAMPLES;
+    if (state.latencyCount < LATENCY_SAMPLES) state.latencyCount++;
+}
+
+// 记录一次失败的请求
+void LLMProviderRouter::recordFailure(const LLMRoute& route) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    ProviderState& state = providers[route.providerIndex];
+    state.failures++;
+    if (state.consecutiveFailures < 255) state.consecutiveFailures++;
+    // 试探请求失败，或连续失败达到阈值时熔断
+    if (state.state == BREAKER_HALF_OPEN ||
+        (state.state == BREAKER_CLOSED && state.consecutiveFailures >= breakerFailures)) {
+        state.state = BREAKER_OPEN;
+        state.openedAt = millis();
+        state.trips++;
+        LOG_W("ROUTE", "%s circuit open after %u consecutive failures (cooldown %lu ms)",
+              route.provider, state.consecutiveFailures, breakerCooldownMs);
+    }
+    xSemaphoreGive(lock);
+}
+
+// 以 JSON 输出路由统计
+void LLMProviderRouter::writeStats(JsonObject out) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (size_t target = ROUTE_PRIMARY; target <= ROUTE_SECONDARY; target++) {
+        const char* name = (target == ROUTE_PRIMARY) ? "primary" : "secondary";
+        if (routeValid[target]) {
+            out[name]["provider"] = routes[target].provider;
+            out[name]["model"] = routes[target].model;
+        } else {
+            out[name] = nullptr;
+        }
+    }
+    out["hedge_enabled"] = hedgeEnabled;
+    out["hedge_percentile"] = hedgePercentile;
+    out["hedges_fired"] = hedgesFired;
+    out["hedge_wins"] = hedgeWins;
+    out["failovers"] = failovers;
+
+    JsonObject providerStats = out["providers"].to<JsonObject>();
+    for (size_t i = 0; i < PROVIDER_COUNT; i++) {
+        const ProviderState& state = providers[i];
+        JsonObject p = providerStats[PROVIDER_ENDPOINTS[i].name].to<JsonObject>();
+        p["breaker"] = breakerStateName(state.state);
+        p["consecutive_failures"] = state.consecutiveFailures;
+        p["successes"] = state.successes;
+        p["failures"] = state.failures;
+        p["trips"] = state.trips;
+        p["first_byte_p50_ms"] = percentile(state, 50);
+        p["first_byte_p95_ms"] = percentile(state, 95);
+        p["samples"] = state.latencyCount;
+    }
+    xSemaphoreGive(lock);
+}
+
+// 熔断器状态名称
+const char* LLMProviderRouter::breakerStateName(LLMBreakerState state) {
+    switch (state) {
+        case BREAKER_CLOSED: return "closed";
+        case BREAKER_OPEN: return "open";
+        case BREAKER_HALF_OPEN: return "half_open";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,162 @@
+#include "llm_request_scheduler.h"
+#include "logger.h"
+
+// 等待时间直方图各桶的上限（毫秒），最后一个桶无上限
+static const unsigned long WAIT_BUCKET_BOUNDS[LLMRequestScheduler::WAIT_BUCKET_COUNT] = {
+    10, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 0
+};
+
+// 构造函数
+LLMRequestScheduler::LLMRequestScheduler(size_t capacityPerClass, unsigned long agingStepMs)
+    : capacity(capacityPerClass), agingStepMs(agingStepMs) {
+    memset(queues, 0, sizeof(queues));
+    for (size_t i = 0; i < PRIORITY_CLASS_COUNT; i++) {
+        queues[i].items = (LLMRequest*)ps_malloc(capacity * sizeof(LLMRequest));
+        if (!queues[i].items) {
+            LOG_E("SCHED", "Failed to allocate %s queue", priorityName((LLMPriority)i));
+        }
+    }
+    lock = xSemaphoreCreateMutex();
+}
+
+// 析构函数：释放仍在排队的请求
+LLMRequestScheduler::~LLMRequestScheduler() {
+    for (size_t i = 0; i < PRIORITY_CLASS_COUNT; i++) {
+        ClassQueue& queue = queues[i];
+        for (size_t n = 0; n < queue.count; n++) {
+            free(queue.items[(queue.head + n) % capacity].prompt);
+        }
+        free(queue.items);
+    }
+    vSemaphoreDelete(lock);
+}
+
+// 尝试把请求放入类别队列（调用方需持有锁）
+bool LLMRequestScheduler::tryPush(LLMRequest& request, LLMPriority priority) {
+    ClassQueue& queue = queues[priority];
+    if (!queue.items || queue.count >= capacity) {
+        return false;
+    }
+    request.priority = priority;
+    request.enqueuedAt = millis();
+    queue.items[(queue.head + queue.count) % capacity] = request;
+    queue.count++;
+    return true;
+}
+
+// 提交请求
+bool LLMRequestScheduler::submit(LLMRequest& request, LLMPriority priority, TickType_t waitTicks) {
+    TickType_t start = xTaskGetTickCount();
+    while (true) {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        bool pushed = tryPush(request, priority);
+        xSemaphoreGive(lock);
+        if (pushed) {
+            return true;
+        }
+        if (xTaskGetTickCount() - start >= waitTicks) {
+            LOG_W("SCHED", "%s queue full, request %s rejected", priorityName(priority), request.requestId);
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+// 取出当前应当执行的请求
+bool LLMRequestScheduler::take(LLMRequest& request, LLMPriority lowestPriority) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+
+    unsigned long now = millis();
+    int best = -1;
+    long bestRank = 0;
+    unsigned long bestWait = 0;
+    for (int i = 0; i <= lowestPriority; i++) {
+        ClassQueue& queue = queues[i];
+        if (queue.count == 0) continue;
+
+        // 老化：每排队 agingStepMs 提升一级，最多提升到最高优先级
+        unsigned long waitMs = now - queue.items[queue.head].enqueuedAt;
+        long rank = (long)i - (long)(waitMs / agingStepMs);
+        if (rank < 0) rank = 0;
+        if (best < 0 || rank < bestRank || (rank == bestRank && waitMs > bestWait)) {
+            best = i;
+            bestRank = rank;
+            bestWait = waitMs;
+        }
+    }
+
+    if (best < 0) {
+        xSemaphoreGive(lock);
+        return false;
+    }
+
+    ClassQueue& queue = queues[best];
+    request = queue.items[queue.head];
+    queue.head = (queue.head + 1) % capacity;
+    queue.count--;
+    queue.dequeued++;
+    // 更高的类别中仍有请求在排队，说明本次是靠老化提升出队的
+    for (int i = 0; i < best; i++) {
+        if (queues[i].count > 0) {
+            queue.promoted++;
+            break;
+        }
+    }
+    recordWait(queue, bestWait);
+
+    xSemaphoreGive(lock);
+    return true;
+}
+
+// 记录一次出队的等待时间（调用方需持有锁）
+void LLMRequestScheduler::recordWait(ClassQueue& queue, unsigned long waitMs) {
+    size_t bucket = 0;
+    while (bucket < WAIT_BUCKET_COUNT - 1 && waitMs > WAIT_BUCKET_BOUNDS[bucket]) {
+        bucket++;
+    }
+    queue.waitBuckets[bucket]++;
+    if (waitMs > queue.maxWaitMs) {
+        queue.maxWaitMs = waitMs;
+    }
+}
+
+// 以 JSON 输出各类别的统计
+void LLMRequestScheduler::writeStats(JsonObject out) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    out["aging_step_ms"] = agingStepMs;
+    out["capacity_per_class"] = capacity;
+    for (size_t i = 0; i < PRIORITY_CLASS_COUNT; i++) {
+        ClassQueue& queue = queues[i];
+        JsonObject cls = out[priorityName((LLMPriority)i)].to<JsonObject>();
+        cls["queued"] = queue.count;
+        cls["dequeued"] = queue.dequeued;
+        cls["promoted"] = queue.promoted;
+        cls["max_wait_ms"] = queue.maxWaitMs;
+        // 直方图：le 为桶上限（毫秒），最后一个桶为 "+Inf"
+        JsonArray buckets = cls["wait_ms"].to<JsonArray>();
+        for (size_t b = 0; b < WAIT_BUCKET_COUNT; b++) {
+            JsonObject bucket = buckets.add<JsonObject>();
+            if (WAIT_BUCKET_BOUNDS[b]) {
+                bucket["le"] = WAIT_BUCKET_BOUNDS[b];
+            } else {
+                bucket["le"] = "+Inf";
+            }
+            bucket["count"] = queue.waitBuckets[b];
+        }
+    }
+    xSemaphoreGive(lock);
+}
+
+// 类别名称
+const char* LLMRequestScheduler::priorityName(LLMPriority priority) {
+    switch (priority) {
+        case PRIORITY_INTERACTIVE: return "interactive";
+        case PRIORITY_FOLLOW_UP: return "follow_up";
+        case PRIORITY_BACKGROUND: return "background";
+        default: return "unknown";
+    }
+}
+
+const unsigned long* LLMRequestScheduler::getWaitBucketBounds() {
+    return WAIT_BUCKET_BOUNDS;
+}
@@ -0,0 +1,310 @@
+#include "llm_response_cache.h"
+#include "logger.h"
+#include <LittleFS.h>
+#include <time.h>
+
+// LittleFS 持久层所在目录
+static const char* CACHE_DIR = "/llm_cache";
+// 持久层文件头的魔数（"NXC1"）
+static const uint32_t CACHE_FILE_MAGIC = 0x3143584e;
+// 早于该时间（2023-11）的系统时间视为尚未通过 SNTP 同步
+static const time_t MIN_VALID_EPOCH = 1700000000;
+
+/**
+ * @brief 持久层文件头，后接 length 字节的回复内容
+ */
+struct LLMCacheFileHeader {
+    uint32_t magic;
+    uint32_t length;
+    uint64_t key;
+    uint32_t storedAt; ///< 写入时的 Unix 时间（秒）
+};
+
+// 构造函数
+LLMResponseCache::LLMResponseCache()
+    : entryCount(0), usedBytes(0), enabled(false), ttlSeconds(0), maxEntries(0), maxBytes(0),
+      persist(false), persistSlots(0), memoryHits(0), persistentHits(0), misses(0),
+      stores(0), evictions(0), expirations(0) {
+    memset(entries, 0, sizeof(entries));
+    lock = xSemaphoreCreateMutex();
+}
+
+// 析构函数
+LLMResponseCache::~LLMResponseCache() {
+    while (entryCount > 0) {
+        removeAt(entryCount - 1);
+    }
+    vSemaphoreDelete(lock);
+}
+
+// 更新缓存配置
+void LLMResponseCache::configure(bool newEnabled, unsigned long newTtlSeconds, size_t newMaxEntries, size_t newMaxBytes,
+                                 bool newPersist, size_t newPersistSlots) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    enabled = newEnabled;
+    ttlSeconds = newTtlSeconds;
+    maxEntries = (newMaxEntries < MAX_ENTRIES) ? newMaxEntries : MAX_ENTRIES;
+    maxBytes = newMaxBytes;
+    persist = newEnabled && newPersist && newPersistSlots > 0;
+    persistSlots = newPersistSlots;
+
+    // 关闭或缩小容量后，超出的条目立即释放
+    while (entryCount > 0 && (!enabled || entryCount > maxEntries || usedBytes > maxBytes)) {
+        evictLeastRecentlyUsed();
+    }
+    xSemaphoreGive(lock);
+
+    if (persist) {
+        if (!LittleFS.exists(CACHE_DIR)) {
+            LittleFS.mkdir(CACHE_DIR);
+        }
+        // 持久层的 TTL 以系统时间计算，需要 SNTP 同步（连上 WiFi 后在后台完成）
+        configTime(0, 0, "pool.ntp.org", "time.cloudflare.com");
+    }
+    LOG_I("CACHE", "%s, TTL %lu s, %u entries / %u bytes in PSRAM, persistent: %s",
+          enabled ? "Enabled" : "Disabled", ttlSeconds, (unsigned)maxEntries, (unsigned)maxBytes,
+          persist ? "on" : "off");
+}
+
+// 查找缓存
+bool LLMResponseCache::get(uint64_t key, String& content) {
+    if (!enabled) return false;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    LLMCacheEntry* entry = find(key);
+    // 按秒比较：ttlSeconds * 1000 在 32 位下约 49 天就会溢出
+    if (entry && (millis() - entry->storedAt) / 1000UL >= ttlSeconds) {
+        expirations++;
+        removeAt(entry - entries);
+        entry = nullptr;
+    }
+    if (entry) {
+        entry->lastUsed = millis();
+        content = String(entry->content);
+        memoryHits++;
+        xSemaphoreGive(lock);
+        return true;
+    }
+
+    bool hit = persist && readPersistent(key, content);
+    if (hit) {
+        persistentHits++;
+        // 提升到 PSRAM 层，下次命中不再读 Flash（TTL 从此刻重新计算）
+        insert(key, content.c_str(), content.length(), millis());
+    } else {
+        misses++;
+    }
+    xSemaphoreGive(lock);
+    return hit;
+}
+
+// 写入缓存
+void LLMResponseCache::put(uint64_t key, const String& content) {
+    if (!enabled || content.length() == 0 || content.length() > MAX_ENTRY_BYTES) return;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    insert(key, content.c_str(), content.length(), millis());
+    if (persist) {
+        writePersistent(key, content);
+    }
+    stores++;
+    xSemaphoreGive(lock);
+}
+
+// 清空两层缓存
+void LLMResponseCache::clear() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    while (entryCount > 0) {
+        removeAt(entryCount - 1);
+    }
+    if (persist) {
+        for (size_t slot = 0; slot < persistSlots; slot++) {
+            String path = String(CACHE_DIR) + "/" + String(slot) + ".bin";
+            if (LittleFS.exists(path)) {
+                LittleFS.remove(path);
+            }
+        }
+    }
+    xSemaphoreGive(lock);
+    LOG_I("CACHE", "Cleared");
+}
+
+// 以 JSON 输出配置和命中统计
+void LLMResponseCache::writeStats(JsonObject out) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    out["enabled"] = enabled;
+    out["persistent"] = persist;
+    out["ttl_s"] = ttlSeconds;
+    out["entries"] = entryCount;
+    out["max_entries"] = maxEntries;
+    out["bytes"] = usedBytes;
+    out["max_bytes"] = maxBytes;
+    out["memory_hits"] = memoryHits;
+    out["persistent_hits"] = persistentHits;
+    out["misses"] = misses;
+    out["stores"] = stores;
+    out["evictions"] = evictions;
+    out["expirations"] = expirations;
+    uint32_t lookups = memoryHits + persistentHits + misses;
+    out["hit_ratio"] = lookups ? (float)(memoryHits + persistentHits) / lookups : 0.0f;
+    xSemaphoreGive(lock);
+}
+
+// 64 位 FNV-1a
+uint64_t LLMResponseCache::hashBytes(uint64_t hash, const void* data, size_t length) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// 规范化文本后加入哈希：去掉首尾空白，连续空白视为一个空格
+uint64_t LLMResponseCache::hashNormalized(uint64_t hash, const char* text) {
+    const uint8_t space = ' ';
+    const uint8_t separator = 0x1f; // 单元分隔符，防止 "ab"+"c" 与 "a"+"bc" 冲突
+    bool pendingSpace = false;
+    bool started = false;
+    for (const char* p = text; *p; p++) {
+        if (isspace((unsigned char)*p)) {
+            pendingSpace = started;
+            continue;
+        }
+        if (pendingSpace) {
+            hash = hashBytes(hash, &space, 1);
+            pendingSpace = false;
+        }
+        hash = hashBytes(hash, p, 1);
+        started = true;
+    }
+    return hashBytes(hash, &separator, 1);
+}
+
+// 查找条目（调用方需持有锁）
+LLMCacheEntry* LLMResponseCache::find(uint64_t key) {
+    for (size_t i = 0; i < entryCount; i++) {
+        if (entries[i].key == key) {
+            return &entries[i];
+        }
+    }
+    return nullptr;
+}
+
+// 删除指定位置的条目，用最后一项填补空位（调用方需持有锁）
+void LLMResponseCache::removeAt(size_t index) {
+    usedBytes -= entries[index].length;
+    free(entries[index].content);
+    entries[index] = entries[entryCount - 1];
+    memset(&entries[entryCount - 1], 0, sizeof(LLMCacheEntry));
+    entryCount--;
+}
+
+// 淘汰最近最少使用的条目（调用方需持有锁）
+bool LLMResponseCache::evictLeastRecentlyUsed() {
+    if (entryCount == 0) return false;
+    size_t victim = 0;
+    for (size_t i = 1; i < entryCount; i++) {
+        if (entries[i].lastUsed < entries[victim].lastUsed) {
+            victim = i;
+        }
+    }
+    removeAt(victim);
+    evictions++;
+    return true;
+}
+
+// 放入 PSRAM 层（调用方需持有锁）
+void LLMResponseCache::insert(uint64_t key, const char* content, size_t length, unsigned long storedAt) {
+    LLMCacheEntry* existing = find(key);
+    if (existing) {
+        removeAt(existing - entries);
+    }
+    if (maxEntries == 0 || length > maxBytes) return;
+
+    while (entryCount >= maxEntries || usedBytes + length > maxBytes) {
+        if (!evictLeastRecentlyUsed()) break;
+    }
+
+    char* copy = (char*)ps_malloc(length + 1);
+    if (!copy) {
+        LOG_E("CACHE", "PSRAM allocation failed, entry not cached");
+        return;
+    }
+    memcpy(copy, content, length);
+    copy[length] = '\0';
+
+    LLMCacheEntry& entry = entries[entryCount++];
+    entry.key = key;
+    entry.content = copy;
+    entry.length = length;
+    entry.storedAt = storedAt;
+    entry.lastUsed = millis();
+    usedBytes += length;
+}
+
+// LittleFS 层的文件路径：按键取模直接映射到固定数量的槽位
+String LLMResponseCache::slotPath(uint64_t key) const {
+    return String(CACHE_DIR) + "/" + String((uint32_t)(key % persistSlots)) + ".bin";
+}
+
+// 从 LittleFS 层读取条目（调用方需持有锁）
+bool LLMResponseCache::readPersistent(uint64_t key, String& content) {
+    time_t now = time(nullptr);
+    if (now < MIN_VALID_EPOCH) {
+        return false; // 系统时间未同步，无法判断条目是否过期
+    }
+
+    String path = slotPath(key);
+    if (!LittleFS.exists(path)) {
+        return false;
+    }
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        return false;
+    }
+
+    LLMCacheFileHeader header;
+    bool valid = file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+                 header.magic == CACHE_FILE_MAGIC && header.key == key && header.length <= MAX_ENTRY_BYTES;
+    // 系统时间回拨时差值按无符号回绕成很大的数，条目视为过期
+    if (valid && (uint32_t)now - header.storedAt >= ttlSeconds) {
+        expirations++;
+        valid = false;
+    }
+    if (valid && !content.reserve(header.length)) {
+        valid = false;
+    }
+    if (valid) {
+        content = "";
+        char buffer[256];
+        size_t remaining = header.length;
+        while (remaining > 0) {
+            size_t n = file.read((uint8_t*)buffer, (remaining < sizeof(buffer)) ? remaining : sizeof(buffer));
+            if (n == 0) break;
+            content.concat(buffer, n);
+            remaining -= n;
+        }
+        valid = (remaining == 0);
+    }
+    file.close();
+    return valid;
+}
+
+// 写入 LittleFS 层（调用方需持有锁）
+void LLMResponseCache::writePersistent(uint64_t key, const String& content) {
+    time_t now = time(nullptr);
+    if (now < MIN_VALID_EPOCH) {
+        return;
+    }
+
+    File file = LittleFS.open(slotPath(key), "w");
+    if (!file) {
+        LOG_E("CACHE", "Failed to open cache file for writing");
+        return;
+    }
+    LLMCacheFileHeader header = {CACHE_FILE_MAGIC, (uint32_t)content.length(), key, (uint32_t)now};
+    file.write((const uint8_t*)&header, sizeof(header));
+    file.write((const uint8_t*)content.c_str(), content.length());
+    file.close();
+}
@@ -0,0 +1,166 @@
+#include "llm_session_table.h"
+#include "logger.h"
+
+// 新建会话后 PSRAM 至少要保留的余量（留给请求、响应和其他模块）
+const size_t PSRAM_RESERVE = 512 * 1024;
+
+// 构造函数
+LLMSessionTable::LLMSessionTable(size_t maxSessions, size_t historyBytes, size_t maxMessages)
+    : count(0), maxSessions(maxSessions < MAX_SESSIONS_LIMIT ? maxSessions : MAX_SESSIONS_LIMIT), historyBytes(historyBytes),
+      maxMessages(maxMessages) {
+    memset(sessions, 0, sizeof(sessions));
+    lock = xSemaphoreCreateMutex();
+}
+
+// 析构函数
+LLMSessionTable::~LLMSessionTable() {
+    while (count > 0) {
+        removeAt(count - 1);
+    }
+    vSemaphoreDelete(lock);
+}
+
+// 更新会话上限和内存上限
+void LLMSessionTable::configure(size_t newMaxSessions, size_t newHistoryBytes) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    maxSessions = (newMaxSessions < MAX_SESSIONS_LIMIT) ? newMaxSessions : MAX_SESSIONS_LIMIT;
+    if (maxSessions == 0) maxSessions = 1;
+    historyBytes = newHistoryBytes;
+    while (count > maxSessions && evictLeastRecentlyUsed()) {
+    }
+    xSemaphoreGive(lock);
+}
+
+// 查找会话（调用方需持有锁）
+LLMSession* LLMSessionTable::find(const char* key) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(sessions[i].key, key) == 0) {
+            return &sessions[i];
+        }
+    }
+    return nullptr;
+}
+
+// 删除指定位置的会话，用最后一项填补空位
+void LLMSessionTable::removeAt(size_t index) {
+    delete sessions[index].history;
+    sessions[index] = sessions[count - 1];
+    memset(&sessions[count - 1], 0, sizeof(LLMSession));
+    count--;
+}
+
+// 淘汰最近最少使用的空闲会话
+bool LLMSessionTable::evictLeastRecentlyUsed() {
+    size_t victim = count;
+    for (size_t i = 0; i < count; i++) {
+        if (sessions[i].busy) continue;
+        if (victim == count || sessions[i].lastUsed < sessions[victim].lastUsed) {
+            victim = i;
+        }
+    }
+    if (victim == count) {
+        return false;
+    }
+    LOG_I("SESSION", "Evicting session %s", sessions[victim].key);
+    removeAt(victim);
+    return true;
+}
+
+// 获取会话的对话历史，不存在时新建
+ConversationHistory* LLMSessionTable::acquire(const char* key) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+
+    LLMSession* session = find(key);
+    if (!session) {
+        // 会话数已满，或新会话的内存区会让 PSRAM 余量不足时，淘汰最久未用的会话
+        size_t needed = historyBytes + maxMessages * sizeof(ConversationMessage) + PSRAM_RESERVE;
+        while (count >= maxSessions ||
+               (count > 0 && heap_caps_get_free_size(MALLOC_CAP_SPIRAM) < needed)) {
+            if (!evictLeastRecentlyUsed()) break;
+        }
+        if (count >= maxSessions) {
+            xSemaphoreGive(lock);
+            LOG_W("SESSION", "No free slot for session %s", key);
+            return nullptr;
+        }
+
+        ConversationHistory* history = new ConversationHistory(maxMessages, historyBytes);
+        if (!history || history->getArenaSize() == 0) {
+            delete history;
+            xSemaphoreGive(lock);
+            LOG_E("SESSION", "Failed to allocate history for session %s", key);
+            return nullptr;
+        }
+
+        session = &sessions[count++];
+        memset(session, 0, sizeof(LLMSession));
+        strncpy(session->key, key, sizeof(session->key) - 1);
+        session->history = history;
+        LOG_I("SESSION", "Created session %s (%u/%u)", key, (unsigned)count, (unsigned)maxSessions);
+    }
+
+    session->busy = true;
+    session->lastUsed = millis();
+    ConversationHistory* history = session->history;
+    xSemaphoreGive(lock);
+    return history;
+}
+
+// 结束使用会话
+void LLMSessionTable::release(const char* key) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    LLMSession* session = find(key);
+    if (session) {
+        session->busy = false;
+        session->lastUsed = millis();
+        if (session->pendingRemove) {
+            removeAt(session - sessions);
+        } else if (session->pendingClear) {
+            session->history->clear();
+            session->pendingClear = false;
+        }
+    }
+    xSemaphoreGive(lock);
+}
+
+// 清空会话的对话历史
+void LLMSessionTable::clear(const char* key) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    LLMSession* session = find(key);
+    if (session) {
+        if (session->busy) {
+            session->pendingClear = true;
+        } else {
+            session->history->clear();
+        }
+    }
+    xSemaphoreGive(lock);
+}
+
+// 删除会话
+void LLMSessionTable::remove(const char* key) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    LLMSession* session = find(key);
+    if (session) {
+        if (session->busy) {
+            session->pendingRemove = true;
+        } else {
+            removeAt(session - sessions);
+            LOG_I("SESSION", "Removed session %s", key);
+        }
+    }
+    xSemaphoreGive(lock);
+}
+
+// 清空所有会话的对话历史
+void LLMSessionTable::clearAll() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (size_t i = 0; i < count; i++) {
+        if (sessions[i].busy) {
+            sessions[i].pendingClear = true;
+        } else {
+            sessions[i].history->clear();
+        }
+    }
+    xSemaphoreGive(lock);
+}
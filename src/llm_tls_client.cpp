@@ -0,0 +1,530 @@
+#include "llm_tls_client.h"
+#include "logger.h"
+#include <WiFi.h>
+#include <lwip/sockets.h>
+#include <lwip/netdb.h>
+#include <errno.h>
+
+// 可持久化到 NVS 的最大会话长度（含服务器证书时约 2~3KB；NVS 分区只有 20KB，超出则仅缓存在内存中）
+const size_t MAX_PERSISTED_SESSION = 3072;
+// 同一主机两次写入 NVS 的最小间隔，服务器每次恢复都可能下发新的 ticket，避免频繁擦写 Flash
+const unsigned long SESSION_PERSIST_INTERVAL = 600000; // 10分钟
+// 未指定时的连接/握手超时
+const int32_t DEFAULT_TLS_TIMEOUT = 5000;
+
+// ==================== LLMTlsSessionCache 类实现 ====================
+
+#ifndef MBEDTLS_PRIVATE
+#define MBEDTLS_PRIVATE(member) member // mbedTLS 2.x 的会话字段是公开的
+#endif
+
+// 会话指纹：主密钥的 64 位 FNV-1a 哈希。
+// 简化握手沿用原会话的主密钥，完整握手总会协商出新的主密钥；
+// Session ID 不能用来判断，因为提供 Session Ticket 时客户端每次都会生成新的随机 ID
+static uint64_t fingerprintOf(const mbedtls_ssl_session& session) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < sizeof(session.MBEDTLS_PRIVATE(master)); i++) {
+        hash ^= session.MBEDTLS_PRIVATE(master)[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// 构造函数
+LLMTlsSessionCache::LLMTlsSessionCache()
+    : count(0), prefsOpen(false), fullHandshakes(0), resumedHandshakes(0),
+      fullHandshakeMsTotal(0), resumedHandshakeMsTotal(0) {
+    memset(entries, 0, sizeof(entries));
+    lock = xSemaphoreCreateMutex();
+}
+
+// 析构函数
+LLMTlsSessionCache::~LLMTlsSessionCache() {
+    for (size_t i = 0; i < count; i++) {
+        if (entries[i].blob) {
+            free(entries[i].blob);
+            entries[i].blob = nullptr;
+        }
+    }
+    if (prefsOpen) {
+        prefs.end();
+    }
+    vSemaphoreDelete(lock);
+}
+
+// 打开 NVS 命名空间
+void LLMTlsSessionCache::begin() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (!prefsOpen) {
+        prefsOpen = prefs.begin("llm_tls", false);
+        if (!prefsOpen) {
+            LOG_E("TLS", "Failed to open NVS namespace, sessions will not survive reboot");
+        }
+    }
+    xSemaphoreGive(lock);
+}
+
+// NVS 键名最长15个字符，使用主机名的 FNV-1a 哈希
+void LLMTlsSessionCache::nvsKeyFor(const char* host, char* key, size_t keySize) {
+    uint32_t hash = 2166136261u;
+    for (const char* p = host; *p; p++) {
+        hash ^= (uint8_t)*p;
+        hash *= 16777619u;
+    }
+    snprintf(key, keySize, "s%08x", hash);
+}
+
+// 查找或创建缓存项（调用方需持有锁）
+LLMTlsSessionCache::Entry* LLMTlsSessionCache::findOrCreate(const char* host) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(entries[i].host, host) == 0) {
+            return &entries[i];
+        }
+    }
+    if (count >= MAX_ENTRIES) {
+        return nullptr;
+    }
+    Entry* entry = &entries[count++];
+    memset(entry, 0, sizeof(Entry));
+    strncpy(entry->host, host, sizeof(entry->host) - 1);
+    return entry;
+}
+
+// 将缓存的会话设置到 SSL 上下文中
+bool LLMTlsSessionCache::apply(const char* host, mbedtls_ssl_context* ssl, uint64_t* fingerprint) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    Entry* entry = findOrCreate(host);
+    if (!entry) {
+        xSemaphoreGive(lock);
+        return false;
+    }
+
+    // 首次使用该主机时尝试从 NVS 加载（重启后恢复会话）
+    if (!entry->loaded) {
+        entry->loaded = true;
+        char key[16];
+        nvsKeyFor(host, key, sizeof(key));
+        if (prefsOpen && prefs.isKey(key)) {
+            size_t length = prefs.getBytesLength(key);
+            uint8_t* blob = (length > 0 && length <= MAX_PERSISTED_SESSION) ? (uint8_t*)ps_malloc(length) : nullptr;
+            if (blob && prefs.getBytes(key, blob, length) == length) {
+                entry->blob = blob;
+                entry->length = length;
+                entry->persisted = true;
+                LOG_I("TLS", "Loaded %u byte session for %s from NVS", length, host);
+            } else if (blob) {
+                free(blob);
+            }
+        }
+    }
+
+    bool applied = false;
+    if (entry->blob) {
+        mbedtls_ssl_session session;
+        mbedtls_ssl_session_init(&session);
+        if (mbedtls_ssl_session_load(&session, entry->blob, entry->length) == 0 &&
+            mbedtls_ssl_set_session(ssl, &session) == 0) {
+            applied = true;
+            if (fingerprint) {
+                *fingerprint = fingerprintOf(session);
+            }
+        } else {
+            // 会话格式不兼容（例如固件升级后 mbedTLS 配置变化），丢弃
+            LOG_W("TLS", "Discarding unusable cached session for %s", host);
+            free(entry->blob);
+            entry->blob = nullptr;
+            entry->length = 0;
+        }
+        mbedtls_ssl_session_free(&session);
+    }
+
+    xSemaphoreGive(lock);
+    return applied;
+}
+
+// 已完成握手的连接当前会话的指纹
+uint64_t LLMTlsSessionCache::sessionFingerprint(mbedtls_ssl_context* ssl) {
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    uint64_t fingerprint = (mbedtls_ssl_get_session(ssl, &session) == 0) ? fingerprintOf(session) : 0;
+    mbedtls_ssl_session_free(&session);
+    return fingerprint;
+}
+
+// 握手完成后保存会话
+void LLMTlsSessionCache::save(const char* host, mbedtls_ssl_context* ssl) {
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    if (mbedtls_ssl_get_session(ssl, &session) != 0) {
+        mbedtls_ssl_session_free(&session);
+        return;
+    }
+
+    // 先查询序列化长度，再分配 PSRAM 缓冲区
+    size_t length = 0;
+    mbedtls_ssl_session_save(&session, nullptr, 0, &length);
+    uint8_t* blob = (length > 0) ? (uint8_t*)ps_malloc(length) : nullptr;
+    if (!blob || mbedtls_ssl_session_save(&session, blob, length, &length) != 0) {
+        if (blob) free(blob);
+        mbedtls_ssl_session_free(&session);
+        return;
+    }
+    mbedtls_ssl_session_free(&session);
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    Entry* entry = findOrCreate(host);
+    if (!entry) {
+        xSemaphoreGive(lock);
+        free(blob);
+        return;
+    }
+    entry->loaded = true;
+
+    bool changed = !(entry->blob && entry->length == length && memcmp(entry->blob, blob, length) == 0);
+    if (!changed) {
+        free(blob);
+    } else {
+        if (entry->blob) free(entry->blob);
+        entry->blob = blob;
+        entry->length = length;
+
+        if (prefsOpen && length <= MAX_PERSISTED_SESSION &&
+            (!entry->persisted || millis() - entry->lastPersisted >= SESSION_PERSIST_INTERVAL)) {
+            char key[16];
+            nvsKeyFor(host, key, sizeof(key));
+            if (prefs.putBytes(key, blob, length) == length) {
+                entry->persisted = true;
+                entry->lastPersisted = millis();
+                LOG_I("TLS", "Persisted %u byte session for %s", length, host);
+            }
+        } else if (length > MAX_PERSISTED_SESSION) {
+            LOG_I("TLS", "Session for %s is %u bytes, keeping it in RAM only", host, length);
+        }
+    }
+    xSemaphoreGive(lock);
+}
+
+// 丢弃某主机的会话
+void LLMTlsSessionCache::forget(const char* host) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    Entry* entry = findOrCreate(host);
+    if (entry) {
+        if (entry->blob) {
+            free(entry->blob);
+            entry->blob = nullptr;
+        }
+        entry->length = 0;
+        if (entry->persisted && prefsOpen) {
+            char key[16];
+            nvsKeyFor(host, key, sizeof(key));
+            prefs.remove(key);
+        }
+        entry->persisted = false;
+    }
+    xSemaphoreGive(lock);
+}
+
+// 记录一次握手耗时
+void LLMTlsSessionCache::recordHandshake(bool resumed, unsigned long durationMs) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (resumed) {
+        resumedHandshakes++;
+        resumedHandshakeMsTotal += durationMs;
+    } else {
+        fullHandshakes++;
+        fullHandshakeMsTotal += durationMs;
+    }
+    xSemaphoreGive(lock);
+}
+
+unsigned long LLMTlsSessionCache::getAvgFullHandshakeMs() const {
+    return fullHandshakes ? fullHandshakeMsTotal / fullHandshakes : 0;
+}
+
+unsigned long LLMTlsSessionCache::getAvgResumedHandshakeMs() const {
+    return resumedHandshakes ? resumedHandshakeMsTotal / resumedHandshakes : 0;
+}
+
+// ==================== LLMTlsClient 类实现 ====================
+
+// 构造函数
+LLMTlsClient::LLMTlsClient(LLMTlsSessionCache* cache)
+    : sessionCache(cache), contextReady(false), isConnected(false), peekedByte(-1),
+      timeoutMs(DEFAULT_TLS_TIMEOUT), lastHandshakeMs(0), lastHandshakeResumed(false),
+      lastDnsMicros(0), lastConnectMicros(0) {
+    mbedtls_net_init(&net);
+}
+
+// 析构函数
+LLMTlsClient::~LLMTlsClient() {
+    stop();
+}
+
+int LLMTlsClient::connect(IPAddress ip, uint16_t port) {
+    return connect(ip, port, DEFAULT_TLS_TIMEOUT);
+}
+
+int LLMTlsClient::connect(IPAddress ip, uint16_t port, int32_t timeout) {
+    String host = ip.toString();
+    lastDnsMicros = 0;
+    return connectTls(ip, host.c_str(), port, timeout, true);
+}
+
+int LLMTlsClient::connect(const char* host, uint16_t port) {
+    return connect(host, port, DEFAULT_TLS_TIMEOUT);
+}
+
+int LLMTlsClient::connect(const char* host, uint16_t port, int32_t timeout) {
+    IPAddress ip;
+    unsigned long dnsStart = micros();
+    if (!WiFi.hostByName(host, ip)) {
+        LOG_E("TLS", "DNS lookup failed for %s", host);
+        return 0;
+    }
+    lastDnsMicros = micros() - dnsStart;
+    return connectTls(ip, host, port, timeout, true);
+}
+
+// 建立 TCP 连接并完成 TLS 握手
+int LLMTlsClient::connectTls(IPAddress ip, const char* host, uint16_t port, int32_t timeout, bool allowResume) {
+    stop();
+    if (timeout <= 0) {
+        timeout = DEFAULT_TLS_TIMEOUT;
+    }
+
+    // 1. 非阻塞 TCP 连接，带超时
+    int sock = lwip_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0) {
+        LOG_E("TLS", "socket() failed: %d", errno);
+        return 0;
+    }
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = (uint32_t)ip;
+    addr.sin_port = htons(port);
+
+    unsigned long connectStart = micros();
+    int res = lwip_connect(sock, (struct sockaddr*)&addr, sizeof(addr));
+    if (res < 0 && errno != EINPROGRESS) {
+        LOG_E("TLS", "connect() to %s failed: %d", host, errno);
+        lwip_close(sock);
+        return 0;
+    }
+
+    fd_set fdset;
+    FD_ZERO(&fdset);
+    FD_SET(sock, &fdset);
+    struct timeval tv;
+    tv.tv_sec = timeout / 1000;
+    tv.tv_usec = (timeout % 1000) * 1000;
+    res = lwip_select(sock + 1, nullptr, &fdset, nullptr, &tv);
+    int sockErr = 0;
+    socklen_t errLen = sizeof(sockErr);
+    if (res <= 0 || lwip_getsockopt(sock, SOL_SOCKET, SO_ERROR, &sockErr, &errLen) < 0 || sockErr != 0) {
+        LOG_E("TLS", "connect() to %s timed out or failed: %d", host, sockErr);
+        lwip_close(sock);
+        return 0;
+    }
+
+    lastConnectMicros = micros() - connectStart;
+
+    // 请求体和 SSE 事件都是小包，关闭 Nagle 降低延迟
+    int one = 1;
+    lwip_setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    net.fd = sock;
+
+    // 2. 初始化 mbedTLS 上下文
+    mbedtls_ssl_init(&ssl);
+    mbedtls_ssl_config_init(&conf);
+    mbedtls_ctr_drbg_init(&drbg);
+    mbedtls_entropy_init(&entropy);
+    contextReady = true;
+
+    int ret = mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, (const unsigned char*)"noox-llm", 8);
+    if (ret == 0) {
+        ret = mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    }
+    if (ret == 0) {
+        mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_NONE); // 与 setInsecure() 一致，跳过证书验证
+        mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &drbg);
+        ret = mbedtls_ssl_setup(&ssl, &conf);
+    }
+    if (ret == 0) {
+        ret = mbedtls_ssl_set_hostname(&ssl, host);
+    }
+    if (ret != 0) {
+        LOG_E("TLS", "mbedTLS setup failed: -0x%04x", -ret);
+        cleanup();
+        return 0;
+    }
+    mbedtls_ssl_set_bio(&ssl, &net, mbedtls_net_send, mbedtls_net_recv, nullptr);
+
+    // 3. 提供缓存的会话，服务器接受时只需简化握手
+    uint64_t offeredFingerprint = 0;
+    bool offered = allowResume && sessionCache && sessionCache->apply(host, &ssl, &offeredFingerprint);
+
+    unsigned long handshakeStart = millis();
+    while ((ret = mbedtls_ssl_handshake(&ssl)) != 0) {
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            break;
+        }
+        if (millis() - handshakeStart > (unsigned long)timeout) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(2));
+    }
+
+    if (ret != 0) {
+        LOG_E("TLS", "Handshake with %s failed: -0x%04x", host, -ret);
+        cleanup();
+        if (offered) {
+            // 服务器可能不再接受该会话，丢弃后以完整握手重试一次
+            sessionCache->forget(host);
+            return connectTls(ip, host, port, timeout, false);
+        }
+        return 0;
+    }
+
+    lastHandshakeMs = millis() - handshakeStart;
+    // 服务器拒绝会话时 mbedTLS 会直接改为完整握手，只有主密钥不变才算恢复
+    bool resumed = offered && LLMTlsSessionCache::sessionFingerprint(&ssl) == offeredFingerprint;
+    if (offered && !resumed) {
+        LOG_I("TLS", "%s declined the cached session", host);
+    }
+    lastHandshakeResumed = resumed;
+    isConnected = true;
+    LOG_I("TLS", "Handshake with %s: %lu ms (%s)", host, lastHandshakeMs, resumed ? "resumed" : "full");
+
+    if (sessionCache) {
+        sessionCache->recordHandshake(resumed, lastHandshakeMs);
+        sessionCache->save(host, &ssl);
+    }
+    return 1;
+}
+
+size_t LLMTlsClient::write(uint8_t data) {
+    return write(&data, 1);
+}
+
+size_t LLMTlsClient::write(const uint8_t* buf, size_t size) {
+    if (!isConnected) return 0;
+
+    size_t written = 0;
+    unsigned long lastProgress = millis();
+    while (written < size) {
+        int ret = mbedtls_ssl_write(&ssl, buf + written, size - written);
+        if (ret > 0) {
+            written += ret;
+            lastProgress = millis();
+            continue;
+        }
+        if ((ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) ||
+            millis() - lastProgress > timeoutMs) {
+            LOG_E("TLS", "Write failed: -0x%04x", -ret);
+            stop();
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    return written;
+}
+
+int LLMTlsClient::available() {
+    int peeked = (peekedByte >= 0) ? 1 : 0;
+    if (!isConnected) return peeked;
+
+    // 读取 0 字节以驱动 mbedTLS 处理已到达的记录
+    int ret = mbedtls_ssl_read(&ssl, nullptr, 0);
+    int pending = mbedtls_ssl_get_bytes_avail(&ssl);
+    if (pending == 0 && ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+        // 对端关闭（close_notify 或 FIN）或连接出错
+        stop();
+    }
+    return pending + peeked;
+}
+
+int LLMTlsClient::read() {
+    uint8_t data = 0;
+    int res = read(&data, 1);
+    return (res == 1) ? data : -1;
+}
+
+int LLMTlsClient::read(uint8_t* buf, size_t size) {
+    if (size == 0) return 0;
+
+    int offset = 0;
+    if (peekedByte >= 0) {
+        buf[0] = (uint8_t)peekedByte;
+        peekedByte = -1;
+        offset = 1;
+        if (size == 1) return 1;
+    }
+    if (!isConnected) return offset ? offset : -1;
+
+    int ret = mbedtls_ssl_read(&ssl, buf + offset, size - offset);
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        return offset ? offset : -1;
+    }
+    if (ret <= 0) {
+        stop();
+        return offset ? offset : -1;
+    }
+    return ret + offset;
+}
+
+int LLMTlsClient::peek() {
+    if (peekedByte < 0 && isConnected && available() > 0) {
+        uint8_t data = 0;
+        if (read(&data, 1) == 1) {
+            peekedByte = data;
+        }
+    }
+    return peekedByte;
+}
+
+// 与 WiFiClient 一致：丢弃接收缓冲区中尚未读取的数据
+void LLMTlsClient::flush() {
+    uint8_t discard[64];
+    while (available() > 0) {
+        if (read(discard, sizeof(discard)) <= 0) break;
+    }
+}
+
+void LLMTlsClient::stop() {
+    if (contextReady && isConnected) {
+        mbedtls_ssl_close_notify(&ssl);
+    }
+    cleanup();
+}
+
+uint8_t LLMTlsClient::connected() {
+    if (isConnected) {
+        available(); // 检测对端是否已关闭
+    }
+    return isConnected ? 1 : 0;
+}
+
+int LLMTlsClient::setTimeout(uint32_t seconds) {
+    timeoutMs = seconds * 1000;
+    Stream::setTimeout(timeoutMs);
+    return 0;
+}
+
+// 释放 socket 和 mbedTLS 上下文
+void LLMTlsClient::cleanup() {
+    if (net.fd >= 0) {
+        mbedtls_net_free(&net);
+    }
+    if (contextReady) {
+        mbedtls_ssl_free(&ssl);
+        mbedtls_ssl_config_free(&conf);
+        mbedtls_ctr_drbg_free(&drbg);
+        mbedtls_entropy_free(&entropy);
+        contextReady = false;
+    }
+    isConnected = false;
+    peekedByte = -1;
+}
@@ -0,0 +1,150 @@
+#include "llm_tool_batch.h"
+#include "logger.h"
+
+// 并行执行工具调用组的临时任务栈大小（HID 宏会逐个解析动作）
+const uint32_t TOOL_GROUP_STACK_SIZE = 6144;
+
+// 构造函数
+LLMToolBatch::LLMToolBatch(const LLMToolRegistry& registry, LLMToolContext& context)
+    : registry(registry), context(context), count(0), unrecorded(0) {
+}
+
+// 加入一个工具调用
+bool LLMToolBatch::add(const char* name, JsonObject args) {
+    if (count >= MAX_RESULTS) {
+        unrecorded++;
+        LOG_W("TOOL", "Too many tool calls, rejecting %s without a result", name);
+        return false;
+    }
+    LLMToolCallResult& call = calls[count++];
+    call.name = name;
+    call.args = args;
+    call.success = false;
+    call.message = "";
+    call.spec = registry.find(name);
+    if (count > MAX_CALLS) {
+        LOG_W("TOOL", "Too many tool calls, rejecting %s", name);
+        call.message = "Error: too many tool calls (max " + String((unsigned)MAX_CALLS) + " per reply)";
+    } else if (!call.spec) {
+        call.message = String("Error: LLM called an unknown tool: ") + name;
+    } else {
+        LLMToolRegistry::validate(*call.spec, args, call.message);
+    }
+    // 被拒绝的调用已带有错误信息，不再执行
+    call.done = call.message.length() > 0;
+    return !call.done;
+}
+
+// 按顺序执行某个资源上的全部调用
+void LLMToolBatch::runGroup(LLMToolResource resource) {
+    // 同一资源可能同时被其他工作任务的批次使用
+    registry.lockResource(resource);
+    for (size_t i = 0; i < count; i++) {
+        LLMToolCallResult& call = calls[i];
+        if (call.done || call.spec->resource != resource) {
+            continue;
+        }
+        call.success = call.spec->handler(context, call.args, call.message);
+        call.done = true;
+    }
+    registry.unlockResource(resource);
+}
+
+// 临时任务入口
+void LLMToolBatch::groupTask(void* parameter) {
+    GroupJob* job = (GroupJob*)parameter;
+    job->batch->runGroup(job->resource);
+    xSemaphoreGive(job->done);
+    vTaskDelete(NULL);
+}
+
+// 执行所有有效的调用
+void LLMToolBatch::execute() {
+    // 找出本轮用到的资源（按首次出现的顺序）
+    LLMToolResource resources[TOOL_RESOURCE_COUNT];
+    size_t resourceCount = 0;
+    for (size_t i = 0; i < count; i++) {
+        const LLMToolCallResult& call = calls[i];
+        if (call.done) continue;
+        bool seen = false;
+        for (size_t r = 0; r < resourceCount; r++) {
+            if (resources[r] == call.spec->resource) seen = true;
+        }
+        if (!seen) resources[resourceCount++] = call.spec->resource;
+    }
+
+    // 第二组起各在一个临时任务中执行，当前任务执行第一组
+    GroupJob jobs[TOOL_RESOURCE_COUNT];
+    size_t started = 0;
+    for (size_t r = 1; r < resourceCount; r++) {
+        GroupJob& job = jobs[started];
+        job.batch = this;
+        job.resource = resources[r];
+        job.done = xSemaphoreCreateBinary();
+        if (job.done &&
+            xTaskCreate(groupTask, "tool_group", TOOL_GROUP_STACK_SIZE, &job, uxTaskPriorityGet(NULL), NULL) == pdPASS) {
+            started++;
+        } else {
+            // 内存不足：这一组在当前任务中顺序执行
+            if (job.done) vSemaphoreDelete(job.done);
+            LOG_W("TOOL", "Could not start a parallel tool task, running inline");
+            runGroup(resources[r]);
+        }
+    }
+    if (resourceCount > 0) {
+        runGroup(resources[0]);
+    }
+    for (size_t j = 0; j < started; j++) {
+        xSemaphoreTake(jobs[j].done, portMAX_DELAY);
+        vSemaphoreDelete(jobs[j].done);
+    }
+}
+
+// 失败或被拒绝的调用数
+size_t LLMToolBatch::getFailureCount() const {
+    size_t failures = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!calls[i].success) failures++;
+    }
+    return failures + unrecorded;
+}
+
+// 以 JSON 数组输出结果
+void LLMToolBatch::writeResults(JsonArray out) const {
+    for (size_t i = 0; i < count; i++) {
+        const LLMToolCallResult& call = calls[i];
+        JsonObject result = out.add<JsonObject>();
+        result["name"] = call.name;
+        result["args"] = call.args;
+        result["ok"] = call.success;
+        result["result"] = call.message;
+    }
+    if (unrecorded > 0) {
+        JsonObject result = out.add<JsonObject>();
+        result["name"] = "";
+        result["ok"] = false;
+        result["result"] = "Error: too many tool calls (" + String((unsigned)unrecorded) + " more not recorded)";
+    }
+}
+
+// 生成给主机的结果摘要
+String LLMToolBatch::summarize() const {
+    String summary;
+    for (size_t i = 0; i < count; i++) {
+        const LLMToolCallResult& call = calls[i];
+        if (call.message.length() == 0) {
+            continue; // 例如已经发给主机执行的 Shell 命令
+        }
+        if (summary.length() > 0) {
+            summary += "\n";
+        }
+        if (count > 1) {
+            summary += call.success ? "[ok] " : "[failed] ";
+        }
+        summary += call.message;
+    }
+    if (unrecorded > 0) {
+        summary += "\n[failed] Error: too many tool calls (" + String((unsigned)unrecorded) + " more not recorded)";
+    }
+    return summary;
+}
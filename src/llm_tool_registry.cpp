@@ -0,0 +1,250 @@
+#include "llm_tool_registry.h"
+#include "logger.h"
+
+// 搜索无冲突哈希种子的最大尝试次数
+const uint32_t MAX_SEED_ATTEMPTS = 1024;
+
+// 构造函数
+LLMToolRegistry::LLMToolRegistry() : toolCount(0), seed(0), built(false) {
+    memset(tools, 0, sizeof(tools));
+    memset(table, 0, sizeof(table));
+    for (size_t r = 0; r < TOOL_RESOURCE_COUNT; r++) {
+        resourceLocks[r] = xSemaphoreCreateMutex();
+    }
+}
+
+// 析构函数
+LLMToolRegistry::~LLMToolRegistry() {
+    for (size_t r = 0; r < TOOL_RESOURCE_COUNT; r++) {
+        vSemaphoreDelete(resourceLocks[r]);
+    }
+}
+
+// 注册一个工具
+bool LLMToolRegistry::add(const LLMToolSpec* spec) {
+    if (toolCount >= MAX_TOOLS) {
+        LOG_W("TOOL", "Registry full, dropping %s", spec->name);
+        return false;
+    }
+    for (size_t i = 0; i < toolCount; i++) {
+        if (strcmp(tools[i]->name, spec->name) == 0) {
+            LOG_W("TOOL", "Duplicate tool %s", spec->name);
+            return false;
+        }
+    }
+    tools[toolCount++] = spec;
+    built = false;
+    return true;
+}
+
+// 带种子的 32 位 FNV-1a 哈希
+uint32_t LLMToolRegistry::hashName(const char* name, uint32_t seed) {
+    uint32_t hash = 2166136261UL ^ (seed * 0x9e3779b9UL);
+    for (; *name; name++) {
+        hash ^= (uint8_t)*name;
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+// 建立完美哈希表
+bool LLMToolRegistry::build() {
+    for (uint32_t candidate = 0; candidate < MAX_SEED_ATTEMPTS; candidate++) {
+        memset(table, 0, sizeof(table));
+        bool collision = false;
+        for (size_t i = 0; i < toolCount && !collision; i++) {
+            uint32_t slot = hashName(tools[i]->name, candidate) & (TABLE_SIZE - 1);
+            if (table[slot] != 0) {
+                collision = true;
+            } else {
+                table[slot] = i + 1;
+            }
+        }
+        if (!collision) {
+            seed = candidate;
+            built = true;
+            LOG_I("TOOL", "%u tools registered, hash seed %u", (unsigned)toolCount, seed);
+            return true;
+        }
+    }
+    LOG_W("TOOL", "No collision-free hash seed found, falling back to linear lookup");
+    built = false;
+    return false;
+}
+
+// 按名称查找工具
+const LLMToolSpec* LLMToolRegistry::find(const char* name) const {
+    if (!name || !*name) {
+        return nullptr;
+    }
+    if (built) {
+        uint8_t entry = table[hashName(name, seed) & (TABLE_SIZE - 1)];
+        if (entry != 0 && strcmp(tools[entry - 1]->name, name) == 0) {
+            return tools[entry - 1];
+        }
+        return nullptr;
+    }
+    for (size_t i = 0; i < toolCount; i++) {
+        if (strcmp(tools[i]->name, name) == 0) {
+            return tools[i];
+        }
+    }
+    return nullptr;
+}
+
+// 占用一个资源
+void LLMToolRegistry::lockResource(LLMToolResource resource) const {
+    xSemaphoreTake(resourceLocks[resource], portMAX_DELAY);
+}
+
+// 释放资源
+void LLMToolRegistry::unlockResource(LLMToolResource resource) const {
+    xSemaphoreGive(resourceLocks[resource]);
+}
+
+// 字符串是否在 '|' 分隔的可选值中
+static bool matchesEnum(const char* value, const char* enumValues) {
+    size_t valueLength = strlen(value);
+    const char* option = enumValues;
+    while (*option) {
+        const char* end = strchr(option, '|');
+        size_t optionLength = end ? (size_t)(end - option) : strlen(option);
+        if (optionLength == valueLength && strncmp(option, value, valueLength) == 0) {
+            return true;
+        }
+        if (!end) break;
+        option = end + 1;
+    }
+    return false;
+}
+
+// 按参数模式校验工具参数
+bool LLMToolRegistry::validate(const LLMToolSpec& spec, JsonObject args, String& error) {
+    for (uint8_t i = 0; i < spec.argCount; i++) {
+        const LLMToolArg& arg = spec.args[i];
+        JsonVariant value = args[arg.name];
+        if (value.isNull()) {
+            if (arg.required) {
+                error = String("Error: ") + spec.name + " requires '" + arg.name + "' parameter";
+                return false;
+            }
+            continue;
+        }
+
+        bool typeOk = false;
+        switch (arg.type) {
+            case TOOL_ARG_STRING: {
+                const char* text = value.as<const char*>();
+                typeOk = value.is<const char*>() && (!arg.required || *text);
+                if (typeOk && arg.enumValues && !matchesEnum(text, arg.enumValues)) {
+                    String options = arg.enumValues;
+                    options.replace("|", "' or '");
+                    error = String("Error: ") + spec.name + " " + arg.name + " must be '" + options + "', got: " + text;
+                    return false;
+                }
+                break;
+            }
+            case TOOL_ARG_INTEGER: typeOk = value.is<int>(); break;
+            case TOOL_ARG_BOOLEAN: typeOk = value.is<bool>(); break;
+            case TOOL_ARG_ARRAY: typeOk = value.is<JsonArray>(); break;
+        }
+        if (!typeOk) {
+            error = String("Error: ") + spec.name + " requires '" + arg.name + "' parameter of type " + typeName(arg.type);
+            return false;
+        }
+    }
+    return true;
+}
+
+// 参数类型在 JSON Schema 中的名称
+const char* LLMToolRegistry::typeName(LLMToolArgType type) {
+    switch (type) {
+        case TOOL_ARG_STRING: return "string";
+        case TOOL_ARG_INTEGER: return "integer";
+        case TOOL_ARG_BOOLEAN: return "boolean";
+        case TOOL_ARG_ARRAY: return "array";
+        default: return "string";
+    }
+}
+
+// 生成系统提示中的工具说明
+String LLMToolRegistry::renderPromptSection() const {
+    String section;
+    for (size_t i = 0; i < toolCount; i++) {
+        const LLMToolSpec& spec = *tools[i];
+        section += "## ";
+        section += spec.name;
+        section += "\n";
+        section += spec.description;
+        section += "\n";
+        if (spec.argCount > 0) {
+            section += "\n**Parameters**:\n";
+        }
+        for (uint8_t a = 0; a < spec.argCount; a++) {
+            const LLMToolArg& arg = spec.args[a];
+            section += "  - ";
+            section += arg.name;
+            section += ": ";
+            section += typeName(arg.type);
+            section += arg.required ? " (required)" : " (optional)";
+            if (arg.enumValues) {
+                String options = arg.enumValues;
+                options.replace("|", "\", \"");
+                section += " - one of \"" + options + "\"";
+            }
+            if (arg.description) {
+                section += " - ";
+                section += arg.description;
+            }
+            section += "\n";
+        }
+        if (i + 1 < toolCount) {
+            section += "\n";
+        }
+    }
+    return section;
+}
+
+// 生成 OpenAI 格式的 tools 数组
+void LLMToolRegistry::writeToolsSchema(JsonArray out) const {
+    for (size_t i = 0; i < toolCount; i++) {
+        const LLMToolSpec& spec = *tools[i];
+        JsonObject tool = out.add<JsonObject>();
+        tool["type"] = "function";
+        JsonObject function = tool["function"].to<JsonObject>();
+        function["name"] = spec.name;
+        function["description"] = spec.description;
+        JsonObject parameters = function["parameters"].to<JsonObject>();
+        parameters["type"] = "object";
+        JsonObject properties = parameters["properties"].to<JsonObject>();
+        JsonArray required;
+        for (uint8_t a = 0; a < spec.argCount; a++) {
+            const LLMToolArg& arg = spec.args[a];
+            JsonObject property = properties[arg.name].to<JsonObject>();
+            property["type"] = typeName(arg.type);
+            if (arg.type == TOOL_ARG_ARRAY) {
+                property["items"]["type"] = "object";
+            }
+            if (arg.enumValues) {
+                JsonArray options = property["enum"].to<JsonArray>();
+                String values = arg.enumValues;
+                int start = 0;
+                while (start <= (int)values.length()) {
+                    int end = values.indexOf('|', start);
+                    if (end < 0) end = values.length();
+                    options.add(values.substring(start, end));
+                    start = end + 1;
+                }
+            }
+            if (arg.description) {
+                property["description"] = arg.description;
+            }
+            if (arg.required) {
+                if (required.isNull()) {
+                    required = parameters["required"].to<JsonArray>();
+                }
+                required.add(arg.name);
+            }
+        }
+    }
+}
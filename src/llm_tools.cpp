@@ -0,0 +1,211 @@
+#include "llm_tools.h"
+#include "logger.h"
+#include "usb_shell_manager.h"
+#include "hid_manager.h"
+#include "hardware_manager.h"
+
+// ==================== sendtoshell ====================
+
+static const LLMToolArg SENDTOSHELL_ARGS[] = {
+    {"type", TOOL_ARG_STRING, true, "command|text", "\"command\" runs value on the host, \"text\" shows it to the user"},
+    {"value", TOOL_ARG_STRING, true, nullptr, "Command line or message text"},
+};
+
+// 在主机上执行命令，或向用户显示一条文本（随本轮的工具结果一起发送）
+static bool runSendToShell(LLMToolContext& context, JsonObject args, String& message) {
+    const char* type = args["type"];
+    String value = args["value"].as<String>();
+    if (strcmp(type, "command") == 0) {
+        LOG_I("TOOL", "LLM requested shell command: %s", value.c_str());
+        context.shell->sendShellCommandToHost(context.requestId, value);
+    } else {
+        LOG_I("TOOL", "LLM requested AI response: %s", value.c_str());
+        message = value;
+    }
+    return true;
+}
+
+static const LLMToolSpec SENDTOSHELL_TOOL = {
+    "sendtoshell",
+    "Run a shell command on the host computer (type=command) or show a status message to the user (type=text). "
+    "Use platform-appropriate, simple commands and do not assume the working directory or environment variables.",
+    SENDTOSHELL_ARGS, sizeof(SENDTOSHELL_ARGS) / sizeof(SENDTOSHELL_ARGS[0]), runSendToShell,
+    TOOL_RESOURCE_HOST
+};
+
+// ==================== HID 键盘 ====================
+
+// HID 是否可用
+static bool hidReady(LLMToolContext& context, String& message) {
+    if (context.hid && context.hid->isReady()) {
+        return true;
+    }
+    message = "Error: HID not available";
+    return false;
+}
+
+static const LLMToolArg KEYBOARD_TYPE_ARGS[] = {
+    {"text", TOOL_ARG_STRING, true, nullptr, "The text to type"},
+};
+
+// 输入文本字符串
+static bool runKeyboardType(LLMToolContext& context, JsonObject args, String& message) {
+    if (!hidReady(context, message)) return false;
+    String text = args["text"].as<String>();
+    LOG_I("TOOL", "LLM requested keyboard type: %s", text.c_str());
+    context.hid->sendString(text);
+    message = "Typed text: " + text;
+    return true;
+}
+
+static const LLMToolSpec KEYBOARD_TYPE_TOOL = {
+    "hid_keyboard_type",
+    "Type text on the host via the USB keyboard.",
+    KEYBOARD_TYPE_ARGS, sizeof(KEYBOARD_TYPE_ARGS) / sizeof(KEYBOARD_TYPE_ARGS[0]), runKeyboardType,
+    TOOL_RESOURCE_HID
+};
+
+static const LLMToolArg KEYBOARD_PRESS_ARGS[] = {
+    {"keys", TOOL_ARG_STRING, true, nullptr, "Key combination like \"Ctrl+C\", \"Alt+Tab\" or a special key like \"Enter\""},
+};
+
+// 处理组合键和特殊键
+static bool runKeyboardPress(LLMToolContext& context, JsonObject args, String& message) {
+    if (!hidReady(context, message)) return false;
+    String keys = args["keys"].as<String>();
+    LOG_I("TOOL", "LLM requested keyboard press: %s", keys.c_str());
+    if (!context.hid->pressKeyCombination(keys)) {
+        message = "Error: " + context.hid->getLastError();
+        return false;
+    }
+    message = "Pressed keys: " + keys;
+    return true;
+}
+
+static const LLMToolSpec KEYBOARD_PRESS_TOOL = {
+    "hid_keyboard_press",
+    "Press a key or key combination. Modifiers: Ctrl, Shift, Alt, Win (case-insensitive). "
+    "Special keys: F1-F12, Enter, Tab, Backspace, Escape, Home, End, PageUp, PageDown, Delete, arrow keys.",
+    KEYBOARD_PRESS_ARGS, sizeof(KEYBOARD_PRESS_ARGS) / sizeof(KEYBOARD_PRESS_ARGS[0]), runKeyboardPress,
+    TOOL_RESOURCE_HID
+};
+
+static const LLMToolArg KEYBOARD_MACRO_ARGS[] = {
+    {"actions", TOOL_ARG_ARRAY, true, nullptr,
+     "Actions run in order: {\"action\":\"type\",\"value\":text}, {\"action\":\"press\",\"key\":combo}, "
+     "{\"action\":\"delay\",\"ms\":n}, {\"action\":\"click\",\"button\":\"left|right|middle\"}, "
+     "{\"action\":\"move\",\"x\":dx,\"y\":dy}"},
+};
+
+// 处理宏操作
+static bool runKeyboardMacro(LLMToolContext& context, JsonObject args, String& message) {
+    if (!hidReady(context, message)) return false;
+    JsonArray actions = args["actions"];
+    LOG_I("TOOL", "LLM requested keyboard macro with %u actions", (unsigned)actions.size());
+    if (!context.hid->executeMacro(actions)) {
+        message = "Error: " + context.hid->getLastError();
+        return false;
+    }
+    message = "Executed macro with " + String(actions.size()) + " actions";
+    return true;
+}
+
+static const LLMToolSpec KEYBOARD_MACRO_TOOL = {
+    "hid_keyboard_macro",
+    "Run a sequence of keyboard/mouse actions on the host.",
+    KEYBOARD_MACRO_ARGS, sizeof(KEYBOARD_MACRO_ARGS) / sizeof(KEYBOARD_MACRO_ARGS[0]), runKeyboardMacro,
+    TOOL_RESOURCE_HID
+};
+
+// ==================== HID 鼠标 ====================
+
+static const LLMToolArg MOUSE_CLICK_ARGS[] = {
+    {"button", TOOL_ARG_STRING, false, "left|right|middle", "Defaults to left"},
+};
+
+// 处理鼠标点击
+static bool runMouseClick(LLMToolContext& context, JsonObject args, String& message) {
+    if (!hidReady(context, message)) return false;
+    String button = args["button"] | "left";
+    int buttonCode = MOUSE_BUTTON_LEFT;
+    if (button == "right") buttonCode = MOUSE_BUTTON_RIGHT;
+    else if (button == "middle") buttonCode = MOUSE_BUTTON_MIDDLE;
+
+    LOG_I("TOOL", "LLM requested mouse click: %s", button.c_str());
+    context.hid->clickMouse(buttonCode);
+    message = "Clicked mouse button: " + button;
+    return true;
+}
+
+static const LLMToolSpec MOUSE_CLICK_TOOL = {
+    "hid_mouse_click",
+    "Click a mouse button on the host.",
+    MOUSE_CLICK_ARGS, sizeof(MOUSE_CLICK_ARGS) / sizeof(MOUSE_CLICK_ARGS[0]), runMouseClick,
+    TOOL_RESOURCE_HID
+};
+
+static const LLMToolArg MOUSE_MOVE_ARGS[] = {
+    {"x", TOOL_ARG_INTEGER, true, nullptr, "Horizontal movement (positive = right)"},
+    {"y", TOOL_ARG_INTEGER, true, nullptr, "Vertical movement (positive = down)"},
+};
+
+// 处理鼠标移动
+static bool runMouseMove(LLMToolContext& context, JsonObject args, String& message) {
+    if (!hidReady(context, message)) return false;
+    int x = args["x"];
+    int y = args["y"];
+    LOG_I("TOOL", "LLM requested mouse move: x=%d, y=%d", x, y);
+    context.hid->moveMouse(x, y);
+    message = "Moved mouse by (" + String(x) + ", " + String(y) + ")";
+    return true;
+}
+
+static const LLMToolSpec MOUSE_MOVE_TOOL = {
+    "hid_mouse_move",
+    "Move the mouse cursor relative to its current position.",
+    MOUSE_MOVE_ARGS, sizeof(MOUSE_MOVE_ARGS) / sizeof(MOUSE_MOVE_ARGS[0]), runMouseMove,
+    TOOL_RESOURCE_HID
+};
+
+// ==================== GPIO ====================
+
+static const LLMToolArg GPIO_SET_ARGS[] = {
+    {"gpio", TOOL_ARG_STRING, true, nullptr, "led1, led2, led3 (onboard LEDs), gpio1 or gpio2; case-insensitive"},
+    {"state", TOOL_ARG_BOOLEAN, true, nullptr, "true = HIGH, false = LOW"},
+};
+
+// 设置 GPIO 输出状态
+static bool runGpioSet(LLMToolContext& context, JsonObject args, String& message) {
+    if (!context.hardware) {
+        message = "Error: Hardware manager not available";
+        return false;
+    }
+    String gpioName = args["gpio"].as<String>();
+    bool state = args["state"];
+    LOG_I("TOOL", "LLM requested gpio_set: %s = %s", gpioName.c_str(), state ? "HIGH" : "LOW");
+    if (!context.hardware->setGpioOutput(gpioName, state)) {
+        message = "Error: Invalid GPIO name: " + gpioName + ". Available: " + context.hardware->getAvailableGpios();
+        return false;
+    }
+    message = "GPIO " + gpioName + " set to " + (state ? "HIGH" : "LOW");
+    return true;
+}
+
+static const LLMToolSpec GPIO_SET_TOOL = {
+    "gpio_set",
+    "Set a GPIO output on the ESP32-S3 device (only output control is supported).",
+    GPIO_SET_ARGS, sizeof(GPIO_SET_ARGS) / sizeof(GPIO_SET_ARGS[0]), runGpioSet,
+    TOOL_RESOURCE_DEVICE
+};
+
+// 注册所有内置工具
+void registerBuiltinTools(LLMToolRegistry& registry) {
+    registry.add(&SENDTOSHELL_TOOL);
+    registry.add(&KEYBOARD_TYPE_TOOL);
+    registry.add(&KEYBOARD_PRESS_TOOL);
+    registry.add(&KEYBOARD_MACRO_TOOL);
+    registry.add(&MOUSE_CLICK_TOOL);
+    registry.add(&MOUSE_MOVE_TOOL);
+    registry.add(&GPIO_SET_TOOL);
+    registry.build();
+}
@@ -0,0 +1,158 @@
+#include "logger.h"
+#include <stdarg.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static const char LEVEL_CHARS[] = {'-', 'E', 'W', 'I', 'D'};
+
+// 获取日志实例
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+// 构造函数：缓冲区在 begin() 中分配，之前的日志同步写出
+Logger::Logger() : slots(nullptr), head(0), tail(0), level(LOG_LEVEL_INFO), reportedDrops(0) {
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    records = registry.counter("noox_log_records_total", "Log records queued");
+    dropped = registry.counter("noox_log_dropped_total", "Log records dropped because the ring buffer was full");
+    truncated = registry.counter("noox_log_truncated_total", "Log records truncated to the slot size");
+}
+
+// 分配环形缓冲区并启动写出任务
+void Logger::begin() {
+    if (slots) {
+        return;
+    }
+    Slot* buffer = (Slot*)ps_malloc(SLOT_COUNT * sizeof(Slot));
+    if (!buffer) {
+        Serial.println("[LOG] Failed to allocate log buffer, logging stays synchronous");
+        return;
+    }
+    for (size_t i = 0; i < SLOT_COUNT; i++) {
+        buffer[i].seq = i;
+    }
+    // 槽位初始化完成后再发布缓冲区，生产者看到指针时槽位已可用
+    __atomic_store_n(&slots, buffer, __ATOMIC_RELEASE);
+    // 写出任务优先级低于所有管理器任务，只在空闲时占用串口
+    xTaskCreatePinnedToCore(drainTask, "LogTask", 3072, this, 1, NULL, 0);
+    Serial.printf("[LOG] Async logging started (%u slots x %u bytes in PSRAM)\n",
+                  (unsigned)SLOT_COUNT, (unsigned)sizeof(Slot));
+}
+
+// 从配置设置运行期级别
+void Logger::setLevel(const char* name) {
+    LogLevel newLevel = LOG_LEVEL_INFO;
+    if (name) {
+        if (strcasecmp(name, "none") == 0) newLevel = LOG_LEVEL_NONE;
+        else if (strcasecmp(name, "error") == 0) newLevel = LOG_LEVEL_ERROR;
+        else if (strcasecmp(name, "warn") == 0) newLevel = LOG_LEVEL_WARN;
+        else if (strcasecmp(name, "debug") == 0) newLevel = LOG_LEVEL_DEBUG;
+    }
+    setLevel(newLevel);
+}
+
+// 写入一条日志
+void Logger::write(LogLevel messageLevel, const char* tag, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+
+    Slot* ring = __atomic_load_n(&slots, __ATOMIC_ACQUIRE);
+    if (!ring) {
+        // 尚未启动：同步写出
+        char text[TEXT_SIZE];
+        int length = vsnprintf(text, sizeof(text), format, args);
+        va_end(args);
+        if (length < 0) length = 0;
+        if ((size_t)length >= sizeof(text)) length = sizeof(text) - 1;
+        emit(millis(), messageLevel, tag, text, length);
+        return;
+    }
+
+    // 占用一个空闲槽位；下一个位置的槽位尚未写出说明缓冲区已满，丢弃本条而不是等待
+    uint32_t pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+    Slot* slot;
+    for (;;) {
+        slot = &ring[pos % SLOT_COUNT];
+        uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            va_end(args);
+            dropped->inc();
+            return;
+        } else {
+            pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->timeMs = millis();
+    slot->tag = tag;
+    slot->level = messageLevel;
+    int length = vsnprintf(slot->text, TEXT_SIZE, format, args);
+    va_end(args);
+    if (length < 0) {
+        length = 0;
+    } else if ((size_t)length >= TEXT_SIZE) {
+        // 截断：末尾注明原始长度
+        char marker[32];
+        int markerLength = snprintf(marker, sizeof(marker), " ...[%d bytes]", length);
+        memcpy(slot->text + TEXT_SIZE - 1 - markerLength, marker, markerLength + 1);
+        length = TEXT_SIZE - 1;
+        truncated->inc();
+    }
+    slot->length = length;
+    records->inc();
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+// 输出一条记录
+void Logger::emit(uint32_t timeMs, LogLevel messageLevel, const char* tag, const char* text, size_t length) {
+    char lineHead[40];
+    int headLength = snprintf(lineHead, sizeof(lineHead), "[%lu.%03lu][%c][%s] ",
+                              (unsigned long)(timeMs / 1000), (unsigned long)(timeMs % 1000),
+                              LEVEL_CHARS[messageLevel <= LOG_LEVEL_DEBUG ? messageLevel : 0], tag ? tag : "-");
+    if (headLength > (int)sizeof(lineHead) - 1) headLength = sizeof(lineHead) - 1;
+    Serial.write((const uint8_t*)lineHead, headLength);
+    Serial.write((const uint8_t*)text, length);
+    Serial.write('\n');
+}
+
+// 写出当前已写好的全部记录
+size_t Logger::drain() {
+    size_t count = 0;
+    for (;;) {
+        Slot* slot = &slots[tail % SLOT_COUNT];
+        uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (seq != tail + 1) {
+            break; // 空，或生产者尚未写完
+        }
+        emit(slot->timeMs, (LogLevel)slot->level, slot->tag, slot->text, slot->length);
+        __atomic_store_n(&slot->seq, tail + SLOT_COUNT, __ATOMIC_RELEASE);
+        tail++;
+        count++;
+    }
+
+    uint32_t drops = dropped->get();
+    if (drops != reportedDrops) {
+        char text[64];
+        int length = snprintf(text, sizeof(text), "%u records dropped (buffer full), %u total",
+                              drops - reportedDrops, drops);
+        emit(millis(), LOG_LEVEL_WARN, "LOG", text, length);
+        reportedDrops = drops;
+    }
+    return count;
+}
+
+// 写出任务
+void Logger::drainTask(void* parameter) {
+    Logger* logger = (Logger*)parameter;
+    for (;;) {
+        if (logger->drain() == 0) {
+            vTaskDelay(pdMS_TO_TICKS(20));
+        }
+    }
+}
@@ -10,6 +10,7 @@
 #include "web_manager.h"
 #include "config_manager.h"
 #include "usb_shell_manager.h" // Include UsbShellManager
+#include "logger.h"
 #include <USBMSC.h> // Explicitly include USBMSC for main.cpp
 #include <HttpClient.h> // 显式引入 HttpClient 以满足 LLMManager 依赖
 #include <LittleFS.h> // Include LittleFS for internal config and web files
@@ -52,10 +53,11 @@ void usbTask(void* pvParameters) {
     }
 }
 
-// Task for LLMManager
+// Task for LLMManager (one per worker, pvParameters is the worker index)
 void llmTask(void* pvParameters) {
+    uint8_t workerIndex = (uint8_t)(uintptr_t)pvParameters;
     for (;;) {
-        llmManagerPtr->loop();
+        llmManagerPtr->loop(workerIndex);
         vTaskDelay(pdMS_TO_TICKS(10)); // Small delay to yield
     }
 }
@@ -64,6 +66,8 @@ void setup() {
     // Initialize UART0 for Serial output
     Serial.begin(115200);
     delay(500);
+    // Async logging: request-path logs go to a PSRAM ring buffer drained by a low-priority task
+    Logger::instance().begin();
     
     Serial.println("Serial setup");
     Serial.println("Setup starting...");
@@ -140,6 +144,7 @@ void setup() {
     Serial.println("=====================================");
 
     configManager.loadConfig();
+    Logger::instance().setLevel(configManager.getConfig()["log_settings"]["level"] | "info");
 
     usbShellManagerPtr = new UsbShellManager(nullptr, &wifiManager);
     
@@ -169,7 +174,12 @@ void setup() {
     xTaskCreatePinnedToCore(webTask, "WebTask", 4096, NULL, 2, NULL, 0);
     xTaskCreatePinnedToCore(uiTask, "UITask", 4096, NULL, 2, NULL, 1);
     xTaskCreatePinnedToCore(usbTask, "USBTask", 4096, NULL, 2, NULL, 1);
-    xTaskCreatePinnedToCore(llmTask, "LLMTask", 8192 * 4, NULL, 2, NULL, 0);
+    // LLM worker pool: each worker runs its own blocking HTTPS request, alternating cores
+    for (uint8_t i = 0; i < llmManagerPtr->getWorkerCount(); i++) {
+        char taskName[16];
+        snprintf(taskName, sizeof(taskName), "LLMTask%u", i);
+        xTaskCreatePinnedToCore(llmTask, taskName, LLMManager::WORKER_STACK_SIZE, (void*)(uintptr_t)i, 2, NULL, i % 2);
+    }
 
     Serial.println("Setup complete. Starting main loop...");
 }
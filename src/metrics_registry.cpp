@@ -0,0 +1,244 @@
+#include "metrics_registry.h"
+#include <freertos/FreeRTOS.h>
+
+// 注册锁：只在注册时使用；静态初始化，全局对象构造期间也可用
+static portMUX_TYPE registerLock = portMUX_INITIALIZER_UNLOCKED;
+
+// 系统仪表的读取函数
+static int32_t readFreeHeap(void*) { return (int32_t)ESP.getFreeHeap(); }
+static int32_t readMinFreeHeap(void*) { return (int32_t)ESP.getMinFreeHeap(); }
+static int32_t readFreePsram(void*) { return (int32_t)ESP.getFreePsram(); }
+static int32_t readUptimeSeconds(void*) { return (int32_t)(millis() / 1000); }
+
+// 仪表当前值
+int32_t MetricGauge::get() const {
+    if (reader) {
+        return reader(readerContext);
+    }
+    return __atomic_load_n(&value, __ATOMIC_RELAXED);
+}
+
+// 记录一个观测值
+void MetricHistogram::observe(uint32_t v) {
+    uint8_t bucket = 0;
+    while (bucket < boundCount && v > bounds[bucket]) {
+        bucket++;
+    }
+    __atomic_fetch_add(&buckets[bucket], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&sum, v, __ATOMIC_RELAXED);
+}
+
+// 观测次数
+uint32_t MetricHistogram::getCount() const {
+    uint32_t count = 0;
+    for (uint8_t b = 0; b <= boundCount; b++) {
+        count += __atomic_load_n(&buckets[b], __ATOMIC_RELAXED);
+    }
+    return count;
+}
+
+// 获取注册表
+MetricsRegistry& MetricsRegistry::instance() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+// 构造函数：注册系统仪表
+MetricsRegistry::MetricsRegistry() : entryCount(0), counterCount(0), gaugeCount(0), histogramCount(0) {
+    memset(counters, 0, sizeof(counters));
+    memset(gauges, 0, sizeof(gauges));
+    memset(histograms, 0, sizeof(histograms));
+    memset(&overflowCounter, 0, sizeof(overflowCounter));
+    memset(&overflowGauge, 0, sizeof(overflowGauge));
+    memset(&overflowHistogram, 0, sizeof(overflowHistogram));
+
+    gauge("noox_heap_free_bytes", "Free internal heap", nullptr, readFreeHeap);
+    gauge("noox_heap_min_free_bytes", "Lowest free internal heap since boot", nullptr, readMinFreeHeap);
+    gauge("noox_psram_free_bytes", "Free PSRAM", nullptr, readFreePsram);
+    gauge("noox_uptime_seconds", "Seconds since boot", nullptr, readUptimeSeconds);
+}
+
+// 发布一项（调用方需持有注册锁）
+void MetricsRegistry::publish(const char* name, const char* help, const char* labels, MetricType type, uint8_t index) {
+    Entry& entry = entries[entryCount];
+    entry.name = name;
+    entry.help = help;
+    entry.labels = labels;
+    entry.type = type;
+    entry.index = index;
+    // 先写好该项再增加项数，导出方读到的项数内的项都是完整的
+    __atomic_store_n(&entryCount, entryCount + 1, __ATOMIC_RELEASE);
+}
+
+// 注册计数器
+MetricCounter* MetricsRegistry::counter(const char* name, const char* help, const char* labels) {
+    MetricCounter* metric = &overflowCounter;
+    portENTER_CRITICAL(&registerLock);
+    if (counterCount < MAX_COUNTERS) {
+        metric = &counters[counterCount];
+        publish(name, help, labels, METRIC_COUNTER, counterCount++);
+    }
+    portEXIT_CRITICAL(&registerLock);
+    if (metric == &overflowCounter) {
+        Serial.printf("[METRICS] Counter table full, %s not exported\n", name);
+    }
+    return metric;
+}
+
+// 注册仪表
+MetricGauge* MetricsRegistry::gauge(const char* name, const char* help, const char* labels,
+                                    MetricGaugeReader reader, void* context) {
+    MetricGauge* metric = &overflowGauge;
+    portENTER_CRITICAL(&registerLock);
+    if (gaugeCount < MAX_GAUGES) {
+        metric = &gauges[gaugeCount];
+        metric->reader = reader;
+        metric->readerContext = context;
+        publish(name, help, labels, METRIC_GAUGE, gaugeCount++);
+    }
+    portEXIT_CRITICAL(&registerLock);
+    if (metric == &overflowGauge) {
+        Serial.printf("[METRICS] Gauge table full, %s not exported\n", name);
+    }
+    return metric;
+}
+
+// 注册直方图
+MetricHistogram* MetricsRegistry::histogram(const char* name, const char* help, const uint32_t* bounds,
+                                            size_t boundCount, const char* labels) {
+    if (boundCount > MetricHistogram::MAX_BOUNDS) {
+        boundCount = MetricHistogram::MAX_BOUNDS;
+    }
+    MetricHistogram* metric = &overflowHistogram;
+    portENTER_CRITICAL(&registerLock);
+    if (histogramCount < MAX_HISTOGRAMS) {
+        metric = &histograms[histogramCount];
+        metric->bounds = bounds;
+        metric->boundCount = boundCount;
+        publish(name, help, labels, METRIC_HISTOGRAM, histogramCount++);
+    } else if (!overflowHistogram.bounds) {
+        // 占位直方图也需要桶上限，observe() 才能正常查找
+        overflowHistogram.bounds = bounds;
+        overflowHistogram.boundCount = boundCount;
+    }
+    portEXIT_CRITICAL(&registerLock);
+    if (metric == &overflowHistogram) {
+        Serial.printf("[METRICS] Histogram table full, %s not exported\n", name);
+    }
+    return metric;
+}
+
+// 该指标名在 index 之前是否已出现
+bool MetricsRegistry::seenBefore(size_t index) const {
+    for (size_t i = 0; i < index; i++) {
+        if (strcmp(entries[i].name, entries[index].name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 输出一行样本
+void MetricsRegistry::writeSample(Print& out, const Entry& entry, const char* suffix, const char* extraLabel,
+                                  const char* value) {
+    out.print(entry.name);
+    if (suffix) out.print(suffix);
+    bool hasLabels = entry.labels && entry.labels[0];
+    if (hasLabels || extraLabel) {
+        out.print('{');
+        if (hasLabels) out.print(entry.labels);
+        if (hasLabels && extraLabel) out.print(',');
+        if (extraLabel) out.print(extraLabel);
+        out.print('}');
+    }
+    out.print(' ');
+    out.print(value);
+    out.print('\n');
+}
+
+// 以 Prometheus 文本格式输出所有指标
+void MetricsRegistry::writePrometheus(Print& out) const {
+    static const char* const TYPE_NAMES[] = {"counter", "gauge", "histogram"};
+    size_t count = __atomic_load_n(&entryCount, __ATOMIC_ACQUIRE);
+    char value[24];
+    char label[24];
+    for (size_t i = 0; i < count; i++) {
+        if (seenBefore(i)) continue;
+        out.printf("# HELP %s %s\n# TYPE %s %s\n", entries[i].name, entries[i].help,
+                   entries[i].name, TYPE_NAMES[entries[i].type]);
+        // 同名的各项（不同标签）必须连续输出
+        for (size_t j = i; j < count; j++) {
+            const Entry& entry = entries[j];
+            if (j != i && strcmp(entry.name, entries[i].name) != 0) continue;
+            switch (entry.type) {
+                case METRIC_COUNTER:
+                    snprintf(value, sizeof(value), "%u", counters[entry.index].get());
+                    writeSample(out, entry, nullptr, nullptr, value);
+                    break;
+                case METRIC_GAUGE:
+                    snprintf(value, sizeof(value), "%d", gauges[entry.index].get());
+                    writeSample(out, entry, nullptr, nullptr, value);
+                    break;
+                case METRIC_HISTOGRAM: {
+                    const MetricHistogram& h = histograms[entry.index];
+                    // Prometheus 的桶是累积的
+                    uint32_t cumulative = 0;
+                    for (uint8_t b = 0; b <= h.boundCount; b++) {
+                        cumulative += __atomic_load_n(&h.buckets[b], __ATOMIC_RELAXED);
+                        if (b < h.boundCount) {
+                            snprintf(label, sizeof(label), "le=\"%u\"", h.bounds[b]);
+                        } else {
+                            snprintf(label, sizeof(label), "le=\"+Inf\"");
+                        }
+                        snprintf(value, sizeof(value), "%u", cumulative);
+                        writeSample(out, entry, "_bucket", label, value);
+                    }
+                    snprintf(value, sizeof(value), "%u", __atomic_load_n(&h.sum, __ATOMIC_RELAXED));
+                    writeSample(out, entry, "_sum", nullptr, value);
+                    snprintf(value, sizeof(value), "%u", cumulative);
+                    writeSample(out, entry, "_count", nullptr, value);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// 以紧凑 JSON 输出所有指标
+void MetricsRegistry::writeCompact(JsonObject out) const {
+    size_t count = __atomic_load_n(&entryCount, __ATOMIC_ACQUIRE);
+    for (size_t i = 0; i < count; i++) {
+        const Entry& entry = entries[i];
+        String key = entry.name;
+        if (entry.labels && entry.labels[0]) {
+            key += '{';
+            key += entry.labels;
+            key += '}';
+        }
+        switch (entry.type) {
+            case METRIC_COUNTER:
+                out[key] = counters[entry.index].get();
+                break;
+            case METRIC_GAUGE:
+                out[key] = gauges[entry.index].get();
+                break;
+            case METRIC_HISTOGRAM: {
+                const MetricHistogram& h = histograms[entry.index];
+                // 先读出各桶，次数与各桶之和一致
+                uint32_t buckets[MetricHistogram::MAX_BOUNDS + 1];
+                uint32_t total = 0;
+                for (uint8_t b = 0; b <= h.boundCount; b++) {
+                    buckets[b] = __atomic_load_n(&h.buckets[b], __ATOMIC_RELAXED);
+                    total += buckets[b];
+                }
+                JsonArray values = out[key].to<JsonArray>();
+                values.add(total);
+                values.add(__atomic_load_n(&h.sum, __ATOMIC_RELAXED));
+                for (uint8_t b = 0; b <= h.boundCount; b++) {
+                    values.add(buckets[b]);
+                }
+                break;
+            }
+        }
+    }
+}
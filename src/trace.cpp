@@ -0,0 +1,167 @@
+#include "trace.h"
+
+#if NOOX_TRACE
+
+#ifdef ARDUINO
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#endif
+
+// 当前任务的标识和名称
+static void* currentTaskKey() {
+#ifdef ARDUINO
+    return (void*)xTaskGetCurrentTaskHandle();
+#else
+    return (void*)(uintptr_t)pthread_self();
+#endif
+}
+
+static void currentTaskName(char* name, size_t size, size_t index) {
+#ifdef ARDUINO
+    (void)index;
+    strncpy(name, pcTaskGetName(NULL), size - 1);
+    name[size - 1] = '\0';
+#else
+    snprintf(name, size, "thread-%u", (unsigned)index);
+#endif
+}
+
+// 当前时间（微秒）
+uint64_t Tracer::now() {
+#ifdef ARDUINO
+    return (uint64_t)esp_timer_get_time();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+#endif
+}
+
+// 获取追踪器
+Tracer& Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+// 构造函数
+Tracer::Tracer() {
+    memset(tasks, 0, sizeof(tasks));
+}
+
+// 当前任务的追踪状态
+Tracer::TaskTrace* Tracer::current() {
+    void* self = currentTaskKey();
+    for (size_t i = 0; i < MAX_TASKS; i++) {
+        if (__atomic_load_n(&tasks[i].key, __ATOMIC_ACQUIRE) == self) {
+            return tasks[i].events ? &tasks[i] : nullptr;
+        }
+    }
+    // 首次出现的任务：占用一个空闲项（只有本任务会写这一项）
+    for (size_t i = 0; i < MAX_TASKS; i++) {
+        void* expected = nullptr;
+        if (__atomic_compare_exchange_n(&tasks[i].key, &expected, self, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            TaskTrace& task = tasks[i];
+            currentTaskName(task.name, sizeof(task.name), i);
+#ifdef ARDUINO
+            Event* events = (Event*)ps_malloc(EVENTS_PER_TASK * sizeof(Event));
+#else
+            Event* events = (Event*)malloc(EVENTS_PER_TASK * sizeof(Event));
+#endif
+            // 分配失败时该任务保持登记但不记录
+            __atomic_store_n(&task.events, events, __ATOMIC_RELEASE);
+            return events ? &task : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+// 写入一个事件
+void Tracer::record(TaskTrace* task, char phase, const char* name, uint64_t ts, uint32_t dur, uint32_t id) {
+    Event& event = task->events[task->written % EVENTS_PER_TASK];
+    event.name = name;
+    event.ts = ts;
+    event.dur = dur;
+    event.id = id;
+    event.phase = phase;
+    __atomic_store_n(&task->written, task->written + 1, __ATOMIC_RELEASE);
+}
+
+// 开始一个区间
+void Tracer::begin(const char* name) {
+    TaskTrace* task = current();
+    if (!task) return;
+    if (task->depth < MAX_DEPTH) {
+        task->openNames[task->depth] = name;
+        task->openStarts[task->depth] = now();
+    } else {
+        task->overflow++;
+    }
+    task->depth++;
+}
+
+// 结束最近开始的区间
+void Tracer::end() {
+    TaskTrace* task = current();
+    if (!task || task->depth == 0) return;
+    task->depth--;
+    if (task->depth < MAX_DEPTH) {
+        uint64_t start = task->openStarts[task->depth];
+        record(task, 'X', task->openNames[task->depth], start, (uint32_t)(now() - start), 0);
+    }
+}
+
+// 记录一个瞬时事件
+void Tracer::instant(const char* name) {
+    TaskTrace* task = current();
+    if (!task) return;
+    record(task, 'i', name, now(), 0, 0);
+}
+
+// 记录一个异步事件
+void Tracer::async(char phase, const char* name, uint32_t id) {
+    TaskTrace* task = current();
+    if (!task) return;
+    record(task, phase, name, now(), 0, id);
+}
+
+// 以 Chrome trace JSON 输出所有任务的事件
+size_t Tracer::writeChromeTrace(Print& out) {
+    size_t count = 0;
+    bool first = true;
+    out.print("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (size_t i = 0; i < MAX_TASKS; i++) {
+        TaskTrace& task = tasks[i];
+        Event* events = __atomic_load_n(&task.events, __ATOMIC_ACQUIRE);
+        if (!events) continue;
+        unsigned tid = i + 1;
+        out.printf("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                   first ? "" : ",", tid, task.name);
+        first = false;
+
+        // 读取时任务可能仍在写入：最旧的几条事件可能恰好被覆盖，对排查足够
+        uint32_t written = __atomic_load_n(&task.written, __ATOMIC_ACQUIRE);
+        uint32_t start = written > EVENTS_PER_TASK ? written - EVENTS_PER_TASK : 0;
+        for (uint32_t n = start; n < written; n++) {
+            Event event = events[n % EVENTS_PER_TASK];
+            out.printf(",{\"name\":\"%s\",\"cat\":\"noox\",\"ph\":\"%c\",\"ts\":%llu,\"pid\":1,\"tid\":%u",
+                       event.name, event.phase, (unsigned long long)event.ts, tid);
+            if (event.phase == 'X') {
+                out.printf(",\"dur\":%u}", (unsigned)event.dur);
+            } else if (event.phase == 'i') {
+                out.print(",\"s\":\"t\"}");
+            } else {
+                out.printf(",\"id\":%u}", (unsigned)event.id);
+            }
+            count++;
+        }
+    }
+    out.print("]}");
+    return count;
+}
+
+#endif // NOOX_TRACE
@@ -1,5 +1,6 @@
 #include "ui_manager.h"
 #include "hardware_config.h"
+#include "trace.h"
 #include <U8g2lib.h>
 // #include <vector> // Removed as script list is no longer needed
 
@@ -8,7 +9,14 @@ static unsigned long lastButtonPressTime = 0;
 const unsigned long DEBOUNCE_DELAY = 200;
 
 UIManager::UIManager(HardwareManager& hw, AppWiFiManager& wifi, LLMManager& llm)
-    : hardware(hw), wifi(wifi), llmManager(llm), currentState(UI_STATE_STATUS) {}
+    : hardware(hw), wifi(wifi), llmManager(llm), currentState(UI_STATE_STATUS) {
+    static const uint32_t FRAME_BOUNDS_MS[] = {1, 2, 5, 10, 20, 50, 100};
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    frames = registry.counter("noox_ui_frames_total", "UI update cycles");
+    frameTime = registry.histogram("noox_ui_frame_ms", "Time spent in one UI update cycle",
+                                   FRAME_BOUNDS_MS, sizeof(FRAME_BOUNDS_MS) / sizeof(FRAME_BOUNDS_MS[0]));
+    buttonPresses = registry.counter("noox_ui_button_presses_total", "Debounced button presses");
+}
 
 void UIManager::begin() {
     hardware.getDisplay().clearBuffer();
@@ -20,6 +28,9 @@ void UIManager::begin() {
 }
 
 void UIManager::update() {
+    TRACE_SCOPE("ui.frame");
+    unsigned long frameStart = millis();
+
     // Reset button events at the beginning of each update cycle
     buttonA_event = false;
     buttonB_event = false;
@@ -46,6 +57,9 @@ void UIManager::update() {
             handleStateStatus();
             break;
     }
+
+    frames->inc();
+    frameTime->observe(millis() - frameStart);
 }
 
 void UIManager::handleButtonInput() {
@@ -65,6 +79,9 @@ void UIManager::handleButtonInput() {
             buttonC_event = true;
             lastButtonPressTime = currentTime;
         }
+        if (buttonA_event || buttonB_event || buttonC_event) {
+            buttonPresses->inc();
+        }
     }
 }
 
@@ -11,6 +11,8 @@
 
 #include <ArduinoJson.h>    // JSON处理库
 #include "usb_shell_manager.h"
+#include "logger.h"
+#include "trace.h"
 #include "llm_manager.h"    // AI管理器
 #include "wifi_manager.h"   // WiFi管理器
 #include "USBHIDKeyboard.h" // HID键盘模拟
@@ -27,6 +29,12 @@ USBHIDKeyboard Keyboard;
 UsbShellManager::UsbShellManager(LLMManager* llmManager, AppWiFiManager* wifiManager)
     : _llmManager(llmManager), _wifiManager(wifiManager) {
     // 初始化成员变量
+    _sendLock = xSemaphoreCreateMutex();
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    _received = registry.counter("noox_cdc_messages_total", "CDC messages exchanged with the host", "direction=\"received\"");
+    _sent = registry.counter("noox_cdc_messages_total", "CDC messages exchanged with the host", "direction=\"sent\"");
+    _invalid = registry.counter("noox_cdc_invalid_messages_total", "Host messages that failed to parse or had an unknown type");
+    _sentBytes = registry.counter("noox_cdc_sent_bytes_total", "Bytes sent to the host");
 }
 
 /**
@@ -41,7 +49,7 @@ void UsbShellManager::begin() {
     USB.begin();           // 初始化USB复合设备
     _cdc.begin();         // 初始化CDC串口
     Serial.begin(115200); // 初始化调试串口
-    Serial.println("UsbShellManager initialized. Waiting for USB connection...");
+    LOG_I("CDC", "UsbShellManager initialized. Waiting for USB connection...");
 }
 
 /**
@@ -76,8 +84,7 @@ void UsbShellManager::handleUsbSerialData() {
 
         // 假定消息以换行符结尾，且为JSON格式
         if (c == '\n') {
-            Serial.print("Received from host: ");
-            Serial.println(_inputBuffer);
+            LOG_D("CDC", "Received from host: %.*s", (int)_inputBuffer.length() - 1, _inputBuffer.c_str());
             processHostMessage(_inputBuffer);
             _inputBuffer = ""; // 处理完毕后清空缓冲区
         }
@@ -92,17 +99,21 @@ void UsbShellManager::handleUsbSerialData() {
  * - linkTest: 链路测试请求
  * - connectToWifi: WiFi连接请求
  * - shellCommandResult: Shell命令执行结果
+ * - getMetrics: 查询 LLM 请求指标
+ * - getMetricsSnapshot: 查询指标注册表快照
  * 
  * @param message JSON格式的消息字符串
  */
 void UsbShellManager::processHostMessage(const String& message) {
+    TRACE_SCOPE("cdc.message");
+    _received->inc();
     JsonDocument doc;
     DeserializationError error = deserializeJson(doc, message);
 
     // 检查JSON解析是否成功
     if (error) {
-        Serial.print(F("deserializeJson() failed: "));
-        Serial.println(error.f_str());
+        _invalid->inc();
+        LOG_W("CDC", "deserializeJson() failed: %s", error.c_str());
         sendToHost("{\"type\":\"error\",\"content\":\"Invalid JSON\"}");
         return;
     }
@@ -110,24 +121,37 @@ void UsbShellManager::processHostMessage(const String& message) {
     // 提取消息类型和请求ID
     String type = doc["type"].as<String>();
     String requestId = doc["requestId"] | ""; // 提取请求ID，如果不存在则为空字符串
+    // 会话键：主机可用 sessionId 区分多个终端会话，缺省共用一个 "cdc" 会话
+    String sessionId = doc["sessionId"] | "";
+    String sessionKey = sessionId.length() > 0 ? "cdc:" + sessionId.substring(0, 40) : String("cdc");
 
     if (type == "userInput") {
         String payload = doc["payload"] | "";
-        Serial.print("User input: ");
-        Serial.println(payload);
+        LOG_D("CDC", "User input: %s", payload.c_str());
+        // "priority":"background" 标记没有人在等待的输入（如主机代理的 /bg 命令），排在交互请求之后
+        String priority = doc["priority"] | "";
+        LLMPriority requestPriority = priority == "background" ? PRIORITY_BACKGROUND : PRIORITY_INTERACTIVE;
         // Forward to LLMManager with requestId
-        _llmManager->processUserInput(requestId, payload);
+        _llmManager->processUserInput(requestId, sessionKey, payload, requestPriority);
+    } else if (type == "cancel") {
+        // 取消该会话中进行中和排队中的请求；被取消的请求会以 "Error: Request cancelled" 回复
+        LOG_I("CDC", "Cancel requested for session %s", sessionKey.c_str());
+        _llmManager->cancelSession(sessionKey);
+    } else if (type == "getMetrics") {
+        // 与 GET /api/metrics/llm 相同的 LLM 请求指标
+        sendMetricsToHost(requestId);
+    } else if (type == "getMetricsSnapshot") {
+        // 与 GET /metrics 相同的指标，以紧凑 JSON 发送
+        sendMetricsSnapshotToHost(requestId);
     } else if (type == "linkTest") {
         String payload = doc["payload"] | "";
-        Serial.print("Received linkTest: ");
-        Serial.println(payload);
+        LOG_I("CDC", "Received linkTest: %s", payload.c_str());
         // Respond with linkTestResult
         sendLinkTestResultToHost(requestId, true, "pong");
     } else if (type == "connectToWifi") {
         String ssid = doc["payload"]["ssid"] | "";
         String password = doc["payload"]["password"] | "";
-        Serial.print("Received connectToWifi for SSID: ");
-        Serial.println(ssid);
+        LOG_I("CDC", "Received connectToWifi for SSID: %s", ssid.c_str());
         // Forward to WiFiManager
         bool success = _wifiManager->connectToWiFi(ssid, password); // Corrected case to connectToWiFi
         sendWifiConnectStatusToHost(requestId, success, success ? "Connected" : "Failed to connect");
@@ -138,22 +162,16 @@ void UsbShellManager::processHostMessage(const String& message) {
         String status = doc["status"] | "error"; // New status field
         int exitCode = doc["exitCode"] | -1; // New exitCode field
         
-        Serial.print("Shell output for '");
-        Serial.print(command);
-        Serial.print("':\nSTDOUT: ");
-        Serial.println(shellStdout);
-        Serial.print("STDERR: ");
-        Serial.println(shellStderr);
-        Serial.print("Status: ");
-        Serial.println(status);
-        Serial.print("Exit Code: ");
-        Serial.println(exitCode);
+        LOG_I("CDC", "Shell result for '%s': status %s, exit code %d, %u bytes stdout, %u bytes stderr",
+              command.c_str(), status.c_str(), exitCode, shellStdout.length(), shellStderr.length());
+        LOG_D("CDC", "STDOUT: %s", shellStdout.c_str());
+        LOG_D("CDC", "STDERR: %s", shellStderr.c_str());
 
         // Forward to LLMManager with context and requestId
-        _llmManager->processShellOutput(requestId, command, shellStdout, shellStderr, status, exitCode);
+        _llmManager->processShellOutput(requestId, sessionKey, command, shellStdout, shellStderr, status, exitCode);
     } else {
-        Serial.print("Unknown message type: ");
-        Serial.println(type);
+        _invalid->inc();
+        LOG_W("CDC", "Unknown message type: %s", type.c_str());
         sendToHost(String("{\"type\":\"error\",\"payload\":\"Unknown message type\",\"requestId\":\"") + requestId + String("\"}"));
     }
 }
@@ -164,9 +182,12 @@ void UsbShellManager::processHostMessage(const String& message) {
  * @param message 要发送的消息字符串
  */
 void UsbShellManager::sendToHost(const String& message) {
+    xSemaphoreTake(_sendLock, portMAX_DELAY);
+    _sent->inc();
+    _sentBytes->inc(message.length() + 2); // 含 println 的 "\r\n"
     _cdc.println(message);        // 通过CDC串口发送消息
-    Serial.print("Sent to host: ");
-    Serial.println(message);      // 同时在调试串口输出
+    LOG_D("CDC", "Sent to host: %s", message.c_str()); // 同时写入调试日志（异步，超长时截断）
+    xSemaphoreGive(_sendLock);
 }
 
 /**
@@ -215,6 +236,33 @@ void UsbShellManager::sendAiResponseToHost(const String& requestId, const String
     sendToHost(output);
 }
 
+/**
+ * @brief 向主机发送流式AI响应的增量片段
+ * 
+ * 构造JSON格式：
+ * {
+ *   "requestId": "xxx",
+ *   "type": "aiResponseDelta",
+ *   "payload": "partial text"
+ * }
+ * 
+ * 增量消息频率较高，不回显到调试串口。
+ * 
+ * @param requestId 请求ID
+ * @param delta 本次新增的响应文本
+ */
+void UsbShellManager::sendAiResponseDeltaToHost(const String& requestId, const String& delta) {
+    JsonDocument doc;
+    doc["requestId"] = requestId;
+    doc["type"] = "aiResponseDelta";
+    doc["payload"] = delta;
+    String output;
+    serializeJson(doc, output);
+    xSemaphoreTake(_sendLock, portMAX_DELAY);
+    _cdc.println(output);
+    xSemaphoreGive(_sendLock);
+}
+
 /**
  * @brief 向主机发送链路测试结果
  * 
@@ -241,6 +289,50 @@ void UsbShellManager::sendLinkTestResultToHost(const String& requestId, bool suc
     sendToHost(output);
 }
 
+/**
+ * @brief 向主机发送 LLM 请求指标
+ * 
+ * 构造JSON格式：
+ * {
+ *   "requestId": "xxx",
+ *   "type": "metrics",
+ *   "payload": { "cancelled": 0, "expired": 0, "series": [...] }
+ * }
+ * 
+ * @param requestId 请求ID
+ */
+void UsbShellManager::sendMetricsToHost(const String& requestId) {
+    JsonDocument doc;
+    doc["requestId"] = requestId;
+    doc["type"] = "metrics";
+    _llmManager->writeMetrics(doc["payload"].to<JsonObject>());
+    String output;
+    serializeJson(doc, output);
+    sendToHost(output);
+}
+
+/**
+ * @brief 向主机发送指标注册表的紧凑快照
+ * 
+ * 构造JSON格式（直方图为 [次数, 总和, 各桶次数...]）：
+ * {
+ *   "requestId": "xxx",
+ *   "type": "metricsSnapshot",
+ *   "payload": { "noox_heap_free_bytes": 123456, "noox_llm_request_duration_ms": [3, 2100, 0, ...] }
+ * }
+ * 
+ * @param requestId 请求ID
+ */
+void UsbShellManager::sendMetricsSnapshotToHost(const String& requestId) {
+    JsonDocument doc;
+    doc["requestId"] = requestId;
+    doc["type"] = "metricsSnapshot";
+    MetricsRegistry::instance().writeCompact(doc["payload"].to<JsonObject>());
+    String output;
+    serializeJson(doc, output);
+    sendToHost(output);
+}
+
 void UsbShellManager::sendWifiConnectStatusToHost(const String& requestId, bool success, const String& message) {
     JsonDocument doc;
     doc["requestId"] = requestId;
@@ -277,8 +369,8 @@ void UsbShellManager::sendWifiConnectStatusToHost(const String& requestId, bool
  * @param wifiStatus 当前WiFi状态，作为代理程序的启动参数
  */
 void UsbShellManager::simulateKeyboardLaunchAgent(const String& wifiStatus) {
-    Serial.println("WARNING: simulateKeyboardLaunchAgent is experimental and may not work reliably.");
-    Serial.println("Attempting to launch agent via keyboard simulation...");
+    LOG_W("CDC", "simulateKeyboardLaunchAgent is experimental and may not work reliably.");
+    LOG_I("CDC", "Attempting to launch agent via keyboard simulation...");
     
     Keyboard.begin();
     delay(2000); // 给主机更多时间识别所有USB设备（HID、CDC、MSC）
@@ -324,6 +416,6 @@ void UsbShellManager::simulateKeyboardLaunchAgent(const String& wifiStatus) {
     delay(500);
     
     Keyboard.end();
-    Serial.println("Keyboard simulation complete. Check PowerShell window for results.");
-    Serial.println("If launch failed, please manually run noox-host-agent.exe from the NOOX device.");
+    LOG_I("CDC", "Keyboard simulation complete. Check PowerShell window for results.");
+    LOG_I("CDC", "If launch failed, please manually run noox-host-agent.exe from the NOOX device.");
 }
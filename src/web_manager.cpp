@@ -1,20 +1,29 @@
 #include "web_manager.h"
 #include "wifi_manager.h"
 #include "hardware_manager.h"
+#include "logger.h"
+#include "trace.h"
 #include <ArduinoJson.h>
 #include <AsyncJson.h>
 #include <LittleFS.h>
+#include <FFat.h>
 
 // Constructor
 WebManager::WebManager(LLMManager& llm, AppWiFiManager& wifi, ConfigManager& config, HardwareManager& hardware) 
     : llmManager(llm), wifiManager(wifi), configManager(config), hardwareManager(hardware), server(80), ws("/ws"),
       currentLLMMode(CHAT_MODE) {
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    wsClients = registry.gauge("noox_web_ws_clients", "Connected WebSocket clients");
+    wsReceived = registry.counter("noox_web_ws_messages_total", "WebSocket messages", "direction=\"received\"");
+    wsSent = registry.counter("noox_web_ws_messages_total", "WebSocket messages", "direction=\"sent\"");
+    configSaved = registry.counter("noox_web_config_updates_total", "Configuration updates applied", "result=\"saved\"");
+    configFailed = registry.counter("noox_web_config_updates_total", "Configuration updates applied", "result=\"failed\"");
 }
 
 // Start web services
 void WebManager::begin() {
     // Note: LittleFS is already mounted in main.cpp before WebManager initialization
-    Serial.println("[WEB] Initializing web server...");
+    LOG_I("WEB", "Initializing web server...");
     
     // Check if web files exist in LittleFS
     const char* requiredFiles[] = {"/index.html.gz", "/style.css.gz", "/script.js.gz"};
@@ -23,25 +32,25 @@ void WebManager::begin() {
     for (const char* file : requiredFiles) {
         if (!LittleFS.exists(file)) {
             allFilesExist = false;
-            Serial.printf("[WEB] WARNING: %s not found in LittleFS\n", file);
+            LOG_W("WEB", "%s not found in LittleFS", file);
         }
     }
     
     if (!allFilesExist) {
-        Serial.println("[WEB] ========================================");
-        Serial.println("[WEB] ERROR: Web files missing!");
-        Serial.println("[WEB] Please run deployment script:");
-        Serial.println("[WEB]   python deploy_all.py");
-        Serial.println("[WEB] ========================================");
+        LOG_E("WEB", "========================================");
+        LOG_E("WEB", "Web files missing!");
+        LOG_E("WEB", "Please run deployment script:");
+        LOG_E("WEB", "  python deploy_all.py");
+        LOG_E("WEB", "========================================");
     } else {
-        Serial.println("[WEB] All web files present in LittleFS");
+        LOG_I("WEB", "All web files present in LittleFS");
     }
     
     setupRoutes();
     ws.onEvent(std::bind(&WebManager::onWebSocketEvent, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
     server.addHandler(&ws);
     server.begin();
-    Serial.println("[WEB] Web server started on port 80");
+    LOG_I("WEB", "Web server started on port 80");
 }
 
 // WebSocket cleanup and LLM response handling
@@ -50,44 +59,53 @@ void WebManager::loop() {
 
     // Handle pending configuration updates
     if (configUpdatePending) {
-        Serial.println("Processing pending configuration update...");
+        LOG_I("WEB", "Processing pending configuration update...");
         JsonDocument& doc = configManager.getConfig();
         doc.clear();
         doc.set(pendingConfigDoc); // Apply the pending config
 
         if (configManager.saveConfig()) {
-            Serial.println("Configuration saved successfully.");
+            LOG_I("WEB", "Configuration saved successfully.");
+            configSaved->inc();
             broadcast("{\"type\":\"config_update_status\", \"status\":\"success\", \"message\":\"Configuration saved and applied.\"}");
+            Logger::instance().setLevel(configManager.getConfig()["log_settings"]["level"] | "info");
             llmManager.begin(); // Re-initialize managers with new config
             wifiManager.begin(); // For WiFi, we might want to connect to the new "last_used" one
         } else {
-            Serial.println("Failed to save configuration.");
+            LOG_E("WEB", "Failed to save configuration.");
+            configFailed->inc();
             broadcast("{\"type\":\"config_update_status\", \"status\":\"error\", \"message\":\"Failed to save configuration.\"}");
         }
         configUpdatePending = false; // Reset flag
     }
 
+    // 转发流式增量（chat_delta），一次取完队列中已有的增量
+    LLMStreamDelta delta;
+    while (xQueueReceive(llmManager.llmDeltaQueue, &delta, 0) == pdPASS) {
+        if (delta.text) {
+            JsonDocument deltaDoc;
+            deltaDoc["type"] = "chat_delta";
+            deltaDoc["sender"] = "bot";
+            deltaDoc["text"] = delta.text;
+            String deltaStr;
+            serializeJson(deltaDoc, deltaStr);
+            sendToClient(delta.clientId, deltaStr);
+            free(delta.text); // 接收方负责释放
+        }
+    }
+
     LLMResponse response;
     if (xQueueReceive(llmManager.llmResponseQueue, &response, 0) == pdPASS) {
+        TRACE_SCOPE("web.deliver");
         JsonDocument responseDoc;
         String responseStr;
 
         if (response.isToolCall) {
-            responseDoc["type"] = "tool_call";
-            responseDoc["tool_name"] = response.toolName;
-            // toolArgs is already a JSON string, so parse it back to JsonObject
-            if (response.toolArgs) {
-                JsonDocument argsDoc;
-                DeserializationError argsError = deserializeJson(argsDoc, response.toolArgs);
-                if (!argsError) {
-                    responseDoc["tool_args"] = argsDoc.as<JsonObject>();
-                } else {
-                    Serial.printf("WebManager: Failed to parse toolArgs JSON: %s\n", argsError.c_str());
-                    responseDoc["tool_args"] = response.toolArgs; // Send as raw string if parsing fails
-                }
-            }
-            serializeJson(responseDoc, responseStr);
-            broadcast(responseStr);
+            // 一轮回复中的所有工具调用结果作为一条消息发送；toolResults 已是 JSON 数组，直接拼接
+            responseStr = "{\"type\":\"tool_results\",\"results\":";
+            responseStr += response.toolResults ? response.toolResults : "[]";
+            responseStr += "}";
+            sendToClient(response.clientId, responseStr);
         } else {
             responseDoc["type"] = "chat_message";
             responseDoc["sender"] = "bot";
@@ -97,13 +115,13 @@ void WebManager::loop() {
                 responseDoc["text"] = "";
             }
             serializeJson(responseDoc, responseStr);
-            broadcast(responseStr);
+            sendToClient(response.clientId, responseStr);
         }
         
         // 释放响应中分配的内存（接收方负责释放）
-        if (response.toolArgs) {
-            free(response.toolArgs);
-            response.toolArgs = nullptr;
+        if (response.toolResults) {
+            free(response.toolResults);
+            response.toolResults = nullptr;
         }
         if (response.naturalLanguageResponse) {
             free(response.naturalLanguageResponse);
@@ -113,55 +131,61 @@ void WebManager::loop() {
 }
 
 void WebManager::broadcast(const String& message) {
+    wsSent->inc();
     ws.textAll(message);
 }
 
-// 创建并发送LLM请求的辅助方法
-bool WebManager::createAndSendLLMRequest(const String& requestId, const String& payload, LLMMode mode) {
-    LLMRequest request;
-    memset(&request, 0, sizeof(LLMRequest));
-    
-    // 安全拷贝requestId（Web请求通常为空）
-    strncpy(request.requestId, requestId.c_str(), sizeof(request.requestId) - 1);
-    request.requestId[sizeof(request.requestId) - 1] = '\0';
-    
-    // 使用PSRAM分配prompt内存
-    size_t promptLen = payload.length() + 1;
-    request.prompt = (char*)ps_malloc(promptLen);
-    if (!request.prompt) {
-        return false; // 内存分配失败
+void WebManager::sendToClient(uint32_t clientId, const String& message) {
+    if (clientId == 0) {
+        broadcast(message);
+    } else if (ws.hasClient(clientId)) {
+        wsSent->inc();
+        ws.text(clientId, message);
     }
-    strncpy(request.prompt, payload.c_str(), promptLen);
-    request.prompt[promptLen - 1] = '\0';
-    
-    request.mode = mode;
-    
-    // 发送到队列
-    if (xQueueSend(llmManager.llmRequestQueue, &request, 0) != pdPASS) {
-        free(request.prompt); // 发送失败，释放内存
-        return false;
+    // 客户端已断开：丢弃这条输出
+}
+
+// 获取 WebSocket 客户端的会话键
+String WebManager::getSessionKey(AsyncWebSocketClient * client, JsonDocument& doc) {
+    // 页面在 localStorage 中保存 sessionId，刷新或重连后仍能接上原来的对话
+    String sessionId = doc["sessionId"] | "";
+    if (sessionId.length() > 0) {
+        return "web:" + sessionId.substring(0, 40);
     }
-    
-    return true;
+    return "ws:" + String(client->id());
+}
+
+// 创建并发送LLM请求的辅助方法
+bool WebManager::createAndSendLLMRequest(const String& requestId, const String& sessionKey, uint32_t clientId, const String& payload, LLMMode mode) {
+    // 新消息取代该会话中尚未完成的请求，旧请求立即中止
+    llmManager.cancelSession(sessionKey);
+    // 由 LLMManager 分配序号和截止时间；Web 请求在队列满时不阻塞，直接失败
+    return llmManager.createAndSendRequest(requestId, sessionKey, payload, mode, clientId);
 }
 
 void WebManager::setLLMMode(LLMMode mode) {
     currentLLMMode = mode;
     llmManager.setCurrentMode(mode);
-    Serial.printf("LLM Mode set to %s\n", (mode == CHAT_MODE ? "CHAT_MODE" : "ADVANCED_MODE"));
+    LOG_I("WEB", "LLM Mode set to %s", (mode == CHAT_MODE ? "CHAT_MODE" : "ADVANCED_MODE"));
 }
 
 void WebManager::onWebSocketEvent(AsyncWebSocket * server, AsyncWebSocketClient * client, AwsEventType type, void * arg, uint8_t *data, size_t len) {
     if (type == WS_EVT_CONNECT) {
-        Serial.printf("WebSocket client #%u connected from %s\n", client->id(), client->remoteIP().toString().c_str());
+        LOG_I("WEB", "WebSocket client #%u connected from %s", client->id(), client->remoteIP().toString().c_str());
+        wsClients->add(1);
     } else if (type == WS_EVT_DISCONNECT) {
-        Serial.printf("WebSocket client #%u disconnected\n", client->id());
+        LOG_I("WEB", "WebSocket client #%u disconnected", client->id());
+        wsClients->add(-1);
+        // 未带 sessionId 的会话随连接结束；"web:" 会话保留，等待页面重连或被 LRU 淘汰
+        llmManager.removeSession("ws:" + String(client->id()));
     } else if (type == WS_EVT_DATA) {
+        wsReceived->inc();
         handleWebSocketData(client, arg, data, len);
     }
 }
 
 void WebManager::handleWebSocketData(AsyncWebSocketClient * client, void *arg, uint8_t *data, size_t len) {
+    TRACE_SCOPE("web.ws_message");
     AwsFrameInfo *info = (AwsFrameInfo*)arg;
     if (info->final && info->index == 0 && info->len == len && info->opcode == WS_TEXT) {
         JsonDocument doc;
@@ -179,13 +203,17 @@ void WebManager::handleWebSocketData(AsyncWebSocketClient * client, void *arg, u
             String payload = doc["payload"].as<String>();
             
             // 使用辅助函数创建并发送LLM请求
-            if (!createAndSendLLMRequest("", payload, currentLLMMode)) {
+            if (!createAndSendLLMRequest("", getSessionKey(client, doc), client->id(), payload, currentLLMMode)) {
                 client->text("{\"type\":\"chat_message\", \"sender\":\"bot\", \"text\":\"Error: Failed to process request.\"}");
             }
-            // 实际响应将通过broadcast发送
+            // 实际响应将发回该客户端
+        } else if (type == "cancel") {
+            // 取消该客户端会话中进行中和排队中的请求
+            llmManager.cancelSession(getSessionKey(client, doc));
+            client->text("{\"type\":\"request_cancelled\", \"status\":\"success\"}");
         } else if (type == "clear_history") {
-            // 清除对话历史
-            llmManager.clearConversationHistory();
+            // 清除该客户端会话的对话历史
+            llmManager.clearConversationHistory(getSessionKey(client, doc));
             client->text("{\"type\":\"history_cleared\", \"status\":\"success\", \"message\":\"对话历史已清除\"}");
         } else if (type == "gpio_control") {
             // GPIO控制
@@ -205,7 +233,7 @@ void WebManager::handleWebSocketData(AsyncWebSocketClient * client, void *arg, u
             if (success) {
                 String response = "{\"type\":\"gpio_status\", \"status\":\"success\", \"gpio\":\"" + gpioNum + "\", \"state\":" + (state ? "true" : "false") + "}";
                 client->text(response);
-                Serial.printf("GPIO %s set to %s\n", gpioNum.c_str(), state ? "HIGH" : "LOW");
+                LOG_I("WEB", "GPIO %s set to %s", gpioNum.c_str(), state ? "HIGH" : "LOW");
             } else {
                 String response = "{\"type\":\"gpio_status\", \"status\":\"error\", \"message\":\"Invalid GPIO number\"}";
                 client->text(response);
@@ -242,6 +270,89 @@ void WebManager::setupRoutes() {
         request->send(200, "application/json", jsonString);
     });
 
+    // API to get LLM scheduler stats (queued requests and queue-wait histograms per priority class)
+    server.on("/api/llm/scheduler", HTTP_GET, [this](AsyncWebServerRequest *request){
+        JsonDocument statsDoc;
+        llmManager.writeSchedulerStats(statsDoc.to<JsonObject>());
+        String jsonString;
+        serializeJson(statsDoc, jsonString);
+        request->send(200, "application/json", jsonString);
+    });
+
+    // API to get LLM response cache stats (hits per tier, misses, evictions)
+    server.on("/api/llm/cache", HTTP_GET, [this](AsyncWebServerRequest *request){
+        JsonDocument statsDoc;
+        llmManager.writeCacheStats(statsDoc.to<JsonObject>());
+        String jsonString;
+        serializeJson(statsDoc, jsonString);
+        request->send(200, "application/json", jsonString);
+    });
+
+    // API to clear the LLM response cache
+    server.on("/api/llm/cache", HTTP_DELETE, [this](AsyncWebServerRequest *request){
+        llmManager.clearResponseCache();
+        request->send(200, "application/json", "{\"status\":\"success\"}");
+    });
+
+    // API to get LLM provider routing stats (hedges, failovers, circuit breaker state per provider)
+    server.on("/api/llm/routing", HTTP_GET, [this](AsyncWebServerRequest *request){
+        JsonDocument statsDoc;
+        llmManager.writeRoutingStats(statsDoc.to<JsonObject>());
+        String jsonString;
+        serializeJson(statsDoc, jsonString);
+        request->send(200, "application/json", jsonString);
+    });
+
+    // API to get local intent matcher stats (hit rate, per-rule hits)
+    server.on("/api/llm/intents", HTTP_GET, [this](AsyncWebServerRequest *request){
+        JsonDocument statsDoc;
+        llmManager.writeIntentStats(statsDoc.to<JsonObject>());
+        String jsonString;
+        serializeJson(statsDoc, jsonString);
+        request->send(200, "application/json", jsonString);
+    });
+
+    // API to get LLM request metrics (per-phase latency per provider and model, dropped and parse-failure counters)
+    server.on("/api/metrics/llm", HTTP_GET, [this](AsyncWebServerRequest *request){
+        JsonDocument statsDoc;
+        llmManager.writeMetrics(statsDoc.to<JsonObject>());
+        String jsonString;
+        serializeJson(statsDoc, jsonString);
+        request->send(200, "application/json", jsonString);
+    });
+
+    // Metrics registry of all managers in Prometheus text format
+    server.on("/metrics", HTTP_GET, [](AsyncWebServerRequest *request){
+        AsyncResponseStream *response = request->beginResponseStream("text/plain; version=0.0.4");
+        MetricsRegistry::instance().writePrometheus(*response);
+        request->send(response);
+    });
+
+    // Span trace in Chrome trace format (open in Perfetto); ?save=1 writes it to /trace.json on the FFat U disk instead
+    server.on("/api/trace", HTTP_GET, [](AsyncWebServerRequest *request){
+#if NOOX_TRACE
+        if (request->hasParam("save")) {
+            File traceFile = FFat.open("/trace.json", "w");
+            if (!traceFile) {
+                request->send(500, "application/json", "{\"status\":\"error\",\"message\":\"Failed to open /trace.json\"}");
+                return;
+            }
+            size_t events = Tracer::instance().writeChromeTrace(traceFile);
+            size_t bytes = traceFile.size();
+            traceFile.close();
+            LOG_I("WEB", "Trace saved to /trace.json (%u events, %u bytes)", events, bytes);
+            request->send(200, "application/json",
+                          "{\"status\":\"success\",\"file\":\"/trace.json\",\"events\":" + String(events) + "}");
+            return;
+        }
+        AsyncResponseStream *response = request->beginResponseStream("application/json");
+        Tracer::instance().writeChromeTrace(*response);
+        request->send(response);
+#else
+        request->send(501, "application/json", "{\"status\":\"error\",\"message\":\"Tracing disabled (build with -DNOOX_TRACE=1)\"}");
+#endif
+    });
+
     // API to update config
     AsyncCallbackJsonWebHandler* handler = new AsyncCallbackJsonWebHandler("/api/config", [this](AsyncWebServerRequest *request, JsonVariant &json) {
         // Copy the received JSON to pendingConfigDoc
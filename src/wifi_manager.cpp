@@ -1,8 +1,18 @@
 #include "wifi_manager.h"
 #include <WiFi.h>
 
+// Gauges sampled when metrics are exported
+static int32_t readWiFiConnected(void*) { return WiFi.status() == WL_CONNECTED ? 1 : 0; }
+static int32_t readWiFiRssi(void*) { return WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : 0; }
+
 AppWiFiManager::AppWiFiManager(ConfigManager& config) 
     : configManager(config) {
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    registry.gauge("noox_wifi_connected", "1 when the station is connected", nullptr, readWiFiConnected);
+    registry.gauge("noox_wifi_rssi_dbm", "Signal strength of the connected AP (0 when disconnected)", nullptr, readWiFiRssi);
+    _connectAttempts = registry.counter("noox_wifi_connect_attempts_total", "WiFi connections initiated");
+    _connectTimeouts = registry.counter("noox_wifi_connect_timeouts_total", "WiFi connections that timed out");
+    _connectionsLost = registry.counter("noox_wifi_connections_lost_total", "Established WiFi connections that dropped");
 }
 
 void AppWiFiManager::begin() {
@@ -67,6 +77,7 @@ bool AppWiFiManager::connectToWiFi(const String& ssid, const String& password) {
 
     Serial.printf("Initiating connection to WiFi: %s\n", ssid.c_str());
     WiFi.begin(ssid.c_str(), password.c_str());
+    _connectAttempts->inc();
     _connectionAttemptStartTime = millis();
     _connectionState = CONNECTING;
     return true;
@@ -85,6 +96,7 @@ void AppWiFiManager::handleWiFiConnection() {
         } else if (millis() - _connectionAttemptStartTime > WIFI_CONNECTION_TIMEOUT_MS) {
             Serial.println("\nWiFi connection timed out.");
             WiFi.disconnect();
+            _connectTimeouts->inc();
             _connectionState = FAILED;
         } else {
             // Still connecting, do nothing or print a dot
@@ -93,6 +105,7 @@ void AppWiFiManager::handleWiFiConnection() {
     } else if (_connectionState == CONNECTED) {
         if (WiFi.status() != WL_CONNECTED) {
             Serial.println("WiFi connection lost. Attempting to reconnect...");
+            _connectionsLost->inc();
             _connectionState = IDLE; // Go back to IDLE to trigger reconnection logic
             connectToLastSSID(); // Attempt to reconnect to the last known SSID
         }
@@ -132,7 +145,7 @@ bool AppWiFiManager::deleteWiFi(const String& ssid) {
     JsonDocument& config = configManager.getConfig();
     JsonArray wifiNetworks = config["wifi_networks"].as<JsonArray>();
 
-    for (int i = 0; i < wifiNetworks.size(); i++) {
+    for (size_t i = 0; i < wifiNetworks.size(); i++) {
         if (wifiNetworks[i]["ssid"].as<String>() == ssid) {
             wifiNetworks.remove(i);
             Serial.printf("Removed WiFi network: %s\n", ssid.c_str());
@@ -0,0 +1,110 @@
+/**
+ * @file test_main.cpp
+ * @brief ConfigManager 的单元测试：缺省配置的生成、保存和重新加载。
+ *
+ * LittleFS 替身指向每个用例新建的临时目录。
+ */
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <unity.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "config_manager.h"
+
+static char fsRoot[64];
+
+void setUp() {
+    strcpy(fsRoot, "/tmp/noox_config_test_XXXXXX");
+    TEST_ASSERT_NOT_NULL(mkdtemp(fsRoot));
+    LittleFS.setRoot(fsRoot);
+    TEST_ASSERT_TRUE(LittleFS.begin(true));
+}
+
+void tearDown() {
+    LittleFS.remove("/config.json");
+    rmdir(fsRoot);
+}
+
+static void writeConfigFile(const char* text) {
+    File file = LittleFS.open("/config.json", "w");
+    TEST_ASSERT_TRUE((bool)file);
+    file.print(text);
+    file.close();
+}
+
+// 没有配置文件时生成缺省配置并写入 LittleFS
+void test_missing_file_creates_defaults() {
+    ConfigManager config;
+    TEST_ASSERT_TRUE(config.loadConfig());
+    TEST_ASSERT_TRUE(LittleFS.exists("/config.json"));
+
+    JsonDocument& doc = config.getConfig();
+    TEST_ASSERT_EQUAL_STRING("deepseek", doc["last_used"]["llm_provider"] | "");
+    TEST_ASSERT_EQUAL_STRING("deepseek-chat", doc["last_used"]["model"] | "");
+    TEST_ASSERT_TRUE(doc["llm_settings"]["stream"] | false);
+    TEST_ASSERT_FALSE(doc["llm_settings"]["cache"]["enabled"] | true);
+    TEST_ASSERT_EQUAL_INT(2, doc["llm_settings"]["workers"] | 0);
+    TEST_ASSERT_EQUAL_STRING("info", doc["log_settings"]["level"] | "");
+    TEST_ASSERT_TRUE(doc["llm_providers"]["openai"]["models"].is<JsonArray>());
+}
+
+// 缺省配置写入后，另一个实例读回的内容相同
+void test_defaults_round_trip_through_file() {
+    ConfigManager first;
+    TEST_ASSERT_TRUE(first.loadConfig());
+
+    ConfigManager second;
+    TEST_ASSERT_TRUE(second.loadConfig());
+    String expected;
+    String actual;
+    serializeJson(first.getConfig(), expected);
+    serializeJson(second.getConfig(), actual);
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), actual.c_str());
+}
+
+// 修改后保存，重新加载时得到修改后的值
+void test_saved_changes_are_loaded() {
+    ConfigManager config;
+    TEST_ASSERT_TRUE(config.loadConfig());
+    config.getConfig()["llm_settings"]["workers"] = 1;
+    config.getConfig()["last_used"]["model"] = "gpt-4o";
+    TEST_ASSERT_TRUE(config.saveConfig());
+
+    ConfigManager reloaded;
+    TEST_ASSERT_TRUE(reloaded.loadConfig());
+    TEST_ASSERT_EQUAL_INT(1, reloaded.getConfig()["llm_settings"]["workers"] | 0);
+    TEST_ASSERT_EQUAL_STRING("gpt-4o", reloaded.getConfig()["last_used"]["model"] | "");
+}
+
+// 已有的配置文件原样加载，不补充缺省值
+void test_existing_file_is_loaded_as_is() {
+    writeConfigFile("{\"last_used\":{\"llm_provider\":\"openai\",\"model\":\"gpt-4o\"}}");
+
+    ConfigManager config;
+    TEST_ASSERT_TRUE(config.loadConfig());
+    TEST_ASSERT_EQUAL_STRING("openai", config.getConfig()["last_used"]["llm_provider"] | "");
+    TEST_ASSERT_TRUE(config.getConfig()["llm_settings"].isNull());
+}
+
+// 损坏的配置文件报告失败，且不被缺省配置覆盖
+void test_corrupt_file_fails_without_overwriting() {
+    writeConfigFile("{\"last_used\": {");
+
+    ConfigManager config;
+    TEST_ASSERT_FALSE(config.loadConfig());
+
+    File file = LittleFS.open("/config.json", "r");
+    TEST_ASSERT_TRUE((bool)file);
+    TEST_ASSERT_EQUAL_STRING("{\"last_used\": {", file.readString().c_str());
+    file.close();
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_missing_file_creates_defaults);
+    RUN_TEST(test_defaults_round_trip_through_file);
+    RUN_TEST(test_saved_changes_are_loaded);
+    RUN_TEST(test_existing_file_is_loaded_as_is);
+    RUN_TEST(test_corrupt_file_fails_without_overwriting);
+    return UNITY_END();
+}
@@ -0,0 +1,237 @@
+/**
+ * @file test_main.cpp
+ * @brief ConversationHistory 的单元测试：消息顺序、淘汰、内存区回绕、UTF-8 截断、token 预算，
+ *        以及与逐条分配的旧实现比较 PSRAM 分配次数。
+ */
+#include <Arduino.h>
+#include <unity.h>
+#include "llm_manager.h"
+
+void setUp() {}
+void tearDown() {}
+
+// 由同一个字符重复组成的消息内容，便于检查回绕后内容是否完整
+static String repeated(char c, size_t length) {
+    String text;
+    for (size_t i = 0; i < length; i++) {
+        text += c;
+    }
+    return text;
+}
+
+/**
+ * @brief 改为环形内存区之前的存储方式：每条消息的角色和内容各 ps_malloc 一次，被覆盖时释放。
+ *        只用于比较分配次数。
+ */
+class PerMessageHistory {
+public:
+    explicit PerMessageHistory(size_t maxMessages) : capacity(maxMessages), count(0), startIndex(0) {
+        slots = (Slot*)ps_calloc(capacity, sizeof(Slot));
+    }
+
+    ~PerMessageHistory() {
+        for (size_t i = 0; i < capacity; i++) {
+            free(slots[i].role);
+            free(slots[i].content);
+        }
+        free(slots);
+    }
+
+    void addMessage(const char* role, const String& content) {
+        size_t index;
+        if (count < capacity) {
+            index = count++;
+        } else {
+            index = startIndex;
+            free(slots[index].role);
+            free(slots[index].content);
+            startIndex = (startIndex + 1) % capacity;
+        }
+        slots[index].role = (char*)ps_malloc(strlen(role) + 1);
+        strcpy(slots[index].role, role);
+        slots[index].content = (char*)ps_malloc(content.length() + 1);
+        strcpy(slots[index].content, content.c_str());
+    }
+
+private:
+    struct Slot {
+        char* role;
+        char* content;
+    };
+    Slot* slots;
+    size_t capacity;
+    size_t count;
+    size_t startIndex;
+};
+
+// 按时间顺序读出消息，角色和内容与写入一致
+void test_messages_read_back_in_order() {
+    ConversationHistory history(8, 1024);
+    history.addMessage(ROLE_USER, "hello");
+    history.addMessage(ROLE_ASSISTANT, "hi there");
+
+    TEST_ASSERT_EQUAL_UINT(2, history.getMessageCount());
+    const ConversationMessage* first = history.getMessage(0);
+    const ConversationMessage* second = history.getMessage(1);
+    TEST_ASSERT_NOT_NULL(first);
+    TEST_ASSERT_NOT_NULL(second);
+    TEST_ASSERT_EQUAL(ROLE_USER, first->role);
+    TEST_ASSERT_EQUAL_STRING("hello", history.getContent(*first));
+    TEST_ASSERT_EQUAL_UINT(5, first->length);
+    TEST_ASSERT_EQUAL(ROLE_ASSISTANT, second->role);
+    TEST_ASSERT_EQUAL_STRING("hi there", history.getContent(*second));
+    TEST_ASSERT_NULL(history.getMessage(2));
+}
+
+// 条数达到上限时淘汰最旧的消息
+void test_evicts_oldest_when_message_count_is_full() {
+    ConversationHistory history(3, 1024);
+    history.addMessage(ROLE_USER, "one");
+    history.addMessage(ROLE_ASSISTANT, "two");
+    history.addMessage(ROLE_USER, "three");
+    history.addMessage(ROLE_ASSISTANT, "four");
+
+    TEST_ASSERT_EQUAL_UINT(3, history.getMessageCount());
+    TEST_ASSERT_EQUAL_STRING("two", history.getContent(*history.getMessage(0)));
+    TEST_ASSERT_EQUAL_STRING("four", history.getContent(*history.getMessage(2)));
+}
+
+// 清空后不再有消息，内存区可以重新使用
+void test_clear_empties_history() {
+    ConversationHistory history(4, 256);
+    history.addMessage(ROLE_USER, "question");
+    history.addMessage(ROLE_ASSISTANT, "answer");
+    history.clear();
+
+    TEST_ASSERT_EQUAL_UINT(0, history.getMessageCount());
+    TEST_ASSERT_EQUAL_UINT(0, history.getArenaUsed());
+    history.addMessage(ROLE_USER, "again");
+    TEST_ASSERT_EQUAL_UINT(1, history.getMessageCount());
+    TEST_ASSERT_EQUAL_STRING("again", history.getContent(*history.getMessage(0)));
+}
+
+// 内存区末尾放不下新内容时回绕到开头，并淘汰被覆盖的最旧消息
+void test_arena_wraps_and_evicts_by_bytes() {
+    ConversationHistory history(16, 256);
+    // 每条 40 字节内容加 '\0' 占 41 字节，前 6 条占用 [0, 246)
+    for (size_t i = 0; i < 6; i++) {
+        history.addMessage(i % 2 ? ROLE_ASSISTANT : ROLE_USER, repeated('a' + i, 40));
+    }
+    TEST_ASSERT_EQUAL_UINT(6, history.getMessageCount());
+    TEST_ASSERT_EQUAL_UINT(246, history.getArenaUsed());
+
+    // 第 7 条放不进末尾的 10 字节，回绕到偏移 0，需要淘汰最旧的两条腾出连续空间
+    history.addMessage(ROLE_USER, repeated('g', 40));
+    TEST_ASSERT_EQUAL_UINT(5, history.getMessageCount());
+    TEST_ASSERT_EQUAL_UINT(0, history.getMessage(4)->offset);
+    for (size_t i = 0; i < 5; i++) {
+        const ConversationMessage* msg = history.getMessage(i);
+        TEST_ASSERT_EQUAL_UINT(40, msg->length);
+        TEST_ASSERT_EQUAL_STRING(repeated('c' + i, 40).c_str(), history.getContent(*msg));
+    }
+    // 已用区间跨过末尾：[82, 246) 加上 [0, 41)，末尾 10 字节的空隙也计入
+    TEST_ASSERT_EQUAL_UINT(256 - 82 + 41, history.getArenaUsed());
+    TEST_ASSERT_LESS_OR_EQUAL(history.getArenaSize(), history.getArenaUsed());
+}
+
+// 长时间运行后内容仍然完整，内存区占用不超过大小
+void test_many_turns_keep_contents_intact() {
+    ConversationHistory history(8, 512);
+    for (size_t i = 0; i < 500; i++) {
+        history.addMessage(i % 2 ? ROLE_ASSISTANT : ROLE_USER, repeated('a' + i % 26, 10 + i % 90));
+        TEST_ASSERT_LESS_OR_EQUAL(512, history.getArenaUsed());
+    }
+    size_t count = history.getMessageCount();
+    TEST_ASSERT_GREATER_THAN(0, count);
+    for (size_t n = 0; n < count; n++) {
+        size_t i = 500 - count + n;
+        const ConversationMessage* msg = history.getMessage(n);
+        TEST_ASSERT_EQUAL(i % 2 ? ROLE_ASSISTANT : ROLE_USER, msg->role);
+        TEST_ASSERT_EQUAL_STRING(repeated('a' + i % 26, 10 + i % 90).c_str(), history.getContent(*msg));
+    }
+}
+
+// 超过内存区四分之一的消息被截断，截断点不落在 UTF-8 多字节字符中间
+void test_long_message_is_truncated_on_utf8_boundary() {
+    ConversationHistory history(4, 64); // 单条最多 15 字节
+    // 14 个 ASCII 字符后跟一个三字节汉字，第 15 字节是汉字的第二个字节
+    history.addMessage(ROLE_ASSISTANT, "abcdefghijklmn\xE4\xB8\xAD");
+    const ConversationMessage* msg = history.getMessage(0);
+    TEST_ASSERT_EQUAL_UINT(14, msg->length);
+    TEST_ASSERT_EQUAL_STRING("abcdefghijklmn", history.getContent(*msg));
+
+    // 汉字正好在上限内结束时完整保留
+    history.addMessage(ROLE_USER, "abcdefghijkl\xE4\xB8\xADxyz");
+    msg = history.getMessage(1);
+    TEST_ASSERT_EQUAL_UINT(15, msg->length);
+    TEST_ASSERT_EQUAL_STRING("abcdefghijkl\xE4\xB8\xAD", history.getContent(*msg));
+}
+
+// 从最新消息向前在预算内选取，不以 assistant 回复开头
+void test_budget_selects_newest_messages_starting_with_user() {
+    ConversationHistory history(8, 1024);
+    // 每条 "abcd" 估算 1 个 token，加上结构开销共 5 个
+    history.addMessage(ROLE_USER, "abcd");
+    history.addMessage(ROLE_ASSISTANT, "abcd");
+    history.addMessage(ROLE_USER, "abcd");
+    history.addMessage(ROLE_ASSISTANT, "abcd");
+    TEST_ASSERT_EQUAL_UINT(5, history.getMessage(0)->tokens);
+
+    size_t used = 0;
+    TEST_ASSERT_EQUAL_UINT(0, history.getFirstIndexWithinBudget(20, used));
+    TEST_ASSERT_EQUAL_UINT(20, used);
+    TEST_ASSERT_EQUAL_UINT(2, history.getFirstIndexWithinBudget(12, used));
+    TEST_ASSERT_EQUAL_UINT(10, used);
+    // 预算能容纳三条，但第一条是 assistant 回复，跳过它
+    TEST_ASSERT_EQUAL_UINT(2, history.getFirstIndexWithinBudget(17, used));
+    TEST_ASSERT_EQUAL_UINT(10, used);
+    TEST_ASSERT_EQUAL_UINT(4, history.getFirstIndexWithinBudget(4, used));
+    TEST_ASSERT_EQUAL_UINT(0, used);
+}
+
+// 环形内存区只在构造时分配两次；逐条分配的旧实现每条消息分配两次
+void test_arena_allocation_count_versus_per_message() {
+    const size_t turns = 200;
+    char text[96];
+
+    uint32_t before = psramAllocationCount();
+    {
+        ConversationHistory history(60, 16384);
+        for (size_t i = 0; i < turns; i++) {
+            snprintf(text, sizeof(text), "turn %u: the quick brown fox jumps over the lazy dog", (unsigned)i);
+            history.addMessage(i % 2 ? ROLE_ASSISTANT : ROLE_USER, text);
+        }
+    }
+    uint32_t arenaAllocations = psramAllocationCount() - before;
+
+    before = psramAllocationCount();
+    {
+        PerMessageHistory history(60);
+        for (size_t i = 0; i < turns; i++) {
+            snprintf(text, sizeof(text), "turn %u: the quick brown fox jumps over the lazy dog", (unsigned)i);
+            history.addMessage(i % 2 ? "assistant" : "user", text);
+        }
+    }
+    uint32_t perMessageAllocations = psramAllocationCount() - before;
+
+    TEST_ASSERT_EQUAL_UINT32(2, arenaAllocations);
+    TEST_ASSERT_EQUAL_UINT32(1 + 2 * turns, perMessageAllocations);
+
+    char summary[96];
+    snprintf(summary, sizeof(summary), "PSRAM allocations for %u messages: arena %u, per-message %u",
+             (unsigned)turns, (unsigned)arenaAllocations, (unsigned)perMessageAllocations);
+    TEST_MESSAGE(summary);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_messages_read_back_in_order);
+    RUN_TEST(test_evicts_oldest_when_message_count_is_full);
+    RUN_TEST(test_clear_empties_history);
+    RUN_TEST(test_arena_wraps_and_evicts_by_bytes);
+    RUN_TEST(test_many_turns_keep_contents_intact);
+    RUN_TEST(test_long_message_is_truncated_on_utf8_boundary);
+    RUN_TEST(test_budget_selects_newest_messages_starting_with_user);
+    RUN_TEST(test_arena_allocation_count_versus_per_message);
+    return UNITY_END();
+}
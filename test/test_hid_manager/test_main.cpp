@@ -0,0 +1,87 @@
+/**
+ * @file test_main.cpp
+ * @brief HIDManager::pressKeyCombination 的单元测试：解析组合键并检查键盘替身记录的按键。
+ */
+#include <Arduino.h>
+#include <unity.h>
+#include "hid_manager.h"
+
+// 修饰键在报告中的位（KEY_LEFT_CTRL 起依次为第 0 位起）
+static const uint8_t MOD_CTRL = 1 << 0;
+static const uint8_t MOD_SHIFT = 1 << 1;
+static const uint8_t MOD_ALT = 1 << 2;
+static const uint8_t MOD_GUI = 1 << 3;
+
+static HIDManager hid;
+static HIDManager idleHid; // 未调用 begin()
+
+void setUp() {}
+void tearDown() {}
+
+void test_rejects_when_not_ready() {
+    TEST_ASSERT_FALSE(idleHid.pressKeyCombination("Ctrl+C"));
+    TEST_ASSERT_EQUAL_STRING("HID not ready", idleHid.getLastError().c_str());
+}
+
+void test_modifier_and_character() {
+    TEST_ASSERT_TRUE(hid.pressKeyCombination("Ctrl+C"));
+    const KeyReport& pressed = USBHIDKeyboard::getLastCombination();
+    TEST_ASSERT_EQUAL_HEX8(MOD_CTRL, pressed.modifiers);
+    TEST_ASSERT_EQUAL_HEX8('C', pressed.keys[0]);
+    TEST_ASSERT_EQUAL_HEX8(0, pressed.keys[1]);
+    TEST_ASSERT_EQUAL_STRING("", hid.getLastError().c_str());
+}
+
+// 修饰键不区分大小写，各部分两侧的空格被忽略
+void test_several_modifiers_and_special_key() {
+    TEST_ASSERT_TRUE(hid.pressKeyCombination("ctrl + ALT + Delete"));
+    const KeyReport& pressed = USBHIDKeyboard::getLastCombination();
+    TEST_ASSERT_EQUAL_HEX8(MOD_CTRL | MOD_ALT, pressed.modifiers);
+    TEST_ASSERT_EQUAL_HEX8(KEY_DELETE, pressed.keys[0]);
+
+    TEST_ASSERT_TRUE(hid.pressKeyCombination("Win+Shift+S"));
+    TEST_ASSERT_EQUAL_HEX8(MOD_GUI | MOD_SHIFT, USBHIDKeyboard::getLastCombination().modifiers);
+    TEST_ASSERT_EQUAL_HEX8('S', USBHIDKeyboard::getLastCombination().keys[0]);
+}
+
+void test_single_special_key() {
+    TEST_ASSERT_TRUE(hid.pressKeyCombination("F5"));
+    const KeyReport& pressed = USBHIDKeyboard::getLastCombination();
+    TEST_ASSERT_EQUAL_HEX8(0, pressed.modifiers);
+    TEST_ASSERT_EQUAL_HEX8(KEY_F5, pressed.keys[0]);
+}
+
+void test_unknown_key_is_rejected() {
+    TEST_ASSERT_FALSE(hid.pressKeyCombination("Ctrl+Foo"));
+    TEST_ASSERT_EQUAL_STRING("Unknown key: Foo", hid.getLastError().c_str());
+}
+
+// 未知修饰键之前已按下的修饰键必须松开，不能带到下一次组合键中
+void test_unknown_modifier_releases_pressed_modifiers() {
+    TEST_ASSERT_FALSE(hid.pressKeyCombination("Ctrl+Hyper+C"));
+    TEST_ASSERT_EQUAL_STRING("Unknown modifier: Hyper", hid.getLastError().c_str());
+
+    TEST_ASSERT_TRUE(hid.pressKeyCombination("Alt+Tab"));
+    const KeyReport& pressed = USBHIDKeyboard::getLastCombination();
+    TEST_ASSERT_EQUAL_HEX8(MOD_ALT, pressed.modifiers);
+    TEST_ASSERT_EQUAL_HEX8(KEY_TAB, pressed.keys[0]);
+}
+
+void test_empty_combination_is_rejected() {
+    TEST_ASSERT_FALSE(hid.pressKeyCombination(""));
+    TEST_ASSERT_EQUAL_STRING("Empty key combination", hid.getLastError().c_str());
+}
+
+int main(int argc, char** argv) {
+    hid.begin();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_rejects_when_not_ready);
+    RUN_TEST(test_modifier_and_character);
+    RUN_TEST(test_several_modifiers_and_special_key);
+    RUN_TEST(test_single_special_key);
+    RUN_TEST(test_unknown_key_is_rejected);
+    RUN_TEST(test_unknown_modifier_releases_pressed_modifiers);
+    RUN_TEST(test_empty_combination_is_rejected);
+    return UNITY_END();
+}
@@ -0,0 +1,237 @@
+/**
+ * @file test_main.cpp
+ * @brief HttpResponseParser 的单元测试：用录制的提供商响应验证三种响应体分帧方式。
+ *
+ * 录制的响应按 readLimit() 分段推入，模拟板上从 TLS 连接读取的方式；
+ * 每段的最大长度模拟一次 read() 实际拿到的字节数。
+ */
+#include <Arduino.h>
+#include <unity.h>
+#include "http_response_parser.h"
+
+// 非流式回复，Content-Length 界定响应体
+static const char CONTENT_LENGTH_RESPONSE[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Date: Tue, 14 Oct 2025 08:12:41 GMT\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: 58\r\n"
+    "Connection: keep-alive\r\n"
+    "Server: nginx\r\n"
+    "\r\n"
+    "{\"choices\":[{\"message\":{\"content\":\"Hello from the LLM\"}}]}";
+
+static const char CONTENT_LENGTH_BODY[] = "{\"choices\":[{\"message\":{\"content\":\"Hello from the LLM\"}}]}";
+
+// 流式回复，chunked 编码，块头带扩展，末尾块之后有 trailer
+static const char CHUNKED_RESPONSE[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/event-stream; charset=utf-8\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n"
+    "2e;sse=1\r\n"
+    "data: {\"choices\":[{\"delta\":{\"content\":\"Hi\"}}]}\r\n"
+    "10 ; note=\"quoted\"\r\n"
+    "\ndata: [DONE]\n\n\n"
+    "\r\n"
+    "0;final\r\n"
+    "X-Request-Id: 3f2a\r\n"
+    "X-Usage: 12\r\n"
+    "\r\n";
+
+static const char CHUNKED_BODY[] =
+    "data: {\"choices\":[{\"delta\":{\"content\":\"Hi\"}}]}"
+    "\ndata: [DONE]\n\n\n";
+
+// 既无 Content-Length 也非 chunked，响应体读到连接关闭为止
+static const char CLOSE_DELIMITED_RESPONSE[] =
+    "HTTP/1.1 502 Bad Gateway\r\n"
+    "Content-Type: text/html\r\n"
+    "\r\n"
+    "<html><body>upstream error</body></html>";
+
+void setUp() {}
+void tearDown() {}
+
+/**
+ * @brief 按 readLimit() 从录制的字节流读取一条响应
+ * @param maxRead 每次读取最多拿到的字节数
+ * @param body 输出：拼接的响应体
+ * @return 从字节流中读取的字节数
+ */
+static size_t readResponse(HttpResponseParser& parser, const char* stream, size_t streamLength,
+                           size_t maxRead, String& body) {
+    size_t pos = 0;
+    while (pos < streamLength && !parser.isComplete() && !parser.hasFailed()) {
+        size_t n = parser.readLimit();
+        if (n > maxRead) n = maxRead;
+        if (n > streamLength - pos) n = streamLength - pos;
+
+        const uint8_t* data = (const uint8_t*)stream + pos;
+        size_t used = 0;
+        while (used < n) {
+            size_t bodyOffset, bodyLength;
+            size_t consumed = parser.feed(data + used, n - used, bodyOffset, bodyLength);
+            body.concat((const char*)data + used + bodyOffset, bodyLength);
+            used += consumed;
+            if (consumed == 0) break;
+        }
+        // 遵守 readLimit() 时每次读到的字节都应被消耗
+        TEST_ASSERT_EQUAL_UINT(n, used);
+        pos += used;
+    }
+    return pos;
+}
+
+void test_content_length_body() {
+    size_t readSizes[] = {1, 7, 512};
+    for (size_t i = 0; i < sizeof(readSizes) / sizeof(readSizes[0]); i++) {
+        HttpResponseParser parser;
+        String body;
+        size_t read = readResponse(parser, CONTENT_LENGTH_RESPONSE, strlen(CONTENT_LENGTH_RESPONSE), readSizes[i], body);
+
+        TEST_ASSERT_TRUE(parser.isComplete());
+        TEST_ASSERT_EQUAL_UINT(strlen(CONTENT_LENGTH_RESPONSE), read);
+        TEST_ASSERT_EQUAL_INT(200, parser.getHead().statusCode);
+        TEST_ASSERT_EQUAL_INT(58, parser.getHead().contentLength);
+        TEST_ASSERT_FALSE(parser.getHead().chunked);
+        TEST_ASSERT_TRUE(parser.getHead().keepAlive);
+        TEST_ASSERT_EQUAL_STRING(CONTENT_LENGTH_BODY, body.c_str());
+    }
+}
+
+// 一次推入整条响应时，feed() 在响应头结束处返回，剩余部分是完整的响应体
+void test_feed_returns_at_end_of_head() {
+    HttpResponseParser parser;
+    const uint8_t* data = (const uint8_t*)CONTENT_LENGTH_RESPONSE;
+    size_t length = strlen(CONTENT_LENGTH_RESPONSE);
+    size_t bodyOffset, bodyLength;
+
+    size_t consumed = parser.feed(data, length, bodyOffset, bodyLength);
+    TEST_ASSERT_TRUE(parser.isHeadComplete());
+    TEST_ASSERT_EQUAL_UINT(0, bodyLength);
+    TEST_ASSERT_EQUAL_UINT(length - strlen(CONTENT_LENGTH_BODY), consumed);
+
+    size_t rest = parser.feed(data + consumed, length - consumed, bodyOffset, bodyLength);
+    TEST_ASSERT_EQUAL_UINT(length - consumed, rest);
+    TEST_ASSERT_EQUAL_UINT(0, bodyOffset);
+    TEST_ASSERT_EQUAL_UINT(strlen(CONTENT_LENGTH_BODY), bodyLength);
+    TEST_ASSERT_TRUE(parser.isComplete());
+}
+
+// 块扩展被忽略，trailer 被跳过，末尾空行之后才完成
+void test_chunked_body_with_extensions_and_trailer() {
+    size_t readSizes[] = {1, 3, 512};
+    for (size_t i = 0; i < sizeof(readSizes) / sizeof(readSizes[0]); i++) {
+        HttpResponseParser parser;
+        String body;
+        size_t read = readResponse(parser, CHUNKED_RESPONSE, strlen(CHUNKED_RESPONSE), readSizes[i], body);
+
+        TEST_ASSERT_TRUE(parser.isComplete());
+        TEST_ASSERT_EQUAL_UINT(strlen(CHUNKED_RESPONSE), read);
+        TEST_ASSERT_TRUE(parser.getHead().chunked);
+        TEST_ASSERT_EQUAL_INT(-1, parser.getHead().contentLength);
+        TEST_ASSERT_EQUAL_STRING(CHUNKED_BODY, body.c_str());
+    }
+}
+
+// 末尾的零长度块分几次到达：trailer 空行到达之前不算完成
+void test_zero_length_chunk_split_across_reads() {
+    HttpResponseParser parser;
+    parser.beginBody(-1, true);
+    size_t bodyOffset, bodyLength;
+
+    const char* first = "3\r\nabc\r\n0";
+    size_t consumed = parser.feed((const uint8_t*)first, strlen(first), bodyOffset, bodyLength);
+    TEST_ASSERT_EQUAL_UINT(6, consumed);
+    TEST_ASSERT_EQUAL_UINT(3, bodyOffset);
+    TEST_ASSERT_EQUAL_UINT(3, bodyLength);
+    consumed += parser.feed((const uint8_t*)first + consumed, strlen(first) - consumed, bodyOffset, bodyLength);
+    TEST_ASSERT_EQUAL_UINT(strlen(first), consumed);
+    TEST_ASSERT_EQUAL(HttpResponseParser::CHUNK_SIZE, parser.getState());
+
+    TEST_ASSERT_EQUAL_UINT(1, parser.feed((const uint8_t*)"\r", 1, bodyOffset, bodyLength));
+    TEST_ASSERT_EQUAL(HttpResponseParser::CHUNK_SIZE, parser.getState());
+    TEST_ASSERT_EQUAL_UINT(2, parser.feed((const uint8_t*)"\n\r", 2, bodyOffset, bodyLength));
+    TEST_ASSERT_EQUAL(HttpResponseParser::TRAILER, parser.getState());
+    TEST_ASSERT_FALSE(parser.isComplete());
+    TEST_ASSERT_EQUAL_UINT(1, parser.readLimit());
+
+    TEST_ASSERT_EQUAL_UINT(1, parser.feed((const uint8_t*)"\n", 1, bodyOffset, bodyLength));
+    TEST_ASSERT_EQUAL_UINT(0, bodyLength);
+    TEST_ASSERT_TRUE(parser.isComplete());
+    TEST_ASSERT_EQUAL_UINT(0, parser.readLimit());
+}
+
+void test_close_delimited_body() {
+    HttpResponseParser parser;
+    String body;
+    size_t read = readResponse(parser, CLOSE_DELIMITED_RESPONSE, strlen(CLOSE_DELIMITED_RESPONSE), 16, body);
+
+    TEST_ASSERT_EQUAL_UINT(strlen(CLOSE_DELIMITED_RESPONSE), read);
+    TEST_ASSERT_EQUAL_INT(502, parser.getHead().statusCode);
+    TEST_ASSERT_FALSE(parser.getHead().keepAlive);
+    TEST_ASSERT_EQUAL(HttpResponseParser::BODY_UNTIL_CLOSE, parser.getState());
+    TEST_ASSERT_EQUAL_UINT(SIZE_MAX, parser.readLimit());
+    TEST_ASSERT_FALSE(parser.isComplete());
+
+    parser.finishOnClose();
+    TEST_ASSERT_TRUE(parser.isComplete());
+    TEST_ASSERT_EQUAL_STRING("<html><body>upstream error</body></html>", body.c_str());
+}
+
+// 按长度或 chunked 界定的响应体未读完时连接关闭，视为中断
+void test_close_before_end_of_body_fails() {
+    HttpResponseParser parser;
+    String body;
+    readResponse(parser, CONTENT_LENGTH_RESPONSE, strlen(CONTENT_LENGTH_RESPONSE) - 10, 512, body);
+    TEST_ASSERT_EQUAL(HttpResponseParser::BODY_LENGTH, parser.getState());
+
+    parser.finishOnClose();
+    TEST_ASSERT_TRUE(parser.hasFailed());
+    TEST_ASSERT_EQUAL_STRING("Connection closed before end of response", parser.getError());
+}
+
+// 长连接上连续两条响应：读取第一条时恰好停在响应体末尾，第二条的字节留在连接中
+void test_keep_alive_stops_exactly_at_end_of_body() {
+    String stream = String(CONTENT_LENGTH_RESPONSE) + CHUNKED_RESPONSE + CONTENT_LENGTH_RESPONSE;
+    size_t firstLength = strlen(CONTENT_LENGTH_RESPONSE);
+    size_t secondLength = strlen(CHUNKED_RESPONSE);
+
+    HttpResponseParser parser;
+    String body;
+    size_t read = readResponse(parser, stream.c_str(), stream.length(), 4096, body);
+    TEST_ASSERT_TRUE(parser.isComplete());
+    TEST_ASSERT_TRUE(parser.getHead().keepAlive);
+    TEST_ASSERT_EQUAL_UINT(firstLength, read);
+    TEST_ASSERT_EQUAL_UINT(0, parser.readLimit());
+    TEST_ASSERT_EQUAL_STRING(CONTENT_LENGTH_BODY, body.c_str());
+
+    // chunked 响应在 trailer 的空行之后停下
+    parser.reset();
+    body = "";
+    read = readResponse(parser, stream.c_str() + firstLength, stream.length() - firstLength, 4096, body);
+    TEST_ASSERT_TRUE(parser.isComplete());
+    TEST_ASSERT_EQUAL_UINT(secondLength, read);
+    TEST_ASSERT_EQUAL_STRING(CHUNKED_BODY, body.c_str());
+
+    parser.reset();
+    body = "";
+    read = readResponse(parser, stream.c_str() + firstLength + secondLength,
+                        stream.length() - firstLength - secondLength, 4096, body);
+    TEST_ASSERT_TRUE(parser.isComplete());
+    TEST_ASSERT_EQUAL_UINT(firstLength, read);
+    TEST_ASSERT_EQUAL_STRING(CONTENT_LENGTH_BODY, body.c_str());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_content_length_body);
+    RUN_TEST(test_feed_returns_at_end_of_head);
+    RUN_TEST(test_chunked_body_with_extensions_and_trailer);
+    RUN_TEST(test_zero_length_chunk_split_across_reads);
+    RUN_TEST(test_close_delimited_body);
+    RUN_TEST(test_close_before_end_of_body_fails);
+    RUN_TEST(test_keep_alive_stops_exactly_at_end_of_body);
+    return UNITY_END();
+}
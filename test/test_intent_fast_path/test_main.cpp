@@ -0,0 +1,132 @@
+/**
+ * @file test_main.cpp
+ * @brief 本地意图快速路径的集成测试：CDC 用户输入经完整的 LLMManager 请求路径在本地执行工具调用。
+ *
+ * 使用缺省配置（意图匹配开启）且不连接 WiFi：请求一旦交给提供商，只会得到
+ * "Error: WiFi is not connected." 回复，不会执行工具。
+ */
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+#include <USBCDC.h>
+#include <unity.h>
+#include <stdlib.h>
+#include "config_manager.h"
+#include "hardware_config.h"
+#include "hardware_manager.h"
+#include "hid_manager.h"
+#include "llm_manager.h"
+#include "usb_shell_manager.h"
+#include "wifi_manager.h"
+
+static ConfigManager configManager;
+static AppWiFiManager wifiManager(configManager);
+static HardwareManager hardwareManager;
+static HIDManager hidManager;
+static UsbShellManager* shell;
+static LLMManager* llm;
+
+void setUp() {
+    USBCDC::captureOutput(true);
+}
+
+void tearDown() {
+    USBCDC::captureOutput(false);
+}
+
+// 工作任务
+static void llmTask(void* parameter) {
+    uint8_t workerIndex = (uint8_t)(uintptr_t)parameter;
+    for (;;) {
+        llm->loop(workerIndex);
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+// 注入一行主机消息，等待同一 requestId 的 aiResponse 并返回其内容；超时返回空字符串
+static String request(const char* line, const char* requestId) {
+    USBCDC::injectInput(line);
+    for (size_t i = 0; i < strlen(line); i++) {
+        shell->loop();
+    }
+    String output;
+    for (int waited = 0; waited < 3000; waited += 10) {
+        output += USBCDC::takeOutput();
+        int start = 0;
+        while (start < (int)output.length()) {
+            int end = output.indexOf('\n', start);
+            if (end < 0) break;
+            JsonDocument doc;
+            if (!deserializeJson(doc, output.substring(start, end)) &&
+                strcmp(doc["type"] | "", "aiResponse") == 0 && strcmp(doc["requestId"] | "", requestId) == 0) {
+                return doc["payload"] | "";
+            }
+            start = end + 1;
+        }
+        delay(10);
+    }
+    return String();
+}
+
+static JsonDocument intentStats() {
+    JsonDocument doc;
+    llm->writeIntentStats(doc.to<JsonObject>());
+    return doc;
+}
+
+// CDC 输入带 "User input: " 前缀进入队列，意图只匹配用户原文，不经过提供商
+void test_cdc_input_runs_gpio_set_locally() {
+    digitalWrite(LED_2_PIN, LOW);
+    uint32_t hitsBefore = intentStats()["hits"] | 0;
+
+    String reply = request("{\"type\":\"userInput\",\"requestId\":\"led\",\"payload\":\"turn on led2\"}\n", "led");
+
+    TEST_ASSERT_EQUAL_STRING("GPIO led2 set to HIGH", reply.c_str());
+    TEST_ASSERT_EQUAL(HIGH, digitalRead(LED_2_PIN));
+    TEST_ASSERT_EQUAL_UINT(hitsBefore + 1, intentStats()["hits"] | 0);
+}
+
+// 不匹配的输入照常交给提供商（这里因为没有 WiFi 而失败）
+void test_unmatched_input_goes_to_provider() {
+    String reply = request("{\"type\":\"userInput\",\"requestId\":\"chat\",\"payload\":\"what is the weather like?\"}\n",
+                           "chat");
+
+    TEST_ASSERT_EQUAL_STRING("Error: WiFi is not connected.", reply.c_str());
+}
+
+// Shell 结果的后续请求不是用户输入：不尝试匹配，也不计入尝试次数
+void test_shell_follow_up_is_not_matched() {
+    digitalWrite(LED_1_PIN, LOW);
+    uint32_t attemptsBefore = intentStats()["attempts"] | 0;
+
+    String reply = request("{\"type\":\"shellCommandResult\",\"requestId\":\"sh\",\"status\":\"success\",\"exitCode\":0,"
+                           "\"payload\":{\"command\":\"echo\",\"stdout\":\"turn on led1\",\"stderr\":\"\"}}\n", "sh");
+
+    TEST_ASSERT_EQUAL_STRING("Error: WiFi is not connected.", reply.c_str());
+    TEST_ASSERT_EQUAL(LOW, digitalRead(LED_1_PIN));
+    TEST_ASSERT_EQUAL_UINT(attemptsBefore, intentStats()["attempts"] | 0);
+}
+
+int main(int argc, char** argv) {
+    char fsRoot[] = "/tmp/noox_intent_test_XXXXXX";
+    if (!mkdtemp(fsRoot)) return 1;
+    LittleFS.setRoot(fsRoot);
+    LittleFS.begin(true);
+    configManager.loadConfig();
+
+    shell = new UsbShellManager(nullptr, &wifiManager);
+    llm = new LLMManager(configManager, wifiManager, shell, &hidManager, &hardwareManager);
+    shell->setLLMManager(llm);
+    llm->begin();
+    for (uint8_t i = 0; i < llm->getWorkerCount(); i++) {
+        xTaskCreate(llmTask, "LLMTask", LLMManager::WORKER_STACK_SIZE, (void*)(uintptr_t)i, 2, NULL);
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_cdc_input_runs_gpio_set_locally);
+    RUN_TEST(test_unmatched_input_goes_to_provider);
+    RUN_TEST(test_shell_follow_up_is_not_matched);
+    int failures = UNITY_END();
+    LittleFS.remove("/config.json");
+    return failures;
+}
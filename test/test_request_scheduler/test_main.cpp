@@ -0,0 +1,113 @@
+/**
+ * @file test_main.cpp
+ * @brief LLMRequestScheduler 的单元测试：类别优先级、后台请求的老化提升和队列容量。
+ */
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <unity.h>
+#include "llm_request_scheduler.h"
+
+// 老化步长取 50 ms，用例里的等待时间与它相差足够大，不受调度抖动影响
+static const unsigned long AGING_STEP_MS = 50;
+
+void setUp() {}
+void tearDown() {}
+
+static void submit(LLMRequestScheduler& scheduler, const char* requestId, LLMPriority priority) {
+    LLMRequest request = {};
+    strncpy(request.requestId, requestId, sizeof(request.requestId) - 1);
+    TEST_ASSERT_TRUE(scheduler.submit(request, priority, 0));
+}
+
+// 取出一个请求并返回它的请求ID，没有请求时返回空字符串
+static String takeId(LLMRequestScheduler& scheduler, LLMPriority lowest = PRIORITY_BACKGROUND) {
+    LLMRequest request;
+    if (!scheduler.take(request, lowest)) {
+        return String();
+    }
+    return String(request.requestId);
+}
+
+// 同时排队时按类别先后出队
+void test_classes_are_taken_in_priority_order() {
+    LLMRequestScheduler scheduler(4, AGING_STEP_MS);
+    submit(scheduler, "bg", PRIORITY_BACKGROUND);
+    submit(scheduler, "follow", PRIORITY_FOLLOW_UP);
+    submit(scheduler, "user", PRIORITY_INTERACTIVE);
+
+    TEST_ASSERT_EQUAL_STRING("user", takeId(scheduler).c_str());
+    TEST_ASSERT_EQUAL_STRING("follow", takeId(scheduler).c_str());
+    TEST_ASSERT_EQUAL_STRING("bg", takeId(scheduler).c_str());
+    TEST_ASSERT_EQUAL_STRING("", takeId(scheduler).c_str());
+}
+
+// 只处理交互请求的工作任务不会取到后台请求
+void test_interactive_only_worker_skips_background() {
+    LLMRequestScheduler scheduler(4, AGING_STEP_MS);
+    submit(scheduler, "bg", PRIORITY_BACKGROUND);
+    delay(AGING_STEP_MS * 3); // 即使已经老化到最高级
+
+    TEST_ASSERT_EQUAL_STRING("", takeId(scheduler, PRIORITY_INTERACTIVE).c_str());
+    TEST_ASSERT_EQUAL_UINT(1, scheduler.getQueued(PRIORITY_BACKGROUND));
+    TEST_ASSERT_EQUAL_STRING("bg", takeId(scheduler).c_str());
+}
+
+// 排队一个步长后提升一级：先于新的后续请求出队，但仍在新的交互请求之后
+void test_background_ages_past_follow_up() {
+    LLMRequestScheduler scheduler(4, AGING_STEP_MS);
+    submit(scheduler, "bg", PRIORITY_BACKGROUND);
+    delay(AGING_STEP_MS + AGING_STEP_MS / 5);
+    submit(scheduler, "follow", PRIORITY_FOLLOW_UP);
+    submit(scheduler, "user", PRIORITY_INTERACTIVE);
+
+    TEST_ASSERT_EQUAL_STRING("user", takeId(scheduler).c_str());
+    TEST_ASSERT_EQUAL_STRING("bg", takeId(scheduler).c_str());
+    TEST_ASSERT_EQUAL_STRING("follow", takeId(scheduler).c_str());
+}
+
+// 持续有交互请求时，后台请求老化到最高级后不再被饿死，并计入 promoted
+void test_background_is_not_starved_by_interactive_stream() {
+    LLMRequestScheduler scheduler(4, AGING_STEP_MS);
+    submit(scheduler, "bg", PRIORITY_BACKGROUND);
+    submit(scheduler, "user-1", PRIORITY_INTERACTIVE);
+    TEST_ASSERT_EQUAL_STRING("user-1", takeId(scheduler).c_str());
+
+    delay(AGING_STEP_MS * 2 + AGING_STEP_MS / 5);
+    submit(scheduler, "user-2", PRIORITY_INTERACTIVE);
+    TEST_ASSERT_EQUAL_STRING("bg", takeId(scheduler).c_str());
+    TEST_ASSERT_EQUAL_STRING("user-2", takeId(scheduler).c_str());
+
+    JsonDocument doc;
+    scheduler.writeStats(doc.to<JsonObject>());
+    TEST_ASSERT_EQUAL_UINT(1, doc["background"]["dequeued"] | 0);
+    TEST_ASSERT_EQUAL_UINT(1, doc["background"]["promoted"] | 0);
+    TEST_ASSERT_GREATER_OR_EQUAL(AGING_STEP_MS * 2, doc["background"]["max_wait_ms"] | 0UL);
+    TEST_ASSERT_EQUAL_UINT(0, doc["interactive"]["promoted"] | 0);
+}
+
+// 类别队列满时立即拒绝，不影响其他类别
+void test_full_class_rejects_without_blocking_others() {
+    LLMRequestScheduler scheduler(2, AGING_STEP_MS);
+    submit(scheduler, "bg-1", PRIORITY_BACKGROUND);
+    submit(scheduler, "bg-2", PRIORITY_BACKGROUND);
+
+    LLMRequest overflow = {};
+    strcpy(overflow.requestId, "bg-3");
+    TEST_ASSERT_FALSE(scheduler.submit(overflow, PRIORITY_BACKGROUND, 0));
+    submit(scheduler, "user", PRIORITY_INTERACTIVE);
+
+    TEST_ASSERT_EQUAL_UINT(2, scheduler.getQueued(PRIORITY_BACKGROUND));
+    TEST_ASSERT_EQUAL_STRING("user", takeId(scheduler).c_str());
+    TEST_ASSERT_EQUAL_STRING("bg-1", takeId(scheduler).c_str());
+    TEST_ASSERT_EQUAL_STRING("bg-2", takeId(scheduler).c_str());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_classes_are_taken_in_priority_order);
+    RUN_TEST(test_interactive_only_worker_skips_background);
+    RUN_TEST(test_background_ages_past_follow_up);
+    RUN_TEST(test_background_is_not_starved_by_interactive_stream);
+    RUN_TEST(test_full_class_rejects_without_blocking_others);
+    return UNITY_END();
+}
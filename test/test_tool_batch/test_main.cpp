@@ -0,0 +1,127 @@
+/**
+ * @file test_main.cpp
+ * @brief LLMToolBatch 的单元测试：超出上限的调用记录为被拒绝的结果，不同批次在同一资源上互斥执行。
+ */
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <unity.h>
+#include <atomic>
+#include "llm_tool_batch.h"
+
+// 记录同时在执行的调用数，每次调用占用一段时间，重叠时 maxActive 大于 1
+static std::atomic<int> active(0);
+static std::atomic<int> maxActive(0);
+static std::atomic<int> executed(0);
+
+static bool runSlowTool(LLMToolContext& context, JsonObject args, String& message) {
+    int now = ++active;
+    int seen = maxActive.load();
+    while (now > seen && !maxActive.compare_exchange_weak(seen, now)) {
+    }
+    delay(20);
+    --active;
+    executed++;
+    return true;
+}
+
+static const LLMToolSpec SLOW_TOOL = {
+    "slow", "Occupies the device for a while.", nullptr, 0, runSlowTool, TOOL_RESOURCE_DEVICE
+};
+
+static LLMToolRegistry registry;
+static String requestId("test");
+static LLMToolContext context = {requestId, nullptr, nullptr, nullptr};
+
+void setUp() {
+    active = 0;
+    maxActive = 0;
+    executed = 0;
+}
+void tearDown() {}
+
+// 向批次加入 n 个 slow 调用，参数对象取自 doc
+static void addCalls(LLMToolBatch& batch, JsonDocument& doc, size_t n) {
+    JsonArray args = doc.to<JsonArray>();
+    for (size_t i = 0; i < n; i++) {
+        batch.add("slow", args.add<JsonObject>());
+    }
+}
+
+// 超过 MAX_CALLS 的调用不执行，按回复中的顺序记录为被拒绝的结果
+void test_calls_beyond_limit_are_rejected() {
+    JsonDocument doc;
+    LLMToolBatch batch(registry, context);
+    addCalls(batch, doc, LLMToolBatch::MAX_CALLS + 2);
+    batch.execute();
+
+    TEST_ASSERT_EQUAL_INT(LLMToolBatch::MAX_CALLS, executed.load());
+    TEST_ASSERT_EQUAL_UINT(LLMToolBatch::MAX_CALLS + 2, batch.size());
+    TEST_ASSERT_EQUAL_UINT(2, batch.getFailureCount());
+    TEST_ASSERT_TRUE(batch.getResult(LLMToolBatch::MAX_CALLS - 1).success);
+    const LLMToolCallResult& rejected = batch.getResult(LLMToolBatch::MAX_CALLS);
+    TEST_ASSERT_FALSE(rejected.success);
+    TEST_ASSERT_EQUAL_STRING("slow", rejected.name);
+    TEST_ASSERT_TRUE(rejected.message.startsWith("Error: too many tool calls"));
+    TEST_ASSERT_TRUE(batch.summarize().indexOf("[failed] Error: too many tool calls") >= 0);
+}
+
+// 超过 MAX_RESULTS 的调用只计数，在结果数组和摘要末尾各占一项
+void test_calls_beyond_result_storage_are_counted() {
+    JsonDocument doc;
+    LLMToolBatch batch(registry, context);
+    addCalls(batch, doc, LLMToolBatch::MAX_RESULTS + 3);
+    batch.execute();
+
+    TEST_ASSERT_EQUAL_UINT(LLMToolBatch::MAX_RESULTS, batch.size());
+    TEST_ASSERT_EQUAL_UINT(LLMToolBatch::MAX_RESULTS + 3 - LLMToolBatch::MAX_CALLS, batch.getFailureCount());
+
+    JsonDocument resultsDoc;
+    JsonArray results = resultsDoc.to<JsonArray>();
+    batch.writeResults(results);
+    TEST_ASSERT_EQUAL_UINT(LLMToolBatch::MAX_RESULTS + 1, results.size());
+    JsonObject last = results[LLMToolBatch::MAX_RESULTS];
+    TEST_ASSERT_FALSE(last["ok"] | true);
+    TEST_ASSERT_EQUAL_STRING("Error: too many tool calls (3 more not recorded)", last["result"] | "");
+}
+
+struct BatchJob {
+    SemaphoreHandle_t done;
+};
+
+// 另一个工作任务中的批次
+static void batchTask(void* parameter) {
+    BatchJob* job = (BatchJob*)parameter;
+    JsonDocument doc;
+    LLMToolBatch batch(registry, context);
+    addCalls(batch, doc, 3);
+    batch.execute();
+    xSemaphoreGive(job->done);
+    vTaskDelete(NULL);
+}
+
+// 两个任务中的批次操作同一资源时依次执行，调用不重叠
+void test_batches_on_same_resource_do_not_overlap() {
+    BatchJob job = {xSemaphoreCreateBinary()};
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(batchTask, "batch", 6144, &job, 1, NULL));
+
+    JsonDocument doc;
+    LLMToolBatch batch(registry, context);
+    addCalls(batch, doc, 3);
+    batch.execute();
+    xSemaphoreTake(job.done, portMAX_DELAY);
+    vSemaphoreDelete(job.done);
+
+    TEST_ASSERT_EQUAL_INT(6, executed.load());
+    TEST_ASSERT_EQUAL_INT(1, maxActive.load());
+}
+
+int main(int argc, char** argv) {
+    registry.add(&SLOW_TOOL);
+    registry.build();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_calls_beyond_limit_are_rejected);
+    RUN_TEST(test_calls_beyond_result_storage_are_counted);
+    RUN_TEST(test_batches_on_same_resource_do_not_overlap);
+    return UNITY_END();
+}
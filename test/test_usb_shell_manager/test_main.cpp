@@ -0,0 +1,92 @@
+/**
+ * @file test_main.cpp
+ * @brief UsbShellManager::processHostMessage 的单元测试：通过 CDC 替身注入主机消息并检查回复。
+ */
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <USBCDC.h>
+#include <unity.h>
+#include "usb_shell_manager.h"
+
+// 只处理不需要 LLMManager 和 WiFi 的消息类型；不调用 begin()，不启动 stdin 读取线程
+static UsbShellManager shell(nullptr, nullptr);
+
+void setUp() {
+    USBCDC::captureOutput(true);
+}
+
+void tearDown() {
+    USBCDC::captureOutput(false);
+}
+
+// 注入一行主机消息，逐字节处理完后取回设备发出的内容
+static String exchange(const char* line) {
+    USBCDC::injectInput(line);
+    for (size_t i = 0; i < strlen(line); i++) {
+        shell.loop();
+    }
+    return USBCDC::takeOutput();
+}
+
+void test_link_test_replies_with_pong() {
+    String reply = exchange("{\"type\":\"linkTest\",\"requestId\":\"42\",\"payload\":\"ping\"}\n");
+
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, reply));
+    TEST_ASSERT_EQUAL_STRING("linkTestResult", doc["type"] | "");
+    TEST_ASSERT_EQUAL_STRING("42", doc["requestId"] | "");
+    TEST_ASSERT_EQUAL_STRING("success", doc["status"] | "");
+    TEST_ASSERT_EQUAL_STRING("pong", doc["payload"] | "");
+}
+
+void test_invalid_json_is_rejected() {
+    String reply = exchange("{not json\n");
+
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, reply));
+    TEST_ASSERT_EQUAL_STRING("error", doc["type"] | "");
+    TEST_ASSERT_EQUAL_STRING("Invalid JSON", doc["content"] | "");
+}
+
+void test_unknown_type_echoes_request_id() {
+    String reply = exchange("{\"type\":\"selfDestruct\",\"requestId\":\"7\"}\n");
+
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, reply));
+    TEST_ASSERT_EQUAL_STRING("error", doc["type"] | "");
+    TEST_ASSERT_EQUAL_STRING("Unknown message type", doc["payload"] | "");
+    TEST_ASSERT_EQUAL_STRING("7", doc["requestId"] | "");
+}
+
+// 消息在换行之前不处理，分几次到达也只处理一次
+void test_message_is_processed_only_at_newline() {
+    TEST_ASSERT_EQUAL_UINT(0, exchange("{\"type\":\"linkTest\",").length());
+    String reply = exchange("\"requestId\":\"split\"}\n");
+
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, reply));
+    TEST_ASSERT_EQUAL_STRING("linkTestResult", doc["type"] | "");
+    TEST_ASSERT_EQUAL_STRING("split", doc["requestId"] | "");
+}
+
+// 指标快照中包含 CDC 自己的消息计数
+void test_metrics_snapshot_counts_received_messages() {
+    String reply = exchange("{\"type\":\"getMetricsSnapshot\",\"requestId\":\"m\"}\n");
+
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, reply));
+    TEST_ASSERT_EQUAL_STRING("metricsSnapshot", doc["type"] | "");
+    TEST_ASSERT_EQUAL_STRING("m", doc["requestId"] | "");
+    TEST_ASSERT_TRUE(doc["payload"].is<JsonObject>());
+    TEST_ASSERT_GREATER_OR_EQUAL(1, doc["payload"]["noox_cdc_messages_total{direction=\"received\"}"] | 0);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_link_test_replies_with_pong);
+    RUN_TEST(test_invalid_json_is_rejected);
+    RUN_TEST(test_unknown_type_echoes_request_id);
+    RUN_TEST(test_message_is_processed_only_at_newline);
+    RUN_TEST(test_metrics_snapshot_counts_received_messages);
+    return UNITY_END();
+}